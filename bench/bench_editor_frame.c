@@ -0,0 +1,92 @@
+// bench_editor_frame.c
+//
+// Measures the cost of composing one editor frame against the size of the
+// visible text: the old strcat/strlen loop from display_editor_screen versus
+// frame_compose_text.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "frame_builder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// The composition loop display_editor_screen used before the frame builder.
+static size_t compose_strcat(char *display_buffer, size_t buffer_size, const char *text, size_t length, size_t cursor) {
+    memset(display_buffer, 0, buffer_size);
+    for (size_t i = 0; i < length; i++) {
+        if (i == cursor) {
+            strcat(display_buffer, "\033[4m");
+            char temp[2] = { text[i], '\0' };
+            strcat(display_buffer, temp);
+            strcat(display_buffer, "\033[0m");
+        } else {
+            size_t len = strlen(display_buffer);
+            if (len < buffer_size - 2) {
+                display_buffer[len] = text[i];
+                display_buffer[len + 1] = '\0';
+            }
+        }
+    }
+    return strlen(display_buffer);
+}
+
+static size_t compose_frame(char *storage, size_t storage_size, const char *text, size_t length, size_t cursor) {
+    FrameSpan frame;
+    frame_init(&frame, storage, storage_size);
+    frame_compose_text(&frame, text, length, cursor, true);
+    return frame.length;
+}
+
+int main(void) {
+    const size_t sizes[] = { 256, 1024, 4096, 16384, 65536 };
+    const size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+
+    char *text = malloc(max_size);
+    char *out = malloc(max_size * 2 + FRAME_CURSOR_OVERHEAD);
+    if (!text || !out) {
+        return 1;
+    }
+    for (size_t i = 0; i < max_size; i++) {
+        text[i] = (i % 61 == 60) ? '\n' : (char)('a' + i % 26);
+    }
+
+    printf("%10s %16s %16s %10s\n", "bytes", "strcat ns/frame", "builder ns/frame", "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t length = sizes[s];
+        size_t cursor = length / 2;
+        volatile size_t sink = 0;
+
+        // Keep the total work per measurement roughly constant
+        int legacy_iterations = (int)(4000000000ULL / (length * length)) + 1;
+        if (legacy_iterations > 20000) {
+            legacy_iterations = 20000;
+        }
+        double t0 = now_ns();
+        for (int i = 0; i < legacy_iterations; i++) {
+            sink += compose_strcat(out, length * 2 + FRAME_CURSOR_OVERHEAD, text, length, cursor);
+        }
+        double legacy_ns = (now_ns() - t0) / legacy_iterations;
+
+        int iterations = (int)(400000000ULL / length);
+        t0 = now_ns();
+        for (int i = 0; i < iterations; i++) {
+            sink += compose_frame(out, length + FRAME_CURSOR_OVERHEAD, text, length, cursor);
+        }
+        double builder_ns = (now_ns() - t0) / iterations;
+
+        printf("%10zu %16.0f %16.0f %9.1fx\n", length, legacy_ns, builder_ns, legacy_ns / builder_ns);
+        (void)sink;
+    }
+
+    free(text);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,117 @@
+// bench_flush_pipeline.c
+//
+// Paces frames through the display flush pipeline over the simulated transfer
+// engine, synchronously (one strip: every transfer finishes before the next
+// band is copied) and double-buffered (two strips). For each link model it
+// reports, while scrolling (every frame repaints the screen), how long the CPU
+// is held in the flush per frame and the frame rate; and while typing (a
+// keystroke changes a few cells), how long the flush holds the CPU and how
+// long until the keystroke is on the panel.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "text_renderer.h"
+#include "flush_pipeline.h"
+#include "flush_sim.h"
+#include "virtual_screen.h"
+#include "hal_interface.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SCROLL_FRAMES 200
+#define KEYSTROKES 500
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+// The display HAL of the ESP32-S3 port, with the simulated engine as the panel.
+void hal_display_clear(void) { text_renderer_clear(); }
+void hal_display_write(const char *text) { text_renderer_write(text); }
+void hal_display_set_cursor(int line, int column) { text_renderer_set_cursor(line, column); }
+void hal_display_flush(void) { text_renderer_flush(); }
+
+static char text[64 * 1024];
+
+// Lines of 100 pseudo-random letters, so that scrolling changes every cell.
+static void fill_text(void) {
+    unsigned seed = 1;
+    for (size_t i = 0; i < sizeof(text); i++) {
+        seed = seed * 1103515245u + 12345u;
+        text[i] = i % 101 == 100 ? '\n' : (char)('a' + (seed >> 16) % 26);
+    }
+}
+
+// Draws the editor screen showing text[top..end), cursor at cursor.
+static double draw_frame(size_t top, size_t end, size_t cursor, double *flush_us) {
+    double t0 = now_us();
+    vscreen_begin_frame();
+    vscreen_write("Editing: /bench.txt\n");
+    vscreen_write_span(text + top, cursor - top);
+    vscreen_write("\033[4m \033[0m");
+    vscreen_write_span(text + cursor, end - cursor);
+    double t1 = now_us();
+    vscreen_flush();
+    double t2 = now_us();
+    *flush_us += t2 - t1;
+    return t2 - t0;
+}
+
+static void run(const FlushSimConfig *config, int strips) {
+    flush_sim_start(config);
+    flush_pipeline_init(&flush_sim_engine, strips);
+    text_renderer_init(flush_pipeline_send);
+    vscreen_init();
+    vscreen_flush();
+    flush_pipeline_drain();
+
+    // Scrolling: one line per frame, every cell changes
+    double flush_us = 0;
+    double t0 = now_us();
+    size_t top = 0;
+    for (int frame = 0; frame < SCROLL_FRAMES; frame++) {
+        top = (size_t)(strchr(text + top, '\n') - text) + 1;
+        draw_frame(top, top + 2000, top, &flush_us);
+    }
+    flush_pipeline_drain();
+    double scroll_fps = SCROLL_FRAMES / ((now_us() - t0) / 1e6);
+    double scroll_hold = flush_us / SCROLL_FRAMES;
+
+    // Typing: the text grows by one character per frame. Keys come slower
+    // than the link, so each frame starts on an idle link.
+    FlushPipelineStats before = flush_pipeline_stats();
+    flush_us = 0;
+    double latency_us = 0;
+    for (int key = 0; key < KEYSTROKES; key++) {
+        t0 = now_us();
+        draw_frame(0, 200 + (size_t)key, 200 + (size_t)key, &flush_us);
+        flush_pipeline_drain();
+        latency_us += now_us() - t0;
+    }
+    FlushPipelineStats after = flush_pipeline_stats();
+
+    printf("  %-7s %10.0f %10.1f %12.1f %12.1f %10.2f\n", strips == 1 ? "sync" : "double", scroll_hold, scroll_fps,
+           flush_us / KEYSTROKES, latency_us / KEYSTROKES, (double)(after.transfers - before.transfers) / KEYSTROKES);
+    flush_sim_stop();
+}
+
+int main(void) {
+    const FlushSimConfig links[] = {
+        { 20u * 1000u * 1000u, 30 },   // 16-bit bus at 10 MHz
+        { 5u * 1000u * 1000u, 60 },    // SPI at 40 MHz
+    };
+    fill_text();
+
+    for (size_t l = 0; l < sizeof(links) / sizeof(links[0]); l++) {
+        printf("Link %.1f MB/s, %u us per transfer\n", links[l].bytes_per_second / 1e6, links[l].setup_us);
+        printf("  %-7s %10s %10s %12s %12s %10s\n", "flush", "scroll us", "scroll fps", "key hold us",
+               "key to panel", "transfers");
+        for (int strips = 1; strips <= FLUSH_PIPELINE_STRIPS; strips++) {
+            run(&links[l], strips);
+        }
+    }
+    return 0;
+}
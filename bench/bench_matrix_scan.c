@@ -0,0 +1,131 @@
+// bench_matrix_scan.c
+//
+// Runs the matrix scanner against the simulated MCP23017 bus and reports the
+// scan time on the wire at several I2C clock rates, the resulting scan rate,
+// the host CPU time per scan and the latency from a switch closing to its key
+// event. The scanner runs back to back, as the scanner task does.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "matrix_scan.h"
+#include "matrix_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define LATENCY_TRIALS 500
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Simulated bus time of one scan in the current matrix state.
+static double scan_bus_ns(MatrixScanner *scanner, MatrixSim *sim) {
+    KeyEvent events[8];
+    uint64_t start = sim->elapsed_ns;
+    matrix_scan_run(scanner, 0, events, 8);
+    return (double)(sim->elapsed_ns - start);
+}
+
+// Scans until the scanner reports an event; returns the bus time spent, or -1.
+static double scan_until_event(MatrixScanner *scanner, MatrixSim *sim) {
+    KeyEvent events[8];
+    uint64_t start = sim->elapsed_ns;
+    for (int i = 0; i < 100; i++) {
+        if (matrix_scan_run(scanner, 0, events, 8) > 0) {
+            return (double)(sim->elapsed_ns - start);
+        }
+    }
+    return -1;
+}
+
+// Scans until every key is released and debounced.
+static void scan_until_idle(MatrixScanner *scanner) {
+    KeyEvent events[8];
+    while (scanner->pressed_count > 0 || scanner->unsettled > 0) {
+        matrix_scan_run(scanner, 0, events, 8);
+    }
+}
+
+static void bench_clock(uint32_t clock_hz) {
+    MatrixSim sim;
+    MatrixScanner scanner;
+    matrix_sim_init(&sim, clock_hz);
+    I2cBus bus = matrix_sim_bus(&sim);
+    if (!matrix_scan_init(&scanner, &bus)) {
+        printf("init failed\n");
+        return;
+    }
+
+    double idle_ns = scan_bus_ns(&scanner, &sim);
+    idle_ns = scan_bus_ns(&scanner, &sim);  // The first probe also switches the row drive
+
+    // Host cost of a full scan with one key held
+    KeyEvent events[8];
+    matrix_sim_set_key(&sim, 3, 1, true);
+    const int iterations = 20000;
+    double t0 = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        matrix_scan_run(&scanner, 0, events, 8);
+    }
+    double host_ns = (now_ns() - t0) / iterations;
+    double active_ns = scan_bus_ns(&scanner, &sim);
+    matrix_sim_set_key(&sim, 3, 1, false);
+    scan_until_idle(&scanner);
+
+    // Press-to-event latency; the press lands at a random point of an idle scan
+    srand(1);
+    double total = 0;
+    double worst = 0;
+    for (int trial = 0; trial < LATENCY_TRIALS; trial++) {
+        int row = 1 + rand() % 4;
+        int col = 1 + rand() % 10;
+        double phase = idle_ns * (double)rand() / RAND_MAX;
+        matrix_sim_set_key(&sim, row, col, true);
+        double latency = (idle_ns - phase) + scan_until_event(&scanner, &sim);
+        matrix_sim_set_key(&sim, row, col, false);
+        scan_until_idle(&scanner);
+        total += latency;
+        if (latency > worst) {
+            worst = latency;
+        }
+    }
+
+    printf("%8u kHz %10.0f %10.0f %10.0f %10.0f %10.2f %10.2f\n", clock_hz / 1000, idle_ns / 1000,
+           active_ns / 1000, 1e9 / active_ns, host_ns, total / LATENCY_TRIALS / 1e6, worst / 1e6);
+}
+
+// Holds three corners of a rectangle and checks that the phantom fourth key is not reported.
+static void check_ghosting(void) {
+    MatrixSim sim;
+    MatrixScanner scanner;
+    matrix_sim_init(&sim, 400000);
+    I2cBus bus = matrix_sim_bus(&sim);
+    matrix_scan_init(&scanner, &bus);
+
+    int reported = 0;
+    KeyEvent events[8];
+    const int corners[3][2] = { { 2, 1 }, { 2, 2 }, { 3, 1 } };  // q, w, a; s is the phantom
+    for (int k = 0; k < 3; k++) {
+        matrix_sim_set_key(&sim, corners[k][0], corners[k][1], true);
+        for (int i = 0; i < 10; i++) {
+            reported += (int)matrix_scan_run(&scanner, 0, events, 8);
+        }
+    }
+    bool phantom = (scanner.stable[3] >> 2) & 1u;
+    printf("ghosting: %d of 3 held keys reported, phantom key %s, %u ghost scans\n",
+           reported, phantom ? "REPORTED" : "blocked", scanner.stats.ghost_scans);
+}
+
+int main(void) {
+    printf("%12s %10s %10s %10s %10s %10s %10s\n", "I2C clock", "idle us", "active us", "scans/s",
+           "host ns", "avg ms", "worst ms");
+    const uint32_t clocks[] = { 100000, 400000, 1000000, 1700000 };
+    for (size_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++) {
+        bench_clock(clocks[i]);
+    }
+    check_ghosting();
+    return 0;
+}
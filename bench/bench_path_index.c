@@ -0,0 +1,136 @@
+// bench_path_index.c
+//
+// Builds a path index of a synthetic card (folders of notes, a few levels
+// deep) on the RAM disk behind the SPI SD card emulator and compares it with
+// loading the index saved at the previous start, which only reads the stamp
+// of each folder. Then times typing and erasing a query one character at a
+// time, the way Find is used. Each step is compared with filtering the whole
+// index again from scratch, which is what a search without the narrowed
+// candidate list would do on every key.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "path_index.h"
+#include "hal_interface.h"
+#include "hal_mock_storage.h"
+#include "ram_disk.h"
+#include "sd_sim.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define FOLDERS 40
+#define SUBFOLDERS 5
+#define FILES_PER_FOLDER 40
+#define REPEAT 20
+#define INDEX_FILE "/paths.idx"
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void make_card(void) {
+    static const char *topics[] = { "meeting", "draft", "journal", "recipe", "todo", "letter", "idea", "chapter" };
+    char path[256];
+    for (int f = 0; f < FOLDERS; f++) {
+        snprintf(path, sizeof(path), "/project_%02d", f);
+        hal_storage_create_directory(path);
+        for (int s = 0; s < SUBFOLDERS; s++) {
+            snprintf(path, sizeof(path), "/project_%02d/part_%d", f, s);
+            hal_storage_create_directory(path);
+            for (int n = 0; n < FILES_PER_FOLDER; n++) {
+                snprintf(path, sizeof(path), "/project_%02d/part_%d/%s_%03d.txt", f, s, topics[(f + s + n) % 8], n);
+                hal_storage_create_file(path);
+            }
+        }
+    }
+}
+
+// Runs one way of getting the index at startup on the emulated card.
+static void time_startup(const char *label, PathIndex *index, bool load) {
+    sd_sim_reset_stats();
+    double t0 = now_ns();
+    bool changed;
+    bool ok = load ? path_index_load(index, INDEX_FILE, &changed) : path_index_build(index, "/");
+    double elapsed = now_ns() - t0;
+    SdSimStats card = sd_sim_stats();
+    printf("%-28s %8s %8.1f ms %6u card operations\n", label, ok ? "ok" : "FAILED", elapsed / 1e6, card.operations);
+}
+
+int main(void) {
+    PathIndex index;
+    PathQuery query = { 0 };
+    path_index_init(&index);
+    hal_mock_storage_set_backend(&ram_disk_backend);
+    make_card();
+
+    SdSimTiming timing;
+    sd_sim_profile("spi", &timing);
+    sd_sim_init(&ram_disk_backend, &timing);
+    hal_mock_storage_set_backend(&sd_sim_backend);
+    time_startup("build by listing every folder", &index, false);
+    path_index_save(&index, INDEX_FILE);
+    time_startup("load the saved index", &index, true);
+    hal_storage_create_file("/project_07/part_2/late_note.txt");
+    time_startup("load after one new file", &index, true);
+    printf("%zu paths, %zu bytes of names\n\n", index.count, index.names_used);
+
+    const char *text = "p12journal07";
+    size_t length = strlen(text);
+    uint32_t best[16];
+
+    printf("%-14s %10s %14s %14s\n", "query", "matches", "narrowed us", "rescan us");
+    for (size_t n = 1; n <= length; n++) {
+        // Narrowed: one push on top of the previous query, then ranking
+        double narrowed = 0;
+        double rescan = 0;
+        size_t matches = 0;
+        for (int r = 0; r < REPEAT; r++) {
+            path_query_reset(&query, &index);
+            for (size_t i = 0; i + 1 < n; i++) {
+                path_query_push(&query, &index, text[i]);
+            }
+            double t0 = now_ns();
+            path_query_push(&query, &index, text[n - 1]);
+            path_query_best(&query, best, 16);
+            narrowed += now_ns() - t0;
+            matches = path_query_match_count(&query);
+
+            // Rescan: the whole query against every path
+            t0 = now_ns();
+            path_query_reset(&query, &index);
+            for (size_t i = 0; i < n; i++) {
+                path_query_push(&query, &index, text[i]);
+            }
+            path_query_best(&query, best, 16);
+            rescan += now_ns() - t0;
+        }
+        printf("%-14.*s %10zu %14.1f %14.1f\n", (int)n, text, matches, narrowed / REPEAT / 1000,
+               rescan / REPEAT / 1000);
+    }
+
+    // Backspace steps back to the previous candidate set and rescores it
+    double t0 = now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        path_query_reset(&query, &index);
+        for (size_t i = 0; i < length; i++) {
+            path_query_push(&query, &index, text[i]);
+        }
+    }
+    double typing = (now_ns() - t0) / REPEAT;
+    t0 = now_ns();
+    path_query_pop(&query, &index);
+    path_query_best(&query, best, 16);
+    double pop = now_ns() - t0;
+    printf("whole query typed: %.1f us, one backspace: %.1f us\n", typing / 1000, pop / 1000);
+
+    char path[256];
+    path_index_path(&index, best[0], path, sizeof(path));
+    printf("best match for \"%.*s\": %s\n", (int)length - 1, text, path);
+
+    path_query_free(&query);
+    path_index_free(&index);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// bench_pixel_kernels.c
+//
+// Checks every fast pixel kernel against its scalar reference and reports
+// the throughput of both in megapixels per second, on buffers the size of
+// the 960x320 screen.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pixel_kernels.h"
+#include "font_8x16.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SCREEN_PIXELS (960 * 320)
+#define ROUNDS 50
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static RenderPixel pixels[SCREEN_PIXELS];
+static RenderPixel pixels_check[SCREEN_PIXELS];
+static uint8_t panel[SCREEN_PIXELS * PANEL_BYTES_PER_PIXEL];
+static uint8_t panel_check[SCREEN_PIXELS * PANEL_BYTES_PER_PIXEL];
+static uint32_t coverage[SCREEN_PIXELS / 8];
+static PixelShades shades;
+
+static void report(const char *name, double fast_ns, double scalar_ns, bool same) {
+    double pixels_done = (double)SCREEN_PIXELS * ROUNDS;
+    printf("  %-22s %10.1f %10.1f %8.1fx  %s\n", name, pixels_done / fast_ns * 1e3, pixels_done / scalar_ns * 1e3,
+           scalar_ns / fast_ns, same ? "ok" : "MISMATCH");
+}
+
+static void bench_convert(void) {
+    // Every 16-bit value first, then a screen of glyph pixels
+    for (uint32_t v = 0; v < 65536; v++) {
+        uint8_t bytes[2] = { (uint8_t)(v >> 8), (uint8_t)v };
+        memcpy(&pixels[v], bytes, 2);
+    }
+    pixel_convert_rgb666(panel, pixels, 65536);
+    pixel_convert_rgb666_scalar(panel_check, pixels, 65536);
+    bool same = memcmp(panel, panel_check, 65536 * PANEL_BYTES_PER_PIXEL) == 0;
+
+    pixel_expand_4bpp(pixels, coverage, SCREEN_PIXELS / 8, &shades);
+    double t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        pixel_convert_rgb666(panel, pixels, SCREEN_PIXELS);
+    }
+    double fast = now_ns() - t0;
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        pixel_convert_rgb666_scalar(panel_check, pixels, SCREEN_PIXELS);
+    }
+    double scalar = now_ns() - t0;
+    report("RGB565 to RGB666", fast, scalar, same && memcmp(panel, panel_check, sizeof(panel)) == 0);
+}
+
+static void bench_fill(void) {
+    RenderPixel paper = shades.shades[0];
+    double t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        pixel_fill(pixels + (r & 1), paper, SCREEN_PIXELS - 1); // Odd start and length
+    }
+    double fast = now_ns() - t0;
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        pixel_fill_scalar(pixels_check + (r & 1), paper, SCREEN_PIXELS - 1);
+    }
+    double scalar = now_ns() - t0;
+    report("fill", fast, scalar, memcmp(pixels, pixels_check, sizeof(pixels)) == 0);
+}
+
+static void bench_expand(void) {
+    double t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        pixel_expand_4bpp(pixels, coverage, SCREEN_PIXELS / 8, &shades);
+    }
+    double fast = now_ns() - t0;
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        pixel_expand_4bpp_scalar(pixels_check, coverage, SCREEN_PIXELS / 8, &shades);
+    }
+    double scalar = now_ns() - t0;
+    report("4-bit glyph expansion", fast, scalar, memcmp(pixels, pixels_check, sizeof(pixels)) == 0);
+}
+
+int main(void) {
+    pixel_shades_init(&shades, 0x101010, 0xE8E8E0);
+    // A screen of glyph rows, cycling through the font
+    const uint32_t *font = &font_8x16[0][0];
+    for (size_t i = 0; i < SCREEN_PIXELS / 8; i++) {
+        coverage[i] = font[i % (FONT_GLYPH_COUNT * FONT_GLYPH_HEIGHT)];
+    }
+
+    printf("%d pixels x %d rounds\n", SCREEN_PIXELS, ROUNDS);
+    printf("  %-22s %10s %10s %9s\n", "kernel", "fast MP/s", "scalar", "speedup");
+    bench_convert();
+    bench_fill();
+    bench_expand();
+    return 0;
+}
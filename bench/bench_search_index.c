@@ -0,0 +1,153 @@
+// bench_search_index.c
+//
+// Writes a synthetic corpus of documents to a mock SD card in a temporary
+// directory, indexes it through the mock HAL and reports the index size, the
+// latency of queries for rare, common and combined words, and the cost of
+// re-indexing one saved document. Word frequencies follow a Zipf distribution
+// like natural text. The mock HAL logs every file operation on stderr.
+
+#define _DEFAULT_SOURCE
+
+#include "search_index.h"
+#include "hal_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DOCUMENTS 1000
+#define DOCUMENT_BYTES 32768
+#define VOCABULARY 20000
+#define QUERY_REPEAT 50
+
+static char words[VOCABULARY][12];
+static double cumulative[VOCABULARY];
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void make_vocabulary(void) {
+    static const char *syllables[] = { "ka", "lo", "mi", "ne", "su", "ta", "ri", "po", "da", "ve", "zu", "ho" };
+    double total = 0;
+    for (int w = 0; w < VOCABULARY; w++) {
+        int n = w;
+        words[w][0] = '\0';
+        do {
+            strcat(words[w], syllables[n % 12]);
+            n /= 12;
+        } while (n > 0);
+        total += 1.0 / (w + 1);
+        cumulative[w] = total;
+    }
+    for (int w = 0; w < VOCABULARY; w++) {
+        cumulative[w] /= total;
+    }
+}
+
+static const char *random_word(void) {
+    double r = (double)rand() / RAND_MAX;
+    int low = 0, high = VOCABULARY - 1;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (cumulative[mid] < r) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return words[low];
+}
+
+static void write_document(const char *path) {
+    static char text[DOCUMENT_BYTES + 16];
+    size_t length = 0;
+    while (length < DOCUMENT_BYTES) {
+        length += (size_t)sprintf(text + length, "%s%s", random_word(), rand() % 12 == 0 ? ".\n" : " ");
+    }
+    hal_storage_create_file(path);
+    hal_storage_write_range(path, 0, text, length);
+}
+
+static void time_query(const char *query) {
+    SearchHit hits[16];
+    size_t found = 0;
+    double t0 = now_ns();
+    for (int r = 0; r < QUERY_REPEAT; r++) {
+        found = search_index_query(query, hits, 16);
+    }
+    printf("  %-24s %5zu hits %10.1f us\n", query, found, (now_ns() - t0) / QUERY_REPEAT / 1000);
+}
+
+int main(void) {
+    char root[] = "/tmp/bench_search_XXXXXX";
+    if (!mkdtemp(root) || chdir(root) != 0 || mkdir("sdcard", 0755) != 0) {
+        perror("setup");
+        return 1;
+    }
+    srand(1);
+    make_vocabulary();
+
+    char path[64];
+    for (int d = 0; d < DOCUMENTS; d++) {
+        snprintf(path, sizeof(path), "/doc_%04d.txt", d);
+        write_document(path);
+    }
+
+    search_index_open();
+    double t0 = now_ns();
+    for (int d = 0; d < DOCUMENTS; d++) {
+        snprintf(path, sizeof(path), "/doc_%04d.txt", d);
+        search_index_update(path);
+    }
+    search_index_commit();
+    double build_ms = (now_ns() - t0) / 1e6;
+
+    // Start from the files alone, as after a restart
+    search_index_close();
+    t0 = now_ns();
+    search_index_open();
+    double open_us = (now_ns() - t0) / 1000;
+
+    SearchIndexStats stats = search_index_stats();
+    double text_mb = (double)DOCUMENTS * DOCUMENT_BYTES / (1024 * 1024);
+    printf("%u documents, %.1f MB of text\n", stats.documents, text_mb);
+    printf("build %.0f ms (%u merges), open %.0f us\n", build_ms, stats.merges, open_us);
+    printf("main segment %u terms, %.2f MB (%.1f%% of the text), %u postings in the delta\n",
+           stats.main_terms, stats.main_bytes / (1024.0 * 1024), 100.0 * stats.main_bytes / (text_mb * 1024 * 1024),
+           stats.delta_postings);
+
+    printf("queries:\n");
+    time_query(words[0]);                   // In every document
+    time_query(words[50]);
+    time_query(words[5000]);                // In a few documents
+    time_query(words[VOCABULARY - 1]);
+    char pair[64];
+    snprintf(pair, sizeof(pair), "%s %s", words[0], words[2000]);
+    time_query(pair);
+    snprintf(pair, sizeof(pair), "%s %s", words[300], words[400]);
+    time_query(pair);
+    time_query("notaword");
+
+    // Saving a document re-indexes only that document
+    snprintf(path, sizeof(path), "/doc_%04d.txt", 7);
+    write_document(path);
+    t0 = now_ns();
+    search_index_update(path);
+    search_index_commit();
+    printf("re-index one %d byte document: %.0f us\n", DOCUMENT_BYTES, (now_ns() - t0) / 1000);
+
+    search_index_close();
+
+    // Remove the corpus
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf %s", root);
+    if (chdir("/") != 0 || system(command) != 0) {
+        printf("could not remove %s\n", root);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+// bench_text_renderer.c
+//
+// Drives the glyph-atlas renderer of the ESP32-S3 display port on Linux, with
+// the mock PPM panel as its flush target. Measures how fast whole screens of
+// glyphs are drawn and how many pixels reach the panel per keystroke when the
+// editor screen is updated through the virtual screen. The last frame is
+// saved as a PPM file if a path is given.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "text_renderer.h"
+#include "ppm_panel.h"
+#include "virtual_screen.h"
+#include "hal_interface.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SCREEN_FRAMES 2000
+#define KEYSTROKES 2000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// The display HAL of the ESP32-S3 port, without the SPI panel.
+void hal_display_clear(void) { text_renderer_clear(); }
+void hal_display_write(const char *text) { text_renderer_write(text); }
+void hal_display_set_cursor(int line, int column) { text_renderer_set_cursor(line, column); }
+void hal_display_flush(void) { text_renderer_flush(); }
+
+// Every cell changes on every frame: the cost of drawing glyphs, and of
+// flushing the whole screen (converted to RGB666 by the mock panel).
+static void bench_full_screens(void) {
+    static char line[VSCREEN_COLS + 1];
+    TextRendererStats before = text_renderer_stats();
+    double draw_ns = 0;
+    double flush_ns = 0;
+    for (int frame = 0; frame < SCREEN_FRAMES; frame++) {
+        double t0 = now_ns();
+        for (int row = 0; row < VSCREEN_ROWS; row++) {
+            for (int col = 0; col < VSCREEN_COLS; col++) {
+                line[col] = (char)('!' + (frame + row + col) % 94);
+            }
+            text_renderer_set_cursor(row, 0);
+            text_renderer_write(line);
+        }
+        double t1 = now_ns();
+        text_renderer_flush();
+        draw_ns += t1 - t0;
+        flush_ns += now_ns() - t1;
+    }
+    TextRendererStats after = text_renderer_stats();
+
+    uint32_t glyphs = after.glyphs_drawn - before.glyphs_drawn;
+    printf("  full screens:  %u glyphs, %.1f M glyphs/s drawn, flush %.0f us/frame, %.0f frames/s\n", glyphs,
+           glyphs / draw_ns * 1e3, flush_ns / 1e3 / SCREEN_FRAMES, SCREEN_FRAMES / ((draw_ns + flush_ns) / 1e9));
+}
+
+// Types into an editor screen: one character per frame, cursor underlined.
+static void bench_typing(void) {
+    static char text[VSCREEN_COLS * 12];
+    static const char words[] = "the quick brown fox jumps over the lazy dog ";
+    size_t length = 0;
+
+    vscreen_init();
+    text_renderer_flush();
+    TextRendererStats before = text_renderer_stats();
+    double t0 = now_ns();
+    for (int key = 0; key < KEYSTROKES; key++) {
+        if (length + 2 >= sizeof(text)) {
+            length = 0;
+        }
+        text[length++] = (key + 1) % 97 == 0 ? '\n' : words[key % (sizeof(words) - 1)];
+
+        vscreen_begin_frame();
+        vscreen_write("Editing /notes.txt\n");
+        vscreen_write_span(text, length);
+        vscreen_write("\033[4m \033[0m");
+        vscreen_flush();
+    }
+    double seconds = (now_ns() - t0) / 1e9;
+    TextRendererStats after = text_renderer_stats();
+
+    uint64_t pixels = after.pixels_flushed - before.pixels_flushed;
+    uint32_t rects = after.rects_flushed - before.rects_flushed;
+    printf("  typing:        %.0f pixels/keystroke in %.2f rects (full screen %d), %.2f us/keystroke\n",
+           (double)pixels / KEYSTROKES, (double)rects / KEYSTROKES, TEXT_RENDERER_WIDTH * TEXT_RENDERER_HEIGHT,
+           seconds * 1e6 / KEYSTROKES);
+}
+
+int main(int argc, char **argv) {
+    double t0 = now_ns();
+    text_renderer_init(ppm_panel_flush);
+    printf("%dx%d panel, %dx%d cells, atlas built in %.1f us\n", TEXT_RENDERER_WIDTH, TEXT_RENDERER_HEIGHT,
+           VSCREEN_COLS, VSCREEN_ROWS, (now_ns() - t0) / 1e3);
+
+    bench_full_screens();
+    bench_typing();
+
+    if (argc > 1) {
+        printf("  last frame:    %s%s\n", argv[1], ppm_panel_save(argv[1]) ? "" : " (could not write)");
+    }
+    return 0;
+}
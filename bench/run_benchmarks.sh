@@ -0,0 +1,53 @@
+#!/bin/sh
+# Builds and runs the microbenchmarks with optimizations on.
+# Usage: bench/run_benchmarks.sh
+set -e
+cd "$(dirname "$0")/.."
+mkdir -p build
+
+CFLAGS="-std=c11 -O2 -Isrc"
+
+echo "== Editor frame composition =="
+gcc $CFLAGS bench/bench_editor_frame.c src/frame_builder.c -o build/bench_editor_frame
+./build/bench_editor_frame
+
+echo
+echo "== Keyboard matrix scan (simulated MCP23017 bus) =="
+gcc $CFLAGS bench/bench_matrix_scan.c src/matrix_scan.c src/matrix_sim.c -o build/bench_matrix_scan
+./build/bench_matrix_scan
+
+echo
+echo "== Path index type-ahead =="
+gcc $CFLAGS bench/bench_path_index.c src/path_index.c src/hal_mock_storage.c src/host_storage.c src/ram_disk.c src/sd_sim.c src/fat_volume.c src/block_image.c -o build/bench_path_index -pthread
+./build/bench_path_index 2>/dev/null
+
+echo
+echo "== Full-text search index (mock SD card) =="
+gcc $CFLAGS bench/bench_search_index.c src/search_index.c src/hal_mock.c src/hal_mock_storage.c src/host_storage.c src/ram_disk.c src/sd_sim.c src/fat_volume.c src/block_image.c src/key_queue.c src/text_renderer.c src/pixel_kernels.c src/font_8x16.c src/ppm_panel.c src/flush_pipeline.c src/flush_sim.c -o build/bench_search_index -pthread
+./build/bench_search_index 2>/dev/null
+
+echo
+echo "== Delta saves (mock SD card) =="
+gcc $CFLAGS bench/bench_delta_save.c src/paged_document.c src/side_file.c src/editor_buffer.c src/line_index.c src/hal_mock.c src/hal_mock_storage.c src/host_storage.c src/ram_disk.c src/sd_sim.c src/fat_volume.c src/block_image.c src/key_queue.c src/text_renderer.c src/pixel_kernels.c src/font_8x16.c src/ppm_panel.c src/flush_pipeline.c src/flush_sim.c -o build/bench_delta_save -pthread
+./build/bench_delta_save 2>/dev/null
+
+echo
+echo "== Glyph-atlas text renderer (mock PPM panel) =="
+gcc $CFLAGS bench/bench_text_renderer.c src/text_renderer.c src/pixel_kernels.c src/font_8x16.c src/ppm_panel.c src/virtual_screen.c -o build/bench_text_renderer
+./build/bench_text_renderer build/bench_text_renderer.ppm
+
+echo
+echo "== Display flush pipeline (simulated transfer engine) =="
+gcc $CFLAGS bench/bench_flush_pipeline.c src/flush_pipeline.c src/flush_sim.c src/text_renderer.c src/pixel_kernels.c src/font_8x16.c src/ppm_panel.c src/virtual_screen.c -o build/bench_flush_pipeline -pthread
+./build/bench_flush_pipeline
+
+echo
+echo "== Pixel kernels (RGB666 conversion, fill, glyph expansion) =="
+gcc $CFLAGS bench/bench_pixel_kernels.c src/pixel_kernels.c src/font_8x16.c -o build/bench_pixel_kernels
+./build/bench_pixel_kernels
+
+echo
+echo "== Key replay on an emulated SD card (SPI bus profile) =="
+CORE="src/cybertyper_core.c src/editor_buffer.c src/paged_document.c src/side_file.c src/line_index.c src/virtual_screen.c src/frame_builder.c src/dir_cache.c src/path_index.c src/search_index.c src/storage_worker.c src/edit_journal.c src/undo_log.c"
+gcc $CFLAGS tests/test_cybertyper.c $CORE src/hal_mock_storage.c src/host_storage.c src/ram_disk.c src/sd_sim.c src/fat_volume.c src/block_image.c -o build/test_cybertyper -pthread
+./build/test_cybertyper --sd spi tests/traces/*.keys 2>/dev/null
@@ -1,3 +1,3 @@
-gcc -std=c11 src/main.c src/cybertyper_core.c src/hal_mock.c -o cybertyper_test
+gcc -std=c11 src/main.c src/cybertyper_core.c src/editor_buffer.c src/paged_document.c src/side_file.c src/line_index.c src/virtual_screen.c src/frame_builder.c src/dir_cache.c src/path_index.c src/search_index.c src/storage_worker.c src/edit_journal.c src/undo_log.c src/key_queue.c src/hal_mock.c src/hal_mock_storage.c src/host_storage.c src/ram_disk.c src/sd_sim.c src/fat_volume.c src/block_image.c src/text_renderer.c src/font_8x16.c src/ppm_panel.c src/flush_pipeline.c src/flush_sim.c src/pixel_kernels.c src/perf_stats.c -o cybertyper_test -pthread
 stty -ixon
-./cybertyper_test
\ No newline at end of file
+./cybertyper_test 2> mock_hal.log
\ No newline at end of file
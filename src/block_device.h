@@ -0,0 +1,29 @@
+#ifndef BLOCK_DEVICE_H
+#define BLOCK_DEVICE_H
+
+#include "hal_interface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct BlockDevice
+ * @brief A card as numbered HAL_STORAGE_BLOCK_SIZE sectors.
+ *
+ * What a FAT driver sits on: the SDMMC or SDSPI driver on the device, an
+ * image file on Linux. Multi-sector transfers are one command each, as
+ * CMD18/CMD25 are on the card.
+ */
+typedef struct {
+    const char *name;
+
+    /** Sectors on the device. */
+    uint32_t (*sector_count)(void);
+
+    /** Reads count sectors starting at lba. */
+    bool (*read)(uint32_t lba, uint32_t count, uint8_t *buffer);
+
+    /** Writes count sectors starting at lba. */
+    bool (*write)(uint32_t lba, uint32_t count, const uint8_t *buffer);
+} BlockDevice;
+
+#endif // BLOCK_DEVICE_H
@@ -0,0 +1,86 @@
+// block_image.c
+//
+// A block device on a disk image file, read and written with pread/pwrite
+// so every transfer is one system call, as it is one command on the card.
+
+#define _POSIX_C_SOURCE 200809L // pread, pwrite, ftruncate
+
+#include "block_image.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int image_fd = -1;
+static uint32_t image_sectors = 0;
+
+// -----------------------------------------------------------------------------
+/* Block Device */
+// -----------------------------------------------------------------------------
+
+static uint32_t image_sector_count(void) {
+    return image_sectors;
+}
+
+static bool image_read(uint32_t lba, uint32_t count, uint8_t *buffer) {
+    if (image_fd < 0 || lba > image_sectors || count > image_sectors - lba) {
+        return false;
+    }
+    size_t length = (size_t)count * HAL_STORAGE_BLOCK_SIZE;
+    return pread(image_fd, buffer, length, (off_t)lba * HAL_STORAGE_BLOCK_SIZE) == (ssize_t)length;
+}
+
+static bool image_write(uint32_t lba, uint32_t count, const uint8_t *buffer) {
+    if (image_fd < 0 || lba > image_sectors || count > image_sectors - lba) {
+        return false;
+    }
+    size_t length = (size_t)count * HAL_STORAGE_BLOCK_SIZE;
+    return pwrite(image_fd, buffer, length, (off_t)lba * HAL_STORAGE_BLOCK_SIZE) == (ssize_t)length;
+}
+
+const BlockDevice block_image_device = {
+    "image", image_sector_count, image_read, image_write,
+};
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+bool block_image_open(const char *path) {
+    block_image_close();
+    int fd = open(path, O_RDWR);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    image_fd = fd;
+    image_sectors = (uint32_t)(st.st_size / HAL_STORAGE_BLOCK_SIZE);
+    return true;
+}
+
+bool block_image_create(const char *path, uint32_t sectors) {
+    block_image_close();
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0 || ftruncate(fd, (off_t)sectors * HAL_STORAGE_BLOCK_SIZE) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    image_fd = fd;
+    image_sectors = sectors;
+    return true;
+}
+
+void block_image_close(void) {
+    if (image_fd >= 0) {
+        close(image_fd);
+        image_fd = -1;
+        image_sectors = 0;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef BLOCK_IMAGE_H
+#define BLOCK_IMAGE_H
+
+#include "block_device.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief A disk image file as the block device.
+ *
+ * Usable once block_image_open or block_image_create has succeeded.
+ */
+extern const BlockDevice block_image_device;
+
+/**
+ * @brief Opens an existing image; its size gives the sector count.
+ *
+ * @return false if the file cannot be opened read-write.
+ */
+bool block_image_open(const char *path);
+
+/**
+ * @brief Creates an image of sectors zeroed sectors and opens it.
+ *
+ * The file is sparse, so a large card only takes the space written to it.
+ */
+bool block_image_create(const char *path, uint32_t sectors);
+
+/**
+ * @brief Closes the image.
+ */
+void block_image_close(void);
+
+#endif // BLOCK_IMAGE_H
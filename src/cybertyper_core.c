@@ -1,42 +1,103 @@
 #include "cybertyper_core.h"
 #include "hal_interface.h"
+#include "paged_document.h"
+#include "virtual_screen.h"
+#include "frame_builder.h"
+#include "dir_cache.h"
+#include "path_index.h"
+#include "search_index.h"
+#include "storage_worker.h"
+#include "edit_journal.h"
+#include "undo_log.h"
+#include "perf_stats.h"
+#include "side_file.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
-#include <time.h>      // Added for timing functions
+#include <stdint.h>
 
-#define MAX_FILES 50
-#define MAX_FILENAME_LEN 64
 #define MAX_PATH_LEN 512
 #define INPUT_BUFFER_SIZE 128
-#define MAX_FILE_CONTENT_SIZE 1024
+#define EDITOR_VIEW_ROWS (VSCREEN_ROWS - 3)   // Screen rows of text, between the header and the status row
+#define EDITOR_VIEW_SIZE (EDITOR_VIEW_ROWS * (VSCREEN_COLS + 1))   // Characters in a full view, newlines included
 #define MAX_COLUMNS 10
+#define COLUMN_WIDTH 30              // Screen cells per explorer column
+#define COLUMN_VIEW_ROWS 16          // Entries shown per explorer column
+#define VISIBLE_COLUMNS (VSCREEN_COLS / COLUMN_WIDTH)
+#define CURSOR_BLINK_MS 500          // Editor cursor blink half-period
+#define KEY_BATCH_SIZE 32            // Key events read from the HAL at a time
+#define SNIPPET_LEN 60               // Text shown around a search hit
+#define SNIPPET_LEAD 20              // Of which before the hit
+#define EDITOR_READ_AHEAD 2          // Blocks read in the background when a file is opened
+#define PATH_INDEX_FILE SEARCH_INDEX_DIR "/paths.idx"   // The path index, saved at startup
 
 
 //File Explorer
 
 // Is a single column of the File Explorer
+// Entries are not stored here: only the visible window is fetched from the
+// directory cache, chunk by chunk, so directory size does not matter.
 typedef struct {
     char directory[MAX_PATH_LEN];                // Current directory path
-    char file_list[MAX_FILES][MAX_FILENAME_LEN]; // List of files/folders in the directory
-    size_t file_count;                           // Number of files/folders
     size_t selected_index;                       // Currently selected index within the directory
+    size_t scroll_offset;                        // Index of the first entry shown
 } DirectoryColumn;
 
 // Global arrays and counters manage multiple columns for navigation.
 static DirectoryColumn columns[MAX_COLUMNS];
 static size_t column_count = 1;      // Start with root directory
 static size_t focused_column = 0;    // Currently focused column (0 = leftmost)
+static DirEntry column_window[COLUMN_VIEW_ROWS]; // Scratch for the visible entries of one column
+
+// Find (F1): type-ahead search over every path on the card
+static PathIndex path_index;                     // Built at init, kept current by the commit functions
+static PathQuery path_query;                     // Narrowed with each typed character
+static uint32_t find_results[COLUMN_VIEW_ROWS];  // Best matches of the current query
+static size_t find_result_count = 0;
+static size_t find_selected = 0;
+
+// Search (Ctrl+F): full-text search through the index on the card
+static SearchHit search_hits[COLUMN_VIEW_ROWS];
+static char search_snippets[COLUMN_VIEW_ROWS][SNIPPET_LEN + 1];
+static size_t search_hit_count = 0;
+static size_t search_selected = 0;
+static bool search_done = false;                 // search_hits are for the query as typed
+static uint32_t search_ms = 0;                   // Duration of the last query
 
 //Editor-related globals.
 /*Improvement: 
 Move editor state into a separate editor-focused module. Provide functions to initialize,
 load, save, and manipulate files. This keeps core.c
 smaller and more focused.*/
-static char edit_filename[MAX_FILENAME_LEN];
-static char edit_buffer[MAX_FILE_CONTENT_SIZE];
-static size_t edit_length = 0;
-static size_t edit_cursor_pos = 0; // Position within edit_buffer
+static PagedDocument edit_doc;     // Open document, only pages near the view are resident
+static size_t edit_cursor = 0;     // Cursor position within edit_doc
+static size_t edit_view_top = 0;   // Start of the first visible screen row
+
+// Storage work on the open document runs on the storage worker; the editor
+// keeps taking keys while it runs. Completions are collected in run_cycle.
+typedef enum {
+    JOB_COMMIT,        // Appends a JournalGroup to the journal
+    JOB_COMPACT,       // Writes compaction.snapshot and its marker
+    JOB_READ_AHEAD,    // Reads one block of read_ahead
+    JOB_CLOSE,         // Folds the journal of closed_path into the file
+    JOB_INDEX          // Re-indexes the saved document for search, or writes the index after a rename
+} StorageJobTag;
+
+// Saving appends the edits to edit_journal; the whole document is only
+// rewritten (compacted) once the journal has grown.
+static EditJournal edit_journal;
+static UndoLog undo_log;                           // Ctrl+Z / Ctrl+Y history of the open document
+static struct {
+    DocSnapshot snapshot;                          // Document content being written
+    JournalGroup marker;                           // Journal marker, after the content or before a patch
+    bool has_marker;                               // false when the journal is broken and dropped
+} compaction;
+static bool compaction_pending = false;            // compaction is being written
+static bool save_again = false;                    // Ctrl+S needs a compaction while one is pending
+static char closed_path[MAX_PATH_LEN];             // Document closed with a journal to fold in
+static DocBlock read_ahead[EDITOR_READ_AHEAD];     // Text around the cursor of a file being opened
+static size_t edit_loading = 0;                    // Read-ahead blocks still awaited before showing text
 
 //Application state machine.
 /*Improvement:
@@ -47,7 +108,10 @@ typedef enum {
     STATE_RENAME,
     STATE_NEW_FOLDER,
     STATE_NEW_FILE,    
-    STATE_EDITING
+    STATE_EDITING,
+    STATE_FIND,
+    STATE_SEARCH,
+    STATE_PERF         // Stats overlay, only with CYBERTYPER_PERF
 } AppState;
 
 // Restore the 'initialized' variable
@@ -60,13 +124,23 @@ static AppState current_state = STATE_NORMAL;
 static char input_buffer[INPUT_BUFFER_SIZE];
 static size_t input_len = 0;
 
+// Screen to draw once the current batch of events has been handled
+static void (*pending_redraw)(void) = NULL;
+
+// Worst delay between a key being captured and being handled
+static uint32_t max_input_delay_ms = 0;
+
 // Variables for cursor blinking
 static bool cursor_visible = true;         // Cursor visibility state
-static time_t last_toggle_time;            // Last time the cursor visibility was toggled
+static uint32_t next_blink_ms;             // hal_time_ms() deadline of the next blink
 
 // Function prototypes
 static void display_columns(void);
 static void load_directory(size_t col, const char *dir);
+static size_t column_entries(size_t col, size_t start, DirEntry *entries, size_t max);
+static bool column_selected_entry(size_t col, DirEntry *entry);
+static void column_scroll_to_selection(size_t col);
+static bool column_entry_path(size_t col, const char *name, char *out, size_t size);
 static void enter_rename_mode(void);
 static void enter_new_folder_mode(void);
 static void enter_new_file_mode(void);      // NEW
@@ -83,7 +157,28 @@ static void handle_new_file_input(KeyCode key);             // NEW
 static void enter_edit_mode(const char *filename);
 static void display_editor_screen(void);
 static void handle_editor_input(KeyCode key);
+static void editor_scroll_to_cursor(void);
+static void restart_cursor_blink(void);
+static void request_redraw(void (*screen)(void));
 static void handle_normal_navigation(KeyCode key);           // NEW: Extracted handler
+static void enter_find_mode(void);
+static void display_find_screen(void);
+static void handle_find_input(KeyCode key);
+static void build_search_index(void);
+static void enter_search_mode(void);
+static void display_search_screen(void);
+static void handle_search_input(KeyCode key);
+static void start_save(void);
+static void handle_storage_job(const StorageJob *job);
+static void finish_storage_jobs(void);
+static void submit_storage_job(StorageJobFn run, void *context, int tag);
+static bool run_close(void *context);
+static bool recover_journals(void);
+#ifdef CYBERTYPER_PERF
+static void enter_perf_mode(void);
+static void display_perf_screen(void);
+static void handle_perf_input(KeyCode key);
+#endif
 
 
 
@@ -97,12 +192,43 @@ static void handle_normal_navigation(KeyCode key);           // NEW: Extracted h
 	•	Move file/directory initialization into a navigation_init() function.
 	•	Move display clearing and initial UI write into a ui_init() function.*/
 void cybertyper_init(void) {
-    hal_display_clear();
+    vscreen_init();
+    dir_cache_init();
+    path_index_init(&path_index);
+    // The search index folder is the application's own: never listed or found
+    dir_cache_hide(SEARCH_INDEX_DIR);
+    path_index_hide(&path_index, SEARCH_INDEX_DIR);
+
+    // Without the worker, saves and loads simply run in the core
+    storage_worker_start();
 
     if (hal_system_is_wakeup_from_sleep()) {
-        hal_display_write("Woke from sleep\n");
+        vscreen_set_status("Woke from sleep");
     } else {
-        hal_display_write("Cold start\n");
+        vscreen_set_status("Cold start");
+    }
+
+    // Every path is indexed up front so Find never has to walk the card. The
+    // index saved at the last start is reused; only folders changed since are listed.
+    bool paths_changed;
+    if (!path_index_load(&path_index, PATH_INDEX_FILE, &paths_changed)) {
+        paths_changed = path_index_build(&path_index, "/");
+        if (!paths_changed) {
+            vscreen_set_status("Not enough memory to index every file.");
+        }
+    }
+
+    // The full-text index lives on the card; it is only built from scratch the first time
+    if (!search_index_open()) {
+        vscreen_set_status("Search index unreadable.");
+    } else if (search_index_needs_build()) {
+        build_search_index();
+    }
+
+    // Saves that never made it into their document file before power was lost
+    paths_changed = recover_journals() || paths_changed;
+    if (paths_changed) {
+        path_index_save(&path_index, PATH_INDEX_FILE);
     }
 
     // Initialize the first column with the root directory
@@ -113,50 +239,162 @@ void cybertyper_init(void) {
     display_columns();
 
     // Initialize cursor blinking variables
-    cursor_visible = true;
-    last_toggle_time = time(NULL);
+    restart_cursor_blink();
 
     initialized = true;
 }
 
-// Initialize the directory for a specific column  Populates a DirectoryColumn with files and subdirectories.
+// Initialize the directory for a specific column. Nothing is read here; entries are
+// fetched from the directory cache when the column is drawn or navigated.
 static void load_directory(size_t col, const char *dir) {
     if (col >= MAX_COLUMNS) return; // Safety check
     strncpy(columns[col].directory, dir, MAX_PATH_LEN);
     columns[col].directory[MAX_PATH_LEN - 1] = '\0';
-    columns[col].file_count = hal_storage_list_files(dir, columns[col].file_list, MAX_FILES);
     columns[col].selected_index = 0;
+    columns[col].scroll_offset = 0;
 }
 
-// Loads a file into edit_buffer and transitions to STATE_EDITING.
-/*Improvement:
-	•	Consider moving file reading and writing to a dedicated file I/O module.
-	•	Document what happens if hal_storage_read_file fails.
-	•	Handle large files exceeding buffer size more gracefully.*/
+// Reads entries start .. start + max - 1 of a column's directory through the cache.
+static size_t column_entries(size_t col, size_t start, DirEntry *entries, size_t max) {
+    return dir_cache_read(columns[col].directory, start, entries, max);
+}
+
+// Fetches the selected entry of a column; false if the directory is empty.
+static bool column_selected_entry(size_t col, DirEntry *entry) {
+    return column_entries(col, columns[col].selected_index, entry, 1) == 1;
+}
+
+// Moves the scroll offset just enough to keep the selection visible.
+static void column_scroll_to_selection(size_t col) {
+    DirectoryColumn *column = &columns[col];
+    if (column->selected_index < column->scroll_offset) {
+        column->scroll_offset = column->selected_index;
+    } else if (column->selected_index >= column->scroll_offset + COLUMN_VIEW_ROWS) {
+        column->scroll_offset = column->selected_index - COLUMN_VIEW_ROWS + 1;
+    }
+}
+
+// Builds the path of an entry of a column's directory the way the explorer shows it.
+// Returns false if it does not fit in size bytes.
+static bool column_entry_path(size_t col, const char *name, char *out, size_t size) {
+    size_t dir_len = strlen(columns[col].directory);
+    const char *separator = dir_len > 0 && columns[col].directory[dir_len - 1] == '/' ? "" : "/";
+    int length = snprintf(out, size, "%s%s%s", columns[col].directory, separator, name);
+    return length >= 0 && (size_t)length < size;
+}
+
+// Finds the position of name in a column's directory and selects it.
+static bool column_select_name(size_t col, const char *name, size_t length) {
+    size_t start = 0;
+    size_t count;
+    while ((count = column_entries(col, start, column_window, COLUMN_VIEW_ROWS)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (strncmp(column_window[i].name, name, length) == 0 && column_window[i].name[length] == '\0') {
+                columns[col].selected_index = start + i;
+                column_scroll_to_selection(col);
+                return true;
+            }
+        }
+        start += count;
+    }
+    return false;
+}
+
+// Opens the columns along path with each component selected, as if it had been
+// navigated to by hand. The entry itself ends up selected in the focused column.
+static bool reveal_path(const char *path) {
+    load_directory(0, "/");
+    column_count = 1;
+    focused_column = 0;
+
+    const char *component = path;
+    for (;;) {
+        while (*component == '/') {
+            component++;
+        }
+        const char *end = strchr(component, '/');
+        size_t length = end ? (size_t)(end - component) : strlen(component);
+        if (!column_select_name(focused_column, component, length)) {
+            return false;
+        }
+        if (!end) {
+            return true;
+        }
+
+        // Open the folder for the next component
+        if (column_count >= MAX_COLUMNS) {
+            return false;
+        }
+        char name[HAL_NAME_LEN];
+        char folder[MAX_PATH_LEN];
+        snprintf(name, sizeof(name), "%.*s", (int)length, component);
+        if (!column_entry_path(focused_column, name, folder, sizeof(folder))) {
+            return false;
+        }
+        load_directory(column_count, folder);
+        column_count++;
+        focused_column++;
+        component = end;
+    }
+}
+
+static bool run_read_ahead(void *context) {
+    return paged_doc_block_read(context);
+}
+
+// Opens a file as a paged document and transitions to STATE_EDITING.
+// Only the file size is read here. The blocks before the cursor are read by
+// the storage worker and the text is shown as soon as they arrive; other
+// pages are loaded when they are displayed. A missing file opens as an empty
+// document.
 static void enter_edit_mode(const char *filename) {
-    size_t col = focused_column;
-    strncpy(edit_filename, filename, MAX_FILENAME_LEN);
-    edit_filename[MAX_FILENAME_LEN - 1] = '\0';
+    // The file may still be written by the journal of its last edit
+    finish_storage_jobs();
+    // Editing would write a new journal over one that could not be replayed
+    bool applied;
+    if (!edit_journal_replay(filename, &applied)) {
+        vscreen_set_status("Saved changes of this file could not be applied; its journal was kept.");
+        request_redraw(display_columns);
+        return;
+    }
 
-    // Read file content into edit_buffer
-    int len = hal_storage_read_file(filename, edit_buffer, sizeof(edit_buffer));
-    if (len < 0) {
-        len = 0;
+    paged_doc_close(&edit_doc);
+    if (!paged_doc_open(&edit_doc, filename)) {
+        vscreen_set_status("Could not open file.");
+        request_redraw(display_columns);
+        return;
+    }
+    if (!edit_journal_open(&edit_journal, filename, paged_doc_length(&edit_doc))) {
+        edit_journal.broken = true; // Saves rewrite the whole file
+    }
+    undo_log_init(&undo_log);
+    edit_cursor = paged_doc_length(&edit_doc); // Start cursor at end of file
+    edit_view_top = 0;
+
+    // Read the end of the file, where the cursor is, then the block before it
+    edit_loading = 0;
+    size_t pos = edit_cursor;
+    for (size_t i = 0; i < EDITOR_READ_AHEAD; i++) {
+        if (!paged_doc_block_request(&edit_doc, pos, &read_ahead[i]) ||
+            !storage_worker_submit(run_read_ahead, &read_ahead[i], JOB_READ_AHEAD)) {
+            break;
+        }
+        edit_loading++;
+        if (read_ahead[i].start == 0) {
+            break;
+        }
+        pos = read_ahead[i].start - 1;
+    }
+    if (edit_loading == 0) {
+        editor_scroll_to_cursor();
     }
-    edit_buffer[len] = '\0';
-    edit_length = (size_t)len;
-    edit_cursor_pos = edit_length; // Start cursor at end of file
 
     current_state = STATE_EDITING;
-    hal_display_clear();
-    hal_display_write("Editing file: ");
-    hal_display_write(edit_filename);
-    hal_display_write("\nCtrl+S to save, Esc to exit editing.\n");
-    hal_display_write(edit_buffer);
 
     // Initialize cursor blinking
-    cursor_visible = true;
-    last_toggle_time = time(NULL);
+    restart_cursor_blink();
+
+    request_redraw(display_editor_screen);
 }
 
 // Clears the display and shows the directory columns, including the current selection, and instructions.
@@ -165,141 +403,264 @@ static void enter_edit_mode(const char *filename) {
 	•	Add comments explaining each step of the rendering process.
 	•	Make the column width a constant defined at the top.
     */
-static void display_columns(void) {
-    hal_display_clear();
-    char line[1024] = {0}; // Adjust size as needed
-
-    // Define column width for uniform spacing
-    const int column_width = 30;
-
-    // Determine the maximum number of entries across all columns
-    size_t max_entries = 0;
-    for (size_t i = 0; i < column_count; i++) {
-        if (columns[i].file_count > max_entries) {
-            max_entries = columns[i].file_count;
-        }
+// Writes prefix + text into one column cell, marking cut-off text with '~'.
+static void write_column_cell(int row, size_t slot, const char *prefix, const char *text) {
+    char cell[COLUMN_WIDTH];
+    int len = snprintf(cell, sizeof(cell), "%s%s", prefix, text);
+    if (len >= COLUMN_WIDTH - 1) {
+        cell[COLUMN_WIDTH - 2] = '~';
+        cell[COLUMN_WIDTH - 1] = '\0';
     }
+    vscreen_write_at(row, (int)(slot * COLUMN_WIDTH), cell, COLUMN_WIDTH - 1);
+}
 
-    // Print header for each column (directory path)
-    for (size_t i = 0; i < column_count; i++) {
-        snprintf(line, sizeof(line), "Dir: %s", columns[i].directory);
-        hal_display_write(line);
-        // Add spacing between columns
-        for (int j = strlen(line); j < column_width; j++) {
-            hal_display_write(" ");
-        }
-    }
-    hal_display_write("\n");
+static void display_columns(void) {
+    PERF_BEGIN(span);
+    vscreen_begin_frame();
+
+    // Show the rightmost columns that fit; the focused column is always the last one
+    size_t first = column_count > VISIBLE_COLUMNS ? column_count - VISIBLE_COLUMNS : 0;
 
-    // If all columns are empty, display a message
+    // Only the visible window of each column is fetched and drawn
     bool all_empty = true;
-    for (size_t i = 0; i < column_count; i++) {
-        if (columns[i].file_count > 0) {
+    for (size_t col = first; col < column_count; col++) {
+        size_t slot = col - first;
+        write_column_cell(0, slot, "Dir: ", columns[col].directory);
+
+        size_t scroll = columns[col].scroll_offset;
+        size_t count = column_entries(col, scroll, column_window, COLUMN_VIEW_ROWS);
+        if (count > 0) {
             all_empty = false;
-            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            // Highlight the selected item in the focused column with a '>' marker
+            bool selected = col == focused_column && scroll + i == columns[col].selected_index;
+            write_column_cell((int)(1 + i), slot, selected ? "> " : "  ", column_window[i].name);
         }
     }
 
+    vscreen_write("\n");
     if (all_empty) {
-        hal_display_write("This directory is empty.\n");
-        hal_display_write("\nUse F2 to create a new folder or Ctrl+N to create a new file.\n");
+        vscreen_write("This directory is empty.\n");
+        vscreen_write("\nUse F2 to create a new folder or Ctrl+N to create a new file.\n");
+        size_t cells = vscreen_flush();
+        PERF_END(span, PERF_COLUMNS_SCREEN, cells);
         return;
     }
 
-    // Print each row of the columns
-    for (size_t entry = 0; entry < max_entries; entry++) {
-        for (size_t col = 0; col < column_count; col++) {
-            if (entry < columns[col].file_count) {
-                // Check if this is the selected item in the focused column
-                if (col == focused_column && entry == columns[col].selected_index) {
-                    // Highlight the selected item (e.g., with a '>' marker)
-                    snprintf(line, sizeof(line), "> %s", columns[col].file_list[entry]);
-                } else {
-                    snprintf(line, sizeof(line), "  %s", columns[col].file_list[entry]);
-                }
-            } else {
-                // If the current column has fewer entries, display an empty line or a placeholder
-                snprintf(line, sizeof(line), "   ");
-            }
-
-            // Ensure uniform column width
-            size_t len = strlen(line);
-            if (len < column_width) {
-                memset(line + len, ' ', column_width - len);
-                line[column_width] = '\0';
-            }
-
-            hal_display_write(line);
-        }
-        hal_display_write("\n");
-    }
-
-    // Instructions or status can be added here
-    hal_display_write("\nUse Up/Down to navigate, Right to open folder/file, Left to go back.\n");
+    // Instructions below the entry rows
+    vscreen_write_at(COLUMN_VIEW_ROWS + 2, 0, "Use Up/Down to navigate, Right to open folder/file, Left to go back, F1 to find, Ctrl+F to search.", VSCREEN_COLS);
+    size_t cells = vscreen_flush();
+    PERF_END(span, PERF_COLUMNS_SCREEN, cells);
 }
 
 // Display Rename Mode
 static void display_rename_mode_screen(void) {
-    hal_display_clear();
-    hal_display_write("Rename Mode:\n");
-    hal_display_write("Current Item: ");
-    hal_display_write(columns[focused_column].file_list[columns[focused_column].selected_index]);
-    hal_display_write("\nType new name and press Enter. Esc to cancel.\n");
-    hal_display_write(input_buffer);
+    DirEntry selected;
+    vscreen_begin_frame();
+    vscreen_write("Rename Mode:\n");
+    vscreen_write("Current Item: ");
+    vscreen_write(column_selected_entry(focused_column, &selected) ? selected.name : "");
+    vscreen_write("\nType new name and press Enter. Esc to cancel.\n");
+    vscreen_write(input_buffer);
+    vscreen_flush();
 }
 
 // Display New Folder Mode
 static void display_new_folder_screen(void) {
-    hal_display_clear();
-    hal_display_write("New Folder Mode:\n");
-    hal_display_write("Type folder name and press Enter. Esc to cancel.\n");
-    hal_display_write(input_buffer);
+    vscreen_begin_frame();
+    vscreen_write("New Folder Mode:\n");
+    vscreen_write("Type folder name and press Enter. Esc to cancel.\n");
+    vscreen_write(input_buffer);
+    vscreen_flush();
 }
 
 // Display New File Mode
 static void display_new_file_screen(void) {
-    hal_display_clear();
-    hal_display_write("New File Mode:\n");
-    hal_display_write("Type file name (without extension) and press Enter. Esc to cancel.\n");
-    hal_display_write(input_buffer);
+    vscreen_begin_frame();
+    vscreen_write("New File Mode:\n");
+    vscreen_write("Type file name (without extension) and press Enter. Esc to cancel.\n");
+    vscreen_write(input_buffer);
+    vscreen_flush();
 }
 
-// Display the editor screen with the current file content
+// Returns the start of the screen row holding pos: a line takes one row per
+// VSCREEN_COLS characters, plus the row its end is on.
+static size_t editor_row_start(size_t pos) {
+    size_t line_start = paged_doc_line_start(&edit_doc, pos);
+    return line_start + (pos - line_start) / VSCREEN_COLS * VSCREEN_COLS;
+}
+
+// Returns the start of the screen row after the one starting at row, or the
+// document length after the last row.
+static size_t editor_next_row(size_t row) {
+    size_t length = paged_doc_length(&edit_doc);
+    size_t line_end = paged_doc_line_end(&edit_doc, row);
+    if (row + VSCREEN_COLS <= line_end) {
+        return row + VSCREEN_COLS; // Wrapped part of the same line
+    }
+    return line_end < length ? line_end + 1 : length;
+}
+
+// Returns the start of the screen row before the one starting at row (> 0).
+static size_t editor_previous_row(size_t row) {
+    size_t line_start = paged_doc_line_start(&edit_doc, row);
+    return row > line_start ? row - VSCREEN_COLS : editor_row_start(row - 1);
+}
+
+// Display the editor screen with the current file content.
+// Shows EDITOR_VIEW_ROWS screen rows starting at edit_view_top; lines wrap every VSCREEN_COLS characters.
 static void display_editor_screen(void) {
-    hal_display_clear();
-    hal_display_write("Editing: ");
-    hal_display_write(edit_filename);
-    hal_display_write("\nCtrl+S to save, Esc to exit.\n");
-
-    // Create a copy of edit_buffer to modify for display
-    char display_buffer[MAX_FILE_CONTENT_SIZE * 2 + 1]; // Increased size to accommodate ANSI codes
-    memset(display_buffer, 0, sizeof(display_buffer));
-
-    for (size_t i = 0; i < edit_length && i < MAX_FILE_CONTENT_SIZE; i++) {
-        if (i == edit_cursor_pos && cursor_visible) {
-            // Start underline
-            strcat(display_buffer, "\033[4m"); // ANSI code to start underlining
-            // Append the character to be underlined
-            char temp[2] = { edit_buffer[i], '\0' };
-            strcat(display_buffer, temp);
-            // Reset formatting
-            strcat(display_buffer, "\033[0m");
-        } else {
-            // Append the character as is
-            size_t len = strlen(display_buffer);
-            if (len < sizeof(display_buffer) - 2) { // Ensure space for the character and null terminator
-                display_buffer[len] = edit_buffer[i];
-                display_buffer[len + 1] = '\0';
-            }
+    PERF_BEGIN(span);
+    vscreen_begin_frame();
+    vscreen_write("Editing: ");
+    vscreen_write(edit_doc.path);
+    vscreen_write("\nCtrl+S to save, Esc to exit.\n");
+    if (edit_loading > 0) {
+        // Nothing is read here so the screen never waits for the card
+        vscreen_write("Loading...");
+        size_t cells = vscreen_flush();
+        PERF_END(span, PERF_EDITOR_SCREEN, cells);
+        return;
+    }
+
+    size_t edit_length = paged_doc_length(&edit_doc);
+    size_t edit_cursor_pos = edit_cursor;
+
+    // Find the visible row range through the line index
+    size_t view_start = edit_view_top;
+    size_t view_end = view_start;
+    for (int row = 0; row < EDITOR_VIEW_ROWS && view_end < edit_length; row++) {
+        view_end = editor_next_row(view_end);
+    }
+    if (view_end - view_start > EDITOR_VIEW_SIZE) {
+        view_end = view_start + EDITOR_VIEW_SIZE;
+    }
+
+    // Fetch the visible text; this loads the pages around the cursor
+    char view[EDITOR_VIEW_SIZE];
+    view_end = view_start + paged_doc_read(&edit_doc, view_start, view, view_end - view_start);
+
+    // Compose the visible text and the cursor cell in one pass into a preallocated span
+    static char frame_storage[EDITOR_VIEW_SIZE + FRAME_CURSOR_OVERHEAD];
+    FrameSpan frame;
+    frame_init(&frame, frame_storage, sizeof(frame_storage));
+    bool cursor_in_view = edit_cursor_pos >= view_start &&
+                          (edit_cursor_pos < view_end || edit_cursor_pos == edit_length);
+    frame_compose_text(&frame, view, view_end - view_start, edit_cursor_pos - view_start,
+                       cursor_visible && cursor_in_view);
+
+    vscreen_write_span(frame.data, frame.length);
+    size_t cells = vscreen_flush();
+    PERF_END(span, PERF_EDITOR_SCREEN, cells);
+}
+
+// Moves pos one line up or down, keeping its column where the target line is long enough.
+static size_t editor_move_vertical(size_t pos, bool down) {
+    size_t line_start = paged_doc_line_start(&edit_doc, pos);
+    size_t column = pos - line_start;
+    size_t target_start;
+
+    if (down) {
+        size_t line_end = paged_doc_line_end(&edit_doc, pos);
+        if (line_end >= paged_doc_length(&edit_doc)) {
+            return line_end; // Last line: go to the end
         }
+        target_start = line_end + 1;
+    } else {
+        if (line_start == 0) {
+            return 0; // First line: go to the start
+        }
+        target_start = paged_doc_line_start(&edit_doc, line_start - 1);
     }
 
-    // If cursor is at the end of the buffer, append an underline space
-    if (edit_cursor_pos == edit_length && cursor_visible && edit_length < MAX_FILE_CONTENT_SIZE) {
-        strcat(display_buffer, "\033[4m \033[0m"); // Underlined space
+    size_t target_end = paged_doc_line_end(&edit_doc, target_start);
+    return target_start + column < target_end ? target_start + column : target_end;
+}
+
+// Adjusts edit_view_top so the cursor row is among the EDITOR_VIEW_ROWS visible rows.
+static void editor_scroll_to_cursor(void) {
+    size_t length = paged_doc_length(&edit_doc);
+    size_t cursor_row = editor_row_start(edit_cursor);
+
+    // Edits may have moved the row boundaries under the view
+    edit_view_top = editor_row_start(edit_view_top < length ? edit_view_top : length);
+    if (cursor_row < edit_view_top) {
+        edit_view_top = cursor_row;
+        return;
+    }
+
+    size_t row = edit_view_top;
+    for (int i = 0; i < EDITOR_VIEW_ROWS; i++) {
+        if (row == cursor_row) {
+            return; // Already visible
+        }
+        row = editor_next_row(row);
     }
 
-    hal_display_write(display_buffer);
+    // Cursor is below the view: make its row the last visible one
+    edit_view_top = cursor_row;
+    for (int i = 1; i < EDITOR_VIEW_ROWS && edit_view_top > 0; i++) {
+        edit_view_top = editor_previous_row(edit_view_top);
+    }
+}
+
+// Edits the document and records the edit in the journal.
+static bool document_insert(size_t pos, const char *text, size_t length) {
+    if (!paged_doc_insert(&edit_doc, pos, text, length)) {
+        return false;
+    }
+    edit_journal_insert(&edit_journal, pos, text, length);
+    return true;
+}
+
+static size_t document_delete(size_t pos, size_t length) {
+    size_t deleted = paged_doc_delete(&edit_doc, pos, length);
+    if (deleted > 0) {
+        edit_journal_delete(&edit_journal, pos, deleted);
+    }
+    return deleted;
+}
+
+// Edits typed by the user: also recorded in the undo log.
+static bool editor_insert(size_t pos, const char *text, size_t length) {
+    if (!document_insert(pos, text, length)) {
+        return false;
+    }
+    undo_log_insert(&undo_log, pos, text, length);
+    return true;
+}
+
+static size_t editor_delete(size_t pos, size_t length) {
+    // The bytes are needed to undo the delete
+    char removed[UNDO_LOG_RECORD_MAX];
+    bool saved = length <= sizeof(removed) && paged_doc_read(&edit_doc, pos, removed, length) == length;
+    size_t deleted = document_delete(pos, length);
+    if (saved) {
+        undo_log_delete(&undo_log, pos, removed, deleted);
+    } else if (deleted > 0) {
+        undo_log_clear(&undo_log);
+    }
+    return deleted;
+}
+
+// Takes back the last edit (Ctrl+Z), or applies the last undone one again (Ctrl+Y).
+static void editor_undo(bool redo) {
+    UndoStep step;
+    if (!(redo ? undo_log_redo(&undo_log, &step) : undo_log_undo(&undo_log, &step))) {
+        vscreen_set_status(redo ? "Nothing to redo." : "Nothing to undo.");
+        return;
+    }
+
+    bool insert = (step.type == UNDO_INSERT) == redo;
+    bool ok = insert ? document_insert(step.pos, step.text, step.length)
+                     : document_delete(step.pos, step.length) == step.length;
+    if (!ok) {
+        undo_log_clear(&undo_log); // The history no longer matches the document
+        vscreen_set_status("Could not undo, history cleared.");
+        return;
+    }
+    edit_cursor = insert ? step.pos + step.length : step.pos;
 }
 
 //  Processes keyboard input in edit mode, handling navigation, insertion, deletion, and saving.
@@ -309,66 +670,305 @@ static void display_editor_screen(void) {
 	•	Refactoring: Move editor logic into a separate editor.c.
     */
 static void handle_editor_input(KeyCode key) {
+    if (edit_loading > 0) {
+        // Typing before the read-ahead is in: stop waiting for it, the pages
+        // the key needs are loaded on demand
+        edit_loading = 0;
+        editor_scroll_to_cursor();
+    }
+
     if (key == KEY_CTRL_S) {
-        // Save file
-        if (hal_storage_write_file(edit_filename, edit_buffer, edit_length)) {
-            hal_display_write("\nFile saved!\n");
-        } else {
-            hal_display_write("\nError saving file!\n");
-        }
-        
-    
-        display_columns();
+        start_save();
+        request_redraw(display_editor_screen);
+        return;
+    }
+
+    if (key == KEY_CTRL_Z || key == KEY_CTRL_Y) {
+        editor_undo(key == KEY_CTRL_Y);
+        editor_scroll_to_cursor();
+        request_redraw(display_editor_screen);
         return;
     }
 
     if (key == KEY_ESCAPE) {
-        // Cancel editing, discard changes
+        // Jobs still reference the document: let them finish before closing it
+        finish_storage_jobs();
+        // Cancel editing, discard changes since the last save
+        bool journaled = edit_journal_exists(&edit_journal);
+        edit_journal_close(&edit_journal);
+        paged_doc_close(&edit_doc);
+        if (journaled) {
+            snprintf(closed_path, sizeof(closed_path), "%s", edit_doc.path);
+            submit_storage_job(run_close, closed_path, JOB_CLOSE);
+        }
         current_state = STATE_NORMAL;
-        display_columns();
+        request_redraw(display_columns);
         return;
     }
 
     // Navigation in edit buffer
-    if (key == KEY_ARROW_LEFT && edit_cursor_pos > 0) {
-        edit_cursor_pos--;
-    } else if (key == KEY_ARROW_RIGHT && edit_cursor_pos < edit_length) {
-        edit_cursor_pos++;
+    if (key == KEY_ARROW_LEFT && edit_cursor > 0) {
+        edit_cursor--;
+    } else if (key == KEY_ARROW_RIGHT && edit_cursor < paged_doc_length(&edit_doc)) {
+        edit_cursor++;
+    }
+
+    // Line navigation through the line index
+    switch (key) {
+        case KEY_ARROW_UP:
+            edit_cursor = editor_move_vertical(edit_cursor, false);
+            break;
+        case KEY_ARROW_DOWN:
+            edit_cursor = editor_move_vertical(edit_cursor, true);
+            break;
+        case KEY_HOME:
+            edit_cursor = paged_doc_line_start(&edit_doc, edit_cursor);
+            break;
+        case KEY_END:
+            edit_cursor = paged_doc_line_end(&edit_doc, edit_cursor);
+            break;
+        case KEY_PAGE_UP:
+        case KEY_PAGE_DOWN:
+            for (int row = 0; row < EDITOR_VIEW_ROWS; row++) {
+                edit_cursor = editor_move_vertical(edit_cursor, key == KEY_PAGE_DOWN);
+            }
+            break;
+        default:
+            break;
     }
 
     // Backspace
-    if (key == KEY_BACKSPACE && edit_cursor_pos > 0) {
-        memmove(&edit_buffer[edit_cursor_pos - 1],
-                &edit_buffer[edit_cursor_pos],
-                edit_length - edit_cursor_pos + 1);
-        edit_length--;
-        edit_cursor_pos--;
+    if (key == KEY_BACKSPACE && edit_cursor > 0) {
+        edit_cursor -= editor_delete(edit_cursor - 1, 1);
+    }
+
+    // Enter starts a new line
+    if (key == KEY_ENTER && editor_insert(edit_cursor, "\n", 1)) {
+        edit_cursor++;
     }
 
     // Printable chars
     if (key >= KEY_CHAR_BASE) {
         char c = (char)(key - KEY_CHAR_BASE);
-        if (edit_length < MAX_FILE_CONTENT_SIZE - 1 && c >= 32 && c <= 126) {
-            memmove(&edit_buffer[edit_cursor_pos + 1],
-                    &edit_buffer[edit_cursor_pos],
-                    edit_length - edit_cursor_pos + 1);
-            edit_buffer[edit_cursor_pos] = c;
-            edit_length++;
-            edit_cursor_pos++;
+        if (c >= 32 && c <= 126 && editor_insert(edit_cursor, &c, 1)) {
+            edit_cursor++;
+        }
+    }
+
+    editor_scroll_to_cursor();
+    request_redraw(display_editor_screen);
+}
+
+static bool run_commit(void *context) {
+    return edit_journal_write(context);
+}
+
+// Writes the document content, then the journal marker saying it is complete.
+// An in-place patch is the other way round: its marker carries the new blocks
+// and has to be on the card before the file is touched.
+static bool run_compact(void *context) {
+    (void)context;
+    DocSnapshot *snapshot = &compaction.snapshot;
+    if (snapshot->in_place) {
+        if (!paged_doc_save_gather(snapshot)) {
+            return false;
+        }
+        edit_journal_fill_patch(&compaction.marker, snapshot);
+        return edit_journal_write(&compaction.marker) && paged_doc_save_write(snapshot);
+    }
+    if (!compaction.has_marker) {
+        // Nothing would tell replay that the file was replaced: its old
+        // groups must not outlive the rewrite
+        hal_storage_delete_file(edit_journal.path);
+    }
+    return paged_doc_save_write(snapshot) && (!compaction.has_marker || edit_journal_write(&compaction.marker));
+}
+
+static bool run_index(void *context) {
+    return search_index_update(context) && search_index_commit();
+}
+
+static bool run_index_commit(void *context) {
+    (void)context;
+    return search_index_commit();
+}
+
+static bool run_close(void *context) {
+    bool applied;
+    return edit_journal_replay(context, &applied) && (!applied || run_index(context));
+}
+
+// Hands a job to the storage worker, or runs it here if the worker cannot take it.
+static void submit_storage_job(StorageJobFn run, void *context, int tag) {
+    if (!storage_worker_submit(run, context, tag)) {
+        StorageJob job = { run, context, tag, run(context) };
+        handle_storage_job(&job);
+    }
+}
+
+// Rewrites the document file from a snapshot, or patches the blocks that
+// changed if there are few. Right after a commit the snapshot equals the
+// journaled content, so the journal marker records that everything before it
+// is now in the file. A broken journal is started over with just the marker
+// and the whole document, saved or not, goes to the file.
+static void start_compaction(void) {
+    if (compaction_pending) {
+        save_again = true;
+        return;
+    }
+    bool full = edit_journal.broken;
+    if (!paged_doc_save_begin(&edit_doc, &compaction.snapshot, !full)) {
+        vscreen_set_status("Error saving file!");
+        return;
+    }
+    if (full) {
+        edit_journal_restart(&edit_journal);
+    }
+    if (compaction.snapshot.in_place) {
+        // Without its marker a cut-short patch could not be completed
+        compaction.has_marker = edit_journal_seal_patch(&edit_journal, &compaction.snapshot, &compaction.marker);
+        if (!compaction.has_marker) {
+            paged_doc_save_end(&edit_doc, &compaction.snapshot, false);
+            vscreen_set_status("Error saving file!");
+            return;
         }
+    } else {
+        compaction.has_marker = edit_journal_seal_marker(&edit_journal, compaction.snapshot.length, &compaction.marker);
+    }
+    compaction_pending = true;
+    submit_storage_job(run_compact, &compaction, JOB_COMPACT);
+}
+
+// Commits the edits since the last save as one journal group, written by the
+// storage worker. Once enough has been journaled the file is compacted too.
+static void start_save(void) {
+    vscreen_set_status("Saving...");
+    if (edit_journal.broken) {
+        start_compaction();
+        return;
     }
 
-    display_editor_screen();
+    JournalGroup *group = malloc(sizeof(JournalGroup));
+    if (group && edit_journal_seal(&edit_journal, group)) {
+        submit_storage_job(run_commit, group, JOB_COMMIT);
+    } else {
+        free(group);
+        if (!edit_journal.broken) {
+            vscreen_set_status("Saved.");  // Nothing changed since the last save
+        }
+    }
+    if (edit_journal_needs_compaction(&edit_journal)) {
+        start_compaction();
+    }
+}
+
+// Reports a completed save with the bytes it wrote to the card.
+static void set_saved_status(size_t bytes, const char *how) {
+    char status[64];
+    if (bytes < 10 * 1024) {
+        snprintf(status, sizeof(status), "Saved, %zu bytes %s.", bytes, how);
+    } else {
+        snprintf(status, sizeof(status), "Saved, %zu KB %s.", bytes / 1024, how);
+    }
+    vscreen_set_status(status);
+}
+
+static void finish_commit(JournalGroup *group, bool written) {
+    size_t bytes = group->length;
+    edit_journal_group_free(group);
+    free(group);
+    if (written) {
+        set_saved_status(bytes, "journaled");
+    } else {
+        // Later groups would follow a hole: the next save rewrites the file
+        edit_journal.broken = true;
+        vscreen_set_status("Error saving file!");
+    }
+}
+
+// Replaces the file with the compacted snapshot and re-indexes it.
+static void finish_compaction(bool written) {
+    compaction_pending = false;
+    bool in_place = compaction.snapshot.in_place;
+    size_t bytes = compaction.snapshot.bytes_written + (compaction.has_marker ? compaction.marker.length : 0);
+    if (paged_doc_save_end(&edit_doc, &compaction.snapshot, written)) {
+        if (compaction.has_marker) {
+            edit_journal_compacted(&edit_journal, &compaction.marker, compaction.snapshot.length);
+        } else {
+            edit_journal_reset(&edit_journal, compaction.snapshot.length);
+        }
+        set_saved_status(bytes, in_place ? "patched in place" : "rewritten");
+        // The path stays valid until the document is closed, which waits for the job
+        submit_storage_job(run_index, edit_doc.path, JOB_INDEX);
+    } else {
+        if (!written) {
+            edit_journal.broken = true;
+        } else if (compaction.has_marker) {
+            edit_journal_abort_marker(&edit_journal); // The content is complete but was not renamed
+        }
+        vscreen_set_status("Error saving file!");
+    }
+    if (compaction.has_marker) {
+        edit_journal_group_free(&compaction.marker);
+    }
+
+    if (save_again) {
+        save_again = false;
+        start_save();
+    }
+}
+
+// Waits for the storage jobs in flight. Called before using files or the
+// search index that a job may still be writing.
+static void finish_storage_jobs(void) {
+    StorageJob job;
+    while (storage_worker_wait(&job)) {
+        handle_storage_job(&job);
+    }
+}
+
+// Acts on a job completed by the storage worker.
+static void handle_storage_job(const StorageJob *job) {
+    switch (job->tag) {
+        case JOB_COMMIT:
+            finish_commit(job->context, job->ok);
+            break;
+        case JOB_COMPACT:
+            finish_compaction(job->ok);
+            break;
+        case JOB_CLOSE:
+            if (!job->ok) {
+                vscreen_set_status("Could not write the saved changes into the file.");
+            }
+            break;
+        case JOB_READ_AHEAD:
+            if (job->ok) {
+                paged_doc_block_fill(&edit_doc, job->context);
+            }
+            if (edit_loading > 0 && --edit_loading == 0) {
+                editor_scroll_to_cursor();
+            }
+            break;
+        case JOB_INDEX:
+            if (!job->ok) {
+                vscreen_set_status("Search index not updated.");
+            }
+            break;
+    }
+    if (current_state == STATE_EDITING) {
+        request_redraw(display_editor_screen);
+    }
 }
 
 // Enter rename mode for the selected file/folder
 static void enter_rename_mode(void) {
-    if (columns[focused_column].file_count == 0) return; // No file selected
+    DirEntry selected;
+    if (!column_selected_entry(focused_column, &selected)) return; // No file selected
     current_state = STATE_RENAME;
     input_len = 0;
     input_buffer[0] = '\0';
 
-    display_rename_mode_screen();
+    request_redraw(display_rename_mode_screen);
 }
 
 // Enter new folder creation mode
@@ -377,7 +977,7 @@ static void enter_new_folder_mode(void) {
     input_len = 0;
     input_buffer[0] = '\0';
 
-    display_new_folder_screen();
+    request_redraw(display_new_folder_screen);
 }
 
 // NEW: Enter new file creation mode
@@ -386,7 +986,20 @@ static void enter_new_file_mode(void) {
     input_len = 0;
     input_buffer[0] = '\0';
 
-    display_new_file_screen();
+    request_redraw(display_new_file_screen);
+}
+
+// True for the search index folder and anything in it, and for the side files
+// of documents: they are never renamed or created by hand.
+static bool is_reserved_path(const char *path) {
+    if (side_file_is_reserved(path)) {
+        return true;
+    }
+    while (*path == '/') {
+        path++; // Paths built in the root column start with "//"
+    }
+    size_t length = strlen(SEARCH_INDEX_DIR) - 1;
+    return strncmp(path, SEARCH_INDEX_DIR + 1, length) == 0 && (path[length] == '\0' || path[length] == '/');
 }
 
 // Commit the rename operation
@@ -394,23 +1007,39 @@ static void commit_rename(void) {
     if (column_count == 0) return; // Safety check
 
     size_t col = focused_column;
+    DirEntry selected;
+    if (!column_selected_entry(col, &selected)) return;
+
     // Construct old path and new path based on the focused column
     char oldpath[MAX_PATH_LEN];
     char newpath[MAX_PATH_LEN];
-    snprintf(oldpath, sizeof(oldpath), "%s/%s", columns[col].directory, columns[col].file_list[columns[col].selected_index]);
-    snprintf(newpath, sizeof(newpath), "%s/%s", columns[col].directory, input_buffer);
-
-    if (hal_storage_rename_file(oldpath, newpath)) {
-        hal_display_write("Rename successful!\n");
+    int old_length = snprintf(oldpath, sizeof(oldpath), "%s/%s", columns[col].directory, selected.name);
+    int new_length = snprintf(newpath, sizeof(newpath), "%s/%s", columns[col].directory, input_buffer);
+
+    // A closed document may still be written
+    finish_storage_jobs();
+    if (old_length < 0 || (size_t)old_length >= sizeof(oldpath) || new_length < 0 ||
+        (size_t)new_length >= sizeof(newpath)) {
+        vscreen_set_status("Path too long.");
+    } else if (is_reserved_path(oldpath) || is_reserved_path(newpath)) {
+        vscreen_set_status("That name is reserved for the editor's own files.");
+    } else if (hal_storage_rename_file(oldpath, newpath)) {
+        vscreen_set_status("Rename successful!");
+        dir_cache_note_renamed(columns[col].directory, selected.name, input_buffer);
+        if (!path_index_rename(&path_index, oldpath, newpath)) {
+            path_index_build(&path_index, "/");
+        }
+        search_index_rename(oldpath, newpath);
+        submit_storage_job(run_index_commit, NULL, JOB_INDEX);
     } else {
-        hal_display_write("Rename failed!\n");
+        vscreen_set_status("Rename failed!");
     }
 
-    // Reload the current column's file list
-    columns[col].file_count = hal_storage_list_files(columns[col].directory, columns[col].file_list, MAX_FILES);
+    // Back to the top of the column; its entries come fresh from the cache
     columns[col].selected_index = 0;
+    columns[col].scroll_offset = 0;
     current_state = STATE_NORMAL;
-    display_columns();
+    request_redraw(display_columns);
 }
 
 // Commit the new folder creation
@@ -419,19 +1048,30 @@ static void commit_new_folder(void) {
 
     size_t col = focused_column;
     char newdir[MAX_PATH_LEN];
-    snprintf(newdir, sizeof(newdir), "%s/%s", columns[col].directory, input_buffer);
-
-    if (hal_storage_create_directory(newdir)) {
-        hal_display_write("Folder created!\n");
+    int length = snprintf(newdir, sizeof(newdir), "%s/%s", columns[col].directory, input_buffer);
+
+    DirEntry created;
+    if (length < 0 || (size_t)length >= sizeof(newdir)) {
+        vscreen_set_status("Path too long.");
+    } else if (is_reserved_path(newdir)) {
+        vscreen_set_status("That name is reserved for the editor's own files.");
+    } else if (hal_storage_create_directory(newdir)) {
+        vscreen_set_status("Folder created!");
+        path_index_add(&path_index, newdir, DIR_ENTRY_DIRECTORY);
+        if (hal_storage_stat(newdir, &created)) {
+            dir_cache_note_created(columns[col].directory, &created);
+        } else {
+            dir_cache_invalidate(columns[col].directory);
+        }
     } else {
-        hal_display_write("Failed to create folder.\n");
+        vscreen_set_status("Failed to create folder.");
     }
 
-    // Reload the current column's file list
-    columns[col].file_count = hal_storage_list_files(columns[col].directory, columns[col].file_list, MAX_FILES);
+    // Back to the top of the column; its entries come fresh from the cache
     columns[col].selected_index = 0;
+    columns[col].scroll_offset = 0;
     current_state = STATE_NORMAL;
-    display_columns();
+    request_redraw(display_columns);
 }
 
 // NEW: Commit the new file creation
@@ -440,28 +1080,39 @@ static void commit_new_file(void) {
 
     size_t col = focused_column;
     char newfile[MAX_PATH_LEN];
-    snprintf(newfile, sizeof(newfile), "%s/%s.txt", columns[col].directory, input_buffer);
+    int length = snprintf(newfile, sizeof(newfile), "%s/%s.txt", columns[col].directory, input_buffer);
 
     // Check if file already exists
-    if (hal_storage_file_exists(newfile)) {
-        hal_display_write("File already exists.\n");
+    if (length < 0 || (size_t)length >= sizeof(newfile)) {
+        vscreen_set_status("Path too long.");
+    } else if (is_reserved_path(newfile)) {
+        vscreen_set_status("That name is reserved for the editor's own files.");
+    } else if (hal_storage_file_exists(newfile)) {
+        vscreen_set_status("File already exists.");
     } else {
         // Create the new file
         if (hal_storage_create_file(newfile)) {
-            hal_display_write("File created successfully!\n");
+            vscreen_set_status("File created successfully!");
+            path_index_add(&path_index, newfile, DIR_ENTRY_FILE);
+            DirEntry created;
+            if (hal_storage_stat(newfile, &created)) {
+                dir_cache_note_created(columns[col].directory, &created);
+            } else {
+                dir_cache_invalidate(columns[col].directory);
+            }
             // Optionally, open the new file in edit mode
             enter_edit_mode(newfile);
             return;
         } else {
-            hal_display_write("Failed to create file.\n");
+            vscreen_set_status("Failed to create file.");
         }
     }
 
-    // Reload the current column's file list
-    columns[col].file_count = hal_storage_list_files(columns[col].directory, columns[col].file_list, MAX_FILES);
+    // Back to the top of the column; its entries come fresh from the cache
     columns[col].selected_index = 0;
+    columns[col].scroll_offset = 0;
     current_state = STATE_NORMAL;
-    display_columns();
+    request_redraw(display_columns);
 }
 
 // Handle text input for rename, new folder, and new file modes
@@ -488,7 +1139,8 @@ static void handle_text_input(KeyCode key) {
 static void handle_rename_input(KeyCode key) {
     if (key == KEY_ENTER) {
         if (input_len == 0) {
-            hal_display_write("New name cannot be empty.\n");
+            vscreen_set_status("New name cannot be empty.");
+            request_redraw(display_rename_mode_screen);
             return;
         }
         commit_rename();
@@ -497,9 +1149,9 @@ static void handle_rename_input(KeyCode key) {
 
     if (key == KEY_ESCAPE) {
         // Cancel operation
-        hal_display_write("Operation canceled.\n");
+        vscreen_set_status("Operation canceled.");
         current_state = STATE_NORMAL;
-        display_columns();
+        request_redraw(display_columns);
         return;
     }
 
@@ -507,14 +1159,15 @@ static void handle_rename_input(KeyCode key) {
     handle_text_input(key);
 
     // Re-display prompt with current buffer and cursor
-    display_rename_mode_screen();
+    request_redraw(display_rename_mode_screen);
 }
 
 // Handle input while in new folder mode
 static void handle_new_folder_input(KeyCode key) {
     if (key == KEY_ENTER) {
         if (input_len == 0) {
-            hal_display_write("Folder name cannot be empty.\n");
+            vscreen_set_status("Folder name cannot be empty.");
+            request_redraw(display_new_folder_screen);
             return;
         }
         commit_new_folder();
@@ -523,9 +1176,9 @@ static void handle_new_folder_input(KeyCode key) {
 
     if (key == KEY_ESCAPE) {
         // Cancel operation
-        hal_display_write("Operation canceled.\n");
+        vscreen_set_status("Operation canceled.");
         current_state = STATE_NORMAL;
-        display_columns();
+        request_redraw(display_columns);
         return;
     }
 
@@ -533,14 +1186,15 @@ static void handle_new_folder_input(KeyCode key) {
     handle_text_input(key);
 
     // Re-display prompt with current buffer and cursor
-    display_new_folder_screen();
+    request_redraw(display_new_folder_screen);
 }
 
 // NEW: Handle input while in new file mode
 static void handle_new_file_input(KeyCode key) {
     if (key == KEY_ENTER) {
         if (input_len == 0) {
-            hal_display_write("File name cannot be empty.\n");
+            vscreen_set_status("File name cannot be empty.");
+            request_redraw(display_new_file_screen);
             return;
         }
         commit_new_file();
@@ -549,9 +1203,9 @@ static void handle_new_file_input(KeyCode key) {
 
     if (key == KEY_ESCAPE) {
         // Cancel operation
-        hal_display_write("Operation canceled.\n");
+        vscreen_set_status("Operation canceled.");
         current_state = STATE_NORMAL;
-        display_columns();
+        request_redraw(display_columns);
         return;
     }
 
@@ -559,63 +1213,384 @@ static void handle_new_file_input(KeyCode key) {
     handle_text_input(key);
 
     // Re-display prompt with current buffer and cursor
-    display_new_file_screen();
+    request_redraw(display_new_file_screen);
+}
+
+// Enter find mode with an empty query over every indexed path
+static void enter_find_mode(void) {
+    if (!path_query_reset(&path_query, &path_index)) {
+        vscreen_set_status("Not enough memory to search.");
+        request_redraw(display_columns);
+        return;
+    }
+    current_state = STATE_FIND;
+    input_len = 0;
+    input_buffer[0] = '\0';
+    find_result_count = 0;
+    find_selected = 0;
+
+    request_redraw(display_find_screen);
+}
+
+// Display Find Mode: the query, then its best matches
+static void display_find_screen(void) {
+    char line[MAX_PATH_LEN + 2];
+
+    vscreen_begin_frame();
+    vscreen_write("Find: ");
+    vscreen_write(input_buffer);
+    if (input_len == 0) {
+        snprintf(line, sizeof(line), "\nType part of a name to search %zu files and folders.\n", path_index.count);
+    } else {
+        snprintf(line, sizeof(line), "\n%zu matches\n", path_query_match_count(&path_query));
+    }
+    vscreen_write(line);
+
+    for (size_t i = 0; i < find_result_count; i++) {
+        char path[MAX_PATH_LEN];
+        path_index_path(&path_index, find_results[i], path, sizeof(path));
+        snprintf(line, sizeof(line), "%s%s", i == find_selected ? "> " : "  ", path);
+        vscreen_write_at((int)(2 + i), 0, line, VSCREEN_COLS);
+    }
+
+    vscreen_write_at(COLUMN_VIEW_ROWS + 2, 0, "Up/Down to choose, Enter to open, Esc to cancel.", VSCREEN_COLS);
+    vscreen_flush();
+}
+
+// Opens the selected match: a file in the editor, a folder selected in the explorer
+static void open_find_result(void) {
+    if (find_selected >= find_result_count) {
+        return;
+    }
+    uint32_t node = find_results[find_selected];
+    char path[MAX_PATH_LEN];
+    path_index_path(&path_index, node, path, sizeof(path));
+
+    current_state = STATE_NORMAL;
+    if (!reveal_path(path)) {
+        vscreen_set_status("Could not open the match in the explorer.");
+        request_redraw(display_columns);
+        return;
+    }
+    if (path_index.nodes[node].type == DIR_ENTRY_DIRECTORY) {
+        request_redraw(display_columns);
+    } else {
+        enter_edit_mode(path);
+    }
+}
+
+// Handle input while in find mode. Each character narrows the previous matches
+// instead of searching the whole index again.
+static void handle_find_input(KeyCode key) {
+    switch (key) {
+        case KEY_ESCAPE:
+            vscreen_set_status("Operation canceled.");
+            current_state = STATE_NORMAL;
+            request_redraw(display_columns);
+            return;
+
+        case KEY_ENTER:
+            open_find_result();
+            return;
+
+        case KEY_ARROW_UP:
+            if (find_selected > 0) {
+                find_selected--;
+            }
+            break;
+
+        case KEY_ARROW_DOWN:
+            if (find_selected + 1 < find_result_count) {
+                find_selected++;
+            }
+            break;
+
+        case KEY_BACKSPACE:
+            if (input_len > 0) {
+                handle_text_input(key);
+                path_query_pop(&path_query, &path_index);
+            }
+            break;
+
+        default:
+            if (key >= KEY_CHAR_BASE && input_len < PATH_QUERY_MAX) {
+                char c = (char)(key - KEY_CHAR_BASE);
+                if (c >= 32 && c <= 126 && path_query_push(&path_query, &path_index, c)) {
+                    handle_text_input(key);
+                }
+            }
+            break;
+    }
+
+    if (key == KEY_BACKSPACE || key >= KEY_CHAR_BASE) {
+        find_result_count = path_query_best(&path_query, find_results, COLUMN_VIEW_ROWS);
+        find_selected = 0;
+    }
+    request_redraw(display_find_screen);
+}
+
+// Indexes every document on the card; only needed when no index exists yet.
+static void build_search_index(void) {
+    char path[MAX_PATH_LEN];
+    bool ok = true;
+    for (size_t node = 0; node < path_index.count && ok; node++) {
+        if (path_index.nodes[node].type == DIR_ENTRY_FILE) {
+            path_index_path(&path_index, (uint32_t)node, path, sizeof(path));
+            ok = search_index_update(path);
+        }
+    }
+    if (!ok || !search_index_commit()) {
+        vscreen_set_status("Could not build the search index.");
+    }
+}
+
+// Applies the journals found by the path index to their documents: they are
+// left behind when power is lost while a document is open. Only side files are
+// touched, never a file named by the user. The path index is rebuilt
+// afterwards since the journals are gone; returns true if it was.
+static bool recover_journals(void) {
+    char path[MAX_PATH_LEN];
+    char doc_path[MAX_PATH_LEN];
+    size_t found = 0;
+    size_t failed = 0;
+    for (size_t node = 0; node < path_index.count; node++) {
+        const char *name = path_index.names + path_index.nodes[node].name;
+        if (path_index.nodes[node].type != DIR_ENTRY_FILE || !side_file_is_reserved(name)) {
+            continue;
+        }
+        size_t length = path_index_path(&path_index, (uint32_t)node, path, sizeof(path));
+        if (length >= sizeof(path) - 1 || !side_file_document(path, SIDE_FILE_JOURNAL, doc_path, sizeof(doc_path))) {
+            continue;
+        }
+        bool applied;
+        found++;
+        if (!edit_journal_replay(doc_path, &applied)) {
+            failed++; // Kept, and opening the document reports it again
+        } else if (applied) {
+            search_index_update(doc_path);
+        }
+    }
+
+    // A temporary file whose document is whole and has no journal is left by
+    // a rewrite cut short before its marker was written; one still needed by
+    // a journal that could not be replayed is kept for the next attempt. Swap
+    // and previous files only serve a document while it is open.
+    size_t removed = 0;
+    char journal_path[MAX_PATH_LEN];
+    for (size_t node = 0; node < path_index.count; node++) {
+        const char *name = path_index.names + path_index.nodes[node].name;
+        if (path_index.nodes[node].type != DIR_ENTRY_FILE || !side_file_is_reserved(name)) {
+            continue;
+        }
+        size_t length = path_index_path(&path_index, (uint32_t)node, path, sizeof(path));
+        if (length >= sizeof(path) - 1) {
+            continue;
+        }
+        if (side_file_document(path, SIDE_FILE_TEMP, doc_path, sizeof(doc_path))) {
+            if (!hal_storage_file_exists(doc_path) ||
+                !side_file_path(doc_path, SIDE_FILE_JOURNAL, journal_path, sizeof(journal_path)) ||
+                hal_storage_file_exists(journal_path)) {
+                continue;
+            }
+        } else if (!side_file_document(path, SIDE_FILE_SWAP, doc_path, sizeof(doc_path)) &&
+                   !side_file_document(path, SIDE_FILE_OLD, doc_path, sizeof(doc_path))) {
+            continue;
+        }
+        removed += hal_storage_delete_file(path);
+    }
+
+    if (found == 0 && removed == 0) {
+        return false;
+    }
+    if (found > 0) {
+        search_index_commit();
+        vscreen_set_status(failed ? "Some saved changes could not be recovered; their journals were kept." :
+                                    "Recovered saved changes.");
+    }
+    return path_index_build(&path_index, "/");
+}
+
+// Enter search mode with an empty query
+static void enter_search_mode(void) {
+    // Saved documents may still be being indexed
+    finish_storage_jobs();
+    current_state = STATE_SEARCH;
+    input_len = 0;
+    input_buffer[0] = '\0';
+    search_hit_count = 0;
+    search_selected = 0;
+    search_done = false;
+
+    request_redraw(display_search_screen);
+}
+
+// Reads the text around a hit into its snippet, on one line.
+static void load_snippet(size_t hit) {
+    size_t start = search_hits[hit].offset > SNIPPET_LEAD ? search_hits[hit].offset - SNIPPET_LEAD : 0;
+    char *snippet = search_snippets[hit];
+    int read = hal_storage_read_range(search_hits[hit].path, start, snippet, SNIPPET_LEN);
+    if (read < 0) {
+        read = 0;
+    }
+    for (int i = 0; i < read; i++) {
+        if ((unsigned char)snippet[i] < 32) {
+            snippet[i] = ' ';
+        }
+    }
+    snippet[read] = '\0';
+}
+
+// Runs the query as typed through the index; no document is read apart from the snippets.
+static void run_search(void) {
+    uint32_t start = hal_time_ms();
+    search_hit_count = search_index_query(input_buffer, search_hits, COLUMN_VIEW_ROWS);
+    search_ms = hal_time_ms() - start;
+    for (size_t i = 0; i < search_hit_count; i++) {
+        load_snippet(i);
+    }
+    search_selected = 0;
+    search_done = true;
+}
+
+// Display Search Mode: the query, then the documents containing all of its words
+static void display_search_screen(void) {
+    char line[MAX_PATH_LEN + SNIPPET_LEN + 8];
+
+    vscreen_begin_frame();
+    vscreen_write("Search: ");
+    vscreen_write(input_buffer);
+    if (!search_done) {
+        snprintf(line, sizeof(line), "\nType words and press Enter to search %u documents.\n",
+                 (unsigned)search_index_stats().documents);
+    } else {
+        snprintf(line, sizeof(line), "\n%zu documents (%u ms)\n", search_hit_count, (unsigned)search_ms);
+    }
+    vscreen_write(line);
+
+    for (size_t i = 0; i < search_hit_count; i++) {
+        int length = snprintf(line, sizeof(line), "%s%s: ", i == search_selected ? "> " : "  ", search_hits[i].path);
+        vscreen_write_at((int)(2 + i), 0, line, VSCREEN_COLS);
+        if (length >= 0 && length < VSCREEN_COLS) {
+            vscreen_write_at((int)(2 + i), length, search_snippets[i], VSCREEN_COLS - length);
+        }
+    }
+
+    vscreen_write_at(COLUMN_VIEW_ROWS + 2, 0, "Enter to search, Up/Down to choose, Enter again to open, Esc to cancel.", VSCREEN_COLS);
+    vscreen_flush();
+}
+
+// Opens the selected hit in the editor with the cursor on the matched word
+static void open_search_hit(void) {
+    SearchHit *hit = &search_hits[search_selected];
+    current_state = STATE_NORMAL;
+    enter_edit_mode(hit->path);
+    if (current_state == STATE_EDITING) {
+        size_t length = paged_doc_length(&edit_doc);
+        edit_cursor = hit->offset < length ? hit->offset : length;
+        edit_view_top = 0;
+        editor_scroll_to_cursor();
+    }
+}
+
+// Handle input while in search mode
+static void handle_search_input(KeyCode key) {
+    switch (key) {
+        case KEY_ESCAPE:
+            vscreen_set_status("Operation canceled.");
+            current_state = STATE_NORMAL;
+            request_redraw(display_columns);
+            return;
+
+        case KEY_ENTER:
+            if (search_done && search_hit_count > 0) {
+                open_search_hit();
+                return;
+            }
+            run_search();
+            break;
+
+        case KEY_ARROW_UP:
+            if (search_selected > 0) {
+                search_selected--;
+            }
+            break;
+
+        case KEY_ARROW_DOWN:
+            if (search_selected + 1 < search_hit_count) {
+                search_selected++;
+            }
+            break;
+
+        default:
+            if (key == KEY_BACKSPACE || key >= KEY_CHAR_BASE) {
+                handle_text_input(key);
+                search_done = false;
+                search_hit_count = 0;
+            }
+            break;
+    }
+    request_redraw(display_search_screen);
 }
 
 // Handle normal navigation (extracted from original run_cycle)
 static void handle_normal_navigation(KeyCode key) {
-    size_t focused_col_file_count = columns[focused_column].file_count;
+    DirectoryColumn *column = &columns[focused_column];
+    DirEntry selected;
+    bool has_selection = column_selected_entry(focused_column, &selected);
 
     switch (key) {
         case KEY_ARROW_UP:
-            if (focused_col_file_count > 0 && columns[focused_column].selected_index > 0) {
-                columns[focused_column].selected_index--;
-                display_columns();
+        case KEY_PAGE_UP:
+            if (has_selection && column->selected_index > 0) {
+                size_t step = key == KEY_PAGE_UP ? COLUMN_VIEW_ROWS : 1;
+                column->selected_index = column->selected_index > step ? column->selected_index - step : 0;
+                column_scroll_to_selection(focused_column);
+                request_redraw(display_columns);
             }
             break;
 
         case KEY_ARROW_DOWN:
-            if (focused_col_file_count > 0 && columns[focused_column].selected_index < columns[focused_column].file_count - 1) {
-                columns[focused_column].selected_index++;
-                display_columns();
+        case KEY_PAGE_DOWN: {
+            // Moving down only needs to know that the next entries exist, not the directory size
+            size_t step = key == KEY_PAGE_DOWN ? COLUMN_VIEW_ROWS : 1;
+            size_t available = column_entries(focused_column, column->selected_index + 1, column_window, step);
+            if (available > 0) {
+                column->selected_index += available;
+                column_scroll_to_selection(focused_column);
+                request_redraw(display_columns);
             }
             break;
+        }
 
         case KEY_ARROW_RIGHT: // Open folder or process file
         case KEY_ENTER:       // **NEW: Handle Enter key the same way**
-            if (focused_col_file_count > 0) {
-                size_t selected = columns[focused_column].selected_index;
+            if (has_selection) {
                 char selected_path[MAX_PATH_LEN];
-
-                size_t dir_len = strlen(columns[focused_column].directory);
-                if (dir_len > 0 && columns[focused_column].directory[dir_len - 1] == '/') {
-                    snprintf(selected_path, sizeof(selected_path), "%s%s", columns[focused_column].directory, columns[focused_column].file_list[selected]);
-                } else {
-                    snprintf(selected_path, sizeof(selected_path), "%s/%s", columns[focused_column].directory, columns[focused_column].file_list[selected]);
+                if (!column_entry_path(focused_column, selected.name, selected_path, sizeof(selected_path))) {
+                    vscreen_set_status("Path too long.");
+                    request_redraw(display_columns);
+                    break;
                 }
 
-                hal_display_write("DEBUG: Selected Path: ");
-                hal_display_write(selected_path);
-                hal_display_write("\n");
-
-                if (hal_storage_is_directory(selected_path)) {
+                // The listing already knows the type, no storage round-trip needed
+                if (selected.type == DIR_ENTRY_DIRECTORY) {
                     // Open the directory
-                    hal_display_write("DEBUG: It's a directory.\n");
                     if (column_count < MAX_COLUMNS) {
                         load_directory(column_count, selected_path);
                         column_count++;
                         focused_column++;
-                        display_columns();
+                        request_redraw(display_columns);
                     } else {
-                        hal_display_write("Maximum column limit reached.\n");
+                        vscreen_set_status("Maximum column limit reached.");
+                        request_redraw(display_columns);
                     }
                 } else {
                     // Open file in edit mode
-                    hal_display_write("DEBUG: It's a file. Opening in edit mode...\n");
                     enter_edit_mode(selected_path);
                 }
             } else {
-                hal_display_write("No items to open in this directory.\n");
+                vscreen_set_status("No items to open in this directory.");
+                request_redraw(display_columns);
             }
             break;
 
@@ -628,16 +1603,17 @@ static void handle_normal_navigation(KeyCode key) {
                     memset(&columns[i], 0, sizeof(DirectoryColumn));
                 }
                 column_count = focused_column + 1;
-                display_columns();
+                request_redraw(display_columns);
             }
             break;
 
         case KEY_CTRL_R:
-            if (focused_col_file_count > 0) {
+            if (has_selection) {
                 // Enter rename mode only if there are items to rename
                 enter_rename_mode();
             } else {
-                hal_display_write("No items to rename in this directory.\n");
+                vscreen_set_status("No items to rename in this directory.");
+                request_redraw(display_columns);
             }
             break;
 
@@ -646,6 +1622,20 @@ static void handle_normal_navigation(KeyCode key) {
             enter_new_file_mode();
             break;
 
+        case KEY_F1:
+            enter_find_mode();
+            break;
+
+        case KEY_CTRL_F:
+            enter_search_mode();
+            break;
+
+#ifdef CYBERTYPER_PERF
+        case KEY_F3:
+            enter_perf_mode();
+            break;
+#endif
+
         default:
             break;
     }
@@ -654,48 +1644,119 @@ static void handle_normal_navigation(KeyCode key) {
 
 
 
-//main loop handler for timing updates (cursor blinking) and dispatching key events to the appropriate state handler.
-/*Improvement:
-	•	Consider a state machine approach: one function per state that handles keys and updates UI.
-	•	Make cursor blinking timing configurable.
-	•	Add comments explaining each step (blink logic, input handling, display refresh).*/
-void cybertyper_run_cycle(void) {
-    if (!initialized) {
-        return;
+#ifdef CYBERTYPER_PERF
+// Stats overlay (F3): the counters of the instrumented hot paths. The overlay
+// is a screen like any other, so drawing it shows up in the counters too.
+static void enter_perf_mode(void) {
+    current_state = STATE_PERF;
+    request_redraw(display_perf_screen);
+}
+
+static void display_perf_screen(void) {
+    char line[VSCREEN_COLS + 1];
+
+    vscreen_begin_frame();
+    vscreen_write("Performance counters since startup or the last reset\n");
+    perf_stats_format_header(line, sizeof(line));
+    vscreen_write_at(2, 0, line, VSCREEN_COLS);
+    for (int probe = 0; probe < PERF_PROBE_COUNT; probe++) {
+        perf_stats_format((PerfProbe)probe, line, sizeof(line));
+        vscreen_write_at(3 + probe, 0, line, VSCREEN_COLS);
+    }
+    vscreen_write_at(COLUMN_VIEW_ROWS + 2, 0,
+                     "Any key to refresh, Ctrl+S to write " PERF_DUMP_PATH ", Ctrl+R to reset, Esc to close.",
+                     VSCREEN_COLS);
+    vscreen_flush();
+}
+
+// Writes the overlay as a text file to the root of the card.
+static void write_perf_dump(void) {
+    char text[(PERF_PROBE_COUNT + 1) * (VSCREEN_COLS + 1)];
+    size_t length = 0;
+    for (int probe = -1; probe < PERF_PROBE_COUNT; probe++) {
+        char *line = text + length;
+        size_t room = sizeof(text) - length;
+        int written = probe < 0 ? perf_stats_format_header(line, room) : perf_stats_format((PerfProbe)probe, line, room);
+        if (written < 0 || (size_t)written + 1 >= room) {
+            break;
+        }
+        length += (size_t)written;
+        text[length++] = '\n';
+    }
+
+    bool existed = hal_storage_file_exists(PERF_DUMP_PATH);
+    if (hal_storage_write_file(PERF_DUMP_PATH, text, length)) {
+        if (!existed) {
+            path_index_add(&path_index, PERF_DUMP_PATH, DIR_ENTRY_FILE);
+        }
+        dir_cache_invalidate("/");
+        vscreen_set_status("Wrote " PERF_DUMP_PATH ".");
+    } else {
+        vscreen_set_status("Could not write " PERF_DUMP_PATH ".");
+    }
+}
+
+static void handle_perf_input(KeyCode key) {
+    switch (key) {
+        case KEY_ESCAPE:
+        case KEY_F3:
+            current_state = STATE_NORMAL;
+            request_redraw(display_columns);
+            return;
+        case KEY_CTRL_S:
+            write_perf_dump();
+            break;
+        case KEY_CTRL_R:
+            perf_stats_reset();
+            vscreen_set_status("Counters reset.");
+            break;
+        default:
+            break;
     }
+    request_redraw(display_perf_screen);
+}
+#endif
 
-    // Handle cursor blinking
-    time_t current_time = time(NULL);
-    if (difftime(current_time, last_toggle_time) >= 0.5) {
+// Marks a screen to be drawn at the end of the current cycle. Handlers call this
+// instead of drawing, so a burst of keys is rendered once; the last request wins.
+static void request_redraw(void (*screen)(void)) {
+    pending_redraw = screen;
+}
+
+// Shows the cursor and schedules the next blink one period from now.
+static void restart_cursor_blink(void) {
+    cursor_visible = true;
+    next_blink_ms = hal_time_ms() + CURSOR_BLINK_MS;
+}
+
+// Milliseconds until the next timer deadline, or HAL_WAIT_FOREVER if none is armed.
+// Only the editor shows a blinking cursor; the other screens are fully idle between keys.
+static uint32_t next_timeout_ms(void) {
+    if (current_state != STATE_EDITING) {
+        return HAL_WAIT_FOREVER;
+    }
+    int32_t remaining = (int32_t)(next_blink_ms - hal_time_ms());
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+// Runs the timers whose deadline has passed.
+static void handle_timers(void) {
+    if (current_state != STATE_EDITING) {
+        return;
+    }
+    uint32_t now = hal_time_ms();
+    if ((int32_t)(now - next_blink_ms) >= 0) {
         cursor_visible = !cursor_visible;
-        last_toggle_time = current_time;
-
-        // Update the display based on current state
-        switch (current_state) {
-            case STATE_EDITING:
-                display_editor_screen();
-                break;
-            case STATE_RENAME:
-                display_rename_mode_screen();
-                break;
-            case STATE_NEW_FOLDER:
-                display_new_folder_screen();
-                break;
-            case STATE_NEW_FILE:
-                display_new_file_screen();
-                break;
-            default:
-                display_columns();
-                break;
-        }
-    }
-
-    KeyCode key = hal_input_get_key();
-    if (key == KEY_NONE) {
-        return; 
-    }
-
-    // Handle different states
+        next_blink_ms += CURSOR_BLINK_MS;
+        if ((int32_t)(now - next_blink_ms) >= 0) {
+            next_blink_ms = now + CURSOR_BLINK_MS; // Fell behind, resynchronize
+        }
+        request_redraw(display_editor_screen);
+    }
+}
+
+// Routes one key to the handler of the current state.
+static void dispatch_key(KeyCode key) {
     switch (current_state) {
         case STATE_EDITING:
             handle_editor_input(key);
@@ -709,9 +1770,76 @@ void cybertyper_run_cycle(void) {
         case STATE_NEW_FILE:
             handle_new_file_input(key);
             break;
+        case STATE_FIND:
+            handle_find_input(key);
+            break;
+        case STATE_SEARCH:
+            handle_search_input(key);
+            break;
+#ifdef CYBERTYPER_PERF
+        case STATE_PERF:
+            handle_perf_input(key);
+            break;
+#endif
         default:
             // Handle normal navigation
             handle_normal_navigation(key);
             break;
     }
-}
\ No newline at end of file
+}
+
+// Main loop handler: waits for the next event, runs due timers (cursor blinking),
+// dispatches every pending key event to the appropriate state handler and then
+// renders the screen once for the whole batch.
+// Blocking in hal_event_wait instead of polling means a key is handled as soon as it
+// arrives and the CPU sleeps while nothing happens.
+void cybertyper_run_cycle(void) {
+    if (!initialized) {
+        return;
+    }
+
+    // Sleep until a key arrives or the next timer is due
+    bool input_ready = hal_event_wait(next_timeout_ms());
+
+    handle_timers();
+
+    StorageJob job;
+    while (storage_worker_poll(&job)) {
+        handle_storage_job(&job);
+    }
+
+    if (input_ready) {
+        KeyEvent events[KEY_BATCH_SIZE];
+        size_t count;
+        bool first_batch = true;
+
+        while ((count = hal_input_read_keys(events, KEY_BATCH_SIZE)) > 0) {
+            if (first_batch) {
+                // Status messages stay visible until the next key press
+                vscreen_set_status("");
+                // Typing keeps the cursor solid
+                restart_cursor_blink();
+                first_batch = false;
+            }
+
+            uint32_t now = hal_time_ms();
+            for (size_t i = 0; i < count; i++) {
+                uint32_t delay = now - events[i].timestamp_ms;
+                if (delay > max_input_delay_ms) {
+                    max_input_delay_ms = delay;
+                }
+                dispatch_key(events[i].key);
+            }
+        }
+    }
+
+    if (pending_redraw) {
+        void (*screen)(void) = pending_redraw;
+        pending_redraw = NULL;
+        screen();
+    }
+}
+
+uint32_t cybertyper_max_input_delay_ms(void) {
+    return max_input_delay_ms;
+}
@@ -2,6 +2,7 @@
 #define CYBERTYPER_CORE_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * @brief Initialize the CyberTyper application logic.
@@ -17,12 +18,21 @@ void cybertyper_init(void);
  * 
  * This function should be called repeatedly, typically in a loop, to drive 
  * the CyberTyper’s application state forward. Each call:
- *  - Processes user input events.
- *  - Updates application state and UI if needed.
- *  - Handles file I/O operations pending for this cycle.
+ *  - Blocks in hal_event_wait() until a key arrives or the next timer
+ *    (e.g. the cursor blink) is due, so no extra sleep is needed.
+ *  - Runs the timers whose deadline has passed.
+ *  - Finishes the storage jobs the worker has completed (saves, read-ahead).
+ *  - Processes every pending key event in one batch.
+ *  - Redraws the screen once at the end if anything changed.
  * 
  * Ensure that `cybertyper_init()` has been called before invoking this function.
  */
 void cybertyper_run_cycle(void);
 
+/**
+ * @brief Returns the longest delay seen between a key being captured by the
+ *        HAL and being handled by the core, in milliseconds.
+ */
+uint32_t cybertyper_max_input_delay_ms(void);
+
 #endif // CYBERTYPER_CORE_H
\ No newline at end of file
@@ -0,0 +1,256 @@
+// dir_cache.c
+
+#include "dir_cache.h"
+#include "hal_interface.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    char path[DIR_CACHE_PATH_LEN];
+    size_t start;                            // Index of entries[0], a multiple of DIR_CACHE_CHUNK
+    uint64_t stamp;                          // hal_storage_dir_stamp when the chunk was valid
+    DirEntry entries[DIR_CACHE_CHUNK];
+    size_t count;                            // Less than DIR_CACHE_CHUNK in the last chunk
+    uint32_t last_used;
+    bool valid;
+} DirCacheSlot;
+
+#define NO_HIDDEN SIZE_MAX
+
+static DirCacheSlot slots[DIR_CACHE_SLOTS];
+static uint32_t clock_tick = 0;
+static DirCacheStats stats;
+
+// The entry left out of listings, and where it was last found in its folder
+static char hidden_dir[DIR_CACHE_PATH_LEN];
+static char hidden_name[HAL_NAME_LEN];
+static uint64_t hidden_stamp;
+static size_t hidden_index = NO_HIDDEN;
+static bool hidden_known = false;
+
+// -----------------------------------------------------------------------------
+/* Internal Helpers */
+// -----------------------------------------------------------------------------
+
+static DirCacheSlot *find_slot(const char *directory, size_t start) {
+    for (size_t i = 0; i < DIR_CACHE_SLOTS; i++) {
+        if (slots[i].valid && slots[i].start == start && strcmp(slots[i].path, directory) == 0) {
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+// Returns an unused slot, or the least recently used one.
+static DirCacheSlot *victim_slot(void) {
+    DirCacheSlot *victim = &slots[0];
+    for (size_t i = 0; i < DIR_CACHE_SLOTS; i++) {
+        if (!slots[i].valid) {
+            return &slots[i];
+        }
+        if (slots[i].last_used < victim->last_used) {
+            victim = &slots[i];
+        }
+    }
+    return victim;
+}
+
+// Joins a directory and an entry name the way the file explorer builds paths.
+static void join_path(char *out, size_t size, const char *directory, const char *name) {
+    size_t len = strlen(directory);
+    if (len > 0 && directory[len - 1] == '/') {
+        snprintf(out, size, "%s%s", directory, name);
+    } else {
+        snprintf(out, size, "%s/%s", directory, name);
+    }
+}
+
+// Drops every chunk of path and, if subtree is set, of every directory below it.
+static void invalidate_path(const char *path, bool subtree) {
+    size_t len = strlen(path);
+    for (size_t i = 0; i < DIR_CACHE_SLOTS; i++) {
+        if (slots[i].valid && strncmp(slots[i].path, path, len) == 0 &&
+            (slots[i].path[len] == '\0' || (subtree && slots[i].path[len] == '/'))) {
+            slots[i].valid = false;
+        }
+    }
+}
+
+// Returns the first chunk of a directory if it holds the whole directory.
+static DirCacheSlot *single_chunk(const char *directory) {
+    DirCacheSlot *slot = find_slot(directory, 0);
+    return (slot && slot->count < DIR_CACHE_CHUNK) ? slot : NULL;
+}
+
+// After an in-place update the directory stamp has moved on; take the new one
+// so the next lookup is still a hit.
+static void refresh_stamp(DirCacheSlot *slot) {
+    if (!hal_storage_dir_stamp(slot->path, &slot->stamp)) {
+        slot->valid = false;
+    }
+}
+
+// Returns the chunk starting at start, reading it if needed.
+static DirCacheSlot *load_chunk(const char *directory, size_t start, uint64_t stamp, bool have_stamp) {
+    DirCacheSlot *slot = find_slot(directory, start);
+    if (slot) {
+        stats.hits++;
+    } else {
+        stats.reads++;
+        slot = victim_slot();
+        strncpy(slot->path, directory, DIR_CACHE_PATH_LEN - 1);
+        slot->path[DIR_CACHE_PATH_LEN - 1] = '\0';
+        slot->start = start;
+        slot->count = hal_storage_list_entries(directory, start, slot->entries, DIR_CACHE_CHUNK);
+        slot->stamp = stamp;
+        slot->valid = have_stamp;  // Never cache a directory we cannot revalidate
+    }
+    slot->last_used = ++clock_tick;
+    return slot;
+}
+
+// Copies entries start .. start + max - 1 as the storage lists them, hidden entry included.
+static size_t read_entries(const char *directory, size_t start, DirEntry *entries, size_t max, uint64_t stamp,
+                           bool have_stamp) {
+    size_t count = 0;
+    while (count < max) {
+        size_t index = start + count;
+        size_t chunk_start = index - index % DIR_CACHE_CHUNK;
+        DirCacheSlot *slot = load_chunk(directory, chunk_start, stamp, have_stamp);
+
+        size_t offset = index - chunk_start;
+        if (offset >= slot->count) {
+            break;  // End of the directory
+        }
+        size_t n = slot->count - offset;
+        if (n > max - count) {
+            n = max - count;
+        }
+        memcpy(&entries[count], &slot->entries[offset], n * sizeof(DirEntry));
+        count += n;
+        if (slot->count < DIR_CACHE_CHUNK) {
+            break;  // That was the last chunk
+        }
+    }
+    return count;
+}
+
+// Returns the position of the hidden entry in directory, or NO_HIDDEN. It is
+// looked up through the cached chunks again only when the folder changed.
+static size_t find_hidden(const char *directory, uint64_t stamp, bool have_stamp) {
+    if (hidden_name[0] == '\0' || strcmp(directory, hidden_dir) != 0) {
+        return NO_HIDDEN;
+    }
+    if (hidden_known && have_stamp && hidden_stamp == stamp) {
+        return hidden_index;
+    }
+    hidden_index = NO_HIDDEN;
+    for (size_t start = 0; hidden_index == NO_HIDDEN; start += DIR_CACHE_CHUNK) {
+        DirCacheSlot *slot = load_chunk(directory, start, stamp, have_stamp);
+        for (size_t i = 0; i < slot->count; i++) {
+            if (strcmp(slot->entries[i].name, hidden_name) == 0) {
+                hidden_index = start + i;
+                break;
+            }
+        }
+        if (slot->count < DIR_CACHE_CHUNK) {
+            break;
+        }
+    }
+    hidden_stamp = stamp;
+    hidden_known = have_stamp;
+    return hidden_index;
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void dir_cache_init(void) {
+    memset(slots, 0, sizeof(slots));
+    memset(&stats, 0, sizeof(stats));
+    clock_tick = 0;
+    hidden_known = false;
+}
+
+void dir_cache_hide(const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (!slash) {
+        hidden_name[0] = '\0';
+        return;
+    }
+    snprintf(hidden_dir, sizeof(hidden_dir), "%.*s", slash == path ? 1 : (int)(slash - path), path);
+    snprintf(hidden_name, sizeof(hidden_name), "%s", slash + 1);
+    hidden_known = false;
+}
+
+size_t dir_cache_read(const char *directory, size_t start, DirEntry *entries, size_t max) {
+    stats.lookups++;
+
+    // One stamp check covers every chunk of the directory
+    uint64_t stamp = 0;
+    bool have_stamp = hal_storage_dir_stamp(directory, &stamp);
+    for (size_t i = 0; i < DIR_CACHE_SLOTS; i++) {
+        if (slots[i].valid && (!have_stamp || slots[i].stamp != stamp) &&
+            strcmp(slots[i].path, directory) == 0) {
+            slots[i].valid = false;  // Changed behind our back (or gone): read it again
+        }
+    }
+
+    size_t hidden = find_hidden(directory, stamp, have_stamp);
+    if (hidden == NO_HIDDEN) {
+        return read_entries(directory, start, entries, max, stamp, have_stamp);
+    }
+
+    // Entries after the hidden one move up by one
+    size_t first = start < hidden ? start : start + 1;
+    size_t count = read_entries(directory, first, entries, max, stamp, have_stamp);
+    if (hidden >= first && hidden < first + count) {
+        size_t at = hidden - first;
+        memmove(&entries[at], &entries[at + 1], (count - at - 1) * sizeof(DirEntry));
+        count--;
+        if (count + 1 == max) {
+            count += read_entries(directory, first + max, &entries[count], 1, stamp, have_stamp);
+        }
+    }
+    return count;
+}
+
+void dir_cache_note_created(const char *directory, const DirEntry *entry) {
+    DirCacheSlot *slot = single_chunk(directory);
+    if (!slot || strchr(entry->name, '/')) {
+        invalidate_path(directory, false);
+        return;
+    }
+    slot->entries[slot->count++] = *entry;
+    stats.updates++;
+    refresh_stamp(slot);
+}
+
+void dir_cache_note_renamed(const char *directory, const char *old_name, const char *new_name) {
+    char old_path[DIR_CACHE_PATH_LEN];
+    join_path(old_path, sizeof(old_path), directory, old_name);
+    invalidate_path(old_path, true);
+
+    DirCacheSlot *slot = single_chunk(directory);
+    if (slot && !strchr(new_name, '/')) {
+        for (size_t i = 0; i < slot->count; i++) {
+            if (strcmp(slot->entries[i].name, old_name) == 0) {
+                strncpy(slot->entries[i].name, new_name, HAL_NAME_LEN - 1);
+                slot->entries[i].name[HAL_NAME_LEN - 1] = '\0';
+                stats.updates++;
+                refresh_stamp(slot);
+                return;
+            }
+        }
+    }
+    invalidate_path(directory, false);
+}
+
+void dir_cache_invalidate(const char *directory) {
+    invalidate_path(directory, false);
+}
+
+DirCacheStats dir_cache_stats(void) {
+    return stats;
+}
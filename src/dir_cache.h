@@ -0,0 +1,86 @@
+#ifndef DIR_CACHE_H
+#define DIR_CACHE_H
+
+#include "hal_interface.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DIR_CACHE_CHUNK 32          // Entries read from storage at a time
+#define DIR_CACHE_SLOTS 16          // Chunks kept, least recently used is replaced
+#define DIR_CACHE_PATH_LEN 512
+
+/**
+ * @struct DirCacheStats
+ * @brief Counters for judging how often listings are served without a readdir.
+ */
+typedef struct {
+    uint32_t lookups;   // dir_cache_read calls
+    uint32_t hits;      // Chunks served from a slot whose stamp still matched
+    uint32_t reads;     // Chunks read through hal_storage_list_entries
+    uint32_t updates;   // Creates and renames applied in place
+} DirCacheStats;
+
+/**
+ * @brief Empties the cache.
+ */
+void dir_cache_init(void);
+
+/**
+ * @brief Leaves one entry out of every listing, for files the application keeps to itself.
+ *
+ * Entries after it in its folder move up by one. Finding it takes a pass over
+ * the cached chunks of that folder each time the folder changes.
+ *
+ * @param path Full path of the entry, such as "/.search".
+ */
+void dir_cache_hide(const char *path);
+
+/**
+ * @brief Copies entries start to start + max - 1 of a directory into entries.
+ *
+ * Directories are cached in fixed chunks of DIR_CACHE_CHUNK entries keyed by
+ * path and chunk, so only the part of a directory that is looked at is ever
+ * read or held in memory, however many entries it has. Cached chunks are
+ * revalidated with hal_storage_dir_stamp, a single stat of the directory per
+ * call; a chunk is only read again when the stamp changed or it is not cached.
+ *
+ * @param directory The directory path.
+ * @param start     Index of the first entry wanted.
+ * @param entries   Receives up to max entry records.
+ * @param max       Capacity of entries.
+ * @return Number of entries copied; less than max at the end of the directory.
+ */
+size_t dir_cache_read(const char *directory, size_t start, DirEntry *entries, size_t max);
+
+/**
+ * @brief Adds an entry created by the application to a cached listing.
+ *
+ * Call after a successful create so the next dir_cache_read does not have to
+ * read the directory again. entry is typically filled by hal_storage_stat.
+ * Directories larger than one chunk are dropped instead, because a fresh
+ * read may place the new entry anywhere.
+ */
+void dir_cache_note_created(const char *directory, const DirEntry *entry);
+
+/**
+ * @brief Renames an entry of a cached listing in place.
+ *
+ * The entry keeps its type, size and mtime, as a rename does not change them.
+ * Call after a successful rename inside directory. Cached listings below the
+ * old path are dropped, since a renamed folder moves everything under it.
+ * As with creates, only single-chunk directories are updated in place.
+ */
+void dir_cache_note_renamed(const char *directory, const char *old_name, const char *new_name);
+
+/**
+ * @brief Drops every cached chunk of a directory.
+ */
+void dir_cache_invalidate(const char *directory);
+
+/**
+ * @brief Returns the cache counters.
+ */
+DirCacheStats dir_cache_stats(void);
+
+#endif // DIR_CACHE_H
@@ -0,0 +1,440 @@
+// edit_journal.c
+
+#include "edit_journal.h"
+#include "hal_interface.h"
+#include "side_file.h"
+#include <stdlib.h>
+#include <string.h>
+
+// File layout: a header, then groups. A group is a run of records closed by
+// a commit record holding the byte count and CRC-32 of the records before it.
+// Numbers are 32-bit little endian.
+#define JOURNAL_MAGIC "CTJ1"
+#define HEADER_SIZE 8         // Magic, base length
+
+#define RECORD_INSERT 'I'     // pos, length, bytes
+#define RECORD_DELETE 'D'     // pos, length
+#define RECORD_MARKER 'K'     // new document length: compaction started
+#define RECORD_PATCH 'P'      // new document length: in-place compaction started
+#define RECORD_BLOCKS 'B'     // file offset, length, bytes: part of an in-place compaction
+#define RECORD_ABORT 'X'      // the last marker did not take effect
+#define RECORD_COMMIT 'C'     // group length, CRC-32
+
+#define COMMIT_SIZE 9
+
+// -----------------------------------------------------------------------------
+/* Encoding */
+// -----------------------------------------------------------------------------
+
+static void put_u32(char *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (char)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const char *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)(uint8_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+static uint32_t crc32(const char *data, size_t length) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint8_t)data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static bool pending_reserve(EditJournal *journal, size_t extra) {
+    if (journal->pending_length + extra <= journal->pending_capacity) {
+        return true;
+    }
+    size_t capacity = journal->pending_capacity ? journal->pending_capacity : 256;
+    while (capacity < journal->pending_length + extra) {
+        capacity *= 2;
+    }
+    char *grown = realloc(journal->pending, capacity);
+    if (!grown) {
+        journal->broken = true;
+        return false;
+    }
+    journal->pending = grown;
+    journal->pending_capacity = capacity;
+    return true;
+}
+
+static bool append_record(EditJournal *journal, char type, size_t pos, size_t length, const char *text) {
+    size_t size = 9 + (text ? length : 0);
+    if (!pending_reserve(journal, size)) {
+        return false;
+    }
+    char *out = journal->pending + journal->pending_length;
+    out[0] = type;
+    put_u32(out + 1, (uint32_t)pos);
+    put_u32(out + 5, (uint32_t)length);
+    if (text) {
+        memcpy(out + 9, text, length);
+    }
+    journal->pending_length += size;
+    return true;
+}
+
+// Builds a group from records at the end of the journal, with the header first
+// if the journal is new.
+static bool seal_records(EditJournal *journal, const char *records, size_t length, JournalGroup *group) {
+    size_t header = journal->length == 0 ? HEADER_SIZE : 0;
+    group->data = malloc(header + length + COMMIT_SIZE);
+    if (!group->data) {
+        journal->broken = true;
+        return false;
+    }
+    char *out = group->data;
+    if (header) {
+        memcpy(out, JOURNAL_MAGIC, 4);
+        put_u32(out + 4, journal->base_length);
+    }
+    memcpy(out + header, records, length);
+    out[header + length] = RECORD_COMMIT;
+    put_u32(out + header + length + 1, (uint32_t)length);
+    put_u32(out + header + length + 5, crc32(records, length));
+
+    strcpy(group->path, journal->path);
+    group->offset = journal->length;
+    group->length = header + length + COMMIT_SIZE;
+    journal->length += group->length;
+    journal->live += group->length;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Recording */
+// -----------------------------------------------------------------------------
+
+bool edit_journal_open(EditJournal *journal, const char *doc_path, size_t doc_length) {
+    memset(journal, 0, sizeof(*journal));
+    if (!side_file_path(doc_path, SIDE_FILE_JOURNAL, journal->path, sizeof(journal->path))) {
+        return false;
+    }
+    journal->base_length = (uint32_t)doc_length;
+    return true;
+}
+
+void edit_journal_close(EditJournal *journal) {
+    free(journal->pending);
+    journal->pending = NULL;
+    journal->pending_length = 0;
+    journal->pending_capacity = 0;
+}
+
+bool edit_journal_insert(EditJournal *journal, size_t pos, const char *text, size_t length) {
+    return append_record(journal, RECORD_INSERT, pos, length, text);
+}
+
+bool edit_journal_delete(EditJournal *journal, size_t pos, size_t length) {
+    return append_record(journal, RECORD_DELETE, pos, length, NULL);
+}
+
+void edit_journal_drop_pending(EditJournal *journal) {
+    journal->pending_length = 0;
+}
+
+bool edit_journal_seal(EditJournal *journal, JournalGroup *group) {
+    if (journal->pending_length == 0 || !seal_records(journal, journal->pending, journal->pending_length, group)) {
+        return false;
+    }
+    journal->pending_length = 0;
+    return true;
+}
+
+bool edit_journal_seal_marker(EditJournal *journal, size_t new_length, JournalGroup *group) {
+    char record[5];
+    record[0] = RECORD_MARKER;
+    put_u32(record + 1, (uint32_t)new_length);
+    return seal_records(journal, record, sizeof(record), group);
+}
+
+bool edit_journal_seal_patch(EditJournal *journal, const DocSnapshot *snapshot, JournalGroup *group) {
+    size_t length = 5;
+    for (size_t i = 0; i < snapshot->run_count; i++) {
+        length += 9 + snapshot->runs[i].length;
+    }
+    char *records = malloc(length);
+    if (!records) {
+        journal->broken = true;
+        return false;
+    }
+
+    // The block bytes are only known once gathered; edit_journal_fill_patch adds them
+    records[0] = RECORD_PATCH;
+    put_u32(records + 1, (uint32_t)snapshot->length);
+    size_t pos = 5;
+    for (size_t i = 0; i < snapshot->run_count; i++) {
+        records[pos] = RECORD_BLOCKS;
+        put_u32(records + pos + 1, (uint32_t)snapshot->runs[i].start);
+        put_u32(records + pos + 5, (uint32_t)snapshot->runs[i].length);
+        pos += 9 + snapshot->runs[i].length;
+    }
+    bool ok = seal_records(journal, records, length, group);
+    free(records);
+    return ok;
+}
+
+void edit_journal_fill_patch(JournalGroup *group, const DocSnapshot *snapshot) {
+    size_t length = get_u32(group->data + group->length - COMMIT_SIZE + 1);
+    char *records = group->data + group->length - COMMIT_SIZE - length;
+    size_t pos = 5;
+    size_t data = 0;
+    for (size_t i = 0; i < snapshot->run_count; i++) {
+        memcpy(records + pos + 9, snapshot->patch + data, snapshot->runs[i].length);
+        pos += 9 + snapshot->runs[i].length;
+        data += snapshot->runs[i].length;
+    }
+    put_u32(records + length + 5, crc32(records, length));
+}
+
+bool edit_journal_write(const JournalGroup *group) {
+    if (group->offset == 0) {
+        // The group with the header starts the file over: nothing of an older
+        // journal may follow it
+        return hal_storage_write_file(group->path, group->data, group->length);
+    }
+    return hal_storage_write_range(group->path, group->offset, group->data, group->length);
+}
+
+void edit_journal_group_free(JournalGroup *group) {
+    free(group->data);
+    group->data = NULL;
+    group->length = 0;
+}
+
+bool edit_journal_needs_compaction(const EditJournal *journal) {
+    return journal->broken || journal->live >= EDIT_JOURNAL_COMPACT_BYTES;
+}
+
+void edit_journal_compacted(EditJournal *journal, const JournalGroup *marker, size_t new_length) {
+    size_t marker_end = marker->offset + marker->length;
+    if (journal->length == marker_end) {
+        // Nothing was saved during the compaction: the journal is spent
+        edit_journal_reset(journal, new_length);
+        return;
+    }
+    journal->live = journal->length - marker_end;
+}
+
+void edit_journal_abort_marker(EditJournal *journal) {
+    char record = RECORD_ABORT;
+    JournalGroup group;
+    if (!seal_records(journal, &record, 1, &group)) {
+        return;
+    }
+    if (!edit_journal_write(&group)) {
+        journal->broken = true;
+    }
+    edit_journal_group_free(&group);
+}
+
+void edit_journal_restart(EditJournal *journal) {
+    edit_journal_drop_pending(journal);
+    journal->length = 0;
+    journal->live = 0;
+    journal->broken = false;
+}
+
+void edit_journal_reset(EditJournal *journal, size_t new_length) {
+    if (journal->length > 0) {
+        hal_storage_delete_file(journal->path);
+    }
+    journal->base_length = (uint32_t)new_length;
+    journal->length = 0;
+    journal->live = 0;
+    journal->broken = false;
+}
+
+bool edit_journal_exists(const EditJournal *journal) {
+    return journal->length > 0;
+}
+
+// -----------------------------------------------------------------------------
+/* Replay */
+// -----------------------------------------------------------------------------
+
+// Checks the group starting at pos: its records must be well formed and end in
+// a commit record with a matching CRC. Returns the end of the group, or 0.
+static size_t group_end(const char *data, size_t size, size_t pos) {
+    size_t start = pos;
+    while (pos < size) {
+        char type = data[pos];
+        size_t need = type == RECORD_INSERT || type == RECORD_DELETE || type == RECORD_BLOCKS ? 9
+                    : type == RECORD_MARKER || type == RECORD_PATCH ? 5
+                    : type == RECORD_ABORT ? 1
+                    : type == RECORD_COMMIT ? COMMIT_SIZE : 0;
+        if (need == 0 || size - pos < need) {
+            return 0;
+        }
+        if (type == RECORD_COMMIT) {
+            size_t length = pos - start;
+            bool intact = get_u32(data + pos + 1) == length && get_u32(data + pos + 5) == crc32(data + start, length);
+            return intact && length > 0 ? pos + COMMIT_SIZE : 0;
+        }
+        if (type == RECORD_INSERT || type == RECORD_BLOCKS) {
+            need += get_u32(data + pos + 5);
+            if (size - pos < need) {
+                return 0;
+            }
+        }
+        pos += need;
+    }
+    return 0;
+}
+
+// Applies the insert and delete records of [pos, end) to doc.
+static bool apply_records(PagedDocument *doc, const char *data, size_t pos, size_t end, bool *changed) {
+    while (pos < end) {
+        char type = data[pos];
+        if (type == RECORD_COMMIT) {
+            pos += COMMIT_SIZE;
+            continue;
+        }
+        if (type == RECORD_MARKER || type == RECORD_PATCH || type == RECORD_ABORT) {
+            pos += type == RECORD_ABORT ? 1 : 5;
+            continue;
+        }
+        if (type == RECORD_BLOCKS) {
+            pos += 9 + get_u32(data + pos + 5);
+            continue;
+        }
+        size_t at = get_u32(data + pos + 1);
+        size_t length = get_u32(data + pos + 5);
+        if (at > paged_doc_length(doc)) {
+            return false;
+        }
+        if (type == RECORD_INSERT) {
+            if (!paged_doc_insert(doc, at, data + pos + 9, length)) {
+                return false;
+            }
+            pos += 9 + length;
+        } else {
+            if (paged_doc_delete(doc, at, length) != length) {
+                return false;
+            }
+            pos += 9;
+        }
+        *changed = true;
+    }
+    return true;
+}
+
+// Writes the blocks of the in-place compaction group at pos into the file
+// again. The compaction may have been cut short; its blocks are the same either way.
+static bool redo_patch(const char *doc_path, const char *data, size_t pos) {
+    uint32_t new_length = get_u32(data + pos + 1);
+    pos += 5;
+    while (data[pos] == RECORD_BLOCKS) {
+        uint32_t length = get_u32(data + pos + 5);
+        if (!hal_storage_write_range(doc_path, get_u32(data + pos + 1), data + pos + 9, length)) {
+            return false;
+        }
+        pos += 9 + length;
+    }
+    return hal_storage_truncate(doc_path, new_length);
+}
+
+bool edit_journal_replay(const char *doc_path, bool *applied) {
+    *applied = false;
+    char path[PAGED_DOC_PATH_LEN];
+    char side_path[PAGED_DOC_PATH_LEN];
+    if (!side_file_path(doc_path, SIDE_FILE_JOURNAL, path, sizeof(path))) {
+        return false;
+    }
+
+    long size = hal_storage_file_size(path);
+    if (size < 0) {
+        return true; // No journal
+    }
+    char *data = malloc(size > 0 ? (size_t)size : 1);
+    if (!data) {
+        return false;
+    }
+    if (hal_storage_read_range(path, 0, data, (size_t)size) != (int)size) {
+        free(data);
+        return false;
+    }
+
+    // Find the intact groups and the last marker that took effect
+    size_t end = HEADER_SIZE;
+    size_t apply_from = HEADER_SIZE;
+    uint32_t expected = 0;
+    bool compacting = false;
+    size_t patch = 0;      // Group of the last in-place compaction, if any
+    if ((size_t)size >= HEADER_SIZE && memcmp(data, JOURNAL_MAGIC, 4) == 0) {
+        expected = get_u32(data + 4);
+        size_t previous_from = apply_from;
+        uint32_t previous_expected = expected;
+        size_t previous_patch = patch;
+        size_t next;
+        while ((next = group_end(data, (size_t)size, end)) != 0) {
+            if (data[end] == RECORD_MARKER || data[end] == RECORD_PATCH) {
+                previous_from = apply_from;
+                previous_expected = expected;
+                previous_patch = patch;
+                apply_from = next;
+                expected = get_u32(data + end + 1);
+                compacting = data[end] == RECORD_MARKER;
+                patch = data[end] == RECORD_PATCH ? end : 0;
+            } else if (data[end] == RECORD_ABORT && compacting) {
+                apply_from = previous_from;
+                expected = previous_expected;
+                patch = previous_patch;
+                compacting = false;
+            }
+            end = next;
+        }
+    } else if (memcmp(data, JOURNAL_MAGIC, (size_t)size < 4 ? (size_t)size : 4) != 0) {
+        // Not written by this editor: kept, and the document is left alone
+        free(data);
+        return false;
+    } else {
+        // The first write was cut short inside the header: nothing was committed
+        end = 0;
+        apply_from = 0;
+    }
+
+    // A compaction whose rename did not happen is finished first
+    if (compacting) {
+        if (side_file_path(doc_path, SIDE_FILE_TEMP, side_path, sizeof(side_path)) &&
+            hal_storage_file_exists(side_path)) {
+            hal_storage_rename_file(side_path, doc_path);
+            *applied = true;
+        }
+    }
+    if (side_file_path(doc_path, SIDE_FILE_OLD, side_path, sizeof(side_path)) &&
+        hal_storage_file_exists(side_path)) {
+        hal_storage_delete_file(side_path);
+    }
+
+    bool ok = patch == 0 || redo_patch(doc_path, data, patch);
+    *applied = *applied || patch != 0;
+    if (ok && apply_from < end) {
+        long doc_size = hal_storage_file_size(doc_path);
+        PagedDocument doc = { 0 };
+        ok = (doc_size < 0 ? 0 : (uint32_t)doc_size) == expected && paged_doc_open(&doc, doc_path);
+        if (ok) {
+            bool changed = false;
+            ok = apply_records(&doc, data, apply_from, end, &changed) && (!changed || paged_doc_save(&doc));
+            *applied = *applied || changed;
+        }
+        paged_doc_close(&doc);
+    }
+    free(data);
+
+    if (ok) {
+        hal_storage_delete_file(path);
+    }
+    return ok;
+}
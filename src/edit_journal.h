@@ -0,0 +1,197 @@
+#ifndef EDIT_JOURNAL_H
+#define EDIT_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "paged_document.h"
+
+#define EDIT_JOURNAL_COMPACT_BYTES 32768  // Journal bytes after which the document file is rewritten
+
+/**
+ * @struct JournalGroup
+ * @brief A run of journal records sealed for writing, ending in a commit record.
+ *
+ * Its place in the journal is fixed when it is sealed, so groups can be
+ * written by another thread in the order they were sealed.
+ */
+typedef struct {
+    char path[PAGED_DOC_PATH_LEN];  // Journal file
+    size_t offset;                  // Where the group goes in the journal
+    char *data;
+    size_t length;
+} JournalGroup;
+
+/**
+ * @struct EditJournal
+ * @brief Append-only log of the edits of one open document.
+ *
+ * Every insert and delete is recorded in RAM. A save seals the records since
+ * the previous save into one group and appends it to .<document>.ct-jnl, the
+ * SIDE_FILE_JOURNAL side file, so saving writes a few bytes instead of the
+ * whole file and never truncates the document. Each group ends with a CRC,
+ * so a group torn by a power loss is recognised and dropped on replay
+ * together with everything after it.
+ *
+ * From time to time the document is compacted: its content is written to a
+ * temporary file, a marker recording the new length is appended, and the
+ * temporary file replaces the document by rename. Replay applies only the
+ * groups after the last marker, finishing the rename first if it was
+ * interrupted, so a crash at any point leaves either the old file and its
+ * groups or the new file and the groups after it.
+ *
+ * When only a few blocks of the file change, compaction patches it in place
+ * instead. The marker of such a compaction carries the new bytes of those
+ * blocks and is written before the file is touched; replay writes them again,
+ * which completes a patch that was cut short.
+ */
+typedef struct {
+    char path[PAGED_DOC_PATH_LEN];  // Journal file
+    uint32_t base_length;           // Document file length the journal starts from
+    size_t length;                  // Journal bytes, including groups still being written
+    size_t live;                    // Bytes of groups after the last compaction marker
+    char *pending;                  // Records not sealed yet
+    size_t pending_length;
+    size_t pending_capacity;
+    bool broken;                    // A write failed, the next save has to rewrite the document
+} EditJournal;
+
+/**
+ * @brief Starts an empty journal for a document of doc_length bytes.
+ *
+ * Nothing is written until the first group is sealed.
+ *
+ * @return true on success, false if the path is too long.
+ */
+bool edit_journal_open(EditJournal *journal, const char *doc_path, size_t doc_length);
+
+/**
+ * @brief Drops the records that were not sealed and releases the journal memory.
+ *
+ * The journal file is kept; edit_journal_replay folds it into the document.
+ */
+void edit_journal_close(EditJournal *journal);
+
+/**
+ * @brief Records an insert of length bytes at pos.
+ *
+ * @return true on success, false if memory ran out. The journal is then
+ *         broken and the next save has to rewrite the document.
+ */
+bool edit_journal_insert(EditJournal *journal, size_t pos, const char *text, size_t length);
+
+/**
+ * @brief Records a delete of length bytes at pos.
+ *
+ * @return true on success, false if memory ran out (see edit_journal_insert).
+ */
+bool edit_journal_delete(EditJournal *journal, size_t pos, size_t length);
+
+/**
+ * @brief Forgets the pending records, for a save that writes the whole document instead.
+ */
+void edit_journal_drop_pending(EditJournal *journal);
+
+/**
+ * @brief Moves the pending records into a group at the end of the journal.
+ *
+ * The first group of a journal also carries its header.
+ *
+ * @return true if a group was sealed, false if nothing was pending or memory ran out.
+ */
+bool edit_journal_seal(EditJournal *journal, JournalGroup *group);
+
+/**
+ * @brief Seals a compaction marker: the document is being rewritten with new_length bytes.
+ *
+ * The marker must be written after the temporary file is complete and before it
+ * replaces the document.
+ *
+ * @return true on success, false if memory ran out.
+ */
+bool edit_journal_seal_marker(EditJournal *journal, size_t new_length, JournalGroup *group);
+
+/**
+ * @brief Seals the marker of an in-place compaction of snapshot.
+ *
+ * Room is reserved for the bytes of every run; they are filled in with
+ * edit_journal_fill_patch once gathered. The marker must be written before
+ * paged_doc_save_write patches the document.
+ *
+ * @return true on success, false if memory ran out.
+ */
+bool edit_journal_seal_patch(EditJournal *journal, const DocSnapshot *snapshot, JournalGroup *group);
+
+/**
+ * @brief Copies the gathered bytes of snapshot into its patch marker. May run on another thread.
+ */
+void edit_journal_fill_patch(JournalGroup *group, const DocSnapshot *snapshot);
+
+/**
+ * @brief Writes a sealed group to the card. May run on another thread.
+ *
+ * The first group of a journal replaces whatever the journal file held.
+ *
+ * @return true on success, false otherwise.
+ */
+bool edit_journal_write(const JournalGroup *group);
+
+/**
+ * @brief Releases the memory of a group.
+ */
+void edit_journal_group_free(JournalGroup *group);
+
+/**
+ * @brief Returns true once enough has been journaled to rewrite the document.
+ */
+bool edit_journal_needs_compaction(const EditJournal *journal);
+
+/**
+ * @brief Follows a compaction that replaced the document with new_length bytes.
+ *
+ * The journal file is removed if no group follows the marker.
+ */
+void edit_journal_compacted(EditJournal *journal, const JournalGroup *marker, size_t new_length);
+
+/**
+ * @brief Cancels the last marker after the document could not be replaced.
+ */
+void edit_journal_abort_marker(EditJournal *journal);
+
+/**
+ * @brief Starts a broken journal over, for a save that rewrites the whole document.
+ *
+ * Pending records are dropped. The next group sealed, normally the marker of
+ * the rewrite, carries a new header and replaces the journal file when it is
+ * written, so the groups of the broken journal can never be replayed onto the
+ * rewritten document.
+ */
+void edit_journal_restart(EditJournal *journal);
+
+/**
+ * @brief Removes the journal file after the document was rewritten in full.
+ *
+ * @param new_length Length of the rewritten document, the base of the next journal.
+ */
+void edit_journal_reset(EditJournal *journal, size_t new_length);
+
+/**
+ * @brief Returns true if the journal file holds groups.
+ */
+bool edit_journal_exists(const EditJournal *journal);
+
+/**
+ * @brief Writes the journaled edits of a document into its file and removes the journal.
+ *
+ * Used when the document is closed and at startup for journals left by a
+ * crash. An interrupted compaction is finished first, in place or by rename. Groups that are torn
+ * or fail their CRC are dropped with everything after them.
+ *
+ * @param applied Set to true if the document file was changed.
+ * @return true on success or if there is no journal, false if the journal
+ *         has no journal header, does not match the document or the document
+ *         could not be written. The journal is kept in that case.
+ */
+bool edit_journal_replay(const char *doc_path, bool *applied);
+
+#endif // EDIT_JOURNAL_H
@@ -0,0 +1,253 @@
+// editor_buffer.c
+
+#include "editor_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define EDITOR_BUFFER_MIN_CAPACITY 64
+
+// -----------------------------------------------------------------------------
+/* Internal Helpers */
+// -----------------------------------------------------------------------------
+
+static size_t gap_size(const EditorBuffer *eb) {
+    return eb->gap_end - eb->gap_start;
+}
+
+// Moves the gap so that it starts at text position pos.
+// Only the bytes between the old and the new gap position are shifted.
+static void move_gap(EditorBuffer *eb, size_t pos) {
+    if (pos < eb->gap_start) {
+        size_t count = eb->gap_start - pos;
+        memmove(eb->data + eb->gap_end - count, eb->data + pos, count);
+        eb->gap_start -= count;
+        eb->gap_end -= count;
+    } else if (pos > eb->gap_start) {
+        size_t count = pos - eb->gap_start;
+        memmove(eb->data + eb->gap_start, eb->data + eb->gap_end, count);
+        eb->gap_start += count;
+        eb->gap_end += count;
+    }
+}
+
+// Makes sure the gap can hold at least 'needed' bytes.
+// Capacity doubles on growth so a sequence of inserts stays amortized O(1).
+static bool ensure_gap(EditorBuffer *eb, size_t needed) {
+    if (gap_size(eb) >= needed) {
+        return true;
+    }
+
+    size_t length = editor_buffer_length(eb);
+    size_t new_capacity = eb->capacity ? eb->capacity : EDITOR_BUFFER_MIN_CAPACITY;
+    while (new_capacity - length < needed) {
+        new_capacity *= 2;
+    }
+
+    char *new_data = realloc(eb->data, new_capacity);
+    if (!new_data) {
+        return false;
+    }
+
+    // Slide the text after the gap to the end of the enlarged storage.
+    size_t tail = eb->capacity - eb->gap_end;
+    memmove(new_data + new_capacity - tail, new_data + eb->gap_end, tail);
+    eb->gap_end = new_capacity - tail;
+    eb->data = new_data;
+    eb->capacity = new_capacity;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Lifecycle */
+// -----------------------------------------------------------------------------
+
+bool editor_buffer_init(EditorBuffer *eb, size_t initial_capacity) {
+    if (initial_capacity < EDITOR_BUFFER_MIN_CAPACITY) {
+        initial_capacity = EDITOR_BUFFER_MIN_CAPACITY;
+    }
+    eb->data = malloc(initial_capacity);
+    if (!eb->data) {
+        eb->capacity = 0;
+        eb->gap_start = eb->gap_end = eb->cursor = 0;
+        return false;
+    }
+    eb->capacity = initial_capacity;
+    eb->gap_start = 0;
+    eb->gap_end = initial_capacity;
+    eb->cursor = 0;
+    return true;
+}
+
+void editor_buffer_free(EditorBuffer *eb) {
+    free(eb->data);
+    eb->data = NULL;
+    eb->capacity = 0;
+    eb->gap_start = eb->gap_end = eb->cursor = 0;
+}
+
+void editor_buffer_clear(EditorBuffer *eb) {
+    eb->gap_start = 0;
+    eb->gap_end = eb->capacity;
+    eb->cursor = 0;
+}
+
+bool editor_buffer_load(EditorBuffer *eb, const char *text, size_t length) {
+    char *storage = editor_buffer_prepare(eb, length);
+    if (!storage) {
+        return false;
+    }
+    memcpy(storage, text, length);
+    return true;
+}
+
+char *editor_buffer_prepare(EditorBuffer *eb, size_t length) {
+    editor_buffer_clear(eb);
+    if (!ensure_gap(eb, length + 1)) {
+        return NULL;
+    }
+    eb->gap_start = length;
+    eb->cursor = length;
+    return eb->data;
+}
+
+// -----------------------------------------------------------------------------
+/* Cursor */
+// -----------------------------------------------------------------------------
+
+size_t editor_buffer_length(const EditorBuffer *eb) {
+    return eb->capacity - gap_size(eb);
+}
+
+size_t editor_buffer_cursor(const EditorBuffer *eb) {
+    return eb->cursor;
+}
+
+void editor_buffer_set_cursor(EditorBuffer *eb, size_t pos) {
+    size_t length = editor_buffer_length(eb);
+    eb->cursor = pos > length ? length : pos;
+}
+
+bool editor_buffer_move_left(EditorBuffer *eb) {
+    if (eb->cursor == 0) {
+        return false;
+    }
+    eb->cursor--;
+    return true;
+}
+
+bool editor_buffer_move_right(EditorBuffer *eb) {
+    if (eb->cursor >= editor_buffer_length(eb)) {
+        return false;
+    }
+    eb->cursor++;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Editing */
+// -----------------------------------------------------------------------------
+
+bool editor_buffer_insert(EditorBuffer *eb, const char *text, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+    if (!ensure_gap(eb, length)) {
+        return false;
+    }
+    move_gap(eb, eb->cursor);
+    memcpy(eb->data + eb->gap_start, text, length);
+    eb->gap_start += length;
+    eb->cursor += length;
+    return true;
+}
+
+bool editor_buffer_insert_char(EditorBuffer *eb, char c) {
+    return editor_buffer_insert(eb, &c, 1);
+}
+
+size_t editor_buffer_delete_backward(EditorBuffer *eb, size_t count) {
+    if (count > eb->cursor) {
+        count = eb->cursor;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    move_gap(eb, eb->cursor);
+    eb->gap_start -= count;
+    eb->cursor -= count;
+    return count;
+}
+
+size_t editor_buffer_delete_forward(EditorBuffer *eb, size_t count) {
+    size_t available = editor_buffer_length(eb) - eb->cursor;
+    if (count > available) {
+        count = available;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    move_gap(eb, eb->cursor);
+    eb->gap_end += count;
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+/* Reading */
+// -----------------------------------------------------------------------------
+
+char editor_buffer_char_at(const EditorBuffer *eb, size_t pos) {
+    if (pos >= editor_buffer_length(eb)) {
+        return '\0';
+    }
+    return pos < eb->gap_start ? eb->data[pos] : eb->data[pos + gap_size(eb)];
+}
+
+size_t editor_buffer_spans(const EditorBuffer *eb, size_t start, size_t length, EditorSpan spans[2]) {
+    size_t text_length = editor_buffer_length(eb);
+    if (start >= text_length || length == 0) {
+        return 0;
+    }
+    if (length > text_length - start) {
+        length = text_length - start;
+    }
+
+    size_t count = 0;
+    size_t end = start + length;
+
+    // Part before the gap
+    if (start < eb->gap_start) {
+        size_t stop = end < eb->gap_start ? end : eb->gap_start;
+        spans[count].text = eb->data + start;
+        spans[count].length = stop - start;
+        count++;
+        start = stop;
+    }
+
+    // Part after the gap
+    if (start < end) {
+        spans[count].text = eb->data + start + gap_size(eb);
+        spans[count].length = end - start;
+        count++;
+    }
+    return count;
+}
+
+size_t editor_buffer_copy(const EditorBuffer *eb, size_t start, char *out, size_t length) {
+    EditorSpan spans[2];
+    size_t count = editor_buffer_spans(eb, start, length, spans);
+    size_t copied = 0;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(out + copied, spans[i].text, spans[i].length);
+        copied += spans[i].length;
+    }
+    return copied;
+}
+
+const char *editor_buffer_contiguous(EditorBuffer *eb) {
+    if (!eb->data || !ensure_gap(eb, 1)) {
+        return NULL;
+    }
+    move_gap(eb, editor_buffer_length(eb));
+    eb->data[eb->gap_start] = '\0';
+    return eb->data;
+}
@@ -0,0 +1,155 @@
+#ifndef EDITOR_BUFFER_H
+#define EDITOR_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @struct EditorBuffer
+ * @brief Growable gap buffer holding the text of the document being edited.
+ *
+ * The text lives in [0, gap_start) and [gap_end, capacity). Cursor moves are
+ * O(1); the gap is only relocated to the cursor when text is inserted or
+ * deleted there, which shifts just the bytes between the old and the new gap
+ * position. Typing at one spot is therefore amortized O(1) per key no matter
+ * how long the file is.
+ */
+typedef struct {
+    char *data;        // Backing storage, text + gap
+    size_t capacity;   // Size of data in bytes
+    size_t gap_start;  // First byte of the gap
+    size_t gap_end;    // First byte after the gap
+    size_t cursor;     // Cursor position in text coordinates
+} EditorBuffer;
+
+/**
+ * @struct EditorSpan
+ * @brief A read-only view of contiguous text inside an EditorBuffer.
+ *
+ * Spans point into the buffer storage and stay valid until the next call that
+ * modifies the buffer.
+ */
+typedef struct {
+    const char *text;
+    size_t length;
+} EditorSpan;
+
+/**
+ * @brief Initializes an empty buffer with room for initial_capacity bytes.
+ *
+ * @return true on success, false if the allocation failed.
+ */
+bool editor_buffer_init(EditorBuffer *eb, size_t initial_capacity);
+
+/**
+ * @brief Releases the buffer storage. The buffer may be re-initialized afterwards.
+ */
+void editor_buffer_free(EditorBuffer *eb);
+
+/**
+ * @brief Removes all text and moves the cursor to 0. Keeps the allocation.
+ */
+void editor_buffer_clear(EditorBuffer *eb);
+
+/**
+ * @brief Replaces the whole content with text and places the cursor at the end.
+ *
+ * @return true on success, false if the buffer could not grow.
+ */
+bool editor_buffer_load(EditorBuffer *eb, const char *text, size_t length);
+
+/**
+ * @brief Replaces the whole content with length bytes the caller fills in.
+ *
+ * Lets a loader read straight into the buffer storage without an intermediate
+ * copy. The cursor is placed at the end of the new content.
+ *
+ * @return Pointer to length writable bytes, or NULL if the buffer could not grow.
+ */
+char *editor_buffer_prepare(EditorBuffer *eb, size_t length);
+
+/**
+ * @brief Returns the number of text bytes in the buffer.
+ */
+size_t editor_buffer_length(const EditorBuffer *eb);
+
+/**
+ * @brief Returns the cursor position (0 .. length).
+ */
+size_t editor_buffer_cursor(const EditorBuffer *eb);
+
+/**
+ * @brief Moves the cursor to pos, clamped to the text length.
+ */
+void editor_buffer_set_cursor(EditorBuffer *eb, size_t pos);
+
+/**
+ * @brief Moves the cursor one byte left. Returns false at the start of the text.
+ */
+bool editor_buffer_move_left(EditorBuffer *eb);
+
+/**
+ * @brief Moves the cursor one byte right. Returns false at the end of the text.
+ */
+bool editor_buffer_move_right(EditorBuffer *eb);
+
+/**
+ * @brief Inserts length bytes at the cursor and advances the cursor past them.
+ *
+ * @return true on success, false if the buffer could not grow.
+ */
+bool editor_buffer_insert(EditorBuffer *eb, const char *text, size_t length);
+
+/**
+ * @brief Inserts a single character at the cursor.
+ */
+bool editor_buffer_insert_char(EditorBuffer *eb, char c);
+
+/**
+ * @brief Deletes up to count bytes before the cursor (Backspace).
+ *
+ * @return The number of bytes actually deleted.
+ */
+size_t editor_buffer_delete_backward(EditorBuffer *eb, size_t count);
+
+/**
+ * @brief Deletes up to count bytes after the cursor (Delete).
+ *
+ * @return The number of bytes actually deleted.
+ */
+size_t editor_buffer_delete_forward(EditorBuffer *eb, size_t count);
+
+/**
+ * @brief Returns the character at text position pos, or '\0' if out of range.
+ */
+char editor_buffer_char_at(const EditorBuffer *eb, size_t pos);
+
+/**
+ * @brief Returns the text range [start, start + length) as at most two spans.
+ *
+ * The range is clamped to the text. No bytes are copied.
+ *
+ * @param spans Output array of two spans.
+ * @return The number of non-empty spans filled in (0, 1 or 2).
+ */
+size_t editor_buffer_spans(const EditorBuffer *eb, size_t start, size_t length, EditorSpan spans[2]);
+
+/**
+ * @brief Copies up to length bytes starting at start into out.
+ *
+ * @return The number of bytes copied. out is not null-terminated.
+ */
+size_t editor_buffer_copy(const EditorBuffer *eb, size_t start, char *out, size_t length);
+
+/**
+ * @brief Makes the text contiguous and null-terminated, e.g. for saving.
+ *
+ * Moves the gap to the end of the text, which costs O(distance) once. The
+ * cursor position is preserved. The pointer stays valid until the next
+ * modification of the buffer.
+ *
+ * @return Pointer to the text, or NULL if the buffer is not initialized.
+ */
+const char *editor_buffer_contiguous(EditorBuffer *eb);
+
+#endif // EDITOR_BUFFER_H
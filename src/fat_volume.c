@@ -0,0 +1,1674 @@
+// fat_volume.c
+//
+// A FAT32 driver on a BlockDevice, shaped like FatFs so the sectors it
+// touches are the ones the card will see: paths are resolved by scanning
+// directory sectors, file offsets by walking cluster chains in the FAT, and
+// every call starts from the path again, as the HAL opens and closes per
+// call. Two LRU sector caches sit in front of the device, one for directory
+// entries and partial data sectors and one for the FAT, so streaming file
+// data cannot evict the table. Whole data sectors bypass the caches and move
+// one multi-sector command per cluster, as FatFs does.
+//
+// Every device command is counted against the operation that issued it.
+
+#include "fat_volume.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SECTOR_SIZE HAL_STORAGE_BLOCK_SIZE
+#define DIR_ENTRY_SIZE 32
+#define ENTRIES_PER_SECTOR (SECTOR_SIZE / DIR_ENTRY_SIZE)
+
+#define FAT_ENTRY_MASK 0x0FFFFFFFu
+#define FAT_END_OF_CHAIN 0x0FFFFFFFu
+#define FAT_FIRST_END 0x0FFFFFF8u     // Values from here on end a chain
+#define FAT_MIN_CLUSTERS 65525u       // Fewer clusters make a FAT16 volume
+#define FAT_MAX_CLUSTERS 0x0FFFFFF5u
+#define FAT_RESERVED_SECTORS 32u
+#define FAT_COPIES 2u
+#define FAT_FSINFO_SECTOR 1u
+#define FAT_BACKUP_BOOT_SECTOR 6u
+#define FAT_ROOT_CLUSTER 2u
+#define FAT_VOLUME_ID 0x43595054u     // "CYPT"; fixed so formatted images are reproducible
+
+#define ATTR_VOLUME_ID 0x08
+#define ATTR_DIRECTORY 0x10
+#define ATTR_ARCHIVE 0x20
+#define ATTR_LONG_NAME 0x0F
+#define ATTR_LONG_NAME_MASK 0x3F
+
+#define ENTRY_FREE 0xE5               // First name byte of a deleted entry
+#define ENTRY_END 0x00                // First name byte of the first never-used entry
+#define LFN_LAST 0x40                 // Sequence flag of the final long name entry
+#define LFN_CHARS 13                  // UCS-2 characters per long name entry
+#define LFN_MAX_ENTRIES 20            // 255 characters
+#define NTRES_LOWER_BASE 0x08         // Short name case flags, as Windows writes them
+#define NTRES_LOWER_EXT 0x10
+#define SHORT_TAIL_MAX 9999           // Numeric tails tried for a generated short name
+
+#define FAT_STAMP_SLOTS 32            // Directories whose generation is remembered
+#define FAT_STAMP_TIME_SHIFT 20       // Generations a mount may use per second since the previous one
+
+static const uint8_t lfn_offsets[LFN_CHARS] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+
+static const char *op_names[FAT_OP_COUNT] = {
+    "list", "stat", "read", "write", "truncate", "create_file", "create_directory", "rename", "remove", "dir_stamp",
+};
+
+typedef struct {
+    uint32_t lba;
+    uint32_t used;       // LRU clock of the last access, 0 for an empty slot
+    bool dirty;
+    uint8_t *data;
+} CacheSlot;
+
+typedef struct {
+    CacheSlot *slots;
+    uint16_t count;
+    uint32_t clock;
+    bool mirrored;       // FAT sectors are written to every copy of the table
+    uint32_t *hits;
+    uint32_t *misses;
+} SectorCache;
+
+// Position of a 32-byte entry: the cluster and the entry index within it
+typedef struct {
+    uint32_t cluster;
+    uint32_t index;
+} DirPos;
+
+// A directory entry as found by a scan
+typedef struct {
+    char name[HAL_NAME_LEN];
+    uint8_t short_name[11];
+    uint8_t attr;
+    uint32_t first_cluster;
+    uint32_t size;
+    uint32_t mtime;
+    DirPos first;        // First slot, a long name entry if it has any
+    DirPos entry;        // The short entry
+    bool root;
+} FatEntry;
+
+typedef struct {
+    DirPos pos;          // Next slot to read
+    bool ended;
+    uint16_t lfn[LFN_MAX_ENTRIES * LFN_CHARS + 1];
+    uint8_t lfn_count;   // Entries in the long name being assembled, 0 for none
+    uint8_t lfn_next;    // Sequence number expected next
+    uint8_t lfn_checksum;
+    DirPos lfn_first;
+} DirScan;
+
+static const BlockDevice *device = NULL;
+static bool mounted = false;
+static uint32_t sectors_per_cluster;
+static uint32_t cluster_bytes;
+static uint32_t entries_per_cluster;
+static uint32_t fat_start;
+static uint32_t fat_sectors;
+static uint32_t fat_copies;
+static uint32_t data_start;
+static uint32_t cluster_count;
+static uint32_t root_cluster;
+static uint32_t fsinfo_sector;
+static uint32_t free_clusters;
+static uint32_t next_free;
+static bool fsinfo_dirty = false;
+
+static SectorCache data_cache;
+static SectorCache fat_cache;
+static FatVolumeStats stats;
+static FatOp current_op = FAT_OP_LIST;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Directory generations, keyed by first cluster. A directory without a slot
+// reports stamp_floor, which is at least every stamp evicted, so a stamp
+// can move spuriously but never stays put across a change.
+static struct {
+    uint32_t cluster;
+    uint64_t stamp;
+} stamps[FAT_STAMP_SLOTS];
+static uint64_t generation = 1;
+static uint64_t stamp_floor = 1;
+
+// Where the last listing stopped
+static struct {
+    bool valid;
+    uint32_t dir_cluster;
+    uint64_t stamp;
+    size_t index;
+    DirScan scan;
+} cursor;
+
+static uint8_t zero_sector[SECTOR_SIZE];
+
+// -----------------------------------------------------------------------------
+/* Little-Endian Fields */
+// -----------------------------------------------------------------------------
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+// -----------------------------------------------------------------------------
+/* Timestamps */
+// -----------------------------------------------------------------------------
+
+// Days since 1970-01-01 of a proleptic Gregorian date.
+static int64_t days_from_civil(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned year_of_era = (unsigned)(year - era * 400);
+    unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + (int64_t)day_of_era - 719468;
+}
+
+static void civil_from_days(int64_t days, int *year, unsigned *month, unsigned *day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned day_of_era = (unsigned)(days - era * 146097);
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned shifted_month = (5 * day_of_year + 2) / 153;
+    *day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    *year = (int)(year_of_era + era * 400 + (*month <= 2));
+}
+
+// FAT keeps local time in two-second steps from 1980; the mock treats it as UTC.
+static void fat_time(time_t now, uint16_t *date, uint16_t *time_of_day) {
+    int64_t seconds = now;
+    int64_t days = seconds / 86400;
+    int64_t rest = seconds % 86400;
+    int year;
+    unsigned month, day;
+    civil_from_days(days, &year, &month, &day);
+    if (year < 1980) {
+        *date = (1 << 5) | 1;
+        *time_of_day = 0;
+        return;
+    }
+    *date = (uint16_t)((year - 1980) << 9 | month << 5 | day);
+    *time_of_day = (uint16_t)((rest / 3600) << 11 | (rest / 60 % 60) << 5 | (rest % 60) / 2);
+}
+
+static uint32_t unix_time(uint16_t date, uint16_t time_of_day) {
+    unsigned month = (date >> 5) & 15;
+    unsigned day = date & 31;
+    if (month < 1 || month > 12 || day < 1) {
+        return 0;
+    }
+    int64_t days = days_from_civil(1980 + (date >> 9), month, day);
+    return (uint32_t)(days * 86400 + (time_of_day >> 11) * 3600 + ((time_of_day >> 5) & 63) * 60 +
+                      (time_of_day & 31) * 2);
+}
+
+static void stamp_entry(uint8_t *entry) {
+    uint16_t date, time_of_day;
+    fat_time(time(NULL), &date, &time_of_day);
+    put16(entry + 22, time_of_day);
+    put16(entry + 24, date);
+    put16(entry + 18, date);
+}
+
+// -----------------------------------------------------------------------------
+/* Block Device and Caches */
+// -----------------------------------------------------------------------------
+
+static bool device_read(uint32_t lba, uint32_t count, uint8_t *buffer) {
+    stats.ops[current_op].reads++;
+    stats.ops[current_op].sectors_read += count;
+    return device->read(lba, count, buffer);
+}
+
+static bool device_write(uint32_t lba, uint32_t count, const uint8_t *buffer) {
+    stats.ops[current_op].writes++;
+    stats.ops[current_op].sectors_written += count;
+    return device->write(lba, count, buffer);
+}
+
+static bool cache_init(SectorCache *cache, uint16_t count, bool mirrored, uint32_t *hits, uint32_t *misses) {
+    cache->slots = calloc(count, sizeof(CacheSlot));
+    uint8_t *data = malloc((size_t)count * SECTOR_SIZE);
+    if (!cache->slots || !data) {
+        free(cache->slots);
+        free(data);
+        cache->slots = NULL;
+        return false;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        cache->slots[i].data = data + (size_t)i * SECTOR_SIZE;
+    }
+    cache->count = count;
+    cache->clock = 0;
+    cache->mirrored = mirrored;
+    cache->hits = hits;
+    cache->misses = misses;
+    return true;
+}
+
+static void cache_free(SectorCache *cache) {
+    if (cache->slots) {
+        free(cache->slots[0].data);
+        free(cache->slots);
+        cache->slots = NULL;
+    }
+}
+
+static bool cache_write_back(SectorCache *cache, CacheSlot *slot) {
+    if (!slot->dirty) {
+        return true;
+    }
+    bool ok = device_write(slot->lba, 1, slot->data);
+    for (uint32_t copy = 1; ok && cache->mirrored && copy < fat_copies; copy++) {
+        ok = device_write(slot->lba + copy * fat_sectors, 1, slot->data);
+    }
+    slot->dirty = !ok;
+    return ok;
+}
+
+// Returns the cached sector, loading it on a miss unless load is false (the
+// caller overwrites it all, or it lies past the end of the file); NULL on an
+// I/O error.
+static CacheSlot *cache_get(SectorCache *cache, uint32_t lba, bool load) {
+    CacheSlot *victim = &cache->slots[0];
+    for (uint16_t i = 0; i < cache->count; i++) {
+        CacheSlot *slot = &cache->slots[i];
+        if (slot->used && slot->lba == lba) {
+            (*cache->hits)++;
+            slot->used = ++cache->clock;
+            return slot;
+        }
+        if (slot->used < victim->used) {
+            victim = slot;
+        }
+    }
+    (*cache->misses)++;
+    if (victim->used && !cache_write_back(cache, victim)) {
+        return NULL;
+    }
+    victim->used = 0;
+    if (load) {
+        if (!device_read(lba, 1, victim->data)) {
+            return NULL;
+        }
+    } else {
+        memset(victim->data, 0, SECTOR_SIZE);
+    }
+    victim->lba = lba;
+    victim->used = ++cache->clock;
+    victim->dirty = false;
+    return victim;
+}
+
+static bool cache_flush(SectorCache *cache) {
+    bool ok = true;
+    for (uint16_t i = 0; i < cache->count; i++) {
+        if (cache->slots[i].used) {
+            ok = cache_write_back(cache, &cache->slots[i]) && ok;
+        }
+    }
+    return ok;
+}
+
+// Forgets cached copies of sectors the caller wrote directly.
+static void cache_drop(SectorCache *cache, uint32_t lba, uint32_t count) {
+    for (uint16_t i = 0; i < cache->count; i++) {
+        CacheSlot *slot = &cache->slots[i];
+        if (slot->used && slot->lba >= lba && slot->lba - lba < count) {
+            slot->used = 0;
+            slot->dirty = false;
+        }
+    }
+}
+
+// Lays cached copies, which may be newer, over sectors the caller read directly.
+static void cache_overlay(const SectorCache *cache, uint32_t lba, uint32_t count, uint8_t *buffer) {
+    for (uint16_t i = 0; i < cache->count; i++) {
+        const CacheSlot *slot = &cache->slots[i];
+        if (slot->used && slot->lba >= lba && slot->lba - lba < count) {
+            memcpy(buffer + (size_t)(slot->lba - lba) * SECTOR_SIZE, slot->data, SECTOR_SIZE);
+        }
+    }
+}
+
+// Writes back the FSInfo hints and every dirty sector, FAT first.
+static bool volume_sync(void) {
+    bool ok = true;
+    if (fsinfo_dirty && fsinfo_sector) {
+        CacheSlot *slot = cache_get(&data_cache, fsinfo_sector, true);
+        ok = slot != NULL;
+        if (ok) {
+            put32(slot->data + 488, free_clusters);
+            put32(slot->data + 492, next_free);
+            slot->dirty = true;
+            fsinfo_dirty = false;
+        }
+    }
+    ok = cache_flush(&fat_cache) && ok;
+    return cache_flush(&data_cache) && ok;
+}
+
+// -----------------------------------------------------------------------------
+/* Clusters */
+// -----------------------------------------------------------------------------
+
+static bool valid_cluster(uint32_t cluster) {
+    return cluster >= 2 && cluster - 2 < cluster_count;
+}
+
+static uint32_t cluster_lba(uint32_t cluster) {
+    return data_start + (cluster - 2) * sectors_per_cluster;
+}
+
+static bool fat_get(uint32_t cluster, uint32_t *value) {
+    CacheSlot *slot = cache_get(&fat_cache, fat_start + cluster / (SECTOR_SIZE / 4), true);
+    if (!slot) {
+        return false;
+    }
+    *value = get32(slot->data + cluster % (SECTOR_SIZE / 4) * 4) & FAT_ENTRY_MASK;
+    return true;
+}
+
+// Keeps the top four bits, which FAT32 reserves.
+static bool fat_set(uint32_t cluster, uint32_t value) {
+    CacheSlot *slot = cache_get(&fat_cache, fat_start + cluster / (SECTOR_SIZE / 4), true);
+    if (!slot) {
+        return false;
+    }
+    uint8_t *entry = slot->data + cluster % (SECTOR_SIZE / 4) * 4;
+    put32(entry, (get32(entry) & ~FAT_ENTRY_MASK) | (value & FAT_ENTRY_MASK));
+    slot->dirty = true;
+    return true;
+}
+
+// Returns 1 and the following cluster, 0 at the end of the chain, -1 on an error.
+static int next_cluster(uint32_t cluster, uint32_t *next) {
+    uint32_t value;
+    if (!fat_get(cluster, &value)) {
+        return -1;
+    }
+    if (value >= FAT_FIRST_END) {
+        return 0;
+    }
+    if (!valid_cluster(value)) {
+        return -1;
+    }
+    *next = value;
+    return 1;
+}
+
+// Finds cluster number index of a chain, counting from 0.
+static bool chain_seek(uint32_t first, uint32_t index, uint32_t *cluster) {
+    if (!valid_cluster(first)) {
+        return false;
+    }
+    *cluster = first;
+    for (uint32_t i = 0; i < index; i++) {
+        if (next_cluster(*cluster, cluster) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Takes a free cluster, marks it as the end of a chain and links it after previous (0 for none).
+static bool allocate_cluster(uint32_t previous, uint32_t *cluster) {
+    if (free_clusters == 0) {
+        return false;
+    }
+    uint32_t start = valid_cluster(next_free) ? next_free : 2;
+    for (uint32_t i = 0; i < cluster_count; i++) {
+        uint32_t candidate = 2 + (start - 2 + i) % cluster_count;
+        uint32_t value;
+        if (!fat_get(candidate, &value)) {
+            return false;
+        }
+        if (value == 0) {
+            if (!fat_set(candidate, FAT_END_OF_CHAIN) || (previous && !fat_set(previous, candidate))) {
+                return false;
+            }
+            free_clusters--;
+            next_free = candidate + 1;
+            fsinfo_dirty = true;
+            *cluster = candidate;
+            return true;
+        }
+    }
+    free_clusters = 0;
+    return false;
+}
+
+static bool free_chain(uint32_t cluster) {
+    while (valid_cluster(cluster)) {
+        uint32_t next;
+        int more = next_cluster(cluster, &next);
+        if (more < 0 || !fat_set(cluster, 0)) {
+            return false;
+        }
+        free_clusters++;
+        fsinfo_dirty = true;
+        if (more == 0) {
+            break;
+        }
+        cluster = next;
+    }
+    return true;
+}
+
+// Zeroes a new directory cluster, a sector per command as FatFs does.
+static bool zero_cluster(uint32_t cluster) {
+    uint32_t lba = cluster_lba(cluster);
+    cache_drop(&data_cache, lba, sectors_per_cluster);
+    for (uint32_t i = 0; i < sectors_per_cluster; i++) {
+        if (!device_write(lba + i, 1, zero_sector)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Directory Generations */
+// -----------------------------------------------------------------------------
+
+static void directory_changed(uint32_t cluster) {
+    int slot = -1;
+    for (int i = 0; i < FAT_STAMP_SLOTS; i++) {
+        if (stamps[i].cluster == cluster) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 || stamps[i].stamp < stamps[slot].stamp) {
+            slot = i;
+        }
+    }
+    if (stamps[slot].cluster != cluster && stamps[slot].stamp > stamp_floor) {
+        stamp_floor = stamps[slot].stamp;
+    }
+    stamps[slot].cluster = cluster;
+    stamps[slot].stamp = ++generation;
+}
+
+static uint64_t directory_stamp(uint32_t cluster) {
+    for (int i = 0; i < FAT_STAMP_SLOTS; i++) {
+        if (stamps[i].cluster == cluster && stamps[i].stamp) {
+            return stamps[i].stamp;
+        }
+    }
+    return stamp_floor;
+}
+
+// -----------------------------------------------------------------------------
+/* Names */
+// -----------------------------------------------------------------------------
+
+static uint8_t short_name_checksum(const uint8_t short_name[11]) {
+    uint8_t sum = 0;
+    for (int i = 0; i < 11; i++) {
+        sum = (uint8_t)(((sum & 1) << 7) + (sum >> 1) + short_name[i]);
+    }
+    return sum;
+}
+
+static char fold(char c) {
+    return c >= 'a' && c <= 'z' ? (char)(c - 'a' + 'A') : c;
+}
+
+// FAT names compare without regard to ASCII case.
+static bool names_equal(const char *a, const char *b, size_t b_length) {
+    size_t i = 0;
+    for (; i < b_length && a[i]; i++) {
+        if (fold(a[i]) != fold(b[i])) {
+            return false;
+        }
+    }
+    return i == b_length && a[i] == '\0';
+}
+
+// Decodes UTF-8 (BMP only) into UCS-2. Returns the length, or -1.
+static int utf8_to_ucs2(const char *text, uint16_t *out, size_t max) {
+    size_t length = 0;
+    const uint8_t *p = (const uint8_t *)text;
+    while (*p) {
+        uint32_t c;
+        if (p[0] < 0x80) {
+            c = *p++;
+        } else if ((p[0] & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80) {
+            c = (uint32_t)(p[0] & 0x1F) << 6 | (p[1] & 0x3F);
+            p += 2;
+        } else if ((p[0] & 0xF0) == 0xE0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+            c = (uint32_t)(p[0] & 0x0F) << 12 | (uint32_t)(p[1] & 0x3F) << 6 | (p[2] & 0x3F);
+            p += 3;
+        } else {
+            return -1;
+        }
+        if (length == max) {
+            return -1;
+        }
+        out[length++] = (uint16_t)c;
+    }
+    return (int)length;
+}
+
+static void ucs2_to_utf8(const uint16_t *name, char *out, size_t size) {
+    size_t length = 0;
+    for (; *name; name++) {
+        uint16_t c = *name;
+        size_t need = c < 0x80 ? 1 : c < 0x800 ? 2 : 3;
+        if (length + need >= size) {
+            break;
+        }
+        if (need == 1) {
+            out[length++] = (char)c;
+        } else if (need == 2) {
+            out[length++] = (char)(0xC0 | c >> 6);
+            out[length++] = (char)(0x80 | (c & 0x3F));
+        } else {
+            out[length++] = (char)(0xE0 | c >> 12);
+            out[length++] = (char)(0x80 | ((c >> 6) & 0x3F));
+            out[length++] = (char)(0x80 | (c & 0x3F));
+        }
+    }
+    out[length] = '\0';
+}
+
+// Formats an 8.3 entry as "NAME.EXT", lowered where the case flags say so.
+static void short_name_text(const uint8_t short_name[11], uint8_t case_flags, char *out) {
+    size_t length = 0;
+    for (int i = 0; i < 8 && short_name[i] != ' '; i++) {
+        uint8_t c = i == 0 && short_name[0] == 0x05 ? ENTRY_FREE : short_name[i];
+        out[length++] = (char)((case_flags & NTRES_LOWER_BASE) && c >= 'A' && c <= 'Z' ? c + 32 : c);
+    }
+    if (short_name[8] != ' ') {
+        out[length++] = '.';
+        for (int i = 8; i < 11 && short_name[i] != ' '; i++) {
+            uint8_t c = short_name[i];
+            out[length++] = (char)((case_flags & NTRES_LOWER_EXT) && c >= 'A' && c <= 'Z' ? c + 32 : c);
+        }
+    }
+    out[length] = '\0';
+}
+
+static bool short_char_valid(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           (c != '\0' && strchr("$%'-_@~`!(){}^#&", c) != NULL);
+}
+
+// Stores name as a plain 8.3 entry if it is one: valid characters, and base
+// and extension each in one case (recorded in the case flags).
+static bool fits_short_name(const char *name, uint8_t short_name[11], uint8_t *case_flags) {
+    const char *dot = strrchr(name, '.');
+    size_t base_length = dot ? (size_t)(dot - name) : strlen(name);
+    size_t ext_length = dot ? strlen(dot + 1) : 0;
+    if (base_length == 0 || base_length > 8 || ext_length > 3 || (dot && ext_length == 0)) {
+        return false;
+    }
+
+    memset(short_name, ' ', 11);
+    *case_flags = 0;
+    for (int part = 0; part < 2; part++) {
+        const char *text = part == 0 ? name : dot + 1;
+        size_t length = part == 0 ? base_length : ext_length;
+        bool upper = false, lower = false;
+        for (size_t i = 0; i < length; i++) {
+            if (!short_char_valid(text[i])) {
+                return false;
+            }
+            upper |= text[i] >= 'A' && text[i] <= 'Z';
+            lower |= text[i] >= 'a' && text[i] <= 'z';
+            short_name[(part == 0 ? 0 : 8) + i] = (uint8_t)fold(text[i]);
+        }
+        if (upper && lower) {
+            return false;
+        }
+        if (lower) {
+            *case_flags |= part == 0 ? NTRES_LOWER_BASE : NTRES_LOWER_EXT;
+        }
+    }
+    if (short_name[0] == ENTRY_FREE) {
+        short_name[0] = 0x05;
+    }
+    return true;
+}
+
+// Uppercased name with invalid characters and multi-byte sequences as '_'.
+static size_t short_basis_part(const char *text, size_t length, uint8_t *out, size_t max) {
+    size_t count = 0;
+    for (size_t i = 0; i < length && count < max; i++) {
+        uint8_t c = (uint8_t)text[i];
+        if (c == ' ' || c == '.' || (c & 0xC0) == 0x80) {
+            continue;
+        }
+        out[count++] = short_char_valid((char)c) ? (uint8_t)fold((char)c) : '_';
+    }
+    return count;
+}
+
+static int scan_next(DirScan *scan, FatEntry *entry);
+static void scan_start(DirScan *scan, uint32_t dir_cluster);
+
+// Picks a short name with the lowest numeric tail (NAME~N) not in use in the directory.
+static bool generate_short_name(uint32_t dir_cluster, const char *name, uint8_t short_name[11]) {
+    while (*name == '.' || *name == ' ') {
+        name++;
+    }
+    const char *dot = strrchr(name, '.');
+    size_t base_end = dot ? (size_t)(dot - name) : strlen(name);
+
+    uint8_t basis[8];
+    size_t basis_length = short_basis_part(name, base_end, basis, 8);
+    if (basis_length == 0) {
+        basis[basis_length++] = '_';
+    }
+    memset(short_name, ' ', 11);
+    if (dot) {
+        short_basis_part(dot + 1, strlen(dot + 1), short_name + 8, 3);
+    }
+
+    static uint8_t tails_used[(SHORT_TAIL_MAX + 8) / 8];
+    memset(tails_used, 0, sizeof(tails_used));
+    DirScan *scan = malloc(sizeof(DirScan));
+    FatEntry *found = malloc(sizeof(FatEntry));
+    if (!scan || !found) {
+        free(scan);
+        free(found);
+        return false;
+    }
+    scan_start(scan, dir_cluster);
+    int more;
+    while ((more = scan_next(scan, found)) == 1) {
+        const uint8_t *other = found->short_name;
+        const uint8_t *tilde = memchr(other, '~', 8);
+        if (!tilde || memcmp(other + 8, short_name + 8, 3) != 0) {
+            continue;
+        }
+        size_t prefix = (size_t)(tilde - other);
+        uint32_t tail = 0;
+        size_t digits = 0;
+        for (size_t i = prefix + 1; i < 8 && other[i] >= '0' && other[i] <= '9'; i++, digits++) {
+            tail = tail * 10 + (other[i] - '0');
+        }
+        bool rest_blank = prefix + 1 + digits == 8 || other[prefix + 1 + digits] == ' ';
+        size_t expected_prefix = basis_length < 7 - digits ? basis_length : 7 - digits;
+        if (digits && rest_blank && tail >= 1 && tail <= SHORT_TAIL_MAX && prefix == expected_prefix &&
+            memcmp(other, basis, prefix) == 0) {
+            tails_used[tail / 8] |= (uint8_t)(1 << (tail % 8));
+        }
+    }
+    free(scan);
+    free(found);
+    if (more < 0) {
+        return false;
+    }
+
+    for (uint32_t tail = 1; tail <= SHORT_TAIL_MAX; tail++) {
+        if (tails_used[tail / 8] & (1 << (tail % 8))) {
+            continue;
+        }
+        char digits[8];
+        int digit_count = snprintf(digits, sizeof(digits), "~%u", (unsigned)tail);
+        size_t prefix = basis_length < 8 - (size_t)digit_count ? basis_length : 8 - (size_t)digit_count;
+        memset(short_name, ' ', 8);
+        memcpy(short_name, basis, prefix);
+        memcpy(short_name + prefix, digits, (size_t)digit_count);
+        if (short_name[0] == ENTRY_FREE) {
+            short_name[0] = 0x05;
+        }
+        return true;
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+/* Directory Scans */
+// -----------------------------------------------------------------------------
+
+static uint8_t *dir_slot(DirPos pos, CacheSlot **slot) {
+    uint32_t lba = cluster_lba(pos.cluster) + pos.index / ENTRIES_PER_SECTOR;
+    *slot = cache_get(&data_cache, lba, true);
+    return *slot ? (*slot)->data + pos.index % ENTRIES_PER_SECTOR * DIR_ENTRY_SIZE : NULL;
+}
+
+// Moves to the next slot. Returns 1, 0 at the end of the chain, -1 on an error.
+static int dir_advance(DirPos *pos) {
+    if (++pos->index < entries_per_cluster) {
+        return 1;
+    }
+    uint32_t next;
+    int more = next_cluster(pos->cluster, &next);
+    if (more == 1) {
+        pos->cluster = next;
+        pos->index = 0;
+    }
+    return more;
+}
+
+static bool same_pos(DirPos a, DirPos b) {
+    return a.cluster == b.cluster && a.index == b.index;
+}
+
+static void scan_start(DirScan *scan, uint32_t dir_cluster) {
+    scan->pos.cluster = dir_cluster;
+    scan->pos.index = 0;
+    scan->ended = !valid_cluster(dir_cluster);
+    scan->lfn_count = 0;
+}
+
+// Fills entry from the next live entry, "." and ".." skipped. Returns 1, 0 at
+// the end of the directory, -1 on an error.
+static int scan_next(DirScan *scan, FatEntry *entry) {
+    while (!scan->ended) {
+        DirPos here = scan->pos;
+        CacheSlot *slot;
+        const uint8_t *raw = dir_slot(here, &slot);
+        if (!raw) {
+            return -1;
+        }
+        uint8_t first = raw[0];
+        uint8_t attr = raw[11];
+        if (first == ENTRY_END) {
+            scan->ended = true;
+            return 0;
+        }
+        int more = dir_advance(&scan->pos);
+        if (more < 0) {
+            return -1;
+        }
+        scan->ended = more == 0;
+
+        if (first == ENTRY_FREE) {
+            scan->lfn_count = 0;
+            continue;
+        }
+        if ((attr & ATTR_LONG_NAME_MASK) == ATTR_LONG_NAME) {
+            uint8_t sequence = first & 0x1F;
+            if (first & LFN_LAST) {
+                scan->lfn_count = sequence >= 1 && sequence <= LFN_MAX_ENTRIES ? sequence : 0;
+                scan->lfn_next = sequence;
+                scan->lfn_checksum = raw[13];
+                scan->lfn_first = here;
+            }
+            if (scan->lfn_count && sequence == scan->lfn_next && sequence >= 1 && raw[13] == scan->lfn_checksum) {
+                for (int i = 0; i < LFN_CHARS; i++) {
+                    scan->lfn[(sequence - 1) * LFN_CHARS + i] = get16(raw + lfn_offsets[i]);
+                }
+                scan->lfn_next--;
+            } else {
+                scan->lfn_count = 0;
+            }
+            continue;
+        }
+        if ((attr & ATTR_VOLUME_ID) || first == '.') {
+            scan->lfn_count = 0;
+            continue;
+        }
+
+        memcpy(entry->short_name, raw, 11);
+        entry->attr = attr;
+        entry->first_cluster = (uint32_t)get16(raw + 20) << 16 | get16(raw + 26);
+        entry->size = get32(raw + 28);
+        entry->mtime = unix_time(get16(raw + 24), get16(raw + 22));
+        entry->entry = here;
+        entry->root = false;
+        if (scan->lfn_count && scan->lfn_next == 0 && short_name_checksum(raw) == scan->lfn_checksum) {
+            // Long names end at a NUL, or fill their last entry exactly
+            scan->lfn[scan->lfn_count * LFN_CHARS] = 0;
+            ucs2_to_utf8(scan->lfn, entry->name, sizeof(entry->name));
+            entry->first = scan->lfn_first;
+        } else {
+            short_name_text(raw, raw[12], entry->name);
+            entry->first = here;
+        }
+        scan->lfn_count = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static int find_in_directory(uint32_t dir_cluster, const char *name, size_t length, FatEntry *entry) {
+    DirScan *scan = malloc(sizeof(DirScan));
+    if (!scan) {
+        return -1;
+    }
+    scan_start(scan, dir_cluster);
+    int found;
+    while ((found = scan_next(scan, entry)) == 1 && !names_equal(entry->name, name, length)) {
+    }
+    free(scan);
+    return found;
+}
+
+static void root_entry(FatEntry *entry) {
+    memset(entry, 0, sizeof(*entry));
+    entry->attr = ATTR_DIRECTORY;
+    entry->first_cluster = root_cluster;
+    entry->root = true;
+}
+
+// Resolves path component by component from the root.
+static bool resolve(const char *path, FatEntry *entry) {
+    root_entry(entry);
+    while (*path) {
+        if (*path == '/') {
+            path++;
+            continue;
+        }
+        size_t length = strcspn(path, "/");
+        if (!(entry->attr & ATTR_DIRECTORY) || find_in_directory(entry->first_cluster, path, length, entry) != 1) {
+            return false;
+        }
+        path += length;
+    }
+    return true;
+}
+
+// Resolves the directory holding path and copies the last component to name.
+static bool resolve_parent(const char *path, FatEntry *dir, char name[HAL_NAME_LEN]) {
+    size_t end = strlen(path);
+    while (end > 0 && path[end - 1] == '/') {
+        end--;
+    }
+    size_t start = end;
+    while (start > 0 && path[start - 1] != '/') {
+        start--;
+    }
+    char dir_path[512];
+    if (start == end || end - start >= HAL_NAME_LEN || start >= sizeof(dir_path)) {
+        return false;
+    }
+    memcpy(name, path + start, end - start);
+    name[end - start] = '\0';
+    memcpy(dir_path, path, start);
+    dir_path[start] = '\0';
+    return resolve(dir_path, dir) && (dir->attr & ATTR_DIRECTORY);
+}
+
+// -----------------------------------------------------------------------------
+/* Directory Changes */
+// -----------------------------------------------------------------------------
+
+// Adds an entry for name to dir, built from the 32 bytes of template (all
+// but the name). Long name entries are written before it when the name is not
+// a plain 8.3 name. The directory grows by a cluster when it has no run of
+// free slots long enough.
+static bool add_entry(const FatEntry *dir, const char *name, const uint8_t template[DIR_ENTRY_SIZE], FatEntry *out) {
+    uint8_t short_name[11];
+    uint8_t case_flags = 0;
+    uint16_t long_name[LFN_MAX_ENTRIES * LFN_CHARS];
+    int long_length = 0;
+    int long_entries = 0;
+    if (!fits_short_name(name, short_name, &case_flags)) {
+        long_length = utf8_to_ucs2(name, long_name, 255);
+        if (long_length <= 0 || !generate_short_name(dir->first_cluster, name, short_name)) {
+            return false;
+        }
+        long_entries = (long_length + LFN_CHARS - 1) / LFN_CHARS;
+    }
+    int slots = long_entries + 1;
+
+    // Find a run of free slots
+    DirPos pos = { dir->first_cluster, 0 };
+    DirPos run_start = pos;
+    int run = 0;
+    while (run < slots) {
+        CacheSlot *slot;
+        const uint8_t *raw = dir_slot(pos, &slot);
+        if (!raw) {
+            return false;
+        }
+        if (raw[0] == ENTRY_END || raw[0] == ENTRY_FREE) {
+            if (run++ == 0) {
+                run_start = pos;
+            }
+            if (run == slots) {
+                break;
+            }
+        } else {
+            run = 0;
+        }
+        int more = dir_advance(&pos);
+        if (more < 0) {
+            return false;
+        }
+        if (more == 0) {
+            uint32_t cluster;
+            if (!allocate_cluster(pos.cluster, &cluster) || !zero_cluster(cluster)) {
+                return false;
+            }
+            pos.cluster = cluster;
+            pos.index = 0;
+        }
+    }
+
+    uint8_t checksum = short_name_checksum(short_name);
+    pos = run_start;
+    for (int sequence = long_entries; sequence >= 1; sequence--) {
+        CacheSlot *slot;
+        uint8_t *raw = dir_slot(pos, &slot);
+        if (!raw) {
+            return false;
+        }
+        memset(raw, 0, DIR_ENTRY_SIZE);
+        raw[0] = (uint8_t)(sequence | (sequence == long_entries ? LFN_LAST : 0));
+        raw[11] = ATTR_LONG_NAME;
+        raw[13] = checksum;
+        for (int i = 0; i < LFN_CHARS; i++) {
+            int index = (sequence - 1) * LFN_CHARS + i;
+            uint16_t c = index < long_length ? long_name[index] : index == long_length ? 0x0000 : 0xFFFF;
+            put16(raw + lfn_offsets[i], c);
+        }
+        slot->dirty = true;
+        if (dir_advance(&pos) != 1) {
+            return false;
+        }
+    }
+
+    CacheSlot *slot;
+    uint8_t *raw = dir_slot(pos, &slot);
+    if (!raw) {
+        return false;
+    }
+    memcpy(raw, template, DIR_ENTRY_SIZE);
+    memcpy(raw, short_name, 11);
+    raw[12] = case_flags;
+    slot->dirty = true;
+    directory_changed(dir->first_cluster);
+
+    if (out) {
+        snprintf(out->name, sizeof(out->name), "%s", name);
+        memcpy(out->short_name, short_name, 11);
+        out->attr = raw[11];
+        out->first_cluster = (uint32_t)get16(raw + 20) << 16 | get16(raw + 26);
+        out->size = get32(raw + 28);
+        out->mtime = unix_time(get16(raw + 24), get16(raw + 22));
+        out->first = run_start;
+        out->entry = pos;
+        out->root = false;
+    }
+    return true;
+}
+
+static bool delete_entry_slots(const FatEntry *entry, uint32_t dir_cluster) {
+    DirPos pos = entry->first;
+    for (;;) {
+        CacheSlot *slot;
+        uint8_t *raw = dir_slot(pos, &slot);
+        if (!raw) {
+            return false;
+        }
+        raw[0] = ENTRY_FREE;
+        slot->dirty = true;
+        if (same_pos(pos, entry->entry)) {
+            break;
+        }
+        if (dir_advance(&pos) != 1) {
+            return false;
+        }
+    }
+    directory_changed(dir_cluster);
+    return true;
+}
+
+// Writes the cluster, size and modification time of entry back to its short entry.
+static bool update_entry(const FatEntry *entry) {
+    CacheSlot *slot;
+    uint8_t *raw = dir_slot(entry->entry, &slot);
+    if (!raw) {
+        return false;
+    }
+    put16(raw + 20, (uint16_t)(entry->first_cluster >> 16));
+    put16(raw + 26, (uint16_t)entry->first_cluster);
+    put32(raw + 28, entry->size);
+    raw[11] |= ATTR_ARCHIVE;
+    stamp_entry(raw);
+    slot->dirty = true;
+    return true;
+}
+
+static void new_entry_template(uint8_t template[DIR_ENTRY_SIZE], uint8_t attr, uint32_t cluster) {
+    memset(template, 0, DIR_ENTRY_SIZE);
+    template[11] = attr;
+    put16(template + 20, (uint16_t)(cluster >> 16));
+    put16(template + 26, (uint16_t)cluster);
+    stamp_entry(template);
+    put16(template + 14, get16(template + 22));
+    put16(template + 16, get16(template + 24));
+}
+
+// Returns the first cluster of a directory's parent from its ".." entry.
+static bool parent_cluster(uint32_t dir_cluster, uint32_t *parent) {
+    CacheSlot *slot;
+    const uint8_t *raw = dir_slot((DirPos){ dir_cluster, 1 }, &slot);
+    if (!raw) {
+        return false;
+    }
+    uint32_t cluster = (uint32_t)get16(raw + 20) << 16 | get16(raw + 26);
+    *parent = cluster ? cluster : root_cluster;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* File Data */
+// -----------------------------------------------------------------------------
+
+// Grows the cluster chain of file to hold length bytes.
+static bool ensure_clusters(FatEntry *file, uint32_t length) {
+    uint32_t needed = (uint32_t)(((uint64_t)length + cluster_bytes - 1) / cluster_bytes);
+    uint32_t have = 0;
+    uint32_t last = 0;
+    if (valid_cluster(file->first_cluster)) {
+        last = file->first_cluster;
+        have = 1;
+        uint32_t next;
+        int more;
+        while (have < needed && (more = next_cluster(last, &next)) == 1) {
+            last = next;
+            have++;
+        }
+        if (have < needed && more < 0) {
+            return false;
+        }
+    }
+    while (have < needed) {
+        uint32_t cluster;
+        if (!allocate_cluster(last, &cluster)) {
+            return false;
+        }
+        if (have == 0) {
+            file->first_cluster = cluster;
+        }
+        last = cluster;
+        have++;
+    }
+    return true;
+}
+
+// Copies between the file and buffer (writing zeros if a write has no
+// buffer). Whole sectors move directly, up to a cluster per command;
+// partial ones go through the cache, loaded only if they hold file data.
+static bool transfer(const FatEntry *file, uint32_t offset, uint8_t *buffer, uint32_t length, bool write,
+                     uint32_t old_size) {
+    uint32_t cluster;
+    if (length == 0) {
+        return true;
+    }
+    if (!chain_seek(file->first_cluster, offset / cluster_bytes, &cluster)) {
+        return false;
+    }
+    uint32_t position = offset;
+    uint32_t done = 0;
+    while (done < length) {
+        uint32_t in_cluster = position % cluster_bytes;
+        if (in_cluster == 0 && done > 0 && next_cluster(cluster, &cluster) != 1) {
+            return false;
+        }
+        uint32_t sector = in_cluster / SECTOR_SIZE;
+        uint32_t in_sector = position % SECTOR_SIZE;
+        uint32_t lba = cluster_lba(cluster) + sector;
+        uint32_t remaining = length - done;
+        uint32_t step;
+
+        if (in_sector == 0 && remaining >= SECTOR_SIZE && (buffer || !write)) {
+            uint32_t count = remaining / SECTOR_SIZE;
+            if (count > sectors_per_cluster - sector) {
+                count = sectors_per_cluster - sector;
+            }
+            step = count * SECTOR_SIZE;
+            if (write) {
+                cache_drop(&data_cache, lba, count);
+                if (!device_write(lba, count, buffer + done)) {
+                    return false;
+                }
+            } else {
+                if (!device_read(lba, count, buffer + done)) {
+                    return false;
+                }
+                cache_overlay(&data_cache, lba, count, buffer + done);
+            }
+        } else if (write && !buffer && in_sector == 0 && remaining >= SECTOR_SIZE) {
+            step = SECTOR_SIZE;
+            cache_drop(&data_cache, lba, 1);
+            if (!device_write(lba, 1, zero_sector)) {
+                return false;
+            }
+        } else {
+            step = SECTOR_SIZE - in_sector < remaining ? SECTOR_SIZE - in_sector : remaining;
+            CacheSlot *slot = cache_get(&data_cache, lba, !write || position - in_sector < old_size);
+            if (!slot) {
+                return false;
+            }
+            if (!write) {
+                memcpy(buffer + done, slot->data + in_sector, step);
+            } else {
+                if (buffer) {
+                    memcpy(slot->data + in_sector, buffer + done, step);
+                } else {
+                    memset(slot->data + in_sector, 0, step);
+                }
+                slot->dirty = true;
+            }
+        }
+        position += step;
+        done += step;
+    }
+    return true;
+}
+
+// Sets the file length, freeing clusters past it or zero-filling up to it.
+static bool resize_file(FatEntry *file, uint32_t length) {
+    if (length < file->size) {
+        if (length == 0) {
+            if (!free_chain(file->first_cluster)) {
+                return false;
+            }
+            file->first_cluster = 0;
+        } else {
+            uint32_t last, rest;
+            if (!chain_seek(file->first_cluster, (length - 1) / cluster_bytes, &last)) {
+                return false;
+            }
+            int more = next_cluster(last, &rest);
+            if (more < 0 || (more == 1 && (!fat_set(last, FAT_END_OF_CHAIN) || !free_chain(rest)))) {
+                return false;
+            }
+        }
+    } else if (length > file->size) {
+        if (!ensure_clusters(file, length) || !transfer(file, file->size, NULL, length - file->size, true, file->size)) {
+            return false;
+        }
+    }
+    file->size = length;
+    return update_entry(file);
+}
+
+// -----------------------------------------------------------------------------
+/* Backend */
+// -----------------------------------------------------------------------------
+
+static bool begin(FatOp op) {
+    pthread_mutex_lock(&lock);
+    current_op = op;
+    stats.ops[op].calls++;
+    if (!mounted) {
+        pthread_mutex_unlock(&lock);
+        return false;
+    }
+    return true;
+}
+
+// Writes back what the operation changed.
+static bool finish(bool ok) {
+    ok = volume_sync() && ok;
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+static void fill_dir_entry(const FatEntry *found, DirEntry *entry) {
+    snprintf(entry->name, sizeof(entry->name), "%s", found->name);
+    entry->type = (found->attr & ATTR_DIRECTORY) ? DIR_ENTRY_DIRECTORY : DIR_ENTRY_FILE;
+    entry->size = entry->type == DIR_ENTRY_DIRECTORY ? 0 : found->size;
+    entry->mtime = found->mtime;
+}
+
+static size_t fat_list(const char *directory, size_t start, DirEntry *entries, size_t max_entries) {
+    if (!begin(FAT_OP_LIST)) {
+        return 0;
+    }
+    size_t count = 0;
+    FatEntry *found = malloc(sizeof(FatEntry));
+    if (found && resolve(directory, found) && (found->attr & ATTR_DIRECTORY)) {
+        uint32_t cluster = found->first_cluster;
+        uint64_t stamp = directory_stamp(cluster);
+        if (!cursor.valid || cursor.dir_cluster != cluster || cursor.stamp != stamp || start < cursor.index) {
+            scan_start(&cursor.scan, cluster);
+            cursor.valid = true;
+            cursor.dir_cluster = cluster;
+            cursor.stamp = stamp;
+            cursor.index = 0;
+        }
+        int more = 1;
+        while (cursor.index < start && (more = scan_next(&cursor.scan, found)) == 1) {
+            cursor.index++;
+        }
+        while (more == 1 && count < max_entries && (more = scan_next(&cursor.scan, found)) == 1) {
+            fill_dir_entry(found, &entries[count++]);
+            cursor.index++;
+        }
+        if (more < 0) {
+            cursor.valid = false;
+        }
+    }
+    free(found);
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
+static bool fat_stat(const char *path, DirEntry *entry) {
+    if (!begin(FAT_OP_STAT)) {
+        return false;
+    }
+    FatEntry found;
+    bool ok = resolve(path, &found);
+    if (ok) {
+        fill_dir_entry(&found, entry);
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+static int fat_read(const char *path, size_t offset, char *buffer, size_t length) {
+    if (!begin(FAT_OP_READ)) {
+        return -1;
+    }
+    int read = -1;
+    FatEntry file;
+    if (resolve(path, &file) && !(file.attr & ATTR_DIRECTORY)) {
+        size_t available = offset < file.size ? file.size - offset : 0;
+        size_t count = length < available ? length : available;
+        if (count > INT32_MAX) {
+            count = INT32_MAX;
+        }
+        if (transfer(&file, (uint32_t)offset, (uint8_t *)buffer, (uint32_t)count, false, file.size)) {
+            read = (int)count;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return read;
+}
+
+// Returns the file at path, added empty to its directory if missing.
+static bool open_file(const char *path, FatEntry *file) {
+    if (resolve(path, file)) {
+        return !(file->attr & ATTR_DIRECTORY);
+    }
+    FatEntry dir;
+    char name[HAL_NAME_LEN];
+    uint8_t template[DIR_ENTRY_SIZE];
+    new_entry_template(template, ATTR_ARCHIVE, 0);
+    return resolve_parent(path, &dir, name) && add_entry(&dir, name, template, file);
+}
+
+static bool fat_write(const char *path, size_t offset, const char *buffer, size_t length) {
+    if (!begin(FAT_OP_WRITE)) {
+        return false;
+    }
+    FatEntry file;
+    bool ok = (uint64_t)offset + length <= UINT32_MAX && open_file(path, &file);
+    if (ok) {
+        uint32_t end = (uint32_t)(offset + length);
+        uint32_t old_size = file.size;
+        ok = ensure_clusters(&file, end > old_size ? end : old_size);
+        if (ok && offset > old_size) {
+            ok = transfer(&file, old_size, NULL, (uint32_t)offset - old_size, true, old_size);
+        }
+        ok = ok && transfer(&file, (uint32_t)offset, (uint8_t *)buffer, (uint32_t)length, true, old_size);
+        if (ok) {
+            file.size = end > old_size ? end : old_size;
+            ok = update_entry(&file);
+        }
+    }
+    return finish(ok);
+}
+
+static bool fat_truncate(const char *path, size_t length) {
+    if (!begin(FAT_OP_TRUNCATE)) {
+        return false;
+    }
+    FatEntry file;
+    bool ok = length <= UINT32_MAX && resolve(path, &file) && !(file.attr & ATTR_DIRECTORY) &&
+              resize_file(&file, (uint32_t)length);
+    return finish(ok);
+}
+
+static bool fat_create_file(const char *path) {
+    if (!begin(FAT_OP_CREATE_FILE)) {
+        return false;
+    }
+    FatEntry file;
+    bool ok = open_file(path, &file) && (file.size == 0 || resize_file(&file, 0));
+    return finish(ok);
+}
+
+static bool fat_create_directory(const char *path) {
+    if (!begin(FAT_OP_CREATE_DIRECTORY)) {
+        return false;
+    }
+    FatEntry dir, existing;
+    char name[HAL_NAME_LEN];
+    uint32_t cluster = 0;
+    bool ok = !resolve(path, &existing) && resolve_parent(path, &dir, name) && allocate_cluster(0, &cluster) &&
+              zero_cluster(cluster);
+    if (ok) {
+        // "." and "..", which names the root as cluster 0
+        CacheSlot *slot = cache_get(&data_cache, cluster_lba(cluster), false);
+        ok = slot != NULL;
+        if (ok) {
+            new_entry_template(slot->data, ATTR_DIRECTORY, cluster);
+            memset(slot->data, ' ', 11);
+            slot->data[0] = '.';
+            new_entry_template(slot->data + DIR_ENTRY_SIZE, ATTR_DIRECTORY, dir.root ? 0 : dir.first_cluster);
+            memset(slot->data + DIR_ENTRY_SIZE, ' ', 11);
+            slot->data[DIR_ENTRY_SIZE] = '.';
+            slot->data[DIR_ENTRY_SIZE + 1] = '.';
+            slot->dirty = true;
+
+            uint8_t template[DIR_ENTRY_SIZE];
+            new_entry_template(template, ATTR_DIRECTORY, cluster);
+            ok = add_entry(&dir, name, template, NULL);
+            directory_changed(cluster);
+        }
+    }
+    if (!ok && valid_cluster(cluster)) {
+        free_chain(cluster);
+    }
+    return finish(ok);
+}
+
+// Replaces an existing file at new_path, as rename(2) does.
+static bool fat_rename(const char *old_path, const char *new_path) {
+    if (!begin(FAT_OP_RENAME)) {
+        return false;
+    }
+    FatEntry node, dir, existing, old_dir;
+    char name[HAL_NAME_LEN];
+    char old_name[HAL_NAME_LEN];
+    bool ok = resolve(old_path, &node) && !node.root && resolve_parent(new_path, &dir, name) &&
+              resolve_parent(old_path, &old_dir, old_name);
+    bool is_dir = ok && (node.attr & ATTR_DIRECTORY);
+
+    // A directory cannot move below itself
+    if (ok && is_dir) {
+        uint32_t cluster = dir.first_cluster;
+        while (ok && cluster != root_cluster) {
+            ok = cluster != node.first_cluster && parent_cluster(cluster, &cluster);
+        }
+    }
+    if (ok && find_in_directory(dir.first_cluster, name, strlen(name), &existing) == 1 &&
+        !same_pos(existing.entry, node.entry)) {
+        ok = !is_dir && !(existing.attr & ATTR_DIRECTORY) && free_chain(existing.first_cluster) &&
+             delete_entry_slots(&existing, dir.first_cluster);
+    }
+
+    if (ok) {
+        uint8_t template[DIR_ENTRY_SIZE];
+        CacheSlot *slot;
+        const uint8_t *raw = dir_slot(node.entry, &slot);
+        ok = raw != NULL;
+        if (ok) {
+            memcpy(template, raw, DIR_ENTRY_SIZE);
+            ok = add_entry(&dir, name, template, NULL) && delete_entry_slots(&node, old_dir.first_cluster);
+        }
+    }
+    if (ok && is_dir && dir.first_cluster != old_dir.first_cluster) {
+        CacheSlot *slot;
+        uint8_t *dotdot = dir_slot((DirPos){ node.first_cluster, 1 }, &slot);
+        ok = dotdot != NULL;
+        if (ok) {
+            uint32_t parent = dir.root ? 0 : dir.first_cluster;
+            put16(dotdot + 20, (uint16_t)(parent >> 16));
+            put16(dotdot + 26, (uint16_t)parent);
+            slot->dirty = true;
+        }
+    }
+    return finish(ok);
+}
+
+// Removes a file or an empty directory.
+static bool fat_remove(const char *path) {
+    if (!begin(FAT_OP_REMOVE)) {
+        return false;
+    }
+    FatEntry node, dir;
+    char name[HAL_NAME_LEN];
+    bool ok = resolve(path, &node) && !node.root && resolve_parent(path, &dir, name);
+    if (ok && (node.attr & ATTR_DIRECTORY)) {
+        FatEntry child;
+        DirScan *scan = malloc(sizeof(DirScan));
+        ok = scan != NULL;
+        if (ok) {
+            scan_start(scan, node.first_cluster);
+            ok = scan_next(scan, &child) == 0;
+            free(scan);
+        }
+    }
+    ok = ok && free_chain(node.first_cluster) && delete_entry_slots(&node, dir.first_cluster);
+    return finish(ok);
+}
+
+static bool fat_dir_stamp(const char *path, uint64_t *stamp) {
+    if (!begin(FAT_OP_DIR_STAMP)) {
+        return false;
+    }
+    FatEntry dir;
+    bool ok = resolve(path, &dir) && (dir.attr & ATTR_DIRECTORY);
+    if (ok) {
+        *stamp = directory_stamp(dir.first_cluster);
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+const StorageBackend fat_volume_backend = {
+    "fat32", fat_list, fat_stat, fat_read, fat_write, fat_truncate,
+    fat_create_file, fat_create_directory, fat_rename, fat_remove, fat_dir_stamp,
+};
+
+// -----------------------------------------------------------------------------
+/* Format and Mount */
+// -----------------------------------------------------------------------------
+
+bool fat_volume_format(const BlockDevice *target, uint8_t cluster_sectors) {
+    uint32_t total = target->sector_count();
+    if (cluster_sectors == 0 || cluster_sectors > 128 || (cluster_sectors & (cluster_sectors - 1))) {
+        return false;
+    }
+
+    // FAT size as computed in the Microsoft FAT specification
+    uint32_t divisor = (256u * cluster_sectors + FAT_COPIES) / 2;
+    uint32_t fat_size = (total - FAT_RESERVED_SECTORS + divisor - 1) / divisor;
+    uint32_t first_data = FAT_RESERVED_SECTORS + FAT_COPIES * fat_size;
+    uint32_t clusters = total > first_data ? (total - first_data) / cluster_sectors : 0;
+    if (clusters < FAT_MIN_CLUSTERS || clusters > FAT_MAX_CLUSTERS) {
+        fprintf(stderr, "fat_volume_format: %u clusters of %u sectors is not a FAT32 volume\n", (unsigned)clusters,
+                (unsigned)cluster_sectors);
+        return false;
+    }
+
+    uint8_t sector[SECTOR_SIZE];
+    memset(sector, 0, sizeof(sector));
+    sector[0] = 0xEB;
+    sector[1] = 0x58;
+    sector[2] = 0x90;
+    memcpy(sector + 3, "MSWIN4.1", 8);
+    put16(sector + 11, SECTOR_SIZE);
+    sector[13] = cluster_sectors;
+    put16(sector + 14, FAT_RESERVED_SECTORS);
+    sector[16] = FAT_COPIES;
+    sector[21] = 0xF8;                       // Fixed disk
+    put16(sector + 24, 63);                  // Sectors per track and heads, unused
+    put16(sector + 26, 255);
+    put32(sector + 32, total);
+    put32(sector + 36, fat_size);
+    put32(sector + 44, FAT_ROOT_CLUSTER);
+    put16(sector + 48, FAT_FSINFO_SECTOR);
+    put16(sector + 50, FAT_BACKUP_BOOT_SECTOR);
+    sector[64] = 0x80;                       // Drive number
+    sector[66] = 0x29;                       // Extended boot signature
+    put32(sector + 67, FAT_VOLUME_ID);
+    memcpy(sector + 71, "NO NAME    ", 11);
+    memcpy(sector + 82, "FAT32   ", 8);
+    sector[510] = 0x55;
+    sector[511] = 0xAA;
+    bool ok = target->write(0, 1, sector) && target->write(FAT_BACKUP_BOOT_SECTOR, 1, sector);
+
+    memset(sector, 0, sizeof(sector));
+    put32(sector, 0x41615252);
+    put32(sector + 484, 0x61417272);
+    put32(sector + 488, clusters - 1);       // The root directory takes one
+    put32(sector + 492, FAT_ROOT_CLUSTER + 1);
+    put32(sector + 508, 0xAA550000);
+    ok = ok && target->write(FAT_FSINFO_SECTOR, 1, sector) &&
+         target->write(FAT_BACKUP_BOOT_SECTOR + FAT_FSINFO_SECTOR, 1, sector);
+
+    // Both FATs and the root directory cluster, zeroed a chunk at a time
+    uint32_t chunk = 64;
+    uint8_t *zeros = calloc(chunk, SECTOR_SIZE);
+    ok = ok && zeros != NULL;
+    uint32_t zero_end = first_data + cluster_sectors;
+    for (uint32_t lba = FAT_RESERVED_SECTORS; ok && lba < zero_end; lba += chunk) {
+        ok = target->write(lba, zero_end - lba < chunk ? zero_end - lba : chunk, zeros);
+    }
+    free(zeros);
+
+    memset(sector, 0, sizeof(sector));
+    put32(sector, 0x0FFFFFF8);               // Media byte
+    put32(sector + 4, 0x0FFFFFFF);
+    put32(sector + 8, FAT_END_OF_CHAIN);     // Root directory
+    for (uint32_t copy = 0; ok && copy < FAT_COPIES; copy++) {
+        ok = target->write(FAT_RESERVED_SECTORS + copy * fat_size, 1, sector);
+    }
+    return ok;
+}
+
+// Counts free clusters when FSInfo does not know.
+static bool count_free_clusters(void) {
+    free_clusters = 0;
+    for (uint32_t cluster = 2; cluster - 2 < cluster_count; cluster++) {
+        uint32_t value;
+        if (!fat_get(cluster, &value)) {
+            return false;
+        }
+        free_clusters += value == 0;
+    }
+    return true;
+}
+
+bool fat_volume_mount(const BlockDevice *target, const FatVolumeConfig *config) {
+    fat_volume_unmount();
+    FatVolumeConfig sizes = { FAT_VOLUME_CACHE_SECTORS, FAT_VOLUME_FAT_CACHE_SECTORS };
+    if (config) {
+        sizes = *config;
+    }
+    if (sizes.cache_sectors == 0 || sizes.fat_cache_sectors == 0) {
+        return false;
+    }
+
+    uint8_t boot[SECTOR_SIZE];
+    if (!target->read(0, 1, boot)) {
+        fprintf(stderr, "fat_volume_mount: cannot read the boot sector\n");
+        return false;
+    }
+    uint32_t total = get16(boot + 19) ? get16(boot + 19) : get32(boot + 32);
+    uint8_t cluster_sectors = boot[13];
+    if (boot[510] != 0x55 || boot[511] != 0xAA || get16(boot + 11) != SECTOR_SIZE || cluster_sectors == 0 ||
+        (cluster_sectors & (cluster_sectors - 1)) || get16(boot + 14) == 0 || boot[16] == 0 ||
+        get16(boot + 17) != 0 || get16(boot + 22) != 0 || get32(boot + 36) == 0) {
+        fprintf(stderr, "fat_volume_mount: no FAT32 volume with 512-byte sectors\n");
+        return false;
+    }
+
+    device = target;
+    sectors_per_cluster = cluster_sectors;
+    cluster_bytes = cluster_sectors * SECTOR_SIZE;
+    entries_per_cluster = cluster_bytes / DIR_ENTRY_SIZE;
+    fat_start = get16(boot + 14);
+    fat_copies = boot[16];
+    fat_sectors = get32(boot + 36);
+    data_start = fat_start + fat_copies * fat_sectors;
+    cluster_count = total > data_start ? (total - data_start) / cluster_sectors : 0;
+    if (cluster_count > fat_sectors * (SECTOR_SIZE / 4) - 2) {
+        cluster_count = fat_sectors * (SECTOR_SIZE / 4) - 2;
+    }
+    root_cluster = get32(boot + 44);
+    fsinfo_sector = get16(boot + 48);
+    if (!valid_cluster(root_cluster)) {
+        fprintf(stderr, "fat_volume_mount: bad root cluster\n");
+        return false;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    if (!cache_init(&data_cache, sizes.cache_sectors, false, &stats.cache_hits, &stats.cache_misses) ||
+        !cache_init(&fat_cache, sizes.fat_cache_sectors, true, &stats.fat_cache_hits, &stats.fat_cache_misses)) {
+        cache_free(&data_cache);
+        return false;
+    }
+
+    // FSInfo hints, counted afresh if missing
+    uint8_t info[SECTOR_SIZE];
+    free_clusters = 0xFFFFFFFF;
+    next_free = 2;
+    if (fsinfo_sector && target->read(fsinfo_sector, 1, info) && get32(info) == 0x41615252 &&
+        get32(info + 484) == 0x61417272) {
+        free_clusters = get32(info + 488);
+        next_free = get32(info + 492);
+    }
+    if (free_clusters > cluster_count && !count_free_clusters()) {
+        cache_free(&data_cache);
+        cache_free(&fat_cache);
+        return false;
+    }
+
+    // Generations go on from the time of the mount, so no stamp of an earlier
+    // mount comes back and a path index saved then is checked correctly
+    memset(stamps, 0, sizeof(stamps));
+    generation = (uint64_t)time(NULL) << FAT_STAMP_TIME_SHIFT;
+    stamp_floor = generation;
+    cursor.valid = false;
+    memset(&stats, 0, sizeof(stats));
+    mounted = true;
+    return true;
+}
+
+void fat_volume_unmount(void) {
+    pthread_mutex_lock(&lock);
+    if (mounted) {
+        volume_sync();
+        cache_free(&data_cache);
+        cache_free(&fat_cache);
+        mounted = false;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+// -----------------------------------------------------------------------------
+/* Counters */
+// -----------------------------------------------------------------------------
+
+FatVolumeStats fat_volume_stats(void) {
+    pthread_mutex_lock(&lock);
+    FatVolumeStats current = stats;
+    pthread_mutex_unlock(&lock);
+    return current;
+}
+
+void fat_volume_reset_stats(void) {
+    pthread_mutex_lock(&lock);
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&lock);
+}
+
+const char *fat_volume_op_name(FatOp op) {
+    return op < FAT_OP_COUNT ? op_names[op] : "?";
+}
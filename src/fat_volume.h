@@ -0,0 +1,111 @@
+#ifndef FAT_VOLUME_H
+#define FAT_VOLUME_H
+
+#include "block_device.h"
+#include "storage_backend.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FAT_VOLUME_CACHE_SECTORS 16      // Default directory and data sector cache
+#define FAT_VOLUME_FAT_CACHE_SECTORS 4   // Default FAT table cache
+
+/**
+ * @struct FatVolumeConfig
+ * @brief Cache sizes of a mounted volume, in sectors.
+ */
+typedef struct {
+    uint16_t cache_sectors;       // Directory entries and partial data sectors
+    uint16_t fat_cache_sectors;   // FAT table, kept apart so file data cannot evict it
+} FatVolumeConfig;
+
+/**
+ * @enum FatOp
+ * @brief The backend operations the counters are kept for.
+ */
+typedef enum {
+    FAT_OP_LIST,
+    FAT_OP_STAT,
+    FAT_OP_READ,
+    FAT_OP_WRITE,
+    FAT_OP_TRUNCATE,
+    FAT_OP_CREATE_FILE,
+    FAT_OP_CREATE_DIRECTORY,
+    FAT_OP_RENAME,
+    FAT_OP_REMOVE,
+    FAT_OP_DIR_STAMP,
+    FAT_OP_COUNT
+} FatOp;
+
+/**
+ * @struct FatOpStats
+ * @brief Block device traffic caused by one kind of operation.
+ */
+typedef struct {
+    uint32_t calls;
+    uint32_t reads;             // Read commands; one may cover several sectors
+    uint64_t sectors_read;
+    uint32_t writes;            // Write commands
+    uint64_t sectors_written;
+} FatOpStats;
+
+/**
+ * @struct FatVolumeStats
+ * @brief Counters of the mounted volume since mounting or the last reset.
+ */
+typedef struct {
+    FatOpStats ops[FAT_OP_COUNT];
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t fat_cache_hits;
+    uint32_t fat_cache_misses;
+} FatVolumeStats;
+
+/**
+ * @brief The mounted FAT32 volume, for hal_mock_storage_set_backend.
+ *
+ * Long file names are read and written; short names are generated with
+ * numeric tails. Directory stamps are generation counters advanced by the
+ * volume's own create, rename and remove calls. Dirty cached sectors are
+ * written back at the end of every operation that changes the volume, as
+ * FatFs does on f_close, so the image is consistent between calls.
+ */
+extern const StorageBackend fat_volume_backend;
+
+/**
+ * @brief Writes an empty FAT32 file system over the whole device.
+ *
+ * @param sectors_per_cluster Cluster size in sectors, a power of two up to 128.
+ * @return false if the device is too small for FAT32 at that cluster size
+ *         or a write fails.
+ */
+bool fat_volume_format(const BlockDevice *device, uint8_t sectors_per_cluster);
+
+/**
+ * @brief Mounts the FAT32 volume on a device.
+ *
+ * @param config Cache sizes, or NULL for the defaults above.
+ * @return false if the device holds no FAT32 volume with 512-byte sectors.
+ */
+bool fat_volume_mount(const BlockDevice *device, const FatVolumeConfig *config);
+
+/**
+ * @brief Writes back the caches and releases them.
+ */
+void fat_volume_unmount(void);
+
+/**
+ * @brief Returns the counters of the mounted volume.
+ */
+FatVolumeStats fat_volume_stats(void);
+
+/**
+ * @brief Clears the counters.
+ */
+void fat_volume_reset_stats(void);
+
+/**
+ * @brief Returns the name of an operation, for reports.
+ */
+const char *fat_volume_op_name(FatOp op);
+
+#endif // FAT_VOLUME_H
@@ -0,0 +1,86 @@
+// flush_pipeline.c
+
+#include "flush_pipeline.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Staging strips. On the ESP32-S3 they sit in internal DMA-capable SRAM,
+// while the framebuffer is in PSRAM.
+static uint8_t strip_data[FLUSH_PIPELINE_STRIPS][FLUSH_STRIP_PIXELS * PANEL_BYTES_PER_PIXEL];
+static atomic_bool strip_busy[FLUSH_PIPELINE_STRIPS];   // Set on start, cleared by the interrupt
+
+static const FlushEngine *flush_engine;
+static int strip_count = FLUSH_PIPELINE_STRIPS;
+static int next_strip = 0;   // Strips are used round robin, so the oldest transfer is reused first
+static FlushPipelineStats stats;
+
+// Returns a strip that is not being sent, waiting for one if necessary.
+static int take_strip(void) {
+    int strip = next_strip;
+    next_strip = (next_strip + 1) % strip_count;
+    if (atomic_load(&strip_busy[strip])) {
+        stats.stalls++;
+        while (atomic_load(&strip_busy[strip])) {
+            flush_engine->wait();
+        }
+    }
+    return strip;
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void flush_pipeline_init(const FlushEngine *engine, int strips) {
+    flush_engine = engine;
+    strip_count = strips < 1 ? 1 : strips > FLUSH_PIPELINE_STRIPS ? FLUSH_PIPELINE_STRIPS : strips;
+    next_strip = 0;
+    for (int strip = 0; strip < FLUSH_PIPELINE_STRIPS; strip++) {
+        atomic_store(&strip_busy[strip], false);
+    }
+    memset(&stats, 0, sizeof(stats));
+}
+
+void flush_pipeline_send(const RenderRect *rect, const RenderPixel *pixels, size_t stride) {
+    int band_rows = FLUSH_STRIP_PIXELS / rect->width;
+    for (int y = 0; y < rect->height; y += band_rows) {
+        RenderRect band = { rect->x, rect->y + y, rect->width, rect->height - y };
+        if (band.height > band_rows) {
+            band.height = band_rows;
+        }
+
+        int strip = take_strip();
+        uint8_t *out = strip_data[strip];
+        size_t row_bytes = (size_t)band.width * PANEL_BYTES_PER_PIXEL;
+        for (int row = 0; row < band.height; row++) {
+            pixel_convert_rgb666(out, pixels + (size_t)(y + row) * stride, (size_t)band.width);
+            out += row_bytes;
+        }
+
+        size_t length = row_bytes * (size_t)band.height;
+        atomic_store(&strip_busy[strip], true);
+        stats.transfers++;
+        stats.bytes += length;
+        flush_engine->start(strip, &band, strip_data[strip], length);
+        if (strip_count == 1) {
+            flush_pipeline_drain();
+        }
+    }
+}
+
+void flush_pipeline_transfer_done(int strip) {
+    atomic_store(&strip_busy[strip], false);
+}
+
+void flush_pipeline_drain(void) {
+    for (int strip = 0; strip < strip_count; strip++) {
+        while (atomic_load(&strip_busy[strip])) {
+            flush_engine->wait();
+        }
+    }
+}
+
+FlushPipelineStats flush_pipeline_stats(void) {
+    return stats;
+}
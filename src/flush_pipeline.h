@@ -0,0 +1,77 @@
+#ifndef FLUSH_PIPELINE_H
+#define FLUSH_PIPELINE_H
+
+#include "text_renderer.h"
+#include <stdint.h>
+
+#define FLUSH_PIPELINE_STRIPS 2                         // Staging buffers, one filled while the other is sent
+#define FLUSH_STRIP_PIXELS (TEXT_RENDERER_WIDTH * 8)    // Eight full-width pixel rows, 22.5 KB in RGB666
+
+/**
+ * @struct FlushEngine
+ * @brief The transfer hardware behind the pipeline (SPI/LCD DMA, or a simulation).
+ */
+typedef struct {
+    /**
+     * Starts sending length bytes of RGB666 pixels from a strip to the panel
+     * window area and returns at once. When the last byte is out, the engine
+     * calls flush_pipeline_transfer_done(strip), typically from the
+     * transfer-done interrupt, and then wakes wait().
+     */
+    void (*start)(int strip, const RenderRect *area, const uint8_t *data, size_t length);
+
+    /**
+     * Blocks until a transfer has completed since the previous call, like
+     * taking a binary semaphore the transfer-done interrupt gives.
+     */
+    void (*wait)(void);
+} FlushEngine;
+
+/**
+ * @struct FlushPipelineStats
+ * @brief Work done by the pipeline since flush_pipeline_init.
+ */
+typedef struct {
+    uint32_t transfers;     // Transfers started
+    uint32_t stalls;        // Times the CPU waited for a strip to come back
+    uint64_t bytes;         // Bytes sent to the panel
+} FlushPipelineStats;
+
+/**
+ * @brief Sets up the pipeline on a transfer engine.
+ *
+ * @param strips Staging strips to use, 1 to FLUSH_PIPELINE_STRIPS. With one
+ *               strip every transfer is waited for before going on, as in a
+ *               synchronous flush.
+ */
+void flush_pipeline_init(const FlushEngine *engine, int strips);
+
+/**
+ * @brief Queues a framebuffer rectangle for the panel; a TextRendererFlush.
+ *
+ * The rectangle is converted into the staging strips in the panel's RGB666
+ * layout, in bands of whole pixel rows, and each band is handed to the engine
+ * as soon as it is converted. The CPU only waits when it needs a strip that
+ * is still being sent, so the conversion of one band overlaps the transfer of
+ * the previous one, and rendering
+ * the next frame overlaps the tail of this one. The framebuffer may be drawn
+ * on as soon as this returns.
+ */
+void flush_pipeline_send(const RenderRect *rect, const RenderPixel *pixels, size_t stride);
+
+/**
+ * @brief Marks the transfer from strip as finished. Safe to call from an interrupt.
+ */
+void flush_pipeline_transfer_done(int strip);
+
+/**
+ * @brief Waits until everything queued has reached the panel.
+ */
+void flush_pipeline_drain(void);
+
+/**
+ * @brief Returns the counters since flush_pipeline_init.
+ */
+FlushPipelineStats flush_pipeline_stats(void);
+
+#endif // FLUSH_PIPELINE_H
@@ -0,0 +1,151 @@
+// flush_sim.c
+
+#define _POSIX_C_SOURCE 200809L // clock_nanosleep
+
+#include "flush_sim.h"
+#include "ppm_panel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+typedef struct {
+    int strip;
+    RenderRect area;
+    const uint8_t *data;
+    size_t length;
+    uint64_t done_ns;   // When the link is through with it, on CLOCK_MONOTONIC
+} SimTransfer;
+
+// The pipeline never has more transfers in flight than it has strips.
+static SimTransfer queue[FLUSH_PIPELINE_STRIPS];
+static size_t queue_head = 0;
+static size_t queue_count = 0;
+static bool completed = false;   // Binary semaphore given on every completion
+static uint64_t busy_us = 0;
+static uint64_t link_free_ns = 0;   // End of the last transfer started
+
+static FlushSimConfig model = { FLUSH_SIM_BYTES_PER_SECOND, FLUSH_SIM_SETUP_US };
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+static pthread_t sim_thread;
+static bool running = false;
+static bool stopping = false;
+
+// -----------------------------------------------------------------------------
+/* Transfer Thread */
+// -----------------------------------------------------------------------------
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t transfer_us(size_t length) {
+    return model.setup_us + (uint64_t)length * 1000000u / model.bytes_per_second;
+}
+
+static void *sim_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (queue_count == 0 && !stopping) {
+            pthread_cond_wait(&queued, &lock);
+        }
+        if (queue_count == 0) {
+            break;
+        }
+        SimTransfer transfer = queue[queue_head];
+        pthread_mutex_unlock(&lock);
+
+        // The link is busy, the strip still belongs to the engine. Sleeping
+        // to an absolute time keeps the thread's wake-up latency out of the model.
+        struct timespec done_at = { (time_t)(transfer.done_ns / 1000000000u), (long)(transfer.done_ns % 1000000000u) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &done_at, NULL) != 0) {
+        }
+        ppm_panel_write(&transfer.area, transfer.data);
+
+        // Transfer-done interrupt. The strip is handed back only once its
+        // queue slot is free, as the pipeline may start it again right away.
+        pthread_mutex_lock(&lock);
+        queue_head = (queue_head + 1) % FLUSH_PIPELINE_STRIPS;
+        queue_count--;
+        busy_us += transfer_us(transfer.length);
+        flush_pipeline_transfer_done(transfer.strip);
+        completed = true;
+        pthread_cond_broadcast(&done);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+/* Engine */
+// -----------------------------------------------------------------------------
+
+static void sim_start(int strip, const RenderRect *area, const uint8_t *data, size_t length) {
+    pthread_mutex_lock(&lock);
+    // Transfers queue on the link one after another
+    uint64_t start_ns = now_ns();
+    if (start_ns < link_free_ns) {
+        start_ns = link_free_ns;
+    }
+    link_free_ns = start_ns + transfer_us(length) * 1000u;
+    queue[(queue_head + queue_count) % FLUSH_PIPELINE_STRIPS] = (SimTransfer){ strip, *area, data, length, link_free_ns };
+    queue_count++;
+    pthread_cond_signal(&queued);
+    pthread_mutex_unlock(&lock);
+}
+
+static void sim_wait(void) {
+    pthread_mutex_lock(&lock);
+    while (!completed) {
+        pthread_cond_wait(&done, &lock);
+    }
+    completed = false;
+    pthread_mutex_unlock(&lock);
+}
+
+const FlushEngine flush_sim_engine = { sim_start, sim_wait };
+
+// -----------------------------------------------------------------------------
+/* Lifecycle */
+// -----------------------------------------------------------------------------
+
+bool flush_sim_start(const FlushSimConfig *config) {
+    if (running) {
+        return true;
+    }
+    if (config) {
+        model = *config;
+    }
+    stopping = false;
+    completed = false;
+    busy_us = 0;
+    if (pthread_create(&sim_thread, NULL, sim_main, NULL) != 0) {
+        perror("flush_sim pthread_create");
+        return false;
+    }
+    running = true;
+    return true;
+}
+
+void flush_sim_stop(void) {
+    if (!running) {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_signal(&queued);
+    pthread_mutex_unlock(&lock);
+    pthread_join(sim_thread, NULL);
+    running = false;
+}
+
+uint64_t flush_sim_busy_us(void) {
+    pthread_mutex_lock(&lock);
+    uint64_t us = busy_us;
+    pthread_mutex_unlock(&lock);
+    return us;
+}
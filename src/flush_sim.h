@@ -0,0 +1,52 @@
+#ifndef FLUSH_SIM_H
+#define FLUSH_SIM_H
+
+#include "flush_pipeline.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FLUSH_SIM_BYTES_PER_SECOND (20u * 1000u * 1000u)   // Default link: 16-bit bus at 10 MHz
+#define FLUSH_SIM_SETUP_US 30u                             // Default cost of one transfer
+
+/**
+ * @struct FlushSimConfig
+ * @brief Bandwidth model of the simulated display link.
+ *
+ * A transfer of n bytes keeps the link busy for setup_us plus n at
+ * bytes_per_second. Transfers run one after another, as on one bus.
+ */
+typedef struct {
+    uint32_t bytes_per_second;   // Pixel data rate
+    uint32_t setup_us;           // Window commands, DMA setup and interrupt per transfer
+} FlushSimConfig;
+
+/**
+ * @brief The simulated transfer engine, for flush_pipeline_init.
+ *
+ * Transfers run on a thread that sleeps for as long as the link would be
+ * busy, copies the pixels into the mock panel (ppm_panel_write) and then
+ * signals completion like the transfer-done interrupt. Frame pacing can so be
+ * measured on Linux with real CPU time on one side and modelled link time on
+ * the other.
+ */
+extern const FlushEngine flush_sim_engine;
+
+/**
+ * @brief Starts the transfer thread.
+ *
+ * @param config Bandwidth model, or NULL for the defaults above.
+ * @return true on success, false if the thread could not be created.
+ */
+bool flush_sim_start(const FlushSimConfig *config);
+
+/**
+ * @brief Finishes the queued transfers and stops the thread.
+ */
+void flush_sim_stop(void);
+
+/**
+ * @brief Returns the modelled link busy time since flush_sim_start, in microseconds.
+ */
+uint64_t flush_sim_busy_us(void);
+
+#endif // FLUSH_SIM_H
@@ -0,0 +1,486 @@
+// font_8x16.c
+//
+// DejaVu Sans Mono rendered at 13 px into 8x16 cells with the baseline on
+// row 12, printable ASCII only. Each row is one 32-bit word of eight 4-bit
+// coverage values, leftmost pixel in the top nibble (0 = background,
+// 15 = fully inked). DejaVu fonts are under the Bitstream Vera license.
+
+#include "font_8x16.h"
+
+const uint32_t font_8x16[FONT_GLYPH_COUNT][FONT_GLYPH_HEIGHT] = {
+    // ' '
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '!'
+    { 0x00000000, 0x00000000, 0x00000000, 0x000B8000,
+      0x000B8000, 0x000B8000, 0x000B8000, 0x000A8000,
+      0x000A7000, 0x00021000, 0x00065000, 0x000B8000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '"'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00D46A00,
+      0x00D46A00, 0x00D46A00, 0x00512400, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '#'
+    { 0x00000000, 0x00000000, 0x00000000, 0x000C33C0,
+      0x000E1690, 0x003C0A50, 0x4EFFEFEB, 0x00B52D00,
+      0x00E16900, 0xDEFEFEE1, 0x0870E100, 0x0D24B000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '$'
+    { 0x00000000, 0x00000000, 0x00046000, 0x00046000,
+      0x019DEC40, 0x09946230, 0x0B746000, 0x04ECA300,
+      0x0017BE80, 0x000463F0, 0x051466D0, 0x07DEEC30,
+      0x00046000, 0x00046000, 0x00000000, 0x00000000 },
+    // '%'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2BC60000,
+      0xA40C2000, 0xA40C2001, 0x2BC628A2, 0x00499200,
+      0x3A618C91, 0x00059077, 0x00059068, 0x0000ACB1,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '&'
+    { 0x00000000, 0x00000000, 0x00000000, 0x01AEE600,
+      0x06C10200, 0x06C00000, 0x02F60000, 0x1D6D3046,
+      0x8904D177, 0x98008CB4, 0x4E200DD0, 0x05CCC8D5,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '\''
+    { 0x00000000, 0x00000000, 0x00000000, 0x000A7000,
+      0x000A7000, 0x000A7000, 0x00043000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '('
+    { 0x00000000, 0x00000000, 0x0000A500, 0x0004D000,
+      0x000A7000, 0x001F3000, 0x003F0000, 0x004E0000,
+      0x003F0000, 0x001F3000, 0x000A7000, 0x0004D000,
+      0x0000A500, 0x00000000, 0x00000000, 0x00000000 },
+    // ')'
+    { 0x00000000, 0x00000000, 0x00880000, 0x001E2000,
+      0x000A8000, 0x0005D000, 0x0003F100, 0x0002F200,
+      0x0003F100, 0x0005D000, 0x000A8000, 0x001E2000,
+      0x00880000, 0x00000000, 0x00000000, 0x00000000 },
+    // '*'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00074000,
+      0x09574670, 0x006DC500, 0x03ABB920, 0x06174250,
+      0x00053000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '+'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00043000, 0x00097000, 0x00097000, 0x6EEFEEE4,
+      0x122A7220, 0x00097000, 0x00097000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // ','
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00077000, 0x000CB000,
+      0x001F5000, 0x005C0000, 0x00000000, 0x00000000 },
+    // '-'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00BFF800, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '.'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x000B9000, 0x000DB000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '/'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000990,
+      0x00002E20, 0x00008A00, 0x0001E300, 0x0008B000,
+      0x001E3000, 0x007B0000, 0x00E40000, 0x06C00000,
+      0x0D500000, 0x27000000, 0x00000000, 0x00000000 },
+    // '0'
+    { 0x00000000, 0x00000000, 0x00000000, 0x01AEE800,
+      0x09D23E60, 0x0E6008B0, 0x1F3646E0, 0x2F2B85F0,
+      0x1F3006E0, 0x0E6008B0, 0x09C13E60, 0x01AEE800,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '1'
+    { 0x00000000, 0x00000000, 0x00000000, 0x04BEF000,
+      0x0356F000, 0x0004F000, 0x0004F000, 0x0004F000,
+      0x0004F000, 0x0004F000, 0x0005F000, 0x04FFFFE0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '2'
+    { 0x00000000, 0x00000000, 0x00000000, 0x08DFD700,
+      0x09414E60, 0x00000B90, 0x00000D60, 0x00009B00,
+      0x0008C100, 0x008C1000, 0x08C10000, 0x0FFFFFB0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '3'
+    { 0x00000000, 0x00000000, 0x00000000, 0x09DFD700,
+      0x04213D60, 0x00001C90, 0x007EFE30, 0x00125810,
+      0x00000890, 0x000008C0, 0x17214E80, 0x1BEFD800,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '4'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0000DE00,
+      0x0008CE00, 0x003C5E00, 0x00C35E00, 0x07905E00,
+      0x2D105E00, 0x5FFFFFF3, 0x00005E00, 0x00005E00,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '5'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0AFFFF20,
+      0x0A800000, 0x0A700000, 0x0ADDC600, 0x04326F50,
+      0x000009A0, 0x000009A0, 0x16215E60, 0x1CEFD600,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '6'
+    { 0x00000000, 0x00000000, 0x00000000, 0x007DFD30,
+      0x07E41320, 0x0D500000, 0x1F7DEA10, 0x2FB11B90,
+      0x2F5005E0, 0x0E5005E0, 0x09B11B90, 0x01AEEA10,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '7'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2FFFFFC0,
+      0x00000C70, 0x00003F10, 0x00009A00, 0x0001E400,
+      0x0006D000, 0x000D7000, 0x004F1000, 0x00AA0000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '8'
+    { 0x00000000, 0x00000000, 0x00000000, 0x02BEE910,
+      0x0CA11C80, 0x0E5008B0, 0x07A12C60, 0x03CFFA00,
+      0x0E911BA0, 0x2F3005E0, 0x0E801AC0, 0x03BEEA20,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '9'
+    { 0x00000000, 0x00000000, 0x00000000, 0x02BEE800,
+      0x0D903E60, 0x2F2008B0, 0x2F2008D0, 0x0D913DE0,
+      0x02BEC8D0, 0x000009A0, 0x03216E30, 0x05EFC500,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // ':'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x000B9000, 0x000DB000, 0x00000000,
+      0x00000000, 0x00000000, 0x000B9000, 0x000DB000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // ';'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x000DB000, 0x000B9000,
+      0x00000000, 0x00000000, 0x00077000, 0x000CB000,
+      0x001F5000, 0x005C0000, 0x00000000, 0x00000000 },
+    // '<'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x000004A4, 0x0028EC61, 0x3CD82000,
+      0x4EA50000, 0x005BE940, 0x000027D4, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '='
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x6EEEEEE4,
+      0x12222220, 0x6EEEEEE4, 0x12222220, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '>'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x69300000, 0x17DD7200, 0x00039EB2,
+      0x00016BD3, 0x05AEA400, 0x7C610000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '?'
+    { 0x00000000, 0x00000000, 0x00000000, 0x03BEEA10,
+      0x05512E70, 0x00000C70, 0x00009C10, 0x0007C100,
+      0x000C6000, 0x00073000, 0x00073000, 0x000E6000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '@'
+    { 0x00000000, 0x00000000, 0x00000000, 0x006CDB40,
+      0x09A204E2, 0x3D000096, 0x9606DCA7, 0xB42D21B7,
+      0xC2590077, 0xB32D10B7, 0x8705BB96, 0x2D100000,
+      0x06C40010, 0x004ADD60, 0x00000000, 0x00000000 },
+    // 'A'
+    { 0x00000000, 0x00000000, 0x00000000, 0x001FD000,
+      0x005DF300, 0x00A9B700, 0x01E47C00, 0x05E03F20,
+      0x0AB00D70, 0x0EFFFFC0, 0x4F1004F2, 0x9B0000E6,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'B'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0EFFEA10,
+      0x0E502BA0, 0x0E5007D0, 0x0E500BA0, 0x0EEEFC10,
+      0x0E6129C0, 0x0E5002F2, 0x0E5018E1, 0x0EFFEC40,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'C'
+    { 0x00000000, 0x00000000, 0x00000000, 0x005CFE80,
+      0x05E61260, 0x0C900000, 0x1F500000, 0x2F400000,
+      0x0F500000, 0x0C900000, 0x04E51260, 0x005CFE80,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'D'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2FFEB400,
+      0x2F327F40, 0x2F2009B0, 0x2F2006E0, 0x2F2005F0,
+      0x2F2006E0, 0x2F2009B0, 0x2F326F40, 0x2FFEB400,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'E'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0BFFFFD0,
+      0x0B800000, 0x0B800000, 0x0B800000, 0x0BEEEEA0,
+      0x0B922210, 0x0B800000, 0x0B800000, 0x0BFFFFF0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'F'
+    { 0x00000000, 0x00000000, 0x00000000, 0x08FFFFF1,
+      0x08C00000, 0x08C00000, 0x08C00000, 0x08FEEE90,
+      0x08C22210, 0x08C00000, 0x08C00000, 0x08C00000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'G'
+    { 0x00000000, 0x00000000, 0x00000000, 0x007DFC50,
+      0x08D41360, 0x1F500000, 0x4F100000, 0x5F008EE0,
+      0x3F1014F0, 0x1E5003F0, 0x08D316F0, 0x008DFC60,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'H'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2F2005E0,
+      0x2F2005E0, 0x2F2005E0, 0x2F2005E0, 0x2FEEEEE0,
+      0x2F4226E0, 0x2F2005E0, 0x2F2005E0, 0x2F2005E0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'I'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0BFFFF80,
+      0x000B8000, 0x000B8000, 0x000B8000, 0x000B8000,
+      0x000B8000, 0x000B8000, 0x000B8000, 0x0BFFFF80,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'J'
+    { 0x00000000, 0x00000000, 0x00000000, 0x009FFF10,
+      0x00004F10, 0x00003F10, 0x00003F10, 0x00003F10,
+      0x00003F10, 0x00004F00, 0x4721AC00, 0x2BEEC300,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'K'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2F2005E3,
+      0x2F205E30, 0x2F25E300, 0x2F8F4000, 0x2FED9000,
+      0x2F43F400, 0x2F207E10, 0x2F200CB0, 0x2F2002E6,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'L'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0AA00000,
+      0x0AA00000, 0x0AA00000, 0x0AA00000, 0x0AA00000,
+      0x0AA00000, 0x0AA00000, 0x0AA00000, 0x0AFFFFF4,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'M'
+    { 0x00000000, 0x00000000, 0x00000000, 0x7F700AF4,
+      0x7DC01DE4, 0x7BB258E4, 0x7B68B3E4, 0x7B1DD0E4,
+      0x7B0860E4, 0x7B0000E4, 0x7B0000E4, 0x7B0000E4,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'N'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2FB004E0,
+      0x2FE204E0, 0x2F9904E0, 0x2F3E14E0, 0x2F2974E0,
+      0x2F23D5E0, 0x2F20C9E0, 0x2F205EE0, 0x2F200DE0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'O'
+    { 0x00000000, 0x00000000, 0x00000000, 0x01AEE900,
+      0x0AC23D70, 0x1F4007D0, 0x3F2004F0, 0x4F1004F1,
+      0x3F2004F0, 0x1F4007D0, 0x0AB12D70, 0x01AEE900,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'P'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0BFFEB30,
+      0x0B8019E1, 0x0B8002F3, 0x0B8008F1, 0x0BEEED50,
+      0x0B911000, 0x0B800000, 0x0B800000, 0x0B800000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'Q'
+    { 0x00000000, 0x00000000, 0x00000000, 0x01AEE900,
+      0x0AC23D70, 0x1F4007D0, 0x3F2004F0, 0x4F1004F1,
+      0x3F2004F0, 0x1F4007D0, 0x0AB12D70, 0x01AEFA00,
+      0x00005E40, 0x00000410, 0x00000000, 0x00000000 },
+    // 'R'
+    { 0x00000000, 0x00000000, 0x00000000, 0x1FFFD800,
+      0x1F303E70, 0x1F3009B0, 0x1F301D80, 0x1FEEF810,
+      0x1F428C10, 0x1F300C70, 0x1F3004E1, 0x1F3000C8,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'S'
+    { 0x00000000, 0x00000000, 0x00000000, 0x02AEEC40,
+      0x0C911440, 0x1F200000, 0x0DB41000, 0x018DFA20,
+      0x00002AB0, 0x000004E0, 0x09312BB0, 0x09DFEA10,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'T'
+    { 0x00000000, 0x00000000, 0x00000000, 0xBFFFFFF8,
+      0x000B9000, 0x000B8000, 0x000B8000, 0x000B8000,
+      0x000B8000, 0x000B8000, 0x000B8000, 0x000B8000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'U'
+    { 0x00000000, 0x00000000, 0x00000000, 0x1F3006D0,
+      0x1F3006D0, 0x1F3006D0, 0x1F3006D0, 0x1F3006D0,
+      0x1F3006D0, 0x0F3006D0, 0x0C912B90, 0x02BEE910,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'V'
+    { 0x00000000, 0x00000000, 0x00000000, 0x7C0000F5,
+      0x3F1004E1, 0x0D6008A0, 0x08A00C60, 0x04E02F10,
+      0x00E36C00, 0x00A7A700, 0x005BE200, 0x001FD000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'W'
+    { 0x00000000, 0x00000000, 0x00000000, 0xE500007B,
+      0xC7000099, 0x980DA0B6, 0x7A1DD0D4, 0x4C49C2F2,
+      0x2E7696E0, 0x0EC35CC0, 0x0CE02FA0, 0x0AB00E70,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'X'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2F3003F3,
+      0x07C00C70, 0x00C77C00, 0x003EE300, 0x001DD000,
+      0x008BC700, 0x04E23E20, 0x1D7009B0, 0x8C0001E6,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'Y'
+    { 0x00000000, 0x00000000, 0x00000000, 0x7D0002E4,
+      0x0C700AA0, 0x04E14E20, 0x00AAC700, 0x001EC000,
+      0x000B8000, 0x000B8000, 0x000B8000, 0x000B8000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'Z'
+    { 0x00000000, 0x00000000, 0x00000000, 0x0DFFFFF4,
+      0x000008D1, 0x00003E30, 0x0001D700, 0x0009B000,
+      0x004E2000, 0x01D50000, 0x0AA00000, 0x0FFFFFF6,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '['
+    { 0x00000000, 0x00000000, 0x001FD800, 0x001F2000,
+      0x001F2000, 0x001F2000, 0x001F2000, 0x001F2000,
+      0x001F2000, 0x001F2000, 0x001F2000, 0x001F2000,
+      0x001ED800, 0x00000000, 0x00000000, 0x00000000 },
+    // '\\'
+    { 0x00000000, 0x00000000, 0x00000000, 0x2E200000,
+      0x0A900000, 0x03E10000, 0x00A80000, 0x003E1000,
+      0x000B7000, 0x0004E000, 0x0000C600, 0x00005D00,
+      0x00000C60, 0x00000450, 0x00000000, 0x00000000 },
+    // ']'
+    { 0x00000000, 0x00000000, 0x00AED000, 0x0004D000,
+      0x0004D000, 0x0004D000, 0x0004D000, 0x0004D000,
+      0x0004D000, 0x0004D000, 0x0004D000, 0x0004D000,
+      0x00ADC000, 0x00000000, 0x00000000, 0x00000000 },
+    // '^'
+    { 0x00000000, 0x00000000, 0x00065000, 0x007DE500,
+      0x05D23E30, 0x3D2004D1, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '_'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x88888886, 0x00000000 },
+    // '`'
+    { 0x00000000, 0x00720000, 0x006B0000, 0x00097000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'a'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x06CED800, 0x06302D70, 0x000008A0,
+      0x04BDDEB0, 0x1E5008B0, 0x1F201DB0, 0x06DBA9B0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'b'
+    { 0x00000000, 0x00000000, 0x0C600000, 0x0C600000,
+      0x0C600000, 0x0C8DEA10, 0x0CD21B90, 0x0C8004E0,
+      0x0C6003F0, 0x0C8004E0, 0x0CD21B90, 0x0C8DEA10,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'c'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x004CED70, 0x03F50150, 0x09A00000,
+      0x0B800000, 0x09A00000, 0x03F50150, 0x004CEE70,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'd'
+    { 0x00000000, 0x00000000, 0x00000890, 0x00000890,
+      0x00000890, 0x02BEB990, 0x0C904F90, 0x1F200A90,
+      0x3F100990, 0x1F200A90, 0x0B702E90, 0x02BCBA90,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'e'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x019DE910, 0x0AB11A90, 0x1F3003E0,
+      0x3FDDDDE1, 0x1F100000, 0x0AA10250, 0x018DED70,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'f'
+    { 0x00000000, 0x00000000, 0x0003DEB0, 0x000B7000,
+      0x000D4000, 0x0ADFEDA0, 0x000D4000, 0x000D4000,
+      0x000D4000, 0x000D4000, 0x000D4000, 0x000D4000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'g'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x02BECA90, 0x0B903E90, 0x1F200A90,
+      0x3F100990, 0x1F200A90, 0x0B903E90, 0x02BECA90,
+      0x00000980, 0x03202E30, 0x04DED600, 0x00000000 },
+    // 'h'
+    { 0x00000000, 0x00000000, 0x0C600000, 0x0C600000,
+      0x0C600000, 0x0C8CEB10, 0x0CD21C70, 0x0C7008A0,
+      0x0C6008A0, 0x0C6008A0, 0x0C6008A0, 0x0C6008A0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'i'
+    { 0x00000000, 0x00000000, 0x00089000, 0x00034000,
+      0x00000000, 0x05DE9000, 0x00089000, 0x00089000,
+      0x00089000, 0x00089000, 0x00089000, 0x0CDEEDC0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'j'
+    { 0x00000000, 0x00000000, 0x0003F000, 0x00016000,
+      0x00000000, 0x03DDF000, 0x0003F000, 0x0003F000,
+      0x0003F000, 0x0003F000, 0x0003F000, 0x0003F000,
+      0x0003E000, 0x0007C000, 0x0CED3000, 0x00000000 },
+    // 'k'
+    { 0x00000000, 0x00000000, 0x08B00000, 0x08B00000,
+      0x08B00000, 0x08B01BA0, 0x08B1B900, 0x08CCA000,
+      0x08FAE200, 0x08B09B00, 0x08B01D80, 0x08B003E4,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'l'
+    { 0x00000000, 0x00000000, 0x0DDF1000, 0x002F1000,
+      0x002F1000, 0x002F1000, 0x002F1000, 0x002F1000,
+      0x002F1000, 0x001F1000, 0x000E5000, 0x0005DE80,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'm'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x5DCD7EA0, 0x5D0BA1E1, 0x5B0970D3,
+      0x5B0970D3, 0x5B0970D3, 0x5B0970D3, 0x5B0970D3,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'n'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x0C8BDB10, 0x0CC10B70, 0x0C7008A0,
+      0x0C6008A0, 0x0C6008A0, 0x0C6008A0, 0x0C6008A0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'o'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x01AED800, 0x0AB12C70, 0x0F4006C0,
+      0x1F2005E0, 0x0F4006C0, 0x0AB12C70, 0x01AED900,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'p'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x0C9BCA10, 0x0CC10A90, 0x0C7004E0,
+      0x0C6003F0, 0x0C8005E0, 0x0CD21B90, 0x0C8DEA10,
+      0x0C600000, 0x0C600000, 0x0C600000, 0x00000000 },
+    // 'q'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x01AEC9B0, 0x0AA13EB0, 0x0F3009B0,
+      0x1F2008B0, 0x0F3009B0, 0x0AA13EB0, 0x01BEC9B0,
+      0x000007B0, 0x000007B0, 0x000007B0, 0x00000000 },
+    // 'r'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00B8ADE4, 0x00BE4012, 0x00B90000,
+      0x00B70000, 0x00B70000, 0x00B70000, 0x00B70000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 's'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x01AEEC20, 0x08B10310, 0x08C30000,
+      0x018DEA10, 0x00002D70, 0x04201D60, 0x06DEE900,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 't'
+    { 0x00000000, 0x00000000, 0x00000000, 0x004D0000,
+      0x004D0000, 0x2DDFDD70, 0x004D0000, 0x004D0000,
+      0x004D0000, 0x004D0000, 0x002F2000, 0x0008ED70,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'u'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x0C6008A0, 0x0C6008A0, 0x0C6008A0,
+      0x0C6008A0, 0x0B6008A0, 0x09A01DA0, 0x02CCA9A0,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'v'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x3E1003E1, 0x0C6008A0, 0x07B00D40,
+      0x02F14E00, 0x00B69900, 0x006CE300, 0x001FD000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'w'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0xD400007B, 0xA70000A7, 0x6B0B80D3,
+      0x3E1CC1F0, 0x0E68A6B0, 0x0BD36D80, 0x07E02F40,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'x'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x1D6009B0, 0x03E35D10, 0x005DE300,
+      0x000DB000, 0x009AC600, 0x06D12E30, 0x3E3006D1,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // 'y'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x2F1002F2, 0x0C7007B0, 0x06C00D50,
+      0x01E33E10, 0x00988900, 0x004EE300, 0x000DD000,
+      0x000B7000, 0x003F2000, 0x0CD60000, 0x00000000 },
+    // 'z'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x08DDDE90, 0x00003E40, 0x0001D600,
+      0x000B9000, 0x008C0000, 0x05D10000, 0x0BEEEE80,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    // '{'
+    { 0x00000000, 0x00000000, 0x0002CE60, 0x0008A000,
+      0x000A8000, 0x000A8000, 0x001D6000, 0x08FC0000,
+      0x001D5000, 0x000A8000, 0x000A8000, 0x000A8000,
+      0x0008B000, 0x0002BD60, 0x00000000, 0x00000000 },
+    // '|'
+    { 0x00000000, 0x00000000, 0x000A7000, 0x000A7000,
+      0x000A7000, 0x000A7000, 0x000A7000, 0x000A7000,
+      0x000A7000, 0x000A7000, 0x000A7000, 0x000A7000,
+      0x000A7000, 0x000A7000, 0x00053000, 0x00000000 },
+    // '}'
+    { 0x00000000, 0x00000000, 0x08EB1000, 0x000D5000,
+      0x000B7000, 0x000B7000, 0x0009A000, 0x0001DF60,
+      0x0008B100, 0x000A7000, 0x000B7000, 0x000B6000,
+      0x001D5000, 0x08DA0000, 0x00000000, 0x00000000 },
+    // '~'
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x1ADA3043,
+      0x6626DFB1, 0x00000100, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+};
@@ -0,0 +1,21 @@
+#ifndef FONT_8X16_H
+#define FONT_8X16_H
+
+#include <stdint.h>
+
+#define FONT_GLYPH_WIDTH 8
+#define FONT_GLYPH_HEIGHT 16
+#define FONT_FIRST_CHAR ' '
+#define FONT_LAST_CHAR '~'
+#define FONT_GLYPH_COUNT (FONT_LAST_CHAR - FONT_FIRST_CHAR + 1)
+
+/**
+ * @brief Anti-aliased monospace glyphs for printable ASCII.
+ *
+ * font_8x16[c - FONT_FIRST_CHAR][row] holds the eight pixels of one glyph
+ * row as 4-bit coverage values, leftmost pixel in the top nibble. Coverage
+ * 0 is background and 15 is fully inked.
+ */
+extern const uint32_t font_8x16[FONT_GLYPH_COUNT][FONT_GLYPH_HEIGHT];
+
+#endif // FONT_8X16_H
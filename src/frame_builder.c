@@ -0,0 +1,50 @@
+// frame_builder.c
+
+#include "frame_builder.h"
+#include <string.h>
+
+#define ANSI_UNDERLINE "\033[4m"
+#define ANSI_RESET "\033[0m"
+
+void frame_init(FrameSpan *frame, char *storage, size_t capacity) {
+    frame->data = storage;
+    frame->length = 0;
+    frame->capacity = capacity;
+    frame->truncated = false;
+}
+
+void frame_append(FrameSpan *frame, const char *text, size_t length) {
+    size_t room = frame->capacity - frame->length;
+    if (length > room) {
+        length = room;
+        frame->truncated = true;
+    }
+    memcpy(frame->data + frame->length, text, length);
+    frame->length += length;
+}
+
+void frame_append_str(FrameSpan *frame, const char *text) {
+    frame_append(frame, text, strlen(text));
+}
+
+void frame_compose_text(FrameSpan *frame, const char *text, size_t length, size_t cursor, bool show_cursor) {
+    if (!show_cursor || cursor > length) {
+        frame_append(frame, text, length);
+        return;
+    }
+
+    // Text before the cursor in one copy
+    frame_append(frame, text, cursor);
+
+    // The cursor cell; newlines and the end of text get a visible stand-in
+    bool on_char = cursor < length && text[cursor] != '\n';
+    frame_append(frame, ANSI_UNDERLINE, sizeof(ANSI_UNDERLINE) - 1);
+    frame_append(frame, on_char ? &text[cursor] : " ", 1);
+    frame_append(frame, ANSI_RESET, sizeof(ANSI_RESET) - 1);
+
+    // Text after the cursor in one copy (a newline under the cursor is kept)
+    size_t rest = on_char ? cursor + 1 : cursor;
+    if (rest < length) {
+        frame_append(frame, text + rest, length - rest);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef FRAME_BUILDER_H
+#define FRAME_BUILDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Extra bytes a cursor adds to a frame: underline on/off codes plus a stand-in space
+#define FRAME_CURSOR_OVERHEAD 16
+
+/**
+ * @struct FrameSpan
+ * @brief Output span that a frame is composed into.
+ *
+ * The storage is preallocated by the caller and the length is tracked as the
+ * frame grows, so appending never rescans the output. Appends that do not fit
+ * are cut off and flagged in truncated.
+ */
+typedef struct {
+    char *data;       // Caller-provided storage
+    size_t length;    // Bytes composed so far
+    size_t capacity;  // Size of data
+    bool truncated;   // Output did not fit
+} FrameSpan;
+
+/**
+ * @brief Starts an empty frame in the given storage.
+ */
+void frame_init(FrameSpan *frame, char *storage, size_t capacity);
+
+/**
+ * @brief Appends length bytes to the frame.
+ */
+void frame_append(FrameSpan *frame, const char *text, size_t length);
+
+/**
+ * @brief Appends a null-terminated string to the frame.
+ */
+void frame_append_str(FrameSpan *frame, const char *text);
+
+/**
+ * @brief Composes a block of text with an underlined cursor cell in one pass.
+ *
+ * The text before and after the cursor is copied in bulk; only the cursor
+ * cell is wrapped in underline codes. A cursor on a newline or at the end of
+ * the text is drawn as an underlined space. The output needs at most
+ * length + FRAME_CURSOR_OVERHEAD bytes.
+ *
+ * @param text          The visible text.
+ * @param length        Number of bytes in text.
+ * @param cursor        Cursor offset within text (length means after the text).
+ * @param show_cursor   false to compose the text without the cursor (blink off).
+ */
+void frame_compose_text(FrameSpan *frame, const char *text, size_t length, size_t cursor, bool show_cursor);
+
+#endif // FRAME_BUILDER_H
@@ -3,6 +3,10 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+// Timeout value for hal_event_wait that never expires
+#define HAL_WAIT_FOREVER UINT32_MAX
 
 
 /**
@@ -82,6 +86,9 @@ typedef enum {
     KEY_CTRL_R,
     KEY_CTRL_N,
     KEY_CTRL_S,
+    KEY_CTRL_F,
+    KEY_CTRL_Z,
+    KEY_CTRL_Y,
     KEY_CTRL_ALT_N,
 
     KEY_CHAR_BASE
@@ -98,6 +105,58 @@ typedef enum {
  */
 KeyCode hal_input_get_key(void);
 
+/**
+ * @struct KeyEvent
+ * @brief A key press together with the time it was captured.
+ *
+ * The timestamp is taken from hal_time_ms() when the key is read from the
+ * keyboard, so the delay until the core handles it can be measured.
+ */
+typedef struct {
+    KeyCode key;
+    uint32_t timestamp_ms;
+} KeyEvent;
+
+/**
+ * @brief Reads all pending key events, oldest first.
+ *
+ * Keys are buffered in a ring inside the HAL so fast typing or pasted text is
+ * not lost between reads. Non-blocking: returns 0 when nothing is pending.
+ *
+ * @param out   Array that receives the events.
+ * @param max   Capacity of out.
+ * @return Number of events written to out.
+ */
+size_t hal_input_read_keys(KeyEvent *out, size_t max);
+
+/**
+ * @brief Blocks until input is available or the timeout expires.
+ *
+ * This is the only place the main loop sleeps. On the device the core task
+ * waits for a notification from the scanner task or hal_event_signal, so the
+ * CPU can idle; in the mock it polls a pipe written by the scanner thread.
+ *
+ * @param timeout_ms Maximum time to wait in milliseconds, or HAL_WAIT_FOREVER.
+ * @return true if keys can be read with hal_input_read_keys, false on timeout.
+ */
+bool hal_event_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Wakes hal_event_wait from another thread.
+ *
+ * Used by background tasks such as the storage worker when they have a
+ * result for the core. hal_event_wait then returns early; it returns false
+ * unless keys are also waiting.
+ */
+void hal_event_signal(void);
+
+/**
+ * @brief Returns a monotonic millisecond clock.
+ *
+ * The value wraps around after about 49 days; compare times by subtraction.
+ */
+uint32_t hal_time_ms(void);
+
 /**
  * @brief Clears the display or screen.
  *
@@ -117,11 +176,76 @@ void hal_display_write(const char *text);
 /**
  * @brief Moves the display cursor to the specified line and column.
  *
- * @param line   The vertical position (e.g. row number).
- * @param column The horizontal position (e.g. column number).
+ * Subsequent hal_display_write calls draw from this position.
+ *
+ * @param line   The vertical position (0-based row number).
+ * @param column The horizontal position (0-based column number).
  */
 void hal_display_set_cursor(int line, int column);
 
+/**
+ * @brief Shows everything drawn since the last call.
+ *
+ * Called once at the end of every frame. The ESP32-S3 port sends the changed
+ * cells of its framebuffer to the panel here; a terminal just flushes stdout.
+ */
+void hal_display_flush(void);
+
+// Storage functions are called from the core and from the storage worker
+// thread. A port must serialize access to the card itself (FatFs does with
+// FF_FS_REENTRANT); the mock backends lock or open a new stream per call.
+
+#define HAL_NAME_LEN 256           // Entry name buffer size, fits a FAT long file name
+#define HAL_STORAGE_BLOCK_SIZE 512 // Card sector: writes aligned to it do not read-modify-write
+
+/**
+ * @enum DirEntryType
+ * @brief Kind of a directory entry.
+ */
+typedef enum {
+    DIR_ENTRY_FILE = 0,
+    DIR_ENTRY_DIRECTORY = 1
+} DirEntryType;
+
+/**
+ * @struct DirEntry
+ * @brief One directory entry with the metadata the file explorer needs.
+ */
+typedef struct {
+    char name[HAL_NAME_LEN];
+    uint32_t size;     // Bytes, 0 for directories
+    uint32_t mtime;    // Seconds since the Unix epoch
+    uint8_t type;      // DirEntryType
+} DirEntry;
+
+/**
+ * @brief Lists part of a directory with the type, size and mtime of every entry.
+ *
+ * Returns the entries with index start to start + max_entries - 1 in
+ * directory order, so large directories can be read a chunk at a time.
+ * The HAL keeps the last directory open: reading the following chunk
+ * continues where the previous call stopped, and only going backwards
+ * rewinds. Everything is filled in while the directory is read (FatFs
+ * f_readdir returns it with each entry; the mock uses d_type and fstatat on
+ * the open directory), so callers need no further storage calls per entry.
+ *
+ * @param directory   The virtual directory path to list.
+ * @param start       Index of the first entry to return.
+ * @param entries     Receives up to max_entries records.
+ * @param max_entries Capacity of entries.
+ * @return The number of entries written; less than max_entries at the end.
+ */
+size_t hal_storage_list_entries(const char *directory, size_t start, DirEntry *entries, size_t max_entries);
+
+/**
+ * @brief Fills a DirEntry for a single path.
+ *
+ * @param path  The path to look up; the record gets its last component as name.
+ * @param entry Receives the record.
+ * @return true on success, false if the path does not exist.
+ */
+bool hal_storage_stat(const char *path, DirEntry *entry);
+
 /**
  * @brief Lists files in a directory.
  *
@@ -166,6 +290,79 @@ bool hal_storage_rename_file(const char *oldpath, const char *newpath);
 bool hal_storage_create_directory(const char *dirpath);
 bool hal_storage_write_file(const char *filepath, const char *buffer, size_t length);
 
+/**
+ * @brief Deletes a file.
+ *
+ * @param filepath The path of the file to delete.
+ * @return true on success, false if the file could not be removed.
+ */
+bool hal_storage_delete_file(const char *filepath);
+
+/**
+ * @brief Returns the size of a file in bytes without reading it.
+ *
+ * @param filepath The path of the file.
+ * @return The file size, or -1 if the file does not exist.
+ */
+long hal_storage_file_size(const char *filepath);
+
+/**
+ * @brief Reads a byte range of a file into a buffer.
+ *
+ * Unlike hal_storage_read_file this does not null-terminate and lets callers
+ * page through files that are larger than RAM.
+ *
+ * @param filepath The path of the file to read.
+ * @param offset   Byte offset of the first byte to read.
+ * @param buffer   The output buffer.
+ * @param length   Number of bytes to read.
+ * @return Number of bytes read (short at end of file), or -1 on failure.
+ */
+int hal_storage_read_range(const char *filepath, size_t offset, char *buffer, size_t length);
+
+/**
+ * @brief Writes a byte range of a file in place.
+ *
+ * Creates the file if it does not exist. Existing bytes outside the range are
+ * left untouched and the file is never truncated.
+ *
+ * @param filepath The path of the file to write.
+ * @param offset   Byte offset of the first byte to write.
+ * @param buffer   The bytes to write.
+ * @param length   Number of bytes to write.
+ * @return true if all bytes were written, false otherwise.
+ */
+bool hal_storage_write_range(const char *filepath, size_t offset, const char *buffer, size_t length);
+
+/**
+ * @brief Sets the length of a file, cutting it short or extending it with zeros.
+ *
+ * Together with hal_storage_write_range this lets a file be patched in place
+ * instead of being written out again in full (FatFs: f_lseek and f_truncate).
+ *
+ * @param filepath The path of the file.
+ * @param length   The new length in bytes.
+ * @return true on success, false if the file does not exist or could not be resized.
+ */
+bool hal_storage_truncate(const char *filepath, size_t length);
+
+/**
+ * @brief Returns a stamp that changes whenever a directory's entries change.
+ *
+ * Used to revalidate cached listings without reading the directory, and the
+ * path index saved at the previous start. A stamp therefore must not repeat
+ * across restarts either. The mock host backend returns the directory mtime
+ * in nanoseconds, the RAM disk a generation counter. A FAT port, where
+ * directory times are not kept up to date, returns a generation counter that
+ * its own create, rename and delete calls advance, starting each mount from
+ * the current time so the stamps of an earlier mount never come back.
+ *
+ * @param dirpath The directory path.
+ * @param stamp   Receives the stamp.
+ * @return true on success, false if the directory does not exist.
+ */
+bool hal_storage_dir_stamp(const char *dirpath, uint64_t *stamp);
+
 bool hal_system_is_wakeup_from_sleep(void);
 void hal_system_prepare_for_sleep(void);
 void hal_system_sleep(void);
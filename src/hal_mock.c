@@ -1,20 +1,30 @@
 // hal_mock.c
 
+#define _DEFAULT_SOURCE // clock_gettime, poll
+
 #include "hal_interface.h"
+#include "hal_mock.h"
+#include "key_queue.h"
+#include "text_renderer.h"
+#include "ppm_panel.h"
+#include "flush_pipeline.h"
+#include "flush_sim.h"
+#include "perf_stats.h"
 #include <stdio.h>
 #include <string.h>
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <stdlib.h>
-#include <dirent.h>  // for opendir, readdir, closedir
-#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdbool.h>
 #include <sys/select.h>
 #include <sys/time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 
-#define SDCARD_DIR "./sdcard" // Root directory for the mock "SD card"
 
 /* 
 Hello, It's me on day one, i understand maybe 5% of this. I made this file to get me
@@ -23,25 +33,7 @@ basic hardware emulation. Have mercy on my code
 w0wfisch, 2024_12_18
 */
 
-// -----------------------------------------------------------------------------
-/* Helper Functions */
-// -----------------------------------------------------------------------------
-
-// Helper function to build full path
-// Converts a virtual (device-level) path into a host filesystem path for the mock environment.
-
-static void build_full_path(const char *virtual_path, char *full_path, size_t size) {
-    if (strcmp(virtual_path, "/") == 0) {
-        snprintf(full_path, size, "%s", SDCARD_DIR);
-    } else {
-        // Remove leading slash to prevent double slashes
-        if (virtual_path[0] == '/') {
-            snprintf(full_path, size, "%s%s", SDCARD_DIR, virtual_path);
-        } else {
-            snprintf(full_path, size, "%s/%s", SDCARD_DIR, virtual_path);
-        }
-    }
-}
+// The SD card half of the mock is in hal_mock_storage.c.
 
 static struct termios orig_termios;
 
@@ -65,15 +57,6 @@ static void enable_raw_mode() {
     tcsetattr(STDIN_FILENO, TCSANOW, &raw);
 }
 
-// Check if a key has been pressed
-static int kbhit(void) {
-    fd_set set;
-    struct timeval timeout = {0, 0};
-    FD_ZERO(&set);
-    FD_SET(STDIN_FILENO, &set);
-    return select(STDIN_FILENO+1, &set, NULL, NULL, &timeout) == 1;
-}
-
 // -----------------------------------------------------------------------------
 /* Key Reading Logic */
 // -----------------------------------------------------------------------------
@@ -89,7 +72,7 @@ static KeyCode read_key() {
     int n = read(STDIN_FILENO, &c, 1);
     if (n == 0) return KEY_NONE;
 
-    printf("DEBUG: Key Pressed: 0x%02x\n", c); // Debug output for key pressed
+    fprintf(stderr, "DEBUG: Key Pressed: 0x%02x\n", c); // Debug output for key pressed
 
     if (c == '\r' || c == '\n') return KEY_ENTER;      // Enter key
     if (c == 127 || c == '\b') return KEY_BACKSPACE;  // Backspace key
@@ -107,8 +90,31 @@ static KeyCode read_key() {
                 case 'B': return KEY_ARROW_DOWN;
                 case 'C': return KEY_ARROW_RIGHT;
                 case 'D': return KEY_ARROW_LEFT;
-                default: return KEY_NONE;
+                case 'H': return KEY_HOME;
+                case 'F': return KEY_END;
+                default: break;
+            }
+
+            // Navigation keys sent as ESC [ <digit> ~
+            if (seq >= '1' && seq <= '6') {
+                unsigned char tilde;
+                if (read(STDIN_FILENO, &tilde, 1) == 0 || tilde != '~') return KEY_NONE;
+                switch (seq) {
+                    case '1': return KEY_HOME;
+                    case '3': return KEY_DELETE;
+                    case '4': return KEY_END;
+                    case '5': return KEY_PAGE_UP;
+                    case '6': return KEY_PAGE_DOWN;
+                    default: return KEY_NONE;
+                }
             }
+            return KEY_NONE;
+        }
+        if (next_c == 'O') { // F1-F4 sent as ESC O P..S
+            unsigned char seq;
+            if (read(STDIN_FILENO, &seq, 1) == 0) return KEY_NONE;
+            if (seq >= 'P' && seq <= 'S') return (KeyCode)(KEY_F1 + (seq - 'P'));
+            return KEY_NONE;
         }
         return KEY_ESCAPE;
     }
@@ -117,6 +123,9 @@ static KeyCode read_key() {
     if (c == 14) return KEY_CTRL_N; // Ctrl+N
     if (c == 18) return KEY_CTRL_R; // Ctrl+R
     if (c == 19) return KEY_CTRL_S; // Ctrl+S
+    if (c == 6) return KEY_CTRL_F;  // Ctrl+F
+    if (c == 26) return KEY_CTRL_Z; // Ctrl+Z
+    if (c == 25) return KEY_CTRL_Y; // Ctrl+Y
 
     // Printable characters
     if (c >= 32 && c <= 126) return (KeyCode)(KEY_CHAR_BASE + c);
@@ -124,174 +133,207 @@ static KeyCode read_key() {
     return KEY_NONE;
 }
 
-// Public HAL function: Retrieves a pressed key or returns KEY_NONE if none.
-KeyCode hal_input_get_key(void) {
-    if (kbhit()) {
-        return read_key();
-    }
-    return KEY_NONE;
-}
+// -----------------------------------------------------------------------------
+/* Keyboard Scanner */
+// -----------------------------------------------------------------------------
 
+// Stand-in for the matrix scanner task on the device: a thread that blocks on
+// stdin, decodes keys and hands them to the core through a lock-free queue.
+// The core is woken through a self-pipe, so a slow redraw or file write in the
+// core never delays reading the keyboard.
+static KeyQueue key_queue;
+static pthread_t scanner_thread;
+static int wake_pipe[2] = { -1, -1 };  // [0] polled by the core, [1] written by the scanner
+static atomic_uint_least32_t keys_queued;
+static atomic_bool input_closed;
+
+static void *scanner_main(void *arg) {
+    (void)arg;
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    for (;;) {
+        if (poll(&pfd, 1, -1) < 0) {
+            continue; // Interrupted by a signal
+        }
+        if (!(pfd.revents & POLLIN)) {
+            break; // stdin was closed
+        }
+        KeyCode key = read_key();
+        if (key == KEY_NONE) {
+            continue;
+        }
 
+        KeyEvent event = { .key = key, .timestamp_ms = hal_time_ms() };
+        if (!key_queue_push(&key_queue, &event)) {
+            continue; // Counted by the queue, see hal_mock_input_stats
+        }
+        atomic_fetch_add(&keys_queued, 1);
+        // Wake the core; if the pipe is full a wakeup is already pending
+        char token = 1;
+        ssize_t written = write(wake_pipe[1], &token, 1);
+        (void)written;
+    }
+    atomic_store(&input_closed, true);
+    return NULL;
+}
 
-// -----------------------------------------------------------------------------
-/* Display Handling */
-// -----------------------------------------------------------------------------
+static void start_scanner(void) {
+    key_queue_init(&key_queue);
+    if (pipe(wake_pipe) != 0) {
+        perror("pipe");
+        return;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&scanner_thread, NULL, scanner_main, NULL) != 0) {
+        perror("pthread_create");
+    }
+}
 
-// Clears the display. In this mock, it just prints a message to stdout.
-void hal_display_clear(void) {
-    printf("\n--- DISPLAY CLEARED ---\n");
+HalMockInputStats hal_mock_input_stats(void) {
+    HalMockInputStats stats;
+    stats.keys_queued = (uint32_t)atomic_load(&keys_queued);
+    stats.keys_dropped = key_queue_dropped(&key_queue);
+    stats.input_closed = atomic_load(&input_closed);
+    return stats;
 }
 
-// Writes the given text to the (mock) display (stdout).
-void hal_display_write(const char *text) {
-    printf("%s", text);
+// Public HAL function: Drains up to max queued key events, oldest first.
+size_t hal_input_read_keys(KeyEvent *out, size_t max) {
+    PERF_BEGIN(span);
+    size_t count = key_queue_pop(&key_queue, out, max);
+    PERF_END(span, PERF_INPUT_READ, count * sizeof(KeyEvent));
+    return count;
 }
 
-// Sets the display cursor to the specified line and column. 
-void hal_display_set_cursor(int line, int column) {
-    (void)line;
-    (void)column;
+// Public HAL function: Retrieves a pressed key or returns KEY_NONE if none.
+KeyCode hal_input_get_key(void) {
+    KeyEvent event;
+    if (hal_input_read_keys(&event, 1) == 1) {
+        return event.key;
+    }
+    return KEY_NONE;
 }
 
 
 
 // -----------------------------------------------------------------------------
-/* Storage Handling */
+/* Event Loop */
 // -----------------------------------------------------------------------------
 
-/* Lists files from the given virtual directory into the 'files' array. Returns the number of files found. */
-size_t hal_storage_list_files(const char *directory, char files[][64], size_t max_files) {
-    char full_path[512];
-    build_full_path(directory, full_path, sizeof(full_path));
-
-    DIR *dir = opendir(full_path);
-    if (!dir) {
-        perror("opendir");
-        return 0;
+// Sleeps on the scanner's wake pipe until a key is queued or the timeout expires.
+bool hal_event_wait(uint32_t timeout_ms) {
+    if (!key_queue_is_empty(&key_queue)) {
+        return true; // Keys left over from an earlier read
     }
-
-    size_t count = 0;
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL && count < max_files) {
-        // Ignore '.' and '..'
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-
-        // Construct filepath to check if it's a file or directory
-        char filepath[512];
-        snprintf(filepath, sizeof(filepath), "%s/%s", full_path, entry->d_name);
-
-        struct stat st;
-        if (stat(filepath, &st) == 0) {
-            // We list both files and directories, core logic handles directories separately.
-            strncpy(files[count], entry->d_name, 64);
-            files[count][63] = '\0';
-            count++;
+    struct pollfd pfd = { .fd = wake_pipe[0], .events = POLLIN };
+    int timeout = timeout_ms == HAL_WAIT_FOREVER ? -1 : (int)timeout_ms;
+    if (poll(&pfd, 1, timeout) > 0) {
+        // Consume the wakeup tokens; the queue itself says what is pending
+        char tokens[64];
+        while (read(wake_pipe[0], tokens, sizeof(tokens)) > 0) {
         }
     }
-
-    closedir(dir);
-    return count;
+    return !key_queue_is_empty(&key_queue);
 }
 
-// Reads the file at 'filepath' into 'buffer' (up to buffer_size-1 bytes). Returns bytes read or -1 on error.
-int hal_storage_read_file(const char *filepath, char *buffer, size_t buffer_size) {
-    char fullpath[512];
-    build_full_path(filepath, fullpath, sizeof(fullpath));
-
-    FILE *f = fopen(fullpath, "rb");
-    if (!f) {
-        return -1;
-    }
-
-    // Read file into buffer
-    size_t bytesRead = fread(buffer, 1, buffer_size - 1, f);
-    fclose(f);
-    buffer[bytesRead] = '\0'; // null terminate
-
-    return (int)bytesRead;
+// Wakes hal_event_wait through the same pipe the scanner uses.
+void hal_event_signal(void) {
+    char token = 1;
+    ssize_t written = write(wake_pipe[1], &token, 1);
+    (void)written;
 }
 
-// Checks if the given file exists in the mock file system.
-bool hal_storage_file_exists(const char *filepath) {
-    struct stat buffer;
-    return (stat(filepath, &buffer) == 0);
+// Monotonic milliseconds since an arbitrary point.
+uint32_t hal_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
 }
 
-// Creates a new empty file. Returns true on success, false on failure.
-bool hal_storage_create_file(const char *filepath) {
-    FILE *file = fopen(filepath, "w");
-    if (file == NULL) {
-        perror("hal_storage_create_file fopen");
-        return false;
-    }
-    fclose(file);
-    printf("File created successfully at '%s'\n", filepath); // Debug statement
-    return true;
-}
 
-// Checks if the given virtual path represents a directory in the mock environment.
-bool hal_storage_is_directory(const char *virtual_path) {
-    char full_path[512];
-    build_full_path(virtual_path, full_path, sizeof(full_path));
 
-    struct stat st;
-    if (stat(full_path, &st) == 0 && S_ISDIR(st.st_mode)) {
-        printf("DEBUG: Path: %s | Is Directory: Yes\n", full_path);
-        return true;
+// -----------------------------------------------------------------------------
+/* Display Handling */
+// -----------------------------------------------------------------------------
+
+// With CYBERTYPER_FRAMES=<dir> set, the display calls also drive the glyph
+// renderer and flush pipeline of the ESP32-S3 port over the simulated
+// transfer engine, and every frame that changed pixels is saved as
+// <dir>/frame_NNNNN.ppm from a mock panel that only receives the flushed
+// rectangles. The pixels and transfers of each frame are logged on stderr.
+static const char *frames_dir = NULL;
+static unsigned frame_count = 0;
+
+static bool frames_enabled(void) {
+    static bool checked = false;
+    if (!checked) {
+        checked = true;
+        frames_dir = getenv("CYBERTYPER_FRAMES");
+        if (frames_dir && flush_sim_start(NULL)) {
+            flush_pipeline_init(&flush_sim_engine, FLUSH_PIPELINE_STRIPS);
+            text_renderer_init(flush_pipeline_send);
+        } else {
+            frames_dir = NULL;
+        }
     }
+    return frames_dir != NULL;
+}
 
-    if (stat(full_path, &st) != 0) {
-        perror("stat");
-        printf("DEBUG: Failed to stat path: %s\n", full_path);
-    } else {
-        printf("DEBUG: Path: %s | Is Directory: No\n", full_path);
+// Clears the display. In this mock, the terminal is cleared and the cursor sent home.
+void hal_display_clear(void) {
+    printf("\033[2J\033[H");
+    fflush(stdout);
+    if (frames_enabled()) {
+        text_renderer_clear();
     }
-    return false;
 }
 
-// Renames a file or directory from oldpath to newpath. Returns true on success.
-bool hal_storage_rename_file(const char *oldpath, const char *newpath) {
-    int result = rename(oldpath, newpath);
-    if (result != 0) {
-        perror("hal_storage_rename_file rename");
-        return false;
+// Writes the given text to the (mock) display (stdout).
+void hal_display_write(const char *text) {
+    PERF_BEGIN(span);
+    printf("%s", text);
+    if (frames_enabled()) {
+        text_renderer_write(text);
     }
-    printf("Renamed '%s' to '%s' successfully\n", oldpath, newpath); // Debug statement
-    return true;
+    PERF_END(span, PERF_DISPLAY_WRITE, strlen(text));
 }
 
-// Creates a directory at 'dirpath'. Returns true on success.
-bool hal_storage_create_directory(const char *dirpath) {
-    int result = mkdir(dirpath, 0777);
-    if (result != 0) {
-        perror("hal_storage_create_directory mkdir");
-        return false;
+// Sets the display cursor to the specified line and column (both 0-based) with an ANSI cursor move.
+void hal_display_set_cursor(int line, int column) {
+    printf("\033[%d;%dH", line + 1, column + 1);
+    if (frames_enabled()) {
+        text_renderer_set_cursor(line, column);
     }
-    printf("Directory created successfully at '%s'\n", dirpath); // Debug statement
-    return true;
 }
 
-// Writes 'length' bytes from 'buffer' to the file at 'filepath'. Returns true on success.
-bool hal_storage_write_file(const char *filepath, const char *buffer, size_t length) {
-    char fullpath[512];
-    build_full_path(filepath, fullpath, sizeof(fullpath));
-    
-    FILE *f = fopen(fullpath, "wb");
-    if (!f) {
-        perror("hal_storage_write_file fopen");
-        return false;
+// Ends a frame: the terminal output is flushed, and the rendered frame saved.
+// Returns the pixels sent to the mock panel.
+static size_t end_frame(void) {
+    fflush(stdout);
+    if (!frames_enabled()) {
+        return 0;
     }
-    size_t written = fwrite(buffer, 1, length, f);
-    fclose(f);
-    if (written != length) {
-        printf("Warning: Only wrote %zu of %zu bytes to '%s'\n", written, length, fullpath);
-        return false;
+    uint32_t transfers = flush_pipeline_stats().transfers;
+    size_t pixels = text_renderer_flush();
+    if (pixels == 0) {
+        return 0;
+    }
+    flush_pipeline_drain();
+    transfers = flush_pipeline_stats().transfers - transfers;
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%05u.ppm", frames_dir, frame_count++);
+    if (!ppm_panel_save(path)) {
+        fprintf(stderr, "Could not write frame %s\n", path);
+        return pixels;
     }
-    printf("Successfully wrote %zu bytes to '%s'\n", written, fullpath);
-    return true;
+    fprintf(stderr, "Frame %u: %zu pixels flushed in %u transfers\n", frame_count - 1, pixels, transfers);
+    return pixels;
+}
+
+void hal_display_flush(void) {
+    PERF_BEGIN(span);
+    size_t pixels = end_frame();
+    PERF_END(span, PERF_DISPLAY_FLUSH, pixels * PANEL_BYTES_PER_PIXEL);
 }
 
 
@@ -312,7 +354,7 @@ void hal_system_prepare_for_sleep(void) {
 
 // Simulates putting the system into a sleep state.
 void hal_system_sleep(void) {
-    printf("Going to sleep... (mock)\n");
+    fprintf(stderr, "Going to sleep... (mock)\n");
 }
 
 
@@ -325,11 +367,14 @@ void hal_system_sleep(void) {
 __attribute__((constructor))
 static void init_mock_hal() {
     enable_raw_mode();
-    printf("--- Mock HAL Initialized ---\n");
+    start_scanner();
+    fprintf(stderr, "--- Mock HAL Initialized ---\n");
 }
 // Automatically called at program exit to restore terminal state and clean up.
 __attribute__((destructor))
 static void cleanup_mock_hal() {
     disable_raw_mode();
-    printf("--- Mock HAL Cleanup ---\n");
+    HalMockInputStats input = hal_mock_input_stats();
+    fprintf(stderr, "Keys queued: %u, dropped: %u\n", (unsigned)input.keys_queued, (unsigned)input.keys_dropped);
+    fprintf(stderr, "--- Mock HAL Cleanup ---\n");
 }
\ No newline at end of file
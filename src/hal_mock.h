@@ -0,0 +1,22 @@
+#ifndef HAL_MOCK_H
+#define HAL_MOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct HalMockInputStats
+ * @brief Keyboard traffic of the mock scanner thread since program start.
+ */
+typedef struct {
+    uint32_t keys_queued;   // Keys handed to the core through the key queue
+    uint32_t keys_dropped;  // Keys lost because the key queue was full
+    bool input_closed;      // stdin reached its end and the scanner stopped
+} HalMockInputStats;
+
+/**
+ * @brief Returns the input counters of the mock HAL.
+ */
+HalMockInputStats hal_mock_input_stats(void);
+
+#endif // HAL_MOCK_H
@@ -0,0 +1,224 @@
+// hal_mock_storage.c
+//
+// The storage half of the mock HAL. The hal_storage_* functions run on a
+// StorageBackend: the ./sdcard directory of the host by default, the RAM
+// disk, a FAT32 image, or any of them behind the SD card emulator. Kept apart from the terminal
+// half in hal_mock.c so headless programs (the replay harness in tests/) can
+// link it with their own input and display.
+
+#define _DEFAULT_SOURCE // getenv
+
+#include "hal_interface.h"
+#include "hal_mock_storage.h"
+#include "block_image.h"
+#include "fat_volume.h"
+#include "host_storage.h"
+#include "sd_sim.h"
+#include "perf_stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#define LIST_FILES_CHUNK 16   // Entries fetched at a time by hal_storage_list_files
+
+static const StorageBackend *_Atomic backend = NULL;
+
+// With CYBERTYPER_FAT=<image> the card is that FAT32 image instead of the
+// host directory; with CYBERTYPER_SD=<profile> it is put behind the SD emulator.
+static const StorageBackend *card(void) {
+    const StorageBackend *current = atomic_load(&backend);
+    if (current) {
+        return current;
+    }
+    const StorageBackend *chosen = &host_storage_backend;
+    const char *image = getenv("CYBERTYPER_FAT");
+    if (image && block_image_open(image) && fat_volume_mount(&block_image_device, NULL)) {
+        chosen = &fat_volume_backend;
+        fprintf(stderr, "Storage: FAT32 image '%s'\n", image);
+    }
+    const char *profile = getenv("CYBERTYPER_SD");
+    SdSimTiming timing;
+    if (profile && sd_sim_profile(profile, &timing)) {
+        sd_sim_init(chosen, &timing);
+        fprintf(stderr, "Storage: %s card behind the '%s' SD card emulator\n", chosen->name, profile);
+        chosen = &sd_sim_backend;
+    }
+    // Another thread may have chosen the same backend first
+    atomic_compare_exchange_strong(&backend, &current, chosen);
+    return atomic_load(&backend);
+}
+
+void hal_mock_storage_set_backend(const StorageBackend *card_backend) {
+    atomic_store(&backend, card_backend);
+}
+
+// -----------------------------------------------------------------------------
+/* Call Counters */
+// -----------------------------------------------------------------------------
+
+// Updated from the core and the storage worker thread alike
+static atomic_uint_fast32_t storage_calls;
+static atomic_uint_fast64_t storage_bytes_read;
+static atomic_uint_fast64_t storage_bytes_written;
+
+static void count_call(void) {
+    atomic_fetch_add_explicit(&storage_calls, 1, memory_order_relaxed);
+}
+
+static void count_read(int bytes) {
+    if (bytes > 0) {
+        atomic_fetch_add_explicit(&storage_bytes_read, (uint_fast64_t)bytes, memory_order_relaxed);
+    }
+}
+
+static void count_written(size_t bytes) {
+    atomic_fetch_add_explicit(&storage_bytes_written, bytes, memory_order_relaxed);
+}
+
+HalMockStorageStats hal_mock_storage_stats(void) {
+    HalMockStorageStats stats;
+    stats.calls = (uint32_t)atomic_load(&storage_calls);
+    stats.bytes_read = atomic_load(&storage_bytes_read);
+    stats.bytes_written = atomic_load(&storage_bytes_written);
+    return stats;
+}
+
+// -----------------------------------------------------------------------------
+/* Directories */
+// -----------------------------------------------------------------------------
+
+size_t hal_storage_list_entries(const char *directory, size_t start, DirEntry *entries, size_t max_entries) {
+    count_call();
+    PERF_BEGIN(span);
+    size_t count = card()->list(directory, start, entries, max_entries);
+    PERF_END(span, PERF_STORAGE_LIST, count * sizeof(DirEntry));
+    return count;
+}
+
+// Names only, built from listings a chunk at a time.
+size_t hal_storage_list_files(const char *directory, char files[][64], size_t max_files) {
+    count_call();
+    PERF_BEGIN(span);
+    DirEntry chunk[LIST_FILES_CHUNK];
+    size_t count = 0;
+    size_t got;
+    while (count < max_files) {
+        size_t want = max_files - count < LIST_FILES_CHUNK ? max_files - count : LIST_FILES_CHUNK;
+        if ((got = card()->list(directory, count, chunk, want)) == 0) {
+            break;
+        }
+        for (size_t i = 0; i < got; i++) {
+            snprintf(files[count + i], 64, "%.63s", chunk[i].name); // The names are cut at 63 characters
+        }
+        count += got;
+    }
+    PERF_END(span, PERF_STORAGE_LIST, count * sizeof(files[0]));
+    return count;
+}
+
+bool hal_storage_stat(const char *path, DirEntry *entry) {
+    count_call();
+    return card()->stat(path, entry);
+}
+
+bool hal_storage_file_exists(const char *filepath) {
+    count_call();
+    DirEntry entry;
+    return card()->stat(filepath, &entry);
+}
+
+bool hal_storage_is_directory(const char *virtual_path) {
+    count_call();
+    DirEntry entry;
+    return card()->stat(virtual_path, &entry) && entry.type == DIR_ENTRY_DIRECTORY;
+}
+
+bool hal_storage_create_directory(const char *dirpath) {
+    count_call();
+    return card()->create_directory(dirpath);
+}
+
+bool hal_storage_rename_file(const char *oldpath, const char *newpath) {
+    count_call();
+    return card()->rename(oldpath, newpath);
+}
+
+bool hal_storage_delete_file(const char *filepath) {
+    count_call();
+    return card()->remove(filepath);
+}
+
+bool hal_storage_dir_stamp(const char *dirpath, uint64_t *stamp) {
+    count_call();
+    return card()->dir_stamp(dirpath, stamp);
+}
+
+// -----------------------------------------------------------------------------
+/* Files */
+// -----------------------------------------------------------------------------
+
+long hal_storage_file_size(const char *filepath) {
+    count_call();
+    DirEntry entry;
+    if (!card()->stat(filepath, &entry) || entry.type != DIR_ENTRY_FILE) {
+        return -1;
+    }
+    return (long)entry.size;
+}
+
+bool hal_storage_create_file(const char *filepath) {
+    count_call();
+    return card()->create_file(filepath);
+}
+
+// Reads up to buffer_size - 1 bytes and null-terminates them.
+int hal_storage_read_file(const char *filepath, char *buffer, size_t buffer_size) {
+    count_call();
+    PERF_BEGIN(span);
+    int read = card()->read(filepath, 0, buffer, buffer_size - 1);
+    if (read >= 0) {
+        buffer[read] = '\0';
+        count_read(read);
+    }
+    PERF_END(span, PERF_STORAGE_READ, read > 0 ? (size_t)read : 0);
+    return read;
+}
+
+int hal_storage_read_range(const char *filepath, size_t offset, char *buffer, size_t length) {
+    count_call();
+    PERF_BEGIN(span);
+    int read = card()->read(filepath, offset, buffer, length);
+    count_read(read);
+    PERF_END(span, PERF_STORAGE_READ, read > 0 ? (size_t)read : 0);
+    return read;
+}
+
+// Replaces the file: emptied first, then written from the start.
+bool hal_storage_write_file(const char *filepath, const char *buffer, size_t length) {
+    count_call();
+    PERF_BEGIN(span);
+    const StorageBackend *target = card();
+    bool ok = target->create_file(filepath) && target->write(filepath, 0, buffer, length);
+    if (ok) {
+        count_written(length);
+    }
+    PERF_END(span, PERF_STORAGE_WRITE, ok ? length : 0);
+    return ok;
+}
+
+bool hal_storage_write_range(const char *filepath, size_t offset, const char *buffer, size_t length) {
+    count_call();
+    PERF_BEGIN(span);
+    bool ok = card()->write(filepath, offset, buffer, length);
+    if (ok) {
+        count_written(length);
+    }
+    PERF_END(span, PERF_STORAGE_WRITE, ok ? length : 0);
+    return ok;
+}
+
+bool hal_storage_truncate(const char *filepath, size_t length) {
+    count_call();
+    return card()->truncate(filepath, length);
+}
@@ -0,0 +1,32 @@
+#ifndef HAL_MOCK_STORAGE_H
+#define HAL_MOCK_STORAGE_H
+
+#include "storage_backend.h"
+#include <stdint.h>
+
+/**
+ * @struct HalMockStorageStats
+ * @brief Storage HAL traffic of the mock SD card since program start.
+ */
+typedef struct {
+    uint32_t calls;           // hal_storage_* calls, from the core and the storage worker
+    uint64_t bytes_read;      // Bytes returned by the read calls
+    uint64_t bytes_written;   // Bytes passed to the write calls
+} HalMockStorageStats;
+
+/**
+ * @brief Returns the storage counters of the mock HAL.
+ */
+HalMockStorageStats hal_mock_storage_stats(void);
+
+/**
+ * @brief Puts the storage HAL on another card.
+ *
+ * Without a call the card is host_storage_backend, or fat_volume_backend on
+ * the image named by the CYBERTYPER_FAT environment variable. It is put
+ * behind the SD card emulator when CYBERTYPER_SD names a profile (see
+ * sd_sim_profile). Call before the first storage access.
+ */
+void hal_mock_storage_set_backend(const StorageBackend *backend);
+
+#endif // HAL_MOCK_STORAGE_H
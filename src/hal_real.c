@@ -1,10 +1,188 @@
-void lvgl_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) {
-    // Set the display window
-    set_display_window(area->x1, area->y1, area->x2, area->y2);
+// hal_real.c
+//
+// Input and display half of the ESP32-S3 port. A FreeRTOS task scans the key
+// matrix and queues keys for the core, which sleeps on a task notification in
+// hal_event_wait. Text is drawn by the glyph renderer into a framebuffer, and
+// the changed rectangles go to the 960x320 TFT through the double-buffered DMA
+// flush pipeline.
 
-    // Send the pixel data
-    send_pixels_to_display((uint8_t *)color_p, lv_area_get_size(area) * sizeof(lv_color_t));
+#include "hal_interface.h"
+#include "key_queue.h"
+#include "matrix_scan.h"
+#include "text_renderer.h"
+#include "flush_pipeline.h"
+#include "perf_stats.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
-    // Notify LVGL that flushing is done
-    lv_disp_flush_ready(disp_drv);
-}
\ No newline at end of file
+// I2C bus to the two keyboard expanders, set up by the board code
+extern const I2cBus keyboard_i2c_bus;
+
+// Panel driver. set_display_window opens an address window and
+// start_pixel_transfer starts a DMA transfer of pixels into it, returning at
+// once; both are queued behind a transfer still in flight. The transfer-done
+// interrupt calls display_transfer_done with the tag and gives the semaphore
+// that wait_pixel_transfer takes.
+void set_display_window(int x1, int y1, int x2, int y2);
+void start_pixel_transfer(const uint8_t *data, size_t length, int tag);
+void wait_pixel_transfer(void);
+
+static bool renderer_ready = false;
+
+// -----------------------------------------------------------------------------
+/* Keyboard Scanner */
+// -----------------------------------------------------------------------------
+
+// The scanner task runs the matrix scan every SCAN_PERIOD_MS and hands keys to
+// the core through the lock-free key queue. After queueing it notifies the
+// core task, so a slow redraw or file write in the core never delays reading
+// the keyboard and the core never polls.
+#define SCAN_PERIOD_MS 5                          // Debounce takes MATRIX_DEBOUNCE_SCANS periods
+#define SCAN_TASK_STACK 3072
+#define SCAN_TASK_PRIORITY (tskIDLE_PRIORITY + 5) // Above the core and the storage worker
+#define SCAN_EVENTS_MAX 8                         // Events taken from a single scan
+
+static KeyQueue key_queue;
+static MatrixScanner scanner;
+static _Atomic(TaskHandle_t) core_task = NULL;  // Task that called the input functions first
+static atomic_bool early_signal = false;         // hal_event_signal before core_task was known
+
+// Wakes the core task, or remembers the wakeup until it is known.
+static void notify_core(void) {
+    TaskHandle_t task = atomic_load(&core_task);
+    if (task) {
+        xTaskNotify(task, 1, eSetBits);
+    } else {
+        atomic_store(&early_signal, true);
+    }
+}
+
+static void scanner_task(void *arg) {
+    (void)arg;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(SCAN_PERIOD_MS));
+        KeyEvent events[SCAN_EVENTS_MAX];
+        size_t count = matrix_scan_run(&scanner, hal_time_ms(), events, SCAN_EVENTS_MAX);
+        bool queued = false;
+        for (size_t i = 0; i < count; i++) {
+            // A full queue counts the event in key_queue_dropped
+            queued |= key_queue_push(&key_queue, &events[i]);
+        }
+        if (queued) {
+            notify_core();
+        }
+    }
+}
+
+// Starts the scanner on the first input call, which comes from the core task.
+// Without the expanders there is no keyboard, but signals still wake the core.
+static void ensure_input(void) {
+    if (atomic_load(&core_task)) {
+        return;
+    }
+    key_queue_init(&key_queue);
+    atomic_store(&core_task, xTaskGetCurrentTaskHandle());
+    if (matrix_scan_init(&scanner, &keyboard_i2c_bus)) {
+        xTaskCreate(scanner_task, "matrix_scan", SCAN_TASK_STACK, NULL, SCAN_TASK_PRIORITY, NULL);
+    }
+}
+
+size_t hal_input_read_keys(KeyEvent *out, size_t max) {
+    PERF_BEGIN(span);
+    ensure_input();
+    size_t count = key_queue_pop(&key_queue, out, max);
+    PERF_END(span, PERF_INPUT_READ, count * sizeof(KeyEvent));
+    return count;
+}
+
+KeyCode hal_input_get_key(void) {
+    KeyEvent event;
+    if (hal_input_read_keys(&event, 1) == 1) {
+        return event.key;
+    }
+    return KEY_NONE;
+}
+
+// -----------------------------------------------------------------------------
+/* Event Loop */
+// -----------------------------------------------------------------------------
+
+// Blocks the core task on its notification until a key is queued, a signal
+// arrives or the timeout expires; the CPU idles meanwhile.
+bool hal_event_wait(uint32_t timeout_ms) {
+    ensure_input();
+    if (!key_queue_is_empty(&key_queue)) {
+        return true; // Keys left over from an earlier read
+    }
+    if (atomic_exchange(&early_signal, false)) {
+        return false;
+    }
+    TickType_t ticks = timeout_ms == HAL_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    // Clear all bits on exit; the queue itself says what is pending
+    xTaskNotifyWait(0, UINT32_MAX, NULL, ticks);
+    return !key_queue_is_empty(&key_queue);
+}
+
+// Called from other tasks such as the storage worker.
+void hal_event_signal(void) {
+    notify_core();
+}
+
+// Milliseconds from the high-resolution timer, which counts from boot.
+uint32_t hal_time_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// -----------------------------------------------------------------------------
+/* Display Handling */
+// -----------------------------------------------------------------------------
+
+static void panel_start(int strip, const RenderRect *area, const uint8_t *data, size_t length) {
+    set_display_window(area->x, area->y, area->x + area->width - 1, area->y + area->height - 1);
+    start_pixel_transfer(data, length, strip);
+}
+
+static const FlushEngine panel_engine = { panel_start, wait_pixel_transfer };
+
+// Called from the transfer-done interrupt (IRAM_ATTR in the ESP-IDF build).
+void display_transfer_done(int tag) {
+    flush_pipeline_transfer_done(tag);
+}
+
+static void ensure_renderer(void) {
+    if (!renderer_ready) {
+        flush_pipeline_init(&panel_engine, FLUSH_PIPELINE_STRIPS);
+        text_renderer_init(flush_pipeline_send);
+        renderer_ready = true;
+    }
+}
+
+void hal_display_clear(void) {
+    ensure_renderer();
+    text_renderer_clear();
+}
+
+void hal_display_write(const char *text) {
+    PERF_BEGIN(span);
+    ensure_renderer();
+    text_renderer_write(text);
+    PERF_END(span, PERF_DISPLAY_WRITE, strlen(text));
+}
+
+void hal_display_set_cursor(int line, int column) {
+    ensure_renderer();
+    text_renderer_set_cursor(line, column);
+}
+
+void hal_display_flush(void) {
+    PERF_BEGIN(span);
+    ensure_renderer();
+    size_t pixels = text_renderer_flush();
+    PERF_END(span, PERF_DISPLAY_FLUSH, pixels * PANEL_BYTES_PER_PIXEL);
+}
@@ -0,0 +1,296 @@
+// host_storage.c
+//
+// The storage backend of the mock HAL that keeps the card in the ./sdcard
+// directory under the working directory, accessed through stdio and POSIX
+// calls.
+
+#define _DEFAULT_SOURCE // d_type, fstatat, truncate
+
+#include "host_storage.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define SDCARD_DIR "./sdcard" // Root directory for the mock "SD card"
+
+// -----------------------------------------------------------------------------
+/* Helper Functions */
+// -----------------------------------------------------------------------------
+
+// Helper function to build full path
+// Converts a virtual (device-level) path into a host filesystem path for the mock environment.
+
+static void build_full_path(const char *virtual_path, char *full_path, size_t size) {
+    if (strcmp(virtual_path, "/") == 0) {
+        snprintf(full_path, size, "%s", SDCARD_DIR);
+    } else {
+        // Remove leading slash to prevent double slashes
+        if (virtual_path[0] == '/') {
+            snprintf(full_path, size, "%s%s", SDCARD_DIR, virtual_path);
+        } else {
+            snprintf(full_path, size, "%s/%s", SDCARD_DIR, virtual_path);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+/* Directories */
+// -----------------------------------------------------------------------------
+
+// Fills size, mtime and, if still unknown, type from a stat result.
+static void fill_entry_from_stat(DirEntry *entry, const struct stat *st, bool type_known) {
+    if (!type_known) {
+        entry->type = S_ISDIR(st->st_mode) ? DIR_ENTRY_DIRECTORY : DIR_ENTRY_FILE;
+    }
+    entry->size = entry->type == DIR_ENTRY_DIRECTORY ? 0 : (uint32_t)st->st_size;
+    entry->mtime = (uint32_t)st->st_mtime;
+}
+
+// Uses the directory mtime, which changes on every create, rename and delete inside it.
+static bool host_dir_stamp(const char *dirpath, uint64_t *stamp) {
+    char fullpath[512];
+    build_full_path(dirpath, fullpath, sizeof(fullpath));
+
+    struct stat st;
+    if (stat(fullpath, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return false;
+    }
+    *stamp = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+    return true;
+}
+
+// The directory stream kept open between listings
+static DIR *list_dir = NULL;
+static char list_path[512];
+static uint64_t list_stamp;   // Directory stamp when list_dir was opened
+static size_t list_index;     // Index of the entry readdir returns next
+
+// Returns the next entry other than '.' and '..', or NULL at the end.
+static struct dirent *next_listing_entry(void) {
+    struct dirent *ent;
+    while ((ent = readdir(list_dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0) {
+            list_index++;
+            return ent;
+        }
+    }
+    return NULL;
+}
+
+// Positions list_dir so the next entry read has index start. Reuses the open
+// stream when moving forward in an unchanged directory.
+static bool seek_listing(const char *directory, size_t start) {
+    uint64_t stamp = 0;
+    host_dir_stamp(directory, &stamp);
+
+    if (!list_dir || strcmp(list_path, directory) != 0 || list_stamp != stamp) {
+        if (list_dir) {
+            closedir(list_dir);
+        }
+        char full_path[512];
+        build_full_path(directory, full_path, sizeof(full_path));
+        list_dir = opendir(full_path);
+        if (!list_dir) {
+            perror("opendir");
+            return false;
+        }
+        strncpy(list_path, directory, sizeof(list_path) - 1);
+        list_path[sizeof(list_path) - 1] = '\0';
+        list_stamp = stamp;
+        list_index = 0;
+    } else if (start < list_index) {
+        rewinddir(list_dir);
+        list_index = 0;
+    }
+
+    // Skipping only needs the names, no stat
+    while (list_index < start) {
+        if (!next_listing_entry()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Lists typed entries in one pass over the directory. The type comes from d_type
+// when the filesystem reports it; size and mtime come from fstatat relative to the
+// open directory, so no path is built or resolved per entry.
+static size_t host_list(const char *directory, size_t start, DirEntry *entries, size_t max_entries) {
+    if (!seek_listing(directory, start)) {
+        return 0;
+    }
+
+    int fd = dirfd(list_dir);
+    size_t count = 0;
+    struct dirent *ent;
+    while (count < max_entries && (ent = next_listing_entry()) != NULL) {
+        DirEntry *entry = &entries[count];
+        snprintf(entry->name, HAL_NAME_LEN, "%s", ent->d_name);
+
+        bool type_known = ent->d_type == DT_DIR || ent->d_type == DT_REG;
+        entry->type = ent->d_type == DT_DIR ? DIR_ENTRY_DIRECTORY : DIR_ENTRY_FILE;
+
+        struct stat st;
+        if (fstatat(fd, ent->d_name, &st, 0) == 0) {
+            fill_entry_from_stat(entry, &st, type_known);
+        } else {
+            entry->size = 0;
+            entry->mtime = 0;
+        }
+        count++;
+    }
+    return count;
+}
+
+static bool host_stat(const char *path, DirEntry *entry) {
+    char full_path[512];
+    build_full_path(path, full_path, sizeof(full_path));
+
+    struct stat st;
+    if (stat(full_path, &st) != 0) {
+        return false;
+    }
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    strncpy(entry->name, name, HAL_NAME_LEN - 1);
+    entry->name[HAL_NAME_LEN - 1] = '\0';
+    fill_entry_from_stat(entry, &st, false);
+    return true;
+}
+
+// Creates a directory at 'dirpath'. Returns true on success.
+static bool host_create_directory(const char *dirpath) {
+    char fullpath[512];
+    build_full_path(dirpath, fullpath, sizeof(fullpath));
+
+    int result = mkdir(fullpath, 0777);
+    if (result != 0) {
+        perror("hal_storage_create_directory mkdir");
+        return false;
+    }
+    fprintf(stderr, "Directory created successfully at '%s'\n", dirpath); // Debug statement
+    return true;
+}
+
+// Renames a file or directory from oldpath to newpath. Returns true on success.
+static bool host_rename(const char *oldpath, const char *newpath) {
+    char old_fullpath[512];
+    char new_fullpath[512];
+    build_full_path(oldpath, old_fullpath, sizeof(old_fullpath));
+    build_full_path(newpath, new_fullpath, sizeof(new_fullpath));
+
+    int result = rename(old_fullpath, new_fullpath);
+    if (result != 0) {
+        perror("hal_storage_rename_file rename");
+        return false;
+    }
+    fprintf(stderr, "Renamed '%s' to '%s' successfully\n", oldpath, newpath); // Debug statement
+    return true;
+}
+
+// Deletes the file at 'filepath'. Returns true on success.
+static bool host_remove(const char *filepath) {
+    char fullpath[512];
+    build_full_path(filepath, fullpath, sizeof(fullpath));
+
+    if (remove(fullpath) != 0) {
+        perror("hal_storage_delete_file remove");
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Files */
+// -----------------------------------------------------------------------------
+
+// Creates a new empty file, or empties an existing one. Returns true on success, false on failure.
+static bool host_create_file(const char *filepath) {
+    char fullpath[512];
+    build_full_path(filepath, fullpath, sizeof(fullpath));
+
+    FILE *file = fopen(fullpath, "w");
+    if (file == NULL) {
+        perror("hal_storage_create_file fopen");
+        return false;
+    }
+    fclose(file);
+    fprintf(stderr, "File created successfully at '%s'\n", filepath); // Debug statement
+    return true;
+}
+
+// Reads 'length' bytes starting at 'offset' into 'buffer'. Returns bytes read or -1 on error.
+static int host_read(const char *filepath, size_t offset, char *buffer, size_t length) {
+    char fullpath[512];
+    build_full_path(filepath, fullpath, sizeof(fullpath));
+
+    FILE *f = fopen(fullpath, "rb");
+    if (!f) {
+        return -1;
+    }
+    if (fseek(f, (long)offset, SEEK_SET) != 0) {
+        fclose(f);
+        return -1;
+    }
+
+    size_t bytesRead = fread(buffer, 1, length, f);
+    fclose(f);
+    return (int)bytesRead;
+}
+
+// Writes 'length' bytes at 'offset' without truncating the file. Creates the file if needed.
+static bool host_write(const char *filepath, size_t offset, const char *buffer, size_t length) {
+    char fullpath[512];
+    build_full_path(filepath, fullpath, sizeof(fullpath));
+
+    FILE *f = fopen(fullpath, "r+b");
+    if (!f) {
+        f = fopen(fullpath, "w+b");
+    }
+    if (!f) {
+        perror("hal_storage_write_range fopen");
+        return false;
+    }
+    if (fseek(f, (long)offset, SEEK_SET) != 0) {
+        fclose(f);
+        return false;
+    }
+
+    size_t written = fwrite(buffer, 1, length, f);
+    fclose(f);
+    if (written != length) {
+        fprintf(stderr, "Warning: Only wrote %zu of %zu bytes to '%s'\n", written, length, fullpath);
+        return false;
+    }
+    return true;
+}
+
+// Resizes the file with truncate(2), which also extends it with zeros.
+static bool host_truncate(const char *filepath, size_t length) {
+    char fullpath[512];
+    build_full_path(filepath, fullpath, sizeof(fullpath));
+
+    if (truncate(fullpath, (off_t)length) != 0) {
+        perror("hal_storage_truncate");
+        return false;
+    }
+    return true;
+}
+
+const StorageBackend host_storage_backend = {
+    "host", host_list, host_stat, host_read, host_write, host_truncate,
+    host_create_file, host_create_directory, host_rename, host_remove, host_dir_stamp,
+};
+
+// Closes the directory stream kept open for listings.
+__attribute__((destructor))
+static void cleanup_host_storage(void) {
+    if (list_dir) {
+        closedir(list_dir);
+    }
+}
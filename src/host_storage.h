@@ -0,0 +1,14 @@
+#ifndef HOST_STORAGE_H
+#define HOST_STORAGE_H
+
+#include "storage_backend.h"
+
+/**
+ * @brief The ./sdcard directory of the host as the card.
+ *
+ * The default backend of the mock HAL. Listings keep the directory stream
+ * open between calls, so reading a large directory chunk by chunk is one pass.
+ */
+extern const StorageBackend host_storage_backend;
+
+#endif // HOST_STORAGE_H
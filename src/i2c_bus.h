@@ -0,0 +1,42 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct I2cBus
+ * @brief Minimal I2C master interface used by the keyboard scanner.
+ *
+ * The device port wraps the ESP32 I2C driver; on Linux a simulated bus stands
+ * in for the MCP23017 expanders. Addresses are 7-bit. Both calls return false
+ * if the device did not acknowledge.
+ */
+typedef struct {
+    void *context;  // Passed to every call
+
+    // One transaction: START, address+W, data, STOP
+    bool (*write)(void *context, uint8_t address, const uint8_t *data, size_t length);
+
+    // Write then read with a repeated START, e.g. a register pointer then a burst read
+    bool (*write_read)(void *context, uint8_t address, const uint8_t *tx, size_t tx_length,
+                       uint8_t *rx, size_t rx_length);
+} I2cBus;
+
+/**
+ * @brief Writes length bytes to the device at address.
+ */
+static inline bool i2c_write(const I2cBus *bus, uint8_t address, const uint8_t *data, size_t length) {
+    return bus->write(bus->context, address, data, length);
+}
+
+/**
+ * @brief Writes tx, then reads rx_length bytes in the same transaction.
+ */
+static inline bool i2c_write_read(const I2cBus *bus, uint8_t address, const uint8_t *tx, size_t tx_length,
+                                  uint8_t *rx, size_t rx_length) {
+    return bus->write_read(bus->context, address, tx, tx_length, rx, rx_length);
+}
+
+#endif // I2C_BUS_H
@@ -0,0 +1,49 @@
+// key_queue.c
+
+#include "key_queue.h"
+
+#define KEY_QUEUE_MASK (KEY_QUEUE_CAPACITY - 1)
+
+void key_queue_init(KeyQueue *queue) {
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->dropped, 0);
+}
+
+bool key_queue_push(KeyQueue *queue, const KeyEvent *event) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == KEY_QUEUE_CAPACITY) {
+        atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    queue->events[head & KEY_QUEUE_MASK] = *event;
+    // Publish the slot: the consumer sees the event before the new head
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+size_t key_queue_pop(KeyQueue *queue, KeyEvent *out, size_t max) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    size_t count = 0;
+    while (count < max && tail != head) {
+        out[count++] = queue->events[tail & KEY_QUEUE_MASK];
+        tail++;
+    }
+
+    // Hand the slots back to the producer only after they were copied out
+    atomic_store_explicit(&queue->tail, tail, memory_order_release);
+    return count;
+}
+
+bool key_queue_is_empty(KeyQueue *queue) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    return atomic_load_explicit(&queue->head, memory_order_acquire) == tail;
+}
+
+uint32_t key_queue_dropped(KeyQueue *queue) {
+    return (uint32_t)atomic_load_explicit(&queue->dropped, memory_order_relaxed);
+}
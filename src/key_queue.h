@@ -0,0 +1,59 @@
+#ifndef KEY_QUEUE_H
+#define KEY_QUEUE_H
+
+#include "hal_interface.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define KEY_QUEUE_CAPACITY 256  // Must be a power of two
+#define KEY_QUEUE_ALIGN 64      // Keeps head and tail on separate cache lines
+
+/**
+ * @struct KeyQueue
+ * @brief Lock-free single-producer/single-consumer ring of key events.
+ *
+ * The keyboard scanner task is the only producer and the core loop the only
+ * consumer. Each side owns one index and only reads the other, so no locks are
+ * needed and a consumer busy with a redraw or a slow SD write never blocks the
+ * scanner. head and tail count up freely and are masked on access.
+ */
+typedef struct {
+    KeyEvent events[KEY_QUEUE_CAPACITY];
+    alignas(KEY_QUEUE_ALIGN) atomic_size_t head;  // Next slot to write, owned by the producer
+    alignas(KEY_QUEUE_ALIGN) atomic_size_t tail;  // Next slot to read, owned by the consumer
+    atomic_uint_least32_t dropped;                // Events lost because the ring was full
+} KeyQueue;
+
+/**
+ * @brief Empties the queue. Must not race with push or pop.
+ */
+void key_queue_init(KeyQueue *queue);
+
+/**
+ * @brief Appends an event. Producer side only.
+ *
+ * @return true on success, false if the queue is full (the event is counted as dropped).
+ */
+bool key_queue_push(KeyQueue *queue, const KeyEvent *event);
+
+/**
+ * @brief Removes up to max events, oldest first. Consumer side only.
+ *
+ * @return Number of events written to out.
+ */
+size_t key_queue_pop(KeyQueue *queue, KeyEvent *out, size_t max);
+
+/**
+ * @brief Returns true if no event is waiting. Consumer side only.
+ */
+bool key_queue_is_empty(KeyQueue *queue);
+
+/**
+ * @brief Returns the number of events dropped because the queue was full.
+ */
+uint32_t key_queue_dropped(KeyQueue *queue);
+
+#endif // KEY_QUEUE_H
@@ -0,0 +1,139 @@
+// line_index.c
+
+#include "line_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+/* Internal Helpers */
+// -----------------------------------------------------------------------------
+
+// Index of the first entry >= pos (binary search).
+static size_t lower_bound(const LineIndex *li, size_t pos) {
+    size_t lo = 0;
+    size_t hi = li->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (li->offsets[mid] < pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool reserve(LineIndex *li, size_t needed) {
+    if (li->count + needed <= li->capacity) {
+        return true;
+    }
+    size_t new_capacity = li->capacity ? li->capacity : 16;
+    while (new_capacity < li->count + needed) {
+        new_capacity *= 2;
+    }
+    uint32_t *grown = realloc(li->offsets, new_capacity * sizeof(uint32_t));
+    if (!grown) {
+        return false;
+    }
+    li->offsets = grown;
+    li->capacity = new_capacity;
+    return true;
+}
+
+static size_t count_newlines(const char *text, size_t length) {
+    size_t count = 0;
+    const char *end = text + length;
+    while ((text = memchr(text, '\n', (size_t)(end - text))) != NULL) {
+        count++;
+        text++;
+    }
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void line_index_free(LineIndex *li) {
+    free(li->offsets);
+    li->offsets = NULL;
+    li->count = 0;
+    li->capacity = 0;
+}
+
+void line_index_clear(LineIndex *li) {
+    li->count = 0;
+}
+
+bool line_index_scan(LineIndex *li, const char *text, size_t length, size_t base) {
+    if (!reserve(li, count_newlines(text, length))) {
+        return false;
+    }
+    const char *p = text;
+    const char *end = text + length;
+    while ((p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        li->offsets[li->count++] = (uint32_t)(base + (size_t)(p - text));
+        p++;
+    }
+    return true;
+}
+
+bool line_index_insert(LineIndex *li, size_t pos, const char *text, size_t length) {
+    size_t added = count_newlines(text, length);
+    if (!reserve(li, added)) {
+        return false;
+    }
+
+    // Entries behind the insertion point move right by length
+    size_t first = lower_bound(li, pos);
+    for (size_t i = first; i < li->count; i++) {
+        li->offsets[i] += (uint32_t)length;
+    }
+
+    if (added > 0) {
+        memmove(&li->offsets[first + added], &li->offsets[first],
+                (li->count - first) * sizeof(uint32_t));
+        size_t slot = first;
+        for (size_t i = 0; i < length; i++) {
+            if (text[i] == '\n') {
+                li->offsets[slot++] = (uint32_t)(pos + i);
+            }
+        }
+        li->count += added;
+    }
+    return true;
+}
+
+void line_index_delete(LineIndex *li, size_t pos, size_t length) {
+    size_t first = lower_bound(li, pos);
+    size_t last = lower_bound(li, pos + length);
+
+    // Drop the newlines inside the deleted range, shift the rest left
+    memmove(&li->offsets[first], &li->offsets[last], (li->count - last) * sizeof(uint32_t));
+    li->count -= last - first;
+    for (size_t i = first; i < li->count; i++) {
+        li->offsets[i] -= (uint32_t)length;
+    }
+}
+
+size_t line_index_count(const LineIndex *li) {
+    return li->count;
+}
+
+bool line_index_find_before(const LineIndex *li, size_t pos, size_t *found) {
+    size_t i = lower_bound(li, pos + 1);
+    if (i == 0) {
+        return false;
+    }
+    *found = li->offsets[i - 1];
+    return true;
+}
+
+bool line_index_find_after(const LineIndex *li, size_t pos, size_t *found) {
+    size_t i = lower_bound(li, pos);
+    if (i == li->count) {
+        return false;
+    }
+    *found = li->offsets[i];
+    return true;
+}
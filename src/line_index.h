@@ -0,0 +1,75 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct LineIndex
+ * @brief Sorted offsets of every '\n' inside one document page.
+ *
+ * The index is kept up to date on each insert and delete, so finding the line
+ * around a position is a binary search instead of a scan over the text. An
+ * edit only shifts the entries behind it within the same page.
+ */
+typedef struct {
+    uint32_t *offsets;  // Offsets of the newlines, ascending
+    size_t count;       // Number of newlines
+    size_t capacity;    // Allocated entries
+} LineIndex;
+
+/**
+ * @brief Releases the index storage and leaves an empty index.
+ */
+void line_index_free(LineIndex *li);
+
+/**
+ * @brief Removes all entries. Keeps the allocation.
+ */
+void line_index_clear(LineIndex *li);
+
+/**
+ * @brief Appends the newlines of text, which starts at page offset base.
+ *
+ * Used to build the index when a page is loaded; text must lie behind every
+ * offset already in the index.
+ *
+ * @return true on success, false if the index could not grow.
+ */
+bool line_index_scan(LineIndex *li, const char *text, size_t length, size_t base);
+
+/**
+ * @brief Updates the index for length bytes of text inserted at pos.
+ *
+ * @return true on success, false if the index could not grow.
+ */
+bool line_index_insert(LineIndex *li, size_t pos, const char *text, size_t length);
+
+/**
+ * @brief Updates the index for length bytes deleted at pos.
+ */
+void line_index_delete(LineIndex *li, size_t pos, size_t length);
+
+/**
+ * @brief Returns the number of newlines in the page.
+ */
+size_t line_index_count(const LineIndex *li);
+
+/**
+ * @brief Finds the last newline at or before pos.
+ *
+ * @param found Receives the newline offset.
+ * @return true if there is such a newline.
+ */
+bool line_index_find_before(const LineIndex *li, size_t pos, size_t *found);
+
+/**
+ * @brief Finds the first newline at or after pos.
+ *
+ * @param found Receives the newline offset.
+ * @return true if there is such a newline.
+ */
+bool line_index_find_after(const LineIndex *li, size_t pos, size_t *found);
+
+#endif // LINE_INDEX_H
@@ -1,6 +1,5 @@
 #include "cybertyper_core.h"
 #include <stdio.h>
-#include <unistd.h>
 
 int main(void) {
     cybertyper_init();
@@ -8,10 +7,9 @@ int main(void) {
     // Run the core logic in a loop.
     // Press arrow keys and type characters to interact.
     // Press Ctrl+C to exit the program.
+    // Each cycle blocks until the next key or timer, so no sleep is needed here.
     while (1) {
         cybertyper_run_cycle();
-        // Add a small sleep to avoid busy-waiting; adjust as needed.
-        usleep(50000); // 50ms
     }
 
     return 0;
@@ -0,0 +1,288 @@
+// matrix_scan.c
+
+#include "matrix_scan.h"
+#include "mcp23017.h"
+#include <string.h>
+
+#define ALL_ROWS_RELEASED 0xFF  // IODIRA with every row pin as a high-impedance input
+#define CH(c) ((KeyCode)(KEY_CHAR_BASE + (c)))
+
+// Logical layout of the G80-3000 on the matrix. Rows and columns follow the
+// key rows of the case; adjust when the PCB traces are mapped pin by pin.
+static const KeyCode keymap[MATRIX_ROWS][MATRIX_COLS] = {
+    { KEY_ESCAPE, KEY_F1, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F7, KEY_F8, KEY_F9, KEY_F10,
+      KEY_F11, KEY_F12, KEY_PRINT_SCREEN, KEY_SCROLL_LOCK, KEY_PAUSE },
+    { CH('`'), CH('1'), CH('2'), CH('3'), CH('4'), CH('5'), CH('6'), CH('7'), CH('8'), CH('9'), CH('0'),
+      CH('-'), CH('='), KEY_BACKSPACE, KEY_INSERT, KEY_HOME, KEY_PAGE_UP,
+      KEY_NUM_LOCK, KEY_KP_DIVIDE, KEY_KP_MULTIPLY, KEY_KP_MINUS },
+    { KEY_TAB, CH('q'), CH('w'), CH('e'), CH('r'), CH('t'), CH('y'), CH('u'), CH('i'), CH('o'), CH('p'),
+      CH('['), CH(']'), CH('\\'), KEY_DELETE, KEY_END, KEY_PAGE_DOWN,
+      KEY_KP_7, KEY_KP_8, KEY_KP_9, KEY_KP_PLUS },
+    { KEY_CAPS_LOCK, CH('a'), CH('s'), CH('d'), CH('f'), CH('g'), CH('h'), CH('j'), CH('k'), CH('l'),
+      CH(';'), CH('\''), KEY_ENTER, KEY_KP_4, KEY_KP_5, KEY_KP_6 },
+    { KEY_SHIFT_LEFT, CH('z'), CH('x'), CH('c'), CH('v'), CH('b'), CH('n'), CH('m'), CH(','), CH('.'),
+      CH('/'), KEY_SHIFT_RIGHT, KEY_ARROW_UP, KEY_KP_1, KEY_KP_2, KEY_KP_3, KEY_KP_ENTER },
+    { KEY_CTRL_LEFT, KEY_GUI_LEFT, KEY_ALT_LEFT, CH(' '), KEY_ALT_RIGHT, KEY_GUI_RIGHT, KEY_CTRL_RIGHT,
+      KEY_ARROW_LEFT, KEY_ARROW_DOWN, KEY_ARROW_RIGHT, KEY_KP_0, KEY_KP_DECIMAL },
+};
+
+// US shifted symbols, indexed by position in unshifted_symbols
+static const char unshifted_symbols[] = "`1234567890-=[]\\;',./";
+static const char shifted_symbols[]   = "~!@#$%^&*()_+{}|:\"<>?";
+
+// -----------------------------------------------------------------------------
+/* Expander Access */
+// -----------------------------------------------------------------------------
+
+static bool write_registers(MatrixScanner *scanner, uint8_t address, uint8_t reg, uint8_t value_a, uint8_t value_b) {
+    uint8_t data[3] = { reg, value_a, value_b };
+    if (!i2c_write(scanner->bus, address, data, 3)) {
+        scanner->stats.bus_errors++;
+        return false;
+    }
+    return true;
+}
+
+// Drives the rows whose bit is 0 in direction low; the others float.
+// Only rows being scanned are outputs, so two pressed keys in one column can
+// never short a driven row against another.
+static bool set_row_direction(MatrixScanner *scanner, uint8_t direction) {
+    if (scanner->row_direction == direction) {
+        return true;
+    }
+    uint8_t data[2] = { MCP23017_IODIRA, direction };
+    if (!i2c_write(scanner->bus, MATRIX_ROW_EXPANDER, data, 2)) {
+        scanner->stats.bus_errors++;
+        return false;
+    }
+    scanner->row_direction = direction;
+    return true;
+}
+
+// Reads all 24 columns: U1 port B alone, then U2 ports A and B in one burst.
+// Inputs are inverted by IPOL, so a set bit is a closed switch.
+static bool read_columns(MatrixScanner *scanner, uint32_t *columns) {
+    uint8_t reg_b = MCP23017_GPIOB;
+    uint8_t reg_a = MCP23017_GPIOA;
+    uint8_t low;
+    uint8_t high[2];
+    if (!i2c_write_read(scanner->bus, MATRIX_ROW_EXPANDER, &reg_b, 1, &low, 1) ||
+        !i2c_write_read(scanner->bus, MATRIX_COL_EXPANDER, &reg_a, 1, high, 2)) {
+        scanner->stats.bus_errors++;
+        return false;
+    }
+    *columns = (uint32_t)low | ((uint32_t)high[0] << 8) | ((uint32_t)high[1] << 16);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Key Translation */
+// -----------------------------------------------------------------------------
+
+static bool is_modifier(KeyCode key) {
+    return key >= KEY_SHIFT_LEFT && key <= KEY_GUI_RIGHT;
+}
+
+static KeyCode translate_keypad(KeyCode key) {
+    switch (key) {
+        case KEY_KP_DIVIDE:   return CH('/');
+        case KEY_KP_MULTIPLY: return CH('*');
+        case KEY_KP_MINUS:    return CH('-');
+        case KEY_KP_PLUS:     return CH('+');
+        case KEY_KP_DECIMAL:  return CH('.');
+        case KEY_KP_ENTER:    return KEY_ENTER;
+        case KEY_KP_0:        return CH('0');
+        default:
+            if (key >= KEY_KP_1 && key <= KEY_KP_9) {
+                return CH('1' + (key - KEY_KP_1));
+            }
+            return key;
+    }
+}
+
+// Applies the held modifiers to a pressed key. Returns KEY_NONE for
+// combinations the core has no KeyCode for.
+static KeyCode translate_key(const MatrixScanner *scanner, KeyCode key) {
+    key = translate_keypad(key);
+    if (key < KEY_CHAR_BASE) {
+        return key;
+    }
+
+    char c = (char)(key - KEY_CHAR_BASE);
+    bool shift = (scanner->modifiers & MATRIX_MOD_SHIFT) != 0;
+
+    if (scanner->modifiers & MATRIX_MOD_CTRL) {
+        if (c == 'n') {
+            return (scanner->modifiers & MATRIX_MOD_ALT) ? KEY_CTRL_ALT_N : KEY_CTRL_N;
+        }
+        if (c == 'r') return KEY_CTRL_R;
+        if (c == 's') return KEY_CTRL_S;
+        if (c == 'f') return KEY_CTRL_F;
+        if (c == 'z') return KEY_CTRL_Z;
+        if (c == 'y') return KEY_CTRL_Y;
+        return KEY_NONE;
+    }
+
+    if (c >= 'a' && c <= 'z') {
+        return (shift != scanner->caps_lock) ? CH(c - 'a' + 'A') : key;
+    }
+    if (shift) {
+        const char *symbol = strchr(unshifted_symbols, c);
+        if (symbol && *symbol) {
+            return CH(shifted_symbols[symbol - unshifted_symbols]);
+        }
+    }
+    return key;
+}
+
+// Updates the modifier state for a debounced transition and returns the
+// KeyCode to report, or KEY_NONE.
+static KeyCode key_transition(MatrixScanner *scanner, int row, int col, bool pressed) {
+    KeyCode key = keymap[row][col];
+    if (key == KEY_NONE) {
+        return KEY_NONE;
+    }
+
+    if (is_modifier(key)) {
+        uint8_t bit = (uint8_t)(1u << (key - KEY_SHIFT_LEFT));
+        if (pressed) {
+            scanner->modifiers |= bit;
+        } else {
+            scanner->modifiers &= (uint8_t)~bit;
+        }
+        return pressed ? key : KEY_NONE;
+    }
+    if (!pressed) {
+        return KEY_NONE;
+    }
+    if (key == KEY_CAPS_LOCK) {
+        scanner->caps_lock = !scanner->caps_lock;
+        return key;
+    }
+    return translate_key(scanner, key);
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+bool matrix_scan_init(MatrixScanner *scanner, const I2cBus *bus) {
+    memset(scanner, 0, sizeof(*scanner));
+    scanner->bus = bus;
+
+    // U1: rows on port A start released with their latches low, columns 0-7 on port B
+    // U2: columns 8-23 on both ports
+    // Column inputs are pulled up and inverted, so a pressed key reads as 1
+    uint8_t iocon[2] = { MCP23017_IOCON, 0x00 };  // BANK = 0, sequential addressing
+    if (!i2c_write(bus, MATRIX_ROW_EXPANDER, iocon, 2) ||
+        !i2c_write(bus, MATRIX_COL_EXPANDER, iocon, 2)) {
+        scanner->stats.bus_errors++;
+        return false;
+    }
+    if (!write_registers(scanner, MATRIX_ROW_EXPANDER, MCP23017_IPOLA, 0x00, 0xFF) ||
+        !write_registers(scanner, MATRIX_ROW_EXPANDER, MCP23017_GPPUA, 0x00, 0xFF) ||
+        !write_registers(scanner, MATRIX_ROW_EXPANDER, MCP23017_OLATA, 0x00, 0x00) ||
+        !write_registers(scanner, MATRIX_ROW_EXPANDER, MCP23017_IODIRA, ALL_ROWS_RELEASED, 0xFF) ||
+        !write_registers(scanner, MATRIX_COL_EXPANDER, MCP23017_IODIRA, 0xFF, 0xFF) ||
+        !write_registers(scanner, MATRIX_COL_EXPANDER, MCP23017_IPOLA, 0xFF, 0xFF) ||
+        !write_registers(scanner, MATRIX_COL_EXPANDER, MCP23017_GPPUA, 0xFF, 0xFF)) {
+        return false;
+    }
+    scanner->row_direction = ALL_ROWS_RELEASED;
+    return true;
+}
+
+size_t matrix_scan_run(MatrixScanner *scanner, uint32_t now_ms, KeyEvent *out, size_t max) {
+    scanner->stats.scans++;
+
+    // Idle fast path: with every row driven at once, one read shows whether any key is down
+    if (scanner->pressed_count == 0 && scanner->unsettled == 0) {
+        uint32_t any;
+        if (!set_row_direction(scanner, 0x00) || !read_columns(scanner, &any)) {
+            return 0;
+        }
+        if (any == 0) {
+            scanner->stats.idle_scans++;
+            return 0;
+        }
+    }
+
+    // Full scan, one row at a time
+    uint32_t raw[MATRIX_ROWS];
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        if (!set_row_direction(scanner, (uint8_t)~(1u << row)) || !read_columns(scanner, &raw[row])) {
+            return 0;
+        }
+    }
+    memcpy(scanner->raw, raw, sizeof(raw));
+
+    // Two rows sharing two or more columns form a rectangle: without diodes
+    // one of its corners may be a phantom, so those rows take no new presses
+    uint32_t ghost_rows = 0;
+    for (int a = 0; a < MATRIX_ROWS; a++) {
+        for (int b = a + 1; b < MATRIX_ROWS; b++) {
+            uint32_t shared = raw[a] & raw[b];
+            if (shared & (shared - 1)) {
+                ghost_rows |= (1u << a) | (1u << b);
+            }
+        }
+    }
+    if (ghost_rows) {
+        scanner->stats.ghost_scans++;
+    }
+
+    size_t count = 0;
+    size_t unsettled = 0;
+    bool refused = false;
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        bool ghosted = (ghost_rows >> row) & 1u;
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            uint32_t bit = 1u << col;
+            bool down = (raw[row] & bit) != 0;
+            bool stable = (scanner->stable[row] & bit) != 0;
+            uint8_t *level = &scanner->integrator[row][col];
+
+            if (down && *level < MATRIX_DEBOUNCE_SCANS && !(ghosted && !stable)) {
+                (*level)++;
+            } else if (!down && *level > 0) {
+                (*level)--;
+            }
+
+            if (!stable && *level == MATRIX_DEBOUNCE_SCANS) {
+                if (scanner->pressed_count >= MATRIX_MAX_ROLLOVER) {
+                    *level = MATRIX_DEBOUNCE_SCANS - 1;  // Retry once a key is released
+                    refused = true;
+                } else {
+                    scanner->stable[row] |= bit;
+                    scanner->pressed_count++;
+                    KeyCode key = key_transition(scanner, row, col, true);
+                    if (key != KEY_NONE && count < max) {
+                        out[count].key = key;
+                        out[count].timestamp_ms = now_ms;
+                        count++;
+                    }
+                }
+            } else if (stable && *level == 0) {
+                scanner->stable[row] &= ~bit;
+                scanner->pressed_count--;
+                key_transition(scanner, row, col, false);
+            }
+
+            if (*level != 0 && *level != MATRIX_DEBOUNCE_SCANS) {
+                unsettled++;
+            }
+        }
+    }
+    scanner->unsettled = unsettled;
+    if (refused) {
+        scanner->stats.rollover_refused++;
+    }
+    return count;
+}
+
+KeyCode matrix_scan_keymap(int row, int col) {
+    if (row < 0 || row >= MATRIX_ROWS || col < 0 || col >= MATRIX_COLS) {
+        return KEY_NONE;
+    }
+    return keymap[row][col];
+}
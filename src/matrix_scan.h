@@ -0,0 +1,92 @@
+#ifndef MATRIX_SCAN_H
+#define MATRIX_SCAN_H
+
+#include "hal_interface.h"
+#include "i2c_bus.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Wiring of the Cherry G80-3000 matrix to the two MCP23017 expanders:
+// rows are driven from U1 port A, columns 0-7 are read from U1 port B and
+// columns 8-23 from U2 ports A and B.
+#define MATRIX_ROWS 8
+#define MATRIX_COLS 24
+#define MATRIX_ROW_EXPANDER 0x20   // U1: rows on GPA, columns 0-7 on GPB
+#define MATRIX_COL_EXPANDER 0x21   // U2: columns 8-23 on GPA/GPB
+
+#define MATRIX_DEBOUNCE_SCANS 4    // Consecutive agreeing scans before a key changes state
+#define MATRIX_MAX_ROLLOVER 10     // Keys held at once before new presses are refused
+
+// Bits of MatrixScanner.modifiers: bit n is the modifier KEY_SHIFT_LEFT + n,
+// so each pair covers the left and right key
+#define MATRIX_MOD_SHIFT 0x03
+#define MATRIX_MOD_CTRL  0x0C
+#define MATRIX_MOD_ALT   0x30
+#define MATRIX_MOD_GUI   0xC0
+
+/**
+ * @struct MatrixScanStats
+ * @brief Counters kept by the scanner for tuning and benchmarks.
+ */
+typedef struct {
+    uint32_t scans;             // Calls to matrix_scan_run
+    uint32_t idle_scans;        // Scans finished by the all-rows probe
+    uint32_t ghost_scans;       // Scans in which a ghosting pattern was seen
+    uint32_t rollover_refused;  // Scans that refused a press because MATRIX_MAX_ROLLOVER keys were held
+    uint32_t bus_errors;        // Failed I2C transactions
+} MatrixScanStats;
+
+/**
+ * @struct MatrixScanner
+ * @brief State of the keyboard matrix scanner.
+ *
+ * Each scan drives one row low at a time and reads all 24 columns with two
+ * burst reads (one per expander). Every key has an integrating debounce
+ * counter that moves one step per scan towards the raw reading, and the key
+ * only changes state when the counter hits either end. The matrix has no
+ * diodes, so three keys on the corners of a rectangle make the fourth appear
+ * pressed; rows involved in such a pattern do not accept new presses until
+ * it clears.
+ */
+typedef struct {
+    const I2cBus *bus;
+    uint8_t row_direction;                              // Last value written to U1 IODIRA
+    uint32_t raw[MATRIX_ROWS];                          // Column bits read in the last scan
+    uint32_t stable[MATRIX_ROWS];                       // Debounced key state
+    uint8_t integrator[MATRIX_ROWS][MATRIX_COLS];       // 0 = released ... MATRIX_DEBOUNCE_SCANS = pressed
+    size_t unsettled;                                   // Keys whose integrator is between the ends
+    size_t pressed_count;                               // Keys in stable
+    uint8_t modifiers;                                  // MATRIX_MOD_* bits of held modifiers
+    bool caps_lock;
+    MatrixScanStats stats;
+} MatrixScanner;
+
+/**
+ * @brief Configures both expanders and resets the scanner state.
+ *
+ * @return true on success, false if an expander did not respond.
+ */
+bool matrix_scan_init(MatrixScanner *scanner, const I2cBus *bus);
+
+/**
+ * @brief Scans the matrix once and translates debounced presses into key events.
+ *
+ * Call at a steady rate from the scanner task. While no key is pressed or
+ * settling, a scan is a single probe with all rows driven at once.
+ * Modifier presses are reported with their own KeyCode and also change how
+ * later keys are translated (Shift, Caps Lock, Ctrl and Ctrl+Alt shortcuts).
+ *
+ * @param now_ms    Timestamp stored in the generated events.
+ * @param out       Receives the events.
+ * @param max       Capacity of out; further events of this scan are dropped.
+ * @return Number of events written to out.
+ */
+size_t matrix_scan_run(MatrixScanner *scanner, uint32_t now_ms, KeyEvent *out, size_t max);
+
+/**
+ * @brief Returns the base KeyCode wired to a matrix position, or KEY_NONE.
+ */
+KeyCode matrix_scan_keymap(int row, int col);
+
+#endif // MATRIX_SCAN_H
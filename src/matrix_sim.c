@@ -0,0 +1,165 @@
+// matrix_sim.c
+
+#include "matrix_sim.h"
+#include <string.h>
+
+#define NO_DEVICE (-1)
+
+// -----------------------------------------------------------------------------
+/* Bus Timing */
+// -----------------------------------------------------------------------------
+
+// Charges the wire time of a transaction: START, 9 clocks per byte (8 bits plus
+// ACK) and STOP, plus a repeated START and a second address byte for reads.
+static void charge(MatrixSim *sim, size_t tx_bytes, size_t rx_bytes) {
+    size_t bytes = 1 + tx_bytes;
+    size_t clocks = 2;
+    if (rx_bytes > 0) {
+        bytes += 1 + rx_bytes;
+        clocks += 1;
+    }
+    clocks += bytes * 9;
+    sim->transactions++;
+    sim->bytes += bytes;
+    sim->elapsed_ns += (uint64_t)clocks * 1000000000ull / sim->clock_hz;
+}
+
+// -----------------------------------------------------------------------------
+/* Matrix Electrics */
+// -----------------------------------------------------------------------------
+
+static int device_index(uint8_t address) {
+    if (address == MATRIX_ROW_EXPANDER) return 0;
+    if (address == MATRIX_COL_EXPANDER) return 1;
+    return NO_DEVICE;
+}
+
+// Returns the columns pulled low by the driven rows. Without diodes current
+// also flows backwards through a closed switch into another row, so the low
+// level spreads through every chain of pressed keys.
+static uint32_t low_columns(const MatrixSim *sim) {
+    const uint8_t *u1 = sim->regs[0];
+    uint32_t rows_low = (uint8_t)~u1[MCP23017_IODIRA] & (uint8_t)~u1[MCP23017_OLATA];
+
+    uint32_t row_keys[MATRIX_ROWS];
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        row_keys[row] = 0;
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            if (sim->keys[row][col]) {
+                row_keys[row] |= 1u << col;
+            }
+        }
+    }
+
+    uint32_t cols_low = 0;
+    for (;;) {
+        uint32_t cols = 0;
+        uint32_t rows = rows_low;
+        for (int row = 0; row < MATRIX_ROWS; row++) {
+            if (rows_low & (1u << row)) {
+                cols |= row_keys[row];
+            }
+        }
+        for (int row = 0; row < MATRIX_ROWS; row++) {
+            if (row_keys[row] & cols) {
+                rows |= 1u << row;
+            }
+        }
+        if (cols == cols_low && rows == rows_low) {
+            return cols_low;
+        }
+        cols_low = cols;
+        rows_low = rows;
+    }
+}
+
+// Reads GPIOA or GPIOB of a device: outputs return their latch, inputs the pin
+// level (columns pulled up unless held low by the matrix), then IPOL is applied.
+static uint8_t read_port(const MatrixSim *sim, int device, int port) {
+    const uint8_t *regs = sim->regs[device];
+    uint8_t direction = regs[MCP23017_IODIRA + port];
+    uint8_t latch = regs[MCP23017_OLATA + port];
+
+    // Which matrix columns sit on this port (U1 port A carries the rows)
+    int first_col = device == 0 ? (port == 1 ? 0 : -1) : 8 + port * 8;
+    uint8_t pins = 0xFF;
+    if (first_col >= 0) {
+        pins = (uint8_t)~(low_columns(sim) >> first_col);
+    }
+
+    uint8_t level = (uint8_t)((latch & ~direction) | (pins & direction));
+    return (uint8_t)(level ^ (regs[MCP23017_IPOLA + port] & direction));
+}
+
+static uint8_t read_register(MatrixSim *sim, int device, uint8_t reg) {
+    if (reg == MCP23017_GPIOA || reg == MCP23017_GPIOB) {
+        return read_port(sim, device, reg - MCP23017_GPIOA);
+    }
+    return sim->regs[device][reg];
+}
+
+static void write_register(MatrixSim *sim, int device, uint8_t reg, uint8_t value) {
+    if (reg == MCP23017_GPIOA || reg == MCP23017_GPIOB) {
+        reg = (uint8_t)(reg + (MCP23017_OLATA - MCP23017_GPIOA)); // Port writes go to the latch
+    }
+    sim->regs[device][reg] = value;
+}
+
+// -----------------------------------------------------------------------------
+/* I2cBus Callbacks */
+// -----------------------------------------------------------------------------
+
+static bool sim_write(void *context, uint8_t address, const uint8_t *data, size_t length) {
+    MatrixSim *sim = context;
+    charge(sim, length, 0);
+    int device = device_index(address);
+    if (device == NO_DEVICE || length == 0) {
+        return device != NO_DEVICE;
+    }
+    uint8_t reg = data[0];
+    for (size_t i = 1; i < length; i++) {
+        write_register(sim, device, reg, data[i]);
+        reg = (uint8_t)((reg + 1) % MCP23017_REGISTER_COUNT);
+    }
+    return true;
+}
+
+static bool sim_write_read(void *context, uint8_t address, const uint8_t *tx, size_t tx_length,
+                           uint8_t *rx, size_t rx_length) {
+    MatrixSim *sim = context;
+    charge(sim, tx_length, rx_length);
+    int device = device_index(address);
+    if (device == NO_DEVICE || tx_length != 1) {
+        return false;
+    }
+    uint8_t reg = tx[0];
+    for (size_t i = 0; i < rx_length; i++) {
+        rx[i] = read_register(sim, device, reg);
+        reg = (uint8_t)((reg + 1) % MCP23017_REGISTER_COUNT);
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void matrix_sim_init(MatrixSim *sim, uint32_t clock_hz) {
+    memset(sim, 0, sizeof(*sim));
+    for (int device = 0; device < 2; device++) {
+        sim->regs[device][MCP23017_IODIRA] = 0xFF;  // Power-on: all pins inputs
+        sim->regs[device][MCP23017_IODIRB] = 0xFF;
+    }
+    sim->clock_hz = clock_hz;
+}
+
+I2cBus matrix_sim_bus(MatrixSim *sim) {
+    I2cBus bus = { .context = sim, .write = sim_write, .write_read = sim_write_read };
+    return bus;
+}
+
+void matrix_sim_set_key(MatrixSim *sim, int row, int col, bool pressed) {
+    if (row >= 0 && row < MATRIX_ROWS && col >= 0 && col < MATRIX_COLS) {
+        sim->keys[row][col] = pressed;
+    }
+}
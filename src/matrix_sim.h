@@ -0,0 +1,45 @@
+#ifndef MATRIX_SIM_H
+#define MATRIX_SIM_H
+
+#include "i2c_bus.h"
+#include "matrix_scan.h"
+#include "mcp23017.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct MatrixSim
+ * @brief Simulated I2C bus with the two MCP23017 expanders and the key matrix behind them.
+ *
+ * Register reads and writes behave like the real parts in BANK = 0 mode,
+ * including the auto-incrementing register pointer, IPOL and the pull-ups.
+ * Column levels are derived from the driven rows and the switch states the
+ * way a matrix without diodes behaves, so ghost keys appear where they would
+ * on the hardware. Every transaction advances a simulated clock by its length
+ * on the wire, which gives the scan rate and latency at a chosen bus speed.
+ */
+typedef struct {
+    uint8_t regs[2][MCP23017_REGISTER_COUNT];  // U1, U2
+    bool keys[MATRIX_ROWS][MATRIX_COLS];       // Physical switch states
+    uint32_t clock_hz;                         // SCL frequency
+    uint64_t elapsed_ns;                       // Simulated bus time so far
+    uint64_t transactions;                     // Transactions on the bus
+    uint64_t bytes;                            // Address and data bytes on the bus
+} MatrixSim;
+
+/**
+ * @brief Resets both expanders to their power-on state with every key released.
+ */
+void matrix_sim_init(MatrixSim *sim, uint32_t clock_hz);
+
+/**
+ * @brief Returns an I2cBus that talks to the simulated expanders.
+ */
+I2cBus matrix_sim_bus(MatrixSim *sim);
+
+/**
+ * @brief Opens or closes the switch at a matrix position.
+ */
+void matrix_sim_set_key(MatrixSim *sim, int row, int col, bool pressed);
+
+#endif // MATRIX_SIM_H
@@ -0,0 +1,22 @@
+#ifndef MCP23017_H
+#define MCP23017_H
+
+// Register addresses of the MCP23017 GPIO expander with IOCON.BANK = 0.
+// In this mode the A and B registers of a pair are adjacent and the address
+// pointer auto-increments, so both ports can be read or written in one burst.
+#define MCP23017_IODIRA   0x00  // Direction, 1 = input
+#define MCP23017_IODIRB   0x01
+#define MCP23017_IPOLA    0x02  // Input polarity, 1 = inverted
+#define MCP23017_IPOLB    0x03
+#define MCP23017_IOCON    0x0A  // Configuration
+#define MCP23017_GPPUA    0x0C  // 100k pull-ups
+#define MCP23017_GPPUB    0x0D
+#define MCP23017_GPIOA    0x12  // Port levels
+#define MCP23017_GPIOB    0x13
+#define MCP23017_OLATA    0x14  // Output latches
+#define MCP23017_OLATB    0x15
+#define MCP23017_REGISTER_COUNT 0x16
+
+#define MCP23017_IOCON_SEQOP 0x20  // Set to disable pointer auto-increment
+
+#endif // MCP23017_H
@@ -0,0 +1,1121 @@
+// paged_document.c
+
+#include "paged_document.h"
+#include "hal_interface.h"
+#include "side_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_PAGE (-1)
+
+// Hand-over states of a DocSnapshotSpan held in a page
+enum {
+    SPAN_PENDING,   // Still in the page, neither side has taken it
+    SPAN_TAKEN,     // One side is copying it out of the page
+    SPAN_WRITTEN,   // The writer has its own copy, the page is free
+    SPAN_COPIED,    // The editor moved it to span->copy, the page is free
+    SPAN_LOST       // The editor could not copy it; the save fails
+};
+
+// -----------------------------------------------------------------------------
+/* Extent Table */
+// -----------------------------------------------------------------------------
+
+// Makes room for extra more extents.
+static bool extents_reserve(PagedDocument *doc, size_t extra) {
+    if (doc->extent_count + extra <= doc->extent_capacity) {
+        return true;
+    }
+    size_t new_capacity = doc->extent_capacity ? doc->extent_capacity * 2 : 8;
+    while (new_capacity < doc->extent_count + extra) {
+        new_capacity *= 2;
+    }
+    DocExtent *grown = realloc(doc->extents, new_capacity * sizeof(DocExtent));
+    if (!grown) {
+        return false;
+    }
+    doc->extents = grown;
+    doc->extent_capacity = new_capacity;
+    return true;
+}
+
+static bool extents_insert(PagedDocument *doc, size_t index, DocExtent extent) {
+    if (!extents_reserve(doc, 1)) {
+        return false;
+    }
+    memmove(&doc->extents[index + 1], &doc->extents[index],
+            (doc->extent_count - index) * sizeof(DocExtent));
+    doc->extents[index] = extent;
+    doc->extent_count++;
+    return true;
+}
+
+static void extents_remove(PagedDocument *doc, size_t index) {
+    memmove(&doc->extents[index], &doc->extents[index + 1],
+            (doc->extent_count - index - 1) * sizeof(DocExtent));
+    doc->extent_count--;
+}
+
+// Finds the extent holding document position pos and the offset inside it.
+// pos == length maps to the end of the last extent so text can be appended.
+static size_t locate(const PagedDocument *doc, size_t pos, size_t *offset_in_extent) {
+    size_t start = 0;
+    for (size_t i = 0; i < doc->extent_count; i++) {
+        size_t length = doc->extents[i].length;
+        if (pos < start + length || i == doc->extent_count - 1) {
+            *offset_in_extent = pos - start;
+            return i;
+        }
+        start += length;
+    }
+    *offset_in_extent = 0;
+    return 0;
+}
+
+// Merges neighbouring non-resident extents that are contiguous in the same source.
+// Called at the end of each public operation so indices stay stable inside one.
+static void coalesce_extents(PagedDocument *doc) {
+    size_t i = 0;
+    while (i + 1 < doc->extent_count) {
+        DocExtent *a = &doc->extents[i];
+        DocExtent *b = &doc->extents[i + 1];
+        if (a->page == NO_PAGE && b->page == NO_PAGE &&
+            a->source == b->source && a->offset + a->length == b->offset) {
+            a->length += b->length;
+            a->newlines = (a->newlines < 0 || b->newlines < 0) ? -1 : a->newlines + b->newlines;
+            extents_remove(doc, i + 1);
+        } else {
+            i++;
+        }
+    }
+}
+
+static const char *source_path(const PagedDocument *doc, ExtentSource source) {
+    return source == EXTENT_SOURCE_SWAP ? doc->swap_path : doc->base_path;
+}
+
+// Resident pages count too: they are read again from their source once evicted.
+static bool extents_use_source(const PagedDocument *doc, ExtentSource source) {
+    for (size_t i = 0; i < doc->extent_count; i++) {
+        if (doc->extents[i].source == source) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Finds the page-aligned block of an extent that loading offset reads.
+// Appending at the end of an extent loads its last block.
+static void extent_block(const DocExtent *extent, size_t offset, size_t *block_start, size_t *block_length) {
+    size_t probe = (offset == extent->length && offset > 0) ? offset - 1 : offset;
+    *block_start = probe - probe % PAGED_DOC_PAGE_SIZE;
+    *block_length = extent->length - *block_start;
+    if (*block_length > PAGED_DOC_PAGE_SIZE) {
+        *block_length = PAGED_DOC_PAGE_SIZE;
+    }
+}
+
+// -----------------------------------------------------------------------------
+/* Page Slots */
+// -----------------------------------------------------------------------------
+
+static void touch_page(PagedDocument *doc, int page) {
+    doc->pages[page].last_used = ++doc->clock;
+}
+
+// Must be called before a frozen page is changed or reused: the snapshot
+// spans still in it are copied out, unless the writer is already doing so.
+static void thaw_page(PagedDocument *doc, int page) {
+    if (!doc->pages[page].frozen) {
+        return;
+    }
+    DocSnapshot *snapshot = doc->snapshot;
+    for (size_t i = 0; i < snapshot->span_count; i++) {
+        DocSnapshotSpan *span = &snapshot->spans[i];
+        if (span->page != page) {
+            continue;
+        }
+        int expected = SPAN_PENDING;
+        if (atomic_compare_exchange_strong(&span->state, &expected, SPAN_TAKEN)) {
+            span->copy = malloc(span->length);
+            if (span->copy) {
+                memcpy(span->copy, span->text, span->length);
+                span->text = span->copy;
+            }
+            atomic_store(&span->state, span->copy ? SPAN_COPIED : SPAN_LOST);
+        } else {
+            // The writer is copying the span out, which takes a few microseconds
+            while (atomic_load(&span->state) == SPAN_TAKEN) {
+            }
+        }
+    }
+    doc->pages[page].frozen = false;
+}
+
+// Records an edit at offset of a page that removed and then inserted bytes.
+static void mark_changed(DocPage *p, size_t offset, size_t removed, size_t inserted) {
+    if (!p->dirty) {
+        p->dirty = true;
+        p->changed_start = offset;
+        p->changed_end = offset;
+    }
+    if (offset < p->changed_start) {
+        p->changed_start = offset;
+    }
+    // Bytes after the edit keep their relation to the source, just shifted
+    size_t end = p->changed_end > removed ? p->changed_end - removed : 0;
+    p->changed_end = (end > offset ? end : offset) + inserted;
+}
+
+static size_t extent_of_page(const PagedDocument *doc, int page) {
+    for (size_t i = 0; i < doc->extent_count; i++) {
+        if (doc->extents[i].page == page) {
+            return i;
+        }
+    }
+    return doc->extent_count;
+}
+
+static long count_newlines(const EditorBuffer *text, size_t start, size_t length) {
+    EditorSpan spans[2];
+    size_t count = editor_buffer_spans(text, start, length, spans);
+    long newlines = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (const char *c = spans[i].text; (c = memchr(c, '\n', spans[i].text + spans[i].length - c)); c++) {
+            newlines++;
+        }
+    }
+    return newlines;
+}
+
+// Frees a page slot. Dirty pages are appended to the swap file first so their
+// extent can be read back later; of a page loaded from the document file only
+// the changed range is, and the bytes around it are read from the file again.
+// If that adds extents before *follow, *follow is moved along.
+static bool evict_page(PagedDocument *doc, int page, size_t *follow) {
+    DocPage *p = &doc->pages[page];
+    size_t index = extent_of_page(doc, page);
+    if (index == doc->extent_count) {
+        p->in_use = false;
+        return true;
+    }
+    DocExtent *extent = &doc->extents[index];
+
+    if (p->dirty) {
+        size_t head = 0;
+        size_t tail = 0;
+        if (extent->source == EXTENT_SOURCE_FILE && extents_reserve(doc, 2)) {
+            extent = &doc->extents[index];
+            head = p->changed_start;
+            tail = extent->length - p->changed_end;
+        }
+        DocExtent before = { extent->offset, head, EXTENT_SOURCE_FILE, NO_PAGE, count_newlines(&p->text, 0, head) };
+        DocExtent after = { extent->offset + p->loaded_length - tail, tail, EXTENT_SOURCE_FILE, NO_PAGE,
+                            count_newlines(&p->text, extent->length - tail, tail) };
+
+        EditorSpan spans[2];
+        size_t count = editor_buffer_spans(&p->text, head, extent->length - head - tail, spans);
+        size_t offset = doc->swap_length;
+        for (size_t i = 0; i < count; i++) {
+            if (!hal_storage_write_range(doc->swap_path, offset, spans[i].text, spans[i].length)) {
+                return false;
+            }
+            offset += spans[i].length;
+        }
+        extent->source = EXTENT_SOURCE_SWAP;
+        extent->offset = doc->swap_length;
+        extent->length -= head + tail;
+        extent->newlines -= before.newlines + after.newlines;
+        extent->page = NO_PAGE;
+        doc->swap_length = offset;
+
+        // Room was reserved, so none of this can fail
+        if (head > 0) {
+            extents_insert(doc, index, before);
+            if (follow && *follow >= index) {
+                (*follow)++;
+            }
+            index++;
+        }
+        if (tail > 0) {
+            extents_insert(doc, index + 1, after);
+            if (follow && *follow > index) {
+                (*follow)++;
+            }
+        }
+        if (doc->extents[index].length == 0) {
+            extents_remove(doc, index);
+            if (follow && *follow > index) {
+                (*follow)--;
+            }
+        }
+    } else {
+        extent->page = NO_PAGE;
+    }
+    p->in_use = false;
+    p->dirty = false;
+    return true;
+}
+
+// Returns a free page slot, evicting the least recently used page if needed.
+// The page 'pinned' is never chosen. Extents the eviction adds are accounted
+// for in *follow, an index the caller holds, if not NULL. Returns NO_PAGE on failure.
+static int acquire_page(PagedDocument *doc, int pinned, size_t *follow) {
+    int victim = NO_PAGE;
+    for (int i = 0; i < PAGED_DOC_RESIDENT_PAGES; i++) {
+        if (!doc->pages[i].in_use) {
+            victim = i;
+            break;
+        }
+        if (i != pinned && (victim == NO_PAGE || doc->pages[i].last_used < doc->pages[victim].last_used)) {
+            victim = i;
+        }
+    }
+    if (victim == NO_PAGE) {
+        return NO_PAGE;
+    }
+
+    DocPage *p = &doc->pages[victim];
+    if (p->in_use && !evict_page(doc, victim, follow)) {
+        return NO_PAGE;
+    }
+    thaw_page(doc, victim);
+    if (!p->text.data && !editor_buffer_init(&p->text, PAGED_DOC_MAX_PAGE_SIZE)) {
+        return NO_PAGE;
+    }
+    editor_buffer_clear(&p->text);
+    line_index_clear(&p->lines);
+    p->in_use = true;
+    p->dirty = false;
+    p->loaded_length = 0;
+    touch_page(doc, victim);
+    return victim;
+}
+
+// Makes the extent at *index resident. Large extents are split first so only
+// the page-aligned block around *offset is read. *index and *offset are updated
+// to point at the same document byte inside the resident extent. If data is
+// not NULL it holds the block, read ahead, and storage is not accessed.
+static int load_page(PagedDocument *doc, size_t *index, size_t *offset, int pinned, const char *data) {
+    DocExtent *extent = &doc->extents[*index];
+    if (extent->page != NO_PAGE) {
+        touch_page(doc, extent->page);
+        return extent->page;
+    }
+
+    int page = acquire_page(doc, pinned, index);
+    if (page == NO_PAGE) {
+        return NO_PAGE;
+    }
+    extent = &doc->extents[*index];
+
+    size_t page_start;
+    size_t page_length;
+    extent_block(extent, *offset, &page_start, &page_length);
+
+    long total_newlines = extent->newlines;
+    long unknown = total_newlines == 0 ? 0 : -1;
+    bool has_head = page_start > 0;
+    bool has_tail = false;
+
+    if (has_head) {
+        DocExtent head = { extent->offset, page_start, extent->source, NO_PAGE, unknown };
+        if (!extents_insert(doc, *index, head)) {
+            doc->pages[page].in_use = false;
+            return NO_PAGE;
+        }
+        (*index)++;
+        extent = &doc->extents[*index];
+        extent->offset += page_start;
+        extent->length -= page_start;
+        *offset -= page_start;
+    }
+    if (extent->length > page_length) {
+        DocExtent tail = { extent->offset + page_length, extent->length - page_length, extent->source, NO_PAGE, unknown };
+        if (!extents_insert(doc, *index + 1, tail)) {
+            doc->pages[page].in_use = false;
+            return NO_PAGE;
+        }
+        has_tail = true;
+        extent = &doc->extents[*index];
+        extent->length = page_length;
+    }
+
+    DocPage *p = &doc->pages[page];
+    char *storage = editor_buffer_prepare(&p->text, page_length);
+    int read = -1;
+    if (storage && data) {
+        memcpy(storage, data, page_length);
+        read = (int)page_length;
+    } else if (storage) {
+        read = hal_storage_read_range(source_path(doc, extent->source), extent->offset, storage, page_length);
+    }
+    if (read != (int)page_length || !line_index_scan(&p->lines, storage, page_length, 0)) {
+        editor_buffer_clear(&p->text);
+        p->in_use = false;
+        return NO_PAGE;
+    }
+
+    extent->page = page;
+    extent->newlines = (long)line_index_count(&p->lines);
+    p->loaded_length = page_length;
+
+    // If the page holds all newlines of the original extent, the rest has none
+    if (total_newlines >= 0 && total_newlines == extent->newlines) {
+        if (has_head) {
+            doc->extents[*index - 1].newlines = 0;
+        }
+        if (has_tail) {
+            doc->extents[*index + 1].newlines = 0;
+        }
+    }
+    return page;
+}
+
+// Splits an oversized resident page in two so no page grows without bound.
+static void split_page(PagedDocument *doc, size_t index) {
+    int page = doc->extents[index].page;
+    int other = acquire_page(doc, page, &index);
+    if (other == NO_PAGE) {
+        return; // Keep the large page, it still works
+    }
+
+    DocExtent *extent = &doc->extents[index];
+    size_t keep = extent->length / 2;
+    size_t move = extent->length - keep;
+
+    thaw_page(doc, page);
+    DocPage *first = &doc->pages[page];
+    DocPage *second_page = &doc->pages[other];
+    char *storage = editor_buffer_prepare(&second_page->text, move);
+    DocExtent second = { 0, move, EXTENT_SOURCE_MEMORY, other, 0 };
+    if (!storage || !extents_insert(doc, index + 1, second)) {
+        second_page->in_use = false;
+        return;
+    }
+    editor_buffer_copy(&first->text, keep, storage, move);
+    editor_buffer_set_cursor(&first->text, keep);
+    editor_buffer_delete_forward(&first->text, move);
+    line_index_scan(&second_page->lines, storage, move, 0);
+    line_index_delete(&first->lines, keep, move);
+    mark_changed(first, keep, move, 0);
+
+    doc->extents[index].length = keep;
+    doc->extents[index].newlines = (long)line_index_count(&first->lines);
+    doc->extents[index + 1].newlines = (long)line_index_count(&second_page->lines);
+    second_page->dirty = true;
+}
+
+// -----------------------------------------------------------------------------
+/* Lifecycle */
+// -----------------------------------------------------------------------------
+
+bool paged_doc_open(PagedDocument *doc, const char *path) {
+    // Every side file name has the length of the swap file name
+    if (strlen(path) >= PAGED_DOC_PATH_LEN ||
+        !side_file_path(path, SIDE_FILE_SWAP, doc->swap_path, sizeof(doc->swap_path))) {
+        return false;
+    }
+    strcpy(doc->path, path);
+    strcpy(doc->base_path, path);
+    doc->swap_length = 0;
+    doc->extent_count = 0;
+    doc->clock = 0;
+    doc->revision = 0;
+    doc->saves = 0;
+    doc->snapshot = NULL;
+    doc->modified = false;
+
+    for (int i = 0; i < PAGED_DOC_RESIDENT_PAGES; i++) {
+        doc->pages[i].in_use = false;
+        doc->pages[i].dirty = false;
+        doc->pages[i].frozen = false;
+    }
+
+    // Opening only needs the size: the whole file starts out as one extent
+    long size = hal_storage_file_size(path);
+    doc->length = size > 0 ? (size_t)size : 0;
+    if (doc->length > 0) {
+        DocExtent whole = { 0, doc->length, EXTENT_SOURCE_FILE, NO_PAGE, -1 };
+        if (!extents_insert(doc, 0, whole)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void paged_doc_close(PagedDocument *doc) {
+    for (int i = 0; i < PAGED_DOC_RESIDENT_PAGES; i++) {
+        editor_buffer_free(&doc->pages[i].text);
+        line_index_free(&doc->pages[i].lines);
+        doc->pages[i].in_use = false;
+        doc->pages[i].dirty = false;
+    }
+    free(doc->extents);
+    doc->extents = NULL;
+    doc->extent_count = 0;
+    doc->extent_capacity = 0;
+    doc->length = 0;
+
+    if (doc->swap_length > 0) {
+        hal_storage_delete_file(doc->swap_path);
+        doc->swap_length = 0;
+    }
+    // The previous file kept aside by a save made while editing
+    if (doc->base_path[0] && strcmp(doc->base_path, doc->path) != 0) {
+        hal_storage_delete_file(doc->base_path);
+    }
+    strcpy(doc->base_path, doc->path);
+    doc->modified = false;
+}
+
+size_t paged_doc_length(const PagedDocument *doc) {
+    return doc->length;
+}
+
+bool paged_doc_is_modified(const PagedDocument *doc) {
+    return doc->modified;
+}
+
+// -----------------------------------------------------------------------------
+/* Editing */
+// -----------------------------------------------------------------------------
+
+bool paged_doc_insert(PagedDocument *doc, size_t pos, const char *text, size_t length) {
+    if (pos > doc->length) {
+        pos = doc->length;
+    }
+
+    bool ok = true;
+    while (length > 0) {
+        // Insert at most one page at a time so pages can be split in between
+        size_t chunk = length < PAGED_DOC_PAGE_SIZE ? length : PAGED_DOC_PAGE_SIZE;
+        size_t index;
+        size_t offset;
+        int page;
+
+        if (doc->extent_count == 0) {
+            page = acquire_page(doc, NO_PAGE, NULL);
+            DocExtent empty = { 0, 0, EXTENT_SOURCE_MEMORY, page, 0 };
+            if (page == NO_PAGE || !extents_insert(doc, 0, empty)) {
+                ok = false;
+                break;
+            }
+            index = 0;
+            offset = 0;
+        } else {
+            index = locate(doc, pos, &offset);
+            page = load_page(doc, &index, &offset, NO_PAGE, NULL);
+            if (page == NO_PAGE) {
+                ok = false;
+                break;
+            }
+        }
+
+        thaw_page(doc, page);
+        DocPage *p = &doc->pages[page];
+        if (!line_index_insert(&p->lines, offset, text, chunk)) {
+            ok = false;
+            break;
+        }
+        editor_buffer_set_cursor(&p->text, offset);
+        if (!editor_buffer_insert(&p->text, text, chunk)) {
+            line_index_delete(&p->lines, offset, chunk);
+            ok = false;
+            break;
+        }
+        doc->extents[index].length += chunk;
+        doc->extents[index].newlines = (long)line_index_count(&p->lines);
+        mark_changed(p, offset, 0, chunk);
+        doc->length += chunk;
+        doc->revision++;
+        doc->modified = true;
+
+        if (doc->extents[index].length > PAGED_DOC_MAX_PAGE_SIZE) {
+            split_page(doc, index);
+        }
+
+        pos += chunk;
+        text += chunk;
+        length -= chunk;
+    }
+
+    coalesce_extents(doc);
+    return ok;
+}
+
+size_t paged_doc_delete(PagedDocument *doc, size_t pos, size_t length) {
+    size_t deleted = 0;
+
+    while (length > 0 && pos < doc->length) {
+        size_t offset;
+        size_t index = locate(doc, pos, &offset);
+        DocExtent *extent = &doc->extents[index];
+        size_t count = extent->length - offset;
+        if (count > length) {
+            count = length;
+        }
+
+        if (offset == 0 && count == extent->length) {
+            // Whole extent goes away, no need to read it
+            if (extent->page != NO_PAGE) {
+                doc->pages[extent->page].in_use = false;
+                doc->pages[extent->page].dirty = false;
+            }
+            extents_remove(doc, index);
+        } else if (extent->page != NO_PAGE) {
+            thaw_page(doc, extent->page);
+            DocPage *p = &doc->pages[extent->page];
+            editor_buffer_set_cursor(&p->text, offset);
+            editor_buffer_delete_forward(&p->text, count);
+            line_index_delete(&p->lines, offset, count);
+            mark_changed(p, offset, count, 0);
+            extent->length -= count;
+            extent->newlines = (long)line_index_count(&p->lines);
+            touch_page(doc, extent->page);
+        } else {
+            // Trim a stored extent without reading it; its newline count is
+            // only still known if it had none
+            long unknown = extent->newlines == 0 ? 0 : -1;
+            if (offset == 0) {
+                extent->offset += count;
+                extent->length -= count;
+            } else if (offset + count == extent->length) {
+                extent->length -= count;
+            } else {
+                // Cut a hole into the extent by splitting it
+                DocExtent tail = { extent->offset + offset + count, extent->length - offset - count,
+                                   extent->source, NO_PAGE, unknown };
+                if (!extents_insert(doc, index + 1, tail)) {
+                    break;
+                }
+                extent = &doc->extents[index];
+                extent->length = offset;
+            }
+            extent->newlines = unknown;
+        }
+
+        doc->length -= count;
+        length -= count;
+        deleted += count;
+    }
+
+    if (deleted > 0) {
+        doc->revision++;
+        doc->modified = true;
+    }
+    coalesce_extents(doc);
+    return deleted;
+}
+
+// -----------------------------------------------------------------------------
+/* Reading */
+// -----------------------------------------------------------------------------
+
+size_t paged_doc_read(PagedDocument *doc, size_t pos, char *out, size_t length) {
+    size_t copied = 0;
+
+    while (copied < length && pos < doc->length) {
+        size_t offset;
+        size_t index = locate(doc, pos, &offset);
+        int page = load_page(doc, &index, &offset, NO_PAGE, NULL);
+        if (page == NO_PAGE) {
+            break;
+        }
+
+        size_t count = editor_buffer_copy(&doc->pages[page].text, offset, out + copied, length - copied);
+        if (count == 0) {
+            break;
+        }
+        copied += count;
+        pos += count;
+    }
+
+    coalesce_extents(doc);
+    return copied;
+}
+
+char paged_doc_char_at(PagedDocument *doc, size_t pos) {
+    char c = '\0';
+    paged_doc_read(doc, pos, &c, 1);
+    return c;
+}
+
+// -----------------------------------------------------------------------------
+/* Line Navigation */
+// -----------------------------------------------------------------------------
+
+size_t paged_doc_line_start(PagedDocument *doc, size_t pos) {
+    if (pos > doc->length) {
+        pos = doc->length;
+    }
+
+    // Look for the last newline before pos, one extent at a time
+    while (pos > 0) {
+        size_t offset;
+        size_t index = locate(doc, pos - 1, &offset);
+        size_t extent_start = pos - 1 - offset;
+        if (doc->extents[index].newlines == 0) {
+            pos = extent_start;
+            continue;
+        }
+
+        int page = load_page(doc, &index, &offset, NO_PAGE, NULL);
+        if (page == NO_PAGE) {
+            break;
+        }
+        extent_start = pos - 1 - offset;
+
+        size_t newline;
+        if (line_index_find_before(&doc->pages[page].lines, offset, &newline)) {
+            pos = extent_start + newline + 1;
+            break;
+        }
+        pos = extent_start;
+    }
+
+    coalesce_extents(doc);
+    return pos;
+}
+
+size_t paged_doc_line_end(PagedDocument *doc, size_t pos) {
+    size_t result = doc->length;
+
+    // Look for the first newline at or after pos, one extent at a time
+    while (pos < doc->length) {
+        size_t offset;
+        size_t index = locate(doc, pos, &offset);
+        size_t extent_end = pos - offset + doc->extents[index].length;
+        if (doc->extents[index].newlines == 0) {
+            pos = extent_end;
+            continue;
+        }
+
+        int page = load_page(doc, &index, &offset, NO_PAGE, NULL);
+        if (page == NO_PAGE) {
+            break;
+        }
+        extent_end = pos - offset + doc->extents[index].length;
+
+        size_t newline;
+        if (line_index_find_after(&doc->pages[page].lines, offset, &newline)) {
+            result = pos - offset + newline;
+            break;
+        }
+        pos = extent_end;
+    }
+
+    coalesce_extents(doc);
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+/* Saving */
+// -----------------------------------------------------------------------------
+
+// Adds document bytes [start, end) to the runs of snapshot, widened to whole
+// storage blocks. Ranges must come in document order.
+static void add_patch_range(DocSnapshot *snapshot, size_t start, size_t end) {
+    if (start >= end) {
+        return;
+    }
+    start -= start % HAL_STORAGE_BLOCK_SIZE;
+    end += (HAL_STORAGE_BLOCK_SIZE - end % HAL_STORAGE_BLOCK_SIZE) % HAL_STORAGE_BLOCK_SIZE;
+    if (end > snapshot->length) {
+        end = snapshot->length;
+    }
+    if (snapshot->run_count > 0) {
+        DocPatchRun *last = &snapshot->runs[snapshot->run_count - 1];
+        if (start <= last->start + last->length) {
+            if (end > last->start + last->length) {
+                last->length = end - last->start;
+            }
+            return;
+        }
+    }
+    snapshot->runs[snapshot->run_count++] = (DocPatchRun){ start, end - start };
+}
+
+// Lists the blocks where the document differs from its file. Fails if some
+// bytes still have to be read from the file at another offset than their own,
+// since patching the file could overwrite them before they are read.
+static bool plan_patch(const PagedDocument *doc, DocSnapshot *snapshot) {
+    if (strcmp(doc->base_path, doc->path) != 0) {
+        return false;
+    }
+    snapshot->runs = malloc((doc->extent_count ? doc->extent_count : 1) * sizeof(DocPatchRun));
+    if (!snapshot->runs) {
+        return false;
+    }
+
+    size_t pos = 0;
+    for (size_t i = 0; i < doc->extent_count; i++) {
+        const DocExtent *extent = &doc->extents[i];
+        size_t end = pos + extent->length;
+        const DocPage *p = extent->page != NO_PAGE ? &doc->pages[extent->page] : NULL;
+        if (extent->source != EXTENT_SOURCE_FILE) {
+            add_patch_range(snapshot, pos, end);
+        } else if (!p || !p->dirty) {
+            if (extent->offset != pos) {
+                return false;
+            }
+        } else {
+            // Before its changed range the page holds file bytes from extent->offset,
+            // after it those ending at extent->offset + loaded_length. Where they
+            // moved they are written too; dirty pages are never read back from the file.
+            size_t from = extent->offset == pos ? pos + p->changed_start : pos;
+            size_t to = extent->offset + p->loaded_length == end ? pos + p->changed_end : end;
+            add_patch_range(snapshot, from, to);
+        }
+        pos = end;
+    }
+
+    for (size_t i = 0; i < snapshot->run_count; i++) {
+        snapshot->patch_length += snapshot->runs[i].length;
+    }
+    return true;
+}
+
+bool paged_doc_save_begin(PagedDocument *doc, DocSnapshot *snapshot, bool allow_in_place) {
+    if (doc->snapshot) {
+        return false;
+    }
+
+    // A resident extent is at most two spans, either side of the gap
+    size_t capacity = 0;
+    for (size_t i = 0; i < doc->extent_count; i++) {
+        capacity += doc->extents[i].page != NO_PAGE ? 2 : 1;
+    }
+    if (!side_file_path(doc->path, SIDE_FILE_TEMP, snapshot->tmp_path, sizeof(snapshot->tmp_path))) {
+        return false;
+    }
+    snapshot->spans = malloc((capacity ? capacity : 1) * sizeof(DocSnapshotSpan));
+    if (!snapshot->spans) {
+        return false;
+    }
+    strcpy(snapshot->file_path, doc->base_path);
+    strcpy(snapshot->swap_path, doc->swap_path);
+    snapshot->span_count = 0;
+    snapshot->length = doc->length;
+    snapshot->revision = doc->revision;
+    snapshot->runs = NULL;
+    snapshot->run_count = 0;
+    snapshot->patch = NULL;
+    snapshot->patch_length = 0;
+    snapshot->bytes_written = 0;
+
+    // Patched bytes are written twice, once to make the patch recoverable
+    snapshot->in_place = allow_in_place && plan_patch(doc, snapshot) && snapshot->patch_length < doc->length / 2;
+    if (!snapshot->in_place) {
+        free(snapshot->runs);
+        snapshot->runs = NULL;
+        snapshot->run_count = 0;
+        snapshot->patch_length = 0;
+    }
+
+    for (size_t i = 0; i < doc->extent_count; i++) {
+        DocExtent *extent = &doc->extents[i];
+        if (extent->page == NO_PAGE) {
+            DocSnapshotSpan *span = &snapshot->spans[snapshot->span_count++];
+            *span = (DocSnapshotSpan){ NULL, extent->source, extent->offset, extent->length, NO_PAGE, NULL, 0 };
+            atomic_init(&span->state, SPAN_WRITTEN);
+            continue;
+        }
+
+        EditorSpan spans[2];
+        size_t count = editor_buffer_spans(&doc->pages[extent->page].text, 0, extent->length, spans);
+        for (size_t s = 0; s < count; s++) {
+            DocSnapshotSpan *span = &snapshot->spans[snapshot->span_count++];
+            *span = (DocSnapshotSpan){ spans[s].text, EXTENT_SOURCE_MEMORY, 0, spans[s].length, extent->page, NULL, 0 };
+            atomic_init(&span->state, SPAN_PENDING);
+        }
+        doc->pages[extent->page].frozen = true;
+    }
+
+    doc->snapshot = snapshot;
+    return true;
+}
+
+bool paged_doc_save_gather(DocSnapshot *snapshot) {
+    snapshot->patch = malloc(snapshot->patch_length ? snapshot->patch_length : 1);
+    if (!snapshot->patch) {
+        return false;
+    }
+
+    // One pass over the spans; each takes the parts of the runs it covers
+    bool ok = true;
+    size_t pos = 0;        // Document position of the span
+    size_t run = 0;
+    size_t run_data = 0;   // Offset of runs[run] in patch
+    for (size_t i = 0; i < snapshot->span_count && ok; i++) {
+        DocSnapshotSpan *span = &snapshot->spans[i];
+        size_t end = pos + span->length;
+        bool taken = false;
+        if (span->page != NO_PAGE) {
+            int expected = SPAN_PENDING;
+            taken = atomic_compare_exchange_strong(&span->state, &expected, SPAN_TAKEN);
+            if (!taken) {
+                while (atomic_load(&span->state) == SPAN_TAKEN) {
+                }
+                if (atomic_load(&span->state) != SPAN_COPIED) {
+                    return false;
+                }
+            }
+        }
+
+        while (run < snapshot->run_count && ok) {
+            const DocPatchRun *r = &snapshot->runs[run];
+            size_t from = r->start > pos ? r->start : pos;
+            size_t to = r->start + r->length < end ? r->start + r->length : end;
+            if (from >= end) {
+                break;
+            }
+            char *out = snapshot->patch + run_data + (from - r->start);
+            if (span->page != NO_PAGE) {
+                memcpy(out, span->text + (from - pos), to - from);
+            } else {
+                const char *path = span->source == EXTENT_SOURCE_SWAP ? snapshot->swap_path : snapshot->file_path;
+                ok = hal_storage_read_range(path, span->offset + (from - pos), out, to - from) == (int)(to - from);
+            }
+            if (r->start + r->length > end) {
+                break; // The run goes on in the next span
+            }
+            run_data += r->length;
+            run++;
+        }
+
+        if (taken) {
+            atomic_store(&span->state, SPAN_WRITTEN);
+        }
+        pos = end;
+    }
+    return ok;
+}
+
+// Writes the gathered runs over the document file and sets its new length.
+static bool save_write_in_place(DocSnapshot *snapshot) {
+    if (!snapshot->patch) {
+        return false;
+    }
+    size_t data = 0;
+    for (size_t i = 0; i < snapshot->run_count; i++) {
+        const DocPatchRun *r = &snapshot->runs[i];
+        if (!hal_storage_write_range(snapshot->file_path, r->start, snapshot->patch + data, r->length)) {
+            return false;
+        }
+        data += r->length;
+        snapshot->bytes_written += r->length;
+    }
+    return hal_storage_truncate(snapshot->file_path, snapshot->length);
+}
+
+bool paged_doc_save_write(DocSnapshot *snapshot) {
+    if (snapshot->in_place) {
+        return save_write_in_place(snapshot);
+    }
+
+    // Creating the file also truncates leftovers of an interrupted save
+    if (!hal_storage_create_file(snapshot->tmp_path)) {
+        return false;
+    }
+
+    // Page bytes are taken out of the page into a private block first, so the
+    // editor never waits for the card when it changes a frozen page
+    size_t block_size = PAGED_DOC_PAGE_SIZE;
+    for (size_t i = 0; i < snapshot->span_count; i++) {
+        if (snapshot->spans[i].page != NO_PAGE && snapshot->spans[i].length > block_size) {
+            block_size = snapshot->spans[i].length;
+        }
+    }
+    char *block = malloc(block_size);
+    if (!block) {
+        return false;
+    }
+
+    bool ok = true;
+    size_t written = 0;
+    for (size_t i = 0; i < snapshot->span_count && ok; i++) {
+        DocSnapshotSpan *span = &snapshot->spans[i];
+        if (span->page != NO_PAGE) {
+            const char *bytes = block;
+            int expected = SPAN_PENDING;
+            if (atomic_compare_exchange_strong(&span->state, &expected, SPAN_TAKEN)) {
+                memcpy(block, span->text, span->length);
+                atomic_store(&span->state, SPAN_WRITTEN);
+            } else {
+                // The editor is copying it out of the page
+                while (atomic_load(&span->state) == SPAN_TAKEN) {
+                }
+                bytes = atomic_load(&span->state) == SPAN_COPIED ? span->copy : NULL;
+            }
+            ok = bytes && hal_storage_write_range(snapshot->tmp_path, written, bytes, span->length);
+            written += span->length;
+            continue;
+        }
+
+        // Stored bytes are copied through the block
+        const char *path = span->source == EXTENT_SOURCE_SWAP ? snapshot->swap_path : snapshot->file_path;
+        for (size_t done = 0; done < span->length && ok; ) {
+            size_t chunk = span->length - done;
+            if (chunk > block_size) {
+                chunk = block_size;
+            }
+            int read = hal_storage_read_range(path, span->offset + done, block, chunk);
+            ok = read == (int)chunk && hal_storage_write_range(snapshot->tmp_path, written, block, chunk);
+            done += chunk;
+            written += chunk;
+        }
+    }
+    free(block);
+    snapshot->bytes_written = written;
+    return ok;
+}
+
+bool paged_doc_save_end(PagedDocument *doc, DocSnapshot *snapshot, bool written) {
+    // The writer is done with every span, so frozen pages can simply be released
+    for (int i = 0; i < PAGED_DOC_RESIDENT_PAGES; i++) {
+        doc->pages[i].frozen = false;
+    }
+    for (size_t i = 0; i < snapshot->span_count; i++) {
+        free(snapshot->spans[i].copy);
+    }
+    free(snapshot->spans);
+    snapshot->spans = NULL;
+    snapshot->span_count = 0;
+    free(snapshot->runs);
+    snapshot->runs = NULL;
+    free(snapshot->patch);
+    snapshot->patch = NULL;
+    doc->snapshot = NULL;
+
+    if (!written) {
+        if (!snapshot->in_place) {
+            hal_storage_delete_file(snapshot->tmp_path);
+        }
+        return false;
+    }
+
+    if (doc->revision != snapshot->revision && snapshot->in_place) {
+        // Unchanged bytes kept their offsets, so the extents still read them
+        // right. What the dirty pages changed is now relative to the snapshot.
+        for (size_t i = 0; i < doc->extent_count; i++) {
+            DocExtent *extent = &doc->extents[i];
+            if (extent->page != NO_PAGE && doc->pages[extent->page].dirty) {
+                doc->pages[extent->page].changed_start = 0;
+                doc->pages[extent->page].changed_end = extent->length;
+            }
+        }
+        doc->saves++;
+        return true;
+    }
+
+    if (doc->revision != snapshot->revision) {
+        // Edited while saving: the extents still read unchanged text from the
+        // previous file, so it is kept aside instead of being replaced
+        if (strcmp(doc->base_path, doc->path) == 0 && extents_use_source(doc, EXTENT_SOURCE_FILE)) {
+            char old_path[PAGED_DOC_PATH_LEN];
+            if (!side_file_path(doc->path, SIDE_FILE_OLD, old_path, sizeof(old_path)) ||
+                !hal_storage_rename_file(doc->path, old_path)) {
+                hal_storage_delete_file(snapshot->tmp_path);
+                return false;
+            }
+            strcpy(doc->base_path, old_path);
+        }
+        if (!hal_storage_rename_file(snapshot->tmp_path, doc->path)) {
+            hal_storage_delete_file(snapshot->tmp_path);
+            return false;
+        }
+        doc->saves++;
+        return true;
+    }
+
+    if (!snapshot->in_place && !hal_storage_rename_file(snapshot->tmp_path, doc->path)) {
+        hal_storage_delete_file(snapshot->tmp_path);
+        return false;
+    }
+
+    // The file now holds the document verbatim: every extent maps 1:1 onto it
+    size_t pos = 0;
+    for (size_t i = 0; i < doc->extent_count; i++) {
+        DocExtent *extent = &doc->extents[i];
+        extent->source = EXTENT_SOURCE_FILE;
+        extent->offset = pos;
+        if (extent->page != NO_PAGE) {
+            doc->pages[extent->page].dirty = false;
+            doc->pages[extent->page].loaded_length = extent->length;
+        }
+        pos += extent->length;
+    }
+    if (doc->swap_length > 0) {
+        hal_storage_delete_file(doc->swap_path);
+        doc->swap_length = 0;
+    }
+    if (strcmp(doc->base_path, doc->path) != 0) {
+        hal_storage_delete_file(doc->base_path);
+        strcpy(doc->base_path, doc->path);
+    }
+
+    doc->saves++;
+    doc->modified = false;
+    coalesce_extents(doc);
+    return true;
+}
+
+bool paged_doc_save(PagedDocument *doc) {
+    DocSnapshot snapshot;
+    if (!paged_doc_save_begin(doc, &snapshot, false)) {
+        return false;
+    }
+    return paged_doc_save_end(doc, &snapshot, paged_doc_save_write(&snapshot));
+}
+
+// -----------------------------------------------------------------------------
+/* Read-Ahead */
+// -----------------------------------------------------------------------------
+
+// Finds the stored block of the document file that loading pos would read.
+static bool find_block(const PagedDocument *doc, size_t pos, DocBlock *block) {
+    if (doc->extent_count == 0) {
+        return false;
+    }
+    size_t offset;
+    size_t index = locate(doc, pos, &offset);
+    const DocExtent *extent = &doc->extents[index];
+    if (extent->page != NO_PAGE || extent->source != EXTENT_SOURCE_FILE) {
+        return false;
+    }
+    size_t block_start;
+    extent_block(extent, offset, &block_start, &block->length);
+    block->start = pos - offset + block_start;
+    block->offset = extent->offset + block_start;
+    return true;
+}
+
+bool paged_doc_block_request(const PagedDocument *doc, size_t pos, DocBlock *block) {
+    if (!find_block(doc, pos, block)) {
+        return false;
+    }
+    block->saves = doc->saves;
+    strcpy(block->path, doc->base_path);
+    return true;
+}
+
+bool paged_doc_block_read(DocBlock *block) {
+    return hal_storage_read_range(block->path, block->offset, block->data, block->length) == (int)block->length;
+}
+
+bool paged_doc_block_fill(PagedDocument *doc, const DocBlock *block) {
+    // A save remaps the file, and edits or loads may have moved the block
+    DocBlock current;
+    if (block->saves != doc->saves || !find_block(doc, block->start, &current) ||
+        current.start != block->start || current.offset != block->offset || current.length != block->length) {
+        return false;
+    }
+
+    size_t offset;
+    size_t index = locate(doc, block->start, &offset);
+    int page = load_page(doc, &index, &offset, NO_PAGE, block->data);
+    coalesce_extents(doc);
+    return page != NO_PAGE;
+}
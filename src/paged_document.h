@@ -0,0 +1,318 @@
+#ifndef PAGED_DOCUMENT_H
+#define PAGED_DOCUMENT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "editor_buffer.h"
+#include "line_index.h"
+
+#define PAGED_DOC_PAGE_SIZE 4096                          // Bytes loaded from storage per page
+#define PAGED_DOC_MAX_PAGE_SIZE (2 * PAGED_DOC_PAGE_SIZE) // A page growing past this is split
+#define PAGED_DOC_RESIDENT_PAGES 8                        // Pages kept in RAM at most
+#define PAGED_DOC_PATH_LEN 512
+
+/**
+ * @enum ExtentSource
+ * @brief Where the bytes of a non-resident extent can be read back from.
+ */
+typedef enum {
+    EXTENT_SOURCE_FILE,   // Unchanged bytes of the document file
+    EXTENT_SOURCE_SWAP,   // Edited bytes spilled to the swap file
+    EXTENT_SOURCE_MEMORY  // New bytes that only exist in a resident page
+} ExtentSource;
+
+/**
+ * @struct DocExtent
+ * @brief A run of document bytes, stored in order in PagedDocument.extents.
+ *
+ * A freshly opened file is a single extent, no matter how large it is. Extents
+ * are only split when a page is loaded or text is deleted inside them, so the
+ * extent table grows with the number of touched regions, not with file size.
+ * Each extent remembers how many newlines it holds once it has been loaded,
+ * which lets line navigation skip over long stretches without reading them.
+ */
+typedef struct {
+    size_t offset;        // Offset in the source file (FILE and SWAP)
+    size_t length;        // Number of document bytes covered
+    ExtentSource source;  // Where the bytes come from when not resident
+    int page;             // Resident page index, or -1
+    long newlines;        // Number of '\n' in the extent, -1 if not counted yet
+} DocExtent;
+
+/**
+ * @struct DocPage
+ * @brief A resident page: the bytes of one extent held in a gap buffer.
+ */
+typedef struct {
+    EditorBuffer text;        // Page content, edited in place
+    LineIndex lines;          // Newline offsets within text
+    unsigned long last_used;  // LRU clock value of the last access
+    bool in_use;              // Slot currently backs an extent
+    bool dirty;               // Content differs from the extent source
+    bool frozen;              // Referenced by the snapshot of a save in progress
+    size_t loaded_length;     // Length when it was read from the extent source
+    size_t changed_start;     // Once dirty, only [changed_start, changed_end) may differ from
+    size_t changed_end;       // the source; the bytes after it are the source's, shifted by
+                              // the difference between the length and loaded_length
+} DocPage;
+
+/**
+ * @struct DocSnapshotSpan
+ * @brief A run of bytes of a save snapshot.
+ *
+ * Bytes of resident pages are referenced in place. If the editor has to change
+ * such a page before the writer got to it, the bytes are copied out first and
+ * text points at the copy. state hands each span over between the two threads.
+ */
+typedef struct {
+    const char *text;      // Bytes in RAM, or NULL if they are read from source
+    ExtentSource source;   // File holding the bytes when text is NULL
+    size_t offset;         // Offset in that file
+    size_t length;
+    int page;              // Page that text points into, or -1
+    char *copy;            // Bytes copied out of the page, owned by the span
+    atomic_int state;
+} DocSnapshotSpan;
+
+/**
+ * @struct DocPatchRun
+ * @brief A run of whole storage blocks of the document file that a save changes.
+ */
+typedef struct {
+    size_t start;    // File offset, a multiple of HAL_STORAGE_BLOCK_SIZE
+    size_t length;   // Up to the end of the document at most
+} DocPatchRun;
+
+/**
+ * @struct DocSnapshot
+ * @brief The content of a document at one instant, for writing it out on another thread.
+ *
+ * Taking a snapshot only lists where the bytes are: stored extents by file
+ * offset, resident pages by pointer. No document text is copied unless the
+ * editor changes a page the writer still has to write.
+ *
+ * A snapshot that differs from the document file in a few blocks only is
+ * saved in place: runs lists those blocks and just they are written, followed
+ * by a truncate to the new length.
+ */
+typedef struct {
+    char tmp_path[PAGED_DOC_PATH_LEN];   // File the snapshot is written to
+    char file_path[PAGED_DOC_PATH_LEN];  // Source of EXTENT_SOURCE_FILE bytes
+    char swap_path[PAGED_DOC_PATH_LEN];  // Source of EXTENT_SOURCE_SWAP bytes
+    DocSnapshotSpan *spans;
+    size_t span_count;
+    size_t length;                       // Total bytes
+    unsigned long revision;              // Document revision it was taken at
+    bool in_place;                       // Patches file_path instead of writing tmp_path
+    DocPatchRun *runs;                   // In place: the blocks to write, in file order
+    size_t run_count;
+    char *patch;                         // Their new bytes, from paged_doc_save_gather
+    size_t patch_length;                 // Sum of the run lengths
+    size_t bytes_written;                // Bytes the writer put on the card
+} DocSnapshot;
+
+/**
+ * @struct DocBlock
+ * @brief One page worth of the document file, read ahead on another thread.
+ */
+typedef struct {
+    size_t start;                        // Document position of the first byte
+    size_t offset;                       // Offset in the document file
+    size_t length;
+    unsigned long saves;                 // Saves completed when it was requested
+    char path[PAGED_DOC_PATH_LEN];
+    char data[PAGED_DOC_PAGE_SIZE];
+} DocBlock;
+
+/**
+ * @struct PagedDocument
+ * @brief A document that keeps only the pages near the viewport in RAM.
+ *
+ * Pages are loaded on demand through hal_storage_read_range. When all slots
+ * are taken the least recently used page is evicted: clean pages are simply
+ * dropped, dirty pages are appended to a swap file next to the document with
+ * hal_storage_write_range. Of a page read from the document file only the
+ * changed range is spilled; the bytes around it are read from the file again. Memory use is therefore bounded by
+ * PAGED_DOC_RESIDENT_PAGES regardless of the file size, and opening a file
+ * only needs its size.
+ */
+typedef struct {
+    char path[PAGED_DOC_PATH_LEN];       // Document file
+    char base_path[PAGED_DOC_PATH_LEN];  // File EXTENT_SOURCE_FILE extents are read from
+    char swap_path[PAGED_DOC_PATH_LEN];  // Spill file for evicted dirty pages
+    size_t swap_length;                  // Bytes used in the swap file
+    DocExtent *extents;                  // Extent table in document order
+    size_t extent_count;
+    size_t extent_capacity;
+    DocPage pages[PAGED_DOC_RESIDENT_PAGES];
+    size_t length;                       // Document length in bytes
+    unsigned long clock;                 // LRU clock
+    unsigned long revision;              // Counts edits
+    unsigned long saves;                 // Counts completed saves
+    DocSnapshot *snapshot;               // Save in progress, or NULL
+    bool modified;                       // Unsaved changes exist
+} PagedDocument;
+
+/**
+ * @brief Opens a document without reading its content.
+ *
+ * A missing file opens as an empty document that is created on the first save.
+ * Any document previously open in doc must have been closed.
+ *
+ * @return true on success, false if the path is too long.
+ */
+bool paged_doc_open(PagedDocument *doc, const char *path);
+
+/**
+ * @brief Releases all pages and removes the swap file. Unsaved changes are lost.
+ *
+ * A save in progress must have been ended with paged_doc_save_end.
+ */
+void paged_doc_close(PagedDocument *doc);
+
+/**
+ * @brief Returns the document length in bytes.
+ */
+size_t paged_doc_length(const PagedDocument *doc);
+
+/**
+ * @brief Returns true if the document has changes that were not saved.
+ */
+bool paged_doc_is_modified(const PagedDocument *doc);
+
+/**
+ * @brief Inserts length bytes at document position pos.
+ *
+ * @return true on success, false on allocation or storage failure.
+ */
+bool paged_doc_insert(PagedDocument *doc, size_t pos, const char *text, size_t length);
+
+/**
+ * @brief Deletes up to length bytes starting at document position pos.
+ *
+ * Whole extents that are not resident are dropped without reading them.
+ *
+ * @return The number of bytes deleted.
+ */
+size_t paged_doc_delete(PagedDocument *doc, size_t pos, size_t length);
+
+/**
+ * @brief Copies up to length bytes starting at pos into out, loading pages as needed.
+ *
+ * @return The number of bytes copied. out is not null-terminated.
+ */
+size_t paged_doc_read(PagedDocument *doc, size_t pos, char *out, size_t length);
+
+/**
+ * @brief Returns the byte at pos, or '\0' if pos is past the end.
+ */
+char paged_doc_char_at(PagedDocument *doc, size_t pos);
+
+/**
+ * @brief Returns the start of the line containing pos.
+ *
+ * Uses the page line indexes and skips extents known to hold no newline, so
+ * the cost depends on the distance to the previous newline, not the file size.
+ */
+size_t paged_doc_line_start(PagedDocument *doc, size_t pos);
+
+/**
+ * @brief Returns the position of the '\n' ending the line containing pos,
+ * or the document length for the last line.
+ */
+size_t paged_doc_line_end(PagedDocument *doc, size_t pos);
+
+/**
+ * @brief Starts a save by taking a snapshot of the document.
+ *
+ * Only the extent table is walked; the resident pages it references are
+ * frozen until paged_doc_save_end and copied out only if they are edited
+ * before paged_doc_save_write got to them. Editing may go on meanwhile.
+ *
+ * With allow_in_place the changed byte ranges of the pages are mapped to
+ * storage blocks. If every unchanged byte is still at its offset in the file
+ * and less than half of the document changed, the snapshot is saved in place.
+ * This is the case after edits that keep the length, and after appending.
+ * An in-place save is not atomic: the caller must first make the patch
+ * recoverable, for instance by journaling the bytes from paged_doc_save_gather.
+ *
+ * @return true on success, false if a save is already in progress or memory ran out.
+ */
+bool paged_doc_save_begin(PagedDocument *doc, DocSnapshot *snapshot, bool allow_in_place);
+
+/**
+ * @brief Copies the new bytes of the runs of an in-place snapshot into snapshot->patch.
+ *
+ * May run on another thread, like paged_doc_save_write, and must be called
+ * before it since the file is read where it is not patched yet.
+ *
+ * @return true on success, false if memory ran out or a file could not be read.
+ */
+bool paged_doc_save_gather(DocSnapshot *snapshot);
+
+/**
+ * @brief Writes a snapshot to its temporary file, or patches the document file in place.
+ *
+ * May run on another thread than the one editing the document. It only reads
+ * the files the snapshot refers to, which stay in place until paged_doc_save_end.
+ * In-place writes only touch blocks whose bytes are not read from the file.
+ * snapshot->bytes_written counts what was written.
+ *
+ * @return true on success, false if the file could not be written.
+ */
+bool paged_doc_save_write(DocSnapshot *snapshot);
+
+/**
+ * @brief Finishes a save on the editing thread and releases the snapshot.
+ *
+ * If the snapshot was written, the temporary file replaces the document by
+ * rename (in-place saves have nothing to rename). When the document was not
+ * edited since the snapshot, its pages become clean and it is no longer
+ * modified. Otherwise it stays modified and keeps reading unchanged text from
+ * the previous file, which is kept aside as its SIDE_FILE_OLD side file until
+ * the next save or close.
+ *
+ * @param written Result of paged_doc_save_write.
+ * @return true if the file now holds the snapshot, false otherwise.
+ */
+bool paged_doc_save_end(PagedDocument *doc, DocSnapshot *snapshot, bool written);
+
+/**
+ * @brief Writes the document to its file.
+ *
+ * The content is streamed into a temporary file which then replaces the
+ * original by rename, so a failed save leaves the old file intact. Resident
+ * pages stay loaded and become clean. This is paged_doc_save_begin,
+ * paged_doc_save_write and paged_doc_save_end in one call, never in place.
+ *
+ * @return true on success, false otherwise.
+ */
+bool paged_doc_save(PagedDocument *doc);
+
+/**
+ * @brief Describes the block of the document file that reading pos would load.
+ *
+ * @return true if the block has to be read, false if pos is resident or not
+ *         backed by the document file.
+ */
+bool paged_doc_block_request(const PagedDocument *doc, size_t pos, DocBlock *block);
+
+/**
+ * @brief Reads a requested block. May run on another thread.
+ *
+ * @return true on success, false if the file could not be read.
+ */
+bool paged_doc_block_read(DocBlock *block);
+
+/**
+ * @brief Makes a block that was read ahead resident, as if it had been loaded on demand.
+ *
+ * The block is dropped if the document changed so that it no longer maps
+ * onto the same bytes, for instance because that part was loaded meanwhile.
+ *
+ * @return true if the block was used.
+ */
+bool paged_doc_block_fill(PagedDocument *doc, const DocBlock *block);
+
+#endif // PAGED_DOCUMENT_H
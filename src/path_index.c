@@ -0,0 +1,752 @@
+// path_index.c
+
+#include "path_index.h"
+#include "hal_interface.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_NODES 256
+#define INITIAL_NAMES 4096
+#define BUILD_CHUNK 32           // Entries listed per storage call while building
+#define MAX_DEPTH 64             // Deepest path rebuilt for matching
+#define PATH_BUFFER_LEN 512
+#define BEST_MAX 64              // Most results path_query_best ranks
+
+// Saved index: a header, the nodes, the stamp of the root and of every folder
+// in node order, the name pool and a CRC-32 of everything before it. Numbers
+// are little endian.
+#define FILE_MAGIC "CTP1"
+#define FILE_HEADER_SIZE 20      // Magic, node count, name pool size, first root, folder count
+#define FILE_NODE_SIZE 17        // parent, first_child, next_sibling, name, type
+#define FILE_STAMP_SIZE 8
+#define NODE_REMOVED 0xFF        // Type of a node dropped while loading, until the index is packed
+
+// Score of each matched character, and the bonuses on top of it
+#define SCORE_MATCH 1
+#define SCORE_ADJACENT 4         // Follows the previous matched character
+#define SCORE_BOUNDARY 3         // First character of a component or word
+#define SCORE_IN_NAME 2          // Inside the entry's own name rather than a parent folder
+
+// -----------------------------------------------------------------------------
+/* Storage */
+// -----------------------------------------------------------------------------
+
+static bool reserve_nodes(PathIndex *index, size_t needed) {
+    if (needed <= index->capacity) {
+        return true;
+    }
+    size_t new_capacity = index->capacity ? index->capacity : INITIAL_NODES;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    PathNode *grown = realloc(index->nodes, new_capacity * sizeof(PathNode));
+    if (!grown) {
+        return false;
+    }
+    index->nodes = grown;
+    index->capacity = new_capacity;
+    return true;
+}
+
+static bool reserve_names(PathIndex *index, size_t needed) {
+    if (needed <= index->names_capacity) {
+        return true;
+    }
+    size_t new_capacity = index->names_capacity ? index->names_capacity : INITIAL_NAMES;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    char *grown = realloc(index->names, new_capacity);
+    if (!grown) {
+        return false;
+    }
+    index->names = grown;
+    index->names_capacity = new_capacity;
+    return true;
+}
+
+// Copies name into the pool; returns its offset, or UINT32_MAX if the pool could not grow.
+static uint32_t store_name(PathIndex *index, const char *name, size_t length) {
+    size_t needed = index->names_used + length + 1;
+    if (!reserve_names(index, needed)) {
+        return UINT32_MAX;
+    }
+    uint32_t offset = (uint32_t)index->names_used;
+    memcpy(index->names + offset, name, length);
+    index->names[offset + length] = '\0';
+    index->names_used = needed;
+    return offset;
+}
+
+static uint32_t *child_list(PathIndex *index, uint32_t parent) {
+    return parent == PATH_INDEX_NONE ? &index->first_root : &index->nodes[parent].first_child;
+}
+
+static void link_child(PathIndex *index, uint32_t parent, uint32_t node) {
+    uint32_t *head = child_list(index, parent);
+    index->nodes[node].parent = parent;
+    index->nodes[node].next_sibling = *head;
+    *head = node;
+}
+
+static void unlink_child(PathIndex *index, uint32_t node) {
+    uint32_t *link = child_list(index, index->nodes[node].parent);
+    while (*link != PATH_INDEX_NONE) {
+        if (*link == node) {
+            *link = index->nodes[node].next_sibling;
+            return;
+        }
+        link = &index->nodes[*link].next_sibling;
+    }
+}
+
+static uint32_t add_child(PathIndex *index, uint32_t parent, const char *name, size_t length, uint8_t type) {
+    if (index->count >= PATH_INDEX_NONE || !reserve_nodes(index, index->count + 1)) {
+        return PATH_INDEX_NONE;
+    }
+    uint32_t name_offset = store_name(index, name, length);
+    if (name_offset == UINT32_MAX) {
+        return PATH_INDEX_NONE;
+    }
+    uint32_t node = (uint32_t)index->count++;
+    index->nodes[node].first_child = PATH_INDEX_NONE;
+    index->nodes[node].name = name_offset;
+    index->nodes[node].type = type;
+    link_child(index, parent, node);
+    return node;
+}
+
+// -----------------------------------------------------------------------------
+/* Path Resolution */
+// -----------------------------------------------------------------------------
+
+static uint32_t find_child(const PathIndex *index, uint32_t parent, const char *name, size_t length) {
+    uint32_t node = parent == PATH_INDEX_NONE ? index->first_root : index->nodes[parent].first_child;
+    while (node != PATH_INDEX_NONE) {
+        const char *candidate = index->names + index->nodes[node].name;
+        if (strncmp(candidate, name, length) == 0 && candidate[length] == '\0') {
+            return node;
+        }
+        node = index->nodes[node].next_sibling;
+    }
+    return PATH_INDEX_NONE;
+}
+
+// Resolves the folder holding the last component of path and returns that
+// component. Empty components ("//") are skipped, as the explorer produces them
+// below the root. *parent is PATH_INDEX_NONE for the root; false if a folder
+// on the way is not indexed or the path has no last component.
+static bool resolve_parent(const PathIndex *index, const char *path, uint32_t *parent,
+                           const char **name, size_t *length) {
+    uint32_t folder = PATH_INDEX_NONE;
+    const char *component = path;
+    for (;;) {
+        while (*component == '/') {
+            component++;
+        }
+        const char *end = strchr(component, '/');
+        size_t component_length = end ? (size_t)(end - component) : strlen(component);
+        const char *rest = component + component_length;
+        while (*rest == '/') {
+            rest++;
+        }
+        if (*rest == '\0') {
+            *parent = folder;
+            *name = component;
+            *length = component_length;
+            return component_length > 0;
+        }
+        folder = find_child(index, folder, component, component_length);
+        if (folder == PATH_INDEX_NONE) {
+            return false;
+        }
+        component = rest;
+    }
+}
+
+// True if name in folder parent is the hidden entry.
+static bool is_hidden(const PathIndex *index, uint32_t parent, const char *name, size_t length) {
+    uint32_t hidden_parent;
+    const char *hidden_name;
+    size_t hidden_length;
+    return index->hidden && resolve_parent(index, index->hidden, &hidden_parent, &hidden_name, &hidden_length) &&
+           hidden_parent == parent && hidden_length == length && strncmp(hidden_name, name, length) == 0;
+}
+
+static uint32_t resolve(const PathIndex *index, const char *path) {
+    uint32_t parent;
+    const char *name;
+    size_t length;
+    if (!resolve_parent(index, path, &parent, &name, &length)) {
+        return PATH_INDEX_NONE;
+    }
+    return find_child(index, parent, name, length);
+}
+
+// -----------------------------------------------------------------------------
+/* Matching */
+// -----------------------------------------------------------------------------
+
+// Writes the path of node without the leading '/' and returns its length;
+// *name_start receives where the node's own name begins.
+static size_t build_match_path(const PathIndex *index, uint32_t node, char *out, size_t size,
+                               size_t *name_start) {
+    uint32_t chain[MAX_DEPTH];
+    size_t depth = 0;
+    for (uint32_t n = node; n != PATH_INDEX_NONE && depth < MAX_DEPTH; n = index->nodes[n].parent) {
+        chain[depth++] = n;
+    }
+
+    size_t length = 0;
+    *name_start = 0;
+    while (depth > 0) {
+        const char *name = index->names + index->nodes[chain[--depth]].name;
+        if (length > 0 && length < size - 1) {
+            out[length++] = '/';
+        }
+        *name_start = length;
+        size_t name_length = strlen(name);
+        if (name_length > size - 1 - length) {
+            name_length = size - 1 - length;
+        }
+        memcpy(out + length, name, name_length);
+        length += name_length;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+static bool is_boundary(char c) {
+    return c == '/' || c == ' ' || c == '_' || c == '-' || c == '.';
+}
+
+// Matches the query as a case-insensitive subsequence of the node's path.
+// Returns the score of the leftmost match, or -1 if there is none.
+static int32_t score_node(const PathIndex *index, uint32_t node, const char *query, size_t query_length) {
+    char path[PATH_BUFFER_LEN];
+    size_t name_start;
+    size_t length = build_match_path(index, node, path, sizeof(path), &name_start);
+
+    int32_t score = 0;
+    size_t q = 0;
+    bool previous_matched = false;
+    for (size_t i = 0; i < length && q < query_length; i++) {
+        if (tolower((unsigned char)path[i]) != tolower((unsigned char)query[q])) {
+            previous_matched = false;
+            continue;
+        }
+        score += SCORE_MATCH;
+        if (previous_matched) {
+            score += SCORE_ADJACENT;
+        }
+        if (i == 0 || is_boundary(path[i - 1])) {
+            score += SCORE_BOUNDARY;
+        }
+        if (i >= name_start) {
+            score += SCORE_IN_NAME;
+        }
+        previous_matched = true;
+        q++;
+    }
+    return q == query_length ? score : -1;
+}
+
+// Scores the first count candidates against the query and moves the matches to
+// the front, keeping their order. Returns the number of matches.
+static size_t filter_candidates(PathQuery *query, const PathIndex *index, size_t count) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t node = query->candidates[i];
+        int32_t score = score_node(index, node, query->text, query->length);
+        if (score < 0) {
+            continue;
+        }
+        // The rejected node moves to i, which stays within the previous level
+        query->candidates[i] = query->candidates[kept];
+        query->candidates[kept] = node;
+        query->scores[kept] = score;
+        kept++;
+    }
+    return kept;
+}
+
+// -----------------------------------------------------------------------------
+/* Listing */
+// -----------------------------------------------------------------------------
+
+// Adds every entry of folder as a child of parent, one chunk at a time.
+static bool list_folder(PathIndex *index, uint32_t parent, const char *folder) {
+    DirEntry chunk[BUILD_CHUNK];
+    size_t start = 0;
+    size_t got;
+    while ((got = hal_storage_list_entries(folder, start, chunk, BUILD_CHUNK)) > 0) {
+        for (size_t i = 0; i < got; i++) {
+            size_t length = strlen(chunk[i].name);
+            if (is_hidden(index, parent, chunk[i].name, length)) {
+                continue; // Nothing below it is listed either
+            }
+            if (add_child(index, parent, chunk[i].name, length, chunk[i].type) == PATH_INDEX_NONE) {
+                return false;
+            }
+        }
+        start += got;
+        if (got < BUILD_CHUNK) {
+            break;
+        }
+    }
+    return true;
+}
+
+// Lists the folders from node first on. Nodes are appended as they are found,
+// so walking them in order is breadth first and reaches the new ones too.
+static bool list_new_folders(PathIndex *index, size_t first) {
+    char folder[PATH_BUFFER_LEN];
+    for (size_t node = first; node < index->count; node++) {
+        if (index->nodes[node].type != DIR_ENTRY_DIRECTORY) {
+            continue;
+        }
+        path_index_path(index, (uint32_t)node, folder, sizeof(folder));
+        if (!list_folder(index, (uint32_t)node, folder)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Marks node and everything below it as removed. It stays linked below its folder.
+static void remove_subtree(PathIndex *index, uint32_t node) {
+    index->nodes[node].type = NODE_REMOVED;
+    for (uint32_t child = index->nodes[node].first_child; child != PATH_INDEX_NONE;
+         child = index->nodes[child].next_sibling) {
+        remove_subtree(index, child);
+    }
+}
+
+// Lists a folder whose stamp changed and brings its children up to date:
+// entries still there keep their node, new ones are added and the children
+// of the first loaded nodes that were not listed again are removed. seen
+// flags those loaded nodes.
+static bool refresh_folder(PathIndex *index, uint32_t parent, const char *folder, uint8_t *seen, size_t loaded) {
+    DirEntry chunk[BUILD_CHUNK];
+    size_t start = 0;
+    size_t got;
+    while ((got = hal_storage_list_entries(folder, start, chunk, BUILD_CHUNK)) > 0) {
+        for (size_t i = 0; i < got; i++) {
+            size_t length = strlen(chunk[i].name);
+            if (is_hidden(index, parent, chunk[i].name, length)) {
+                continue;
+            }
+            uint32_t node = find_child(index, parent, chunk[i].name, length);
+            if (node != PATH_INDEX_NONE && node < loaded && index->nodes[node].type == chunk[i].type) {
+                seen[node] = 1;
+            } else if (add_child(index, parent, chunk[i].name, length, chunk[i].type) == PATH_INDEX_NONE) {
+                return false;
+            }
+        }
+        start += got;
+        if (got < BUILD_CHUNK) {
+            break;
+        }
+    }
+
+    uint32_t *link = child_list(index, parent);
+    while (*link != PATH_INDEX_NONE) {
+        uint32_t node = *link;
+        if (node < loaded && !seen[node]) {
+            *link = index->nodes[node].next_sibling;
+            remove_subtree(index, node);
+        } else {
+            link = &index->nodes[node].next_sibling;
+        }
+    }
+    return true;
+}
+
+// Drops the removed nodes and the names no node uses any more. The others
+// keep their order, so node numbers only shift down.
+static bool pack(PathIndex *index) {
+    uint32_t *renumbered = malloc((index->count ? index->count : 1) * sizeof(uint32_t));
+    char *names = malloc(index->names_capacity ? index->names_capacity : 1);
+    if (!renumbered || !names) {
+        free(renumbered);
+        free(names);
+        return false;
+    }
+    size_t live = 0;
+    for (size_t i = 0; i < index->count; i++) {
+        renumbered[i] = index->nodes[i].type == NODE_REMOVED ? PATH_INDEX_NONE : (uint32_t)live++;
+    }
+
+    size_t names_used = 0;
+    for (size_t i = 0; i < index->count; i++) {
+        if (renumbered[i] == PATH_INDEX_NONE) {
+            continue;
+        }
+        PathNode node = index->nodes[i];
+        const char *name = index->names + node.name;
+        size_t length = strlen(name) + 1;
+        memcpy(names + names_used, name, length);
+        node.name = (uint32_t)names_used;
+        names_used += length;
+        node.parent = node.parent == PATH_INDEX_NONE ? PATH_INDEX_NONE : renumbered[node.parent];
+        node.first_child = node.first_child == PATH_INDEX_NONE ? PATH_INDEX_NONE : renumbered[node.first_child];
+        node.next_sibling = node.next_sibling == PATH_INDEX_NONE ? PATH_INDEX_NONE : renumbered[node.next_sibling];
+        index->nodes[renumbered[i]] = node;
+    }
+    index->first_root = index->first_root == PATH_INDEX_NONE ? PATH_INDEX_NONE : renumbered[index->first_root];
+    index->count = live;
+    free(index->names);
+    index->names = names;
+    index->names_used = names_used;
+    free(renumbered);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+/* Saved Index */
+// -----------------------------------------------------------------------------
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t length) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+// True if link is a node number of a saved index of count nodes, or PATH_INDEX_NONE.
+static bool valid_link(uint32_t link, size_t count) {
+    return link == PATH_INDEX_NONE || link < count;
+}
+
+// Takes the nodes and names of a saved index whose CRC matched.
+static bool decode_nodes(PathIndex *index, const uint8_t *data, size_t count, size_t names_used) {
+    const uint8_t *in = data + FILE_HEADER_SIZE;
+    size_t folders = get_u32(data + 16);
+    const uint8_t *names = in + count * FILE_NODE_SIZE + folders * FILE_STAMP_SIZE;
+    if ((names_used > 0 && names[names_used - 1] != '\0') || !reserve_nodes(index, count) ||
+        !reserve_names(index, names_used)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        PathNode *node = &index->nodes[i];
+        node->parent = get_u32(in);
+        node->first_child = get_u32(in + 4);
+        node->next_sibling = get_u32(in + 8);
+        node->name = get_u32(in + 12);
+        node->type = in[16];
+        if (!valid_link(node->parent, count) || !valid_link(node->first_child, count) ||
+            !valid_link(node->next_sibling, count) || node->name >= names_used ||
+            (node->type != DIR_ENTRY_FILE && node->type != DIR_ENTRY_DIRECTORY)) {
+            return false;
+        }
+        folders -= node->type == DIR_ENTRY_DIRECTORY;
+        in += FILE_NODE_SIZE;
+    }
+    memcpy(index->names, names, names_used);
+    index->names_used = names_used;
+    index->count = count;
+    index->first_root = get_u32(data + 12);
+    return folders == 1 && valid_link(index->first_root, count); // The root has a stamp too
+}
+
+// Compares the stamp of the root and of every loaded folder with the saved
+// one and refreshes the folders that changed. Folders found meanwhile are
+// listed in full.
+static bool refresh_changed(PathIndex *index, const uint8_t *data, bool *changed) {
+    size_t loaded = index->count;
+    const uint8_t *types = data + FILE_HEADER_SIZE + 16;
+    const uint8_t *stamps = data + FILE_HEADER_SIZE + loaded * FILE_NODE_SIZE;
+    uint8_t *seen = calloc(loaded ? loaded : 1, 1);
+    if (!seen) {
+        return false;
+    }
+    bool ok = true;
+    char folder[PATH_BUFFER_LEN];
+    for (size_t next = 0; next <= loaded && ok; next++) {
+        // Stamps follow the saved types, even of folders removed meanwhile
+        uint32_t parent = next == 0 ? PATH_INDEX_NONE : (uint32_t)(next - 1);
+        if (next > 0 && types[(next - 1) * FILE_NODE_SIZE] != DIR_ENTRY_DIRECTORY) {
+            continue;
+        }
+        uint64_t saved = get_u32(stamps) | (uint64_t)get_u32(stamps + 4) << 32;
+        stamps += FILE_STAMP_SIZE;
+        if (next > 0 && index->nodes[parent].type == NODE_REMOVED) {
+            continue;
+        }
+        if (next == 0) {
+            strcpy(folder, "/");
+        } else {
+            path_index_path(index, parent, folder, sizeof(folder));
+        }
+        uint64_t stamp;
+        if (!hal_storage_dir_stamp(folder, &stamp) || stamp != saved) {
+            *changed = true;
+            ok = refresh_folder(index, parent, folder, seen, loaded);
+        }
+    }
+    free(seen);
+    return ok && list_new_folders(index, loaded) && (!*changed || pack(index));
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void path_index_init(PathIndex *index) {
+    memset(index, 0, sizeof(*index));
+    index->first_root = PATH_INDEX_NONE;
+}
+
+void path_index_free(PathIndex *index) {
+    free(index->nodes);
+    free(index->names);
+    path_index_init(index);
+}
+
+void path_index_hide(PathIndex *index, const char *path) {
+    index->hidden = path;
+}
+
+bool path_index_build(PathIndex *index, const char *root) {
+    index->count = 0;
+    index->names_used = 0;
+    index->first_root = PATH_INDEX_NONE;
+    return list_folder(index, PATH_INDEX_NONE, root) && list_new_folders(index, 0);
+}
+
+bool path_index_save(const PathIndex *index, const char *file) {
+    size_t folders = 1;
+    for (size_t i = 0; i < index->count; i++) {
+        folders += index->nodes[i].type == DIR_ENTRY_DIRECTORY;
+    }
+    size_t size = FILE_HEADER_SIZE + index->count * FILE_NODE_SIZE + folders * FILE_STAMP_SIZE +
+                  index->names_used + 4;
+    uint8_t *data = malloc(size);
+    if (!data) {
+        return false;
+    }
+    memcpy(data, FILE_MAGIC, 4);
+    put_u32(data + 4, (uint32_t)index->count);
+    put_u32(data + 8, (uint32_t)index->names_used);
+    put_u32(data + 12, index->first_root);
+    put_u32(data + 16, (uint32_t)folders);
+
+    uint8_t *out = data + FILE_HEADER_SIZE;
+    for (size_t i = 0; i < index->count; i++) {
+        const PathNode *node = &index->nodes[i];
+        put_u32(out, node->parent);
+        put_u32(out + 4, node->first_child);
+        put_u32(out + 8, node->next_sibling);
+        put_u32(out + 12, node->name);
+        out[16] = node->type;
+        out += FILE_NODE_SIZE;
+    }
+
+    // A folder whose stamp cannot be taken would never validate
+    bool ok = true;
+    char folder[PATH_BUFFER_LEN];
+    for (size_t next = 0; next <= index->count && ok; next++) {
+        if (next == 0) {
+            strcpy(folder, "/");
+        } else if (index->nodes[next - 1].type == DIR_ENTRY_DIRECTORY) {
+            path_index_path(index, (uint32_t)(next - 1), folder, sizeof(folder));
+        } else {
+            continue;
+        }
+        uint64_t stamp = 0;
+        ok = hal_storage_dir_stamp(folder, &stamp);
+        put_u32(out, (uint32_t)stamp);
+        put_u32(out + 4, (uint32_t)(stamp >> 32));
+        out += FILE_STAMP_SIZE;
+    }
+    memcpy(out, index->names, index->names_used);
+    out += index->names_used;
+    put_u32(out, crc32(data, (size_t)(out - data)));
+
+    ok = ok && hal_storage_write_file(file, (const char *)data, size);
+    free(data);
+    return ok;
+}
+
+bool path_index_load(PathIndex *index, const char *file, bool *changed) {
+    *changed = false;
+    long size = hal_storage_file_size(file);
+    if (size < FILE_HEADER_SIZE + 4) {
+        return false;
+    }
+    uint8_t *data = malloc((size_t)size);
+    if (!data) {
+        return false;
+    }
+    bool ok = hal_storage_read_range(file, 0, (char *)data, (size_t)size) == (int)size &&
+              memcmp(data, FILE_MAGIC, 4) == 0 && get_u32(data + size - 4) == crc32(data, (size_t)size - 4);
+    if (ok) {
+        size_t count = get_u32(data + 4);
+        size_t names_used = get_u32(data + 8);
+        size_t folders = get_u32(data + 16);
+        ok = (size_t)size == FILE_HEADER_SIZE + count * FILE_NODE_SIZE + folders * FILE_STAMP_SIZE + names_used + 4 &&
+             decode_nodes(index, data, count, names_used) && refresh_changed(index, data, changed);
+    }
+    free(data);
+    if (!ok) {
+        index->count = 0;
+        index->names_used = 0;
+        index->first_root = PATH_INDEX_NONE;
+    }
+    return ok;
+}
+
+bool path_index_add(PathIndex *index, const char *path, uint8_t type) {
+    uint32_t parent;
+    const char *name;
+    size_t length;
+    if (!resolve_parent(index, path, &parent, &name, &length)) {
+        return false;
+    }
+    if (find_child(index, parent, name, length) != PATH_INDEX_NONE || is_hidden(index, parent, name, length)) {
+        return true; // Already indexed, or never
+    }
+    return add_child(index, parent, name, length, type) != PATH_INDEX_NONE;
+}
+
+bool path_index_rename(PathIndex *index, const char *old_path, const char *new_path) {
+    uint32_t node = resolve(index, old_path);
+    uint32_t parent;
+    const char *name;
+    size_t length;
+    if (node == PATH_INDEX_NONE || !resolve_parent(index, new_path, &parent, &name, &length) ||
+        is_hidden(index, parent, name, length)) {
+        return false;
+    }
+    // A folder cannot move into itself
+    for (uint32_t n = parent; n != PATH_INDEX_NONE; n = index->nodes[n].parent) {
+        if (n == node) {
+            return false;
+        }
+    }
+
+    uint32_t name_offset = store_name(index, name, length);
+    if (name_offset == UINT32_MAX) {
+        return false;
+    }
+    unlink_child(index, node);
+    index->nodes[node].name = name_offset;
+    link_child(index, parent, node);
+    return true;
+}
+
+size_t path_index_path(const PathIndex *index, uint32_t node, char *out, size_t size) {
+    if (size < 2) {
+        if (size == 1) {
+            out[0] = '\0';
+        }
+        return 0;
+    }
+    size_t name_start;
+    out[0] = '/';
+    return 1 + build_match_path(index, node, out + 1, size - 1, &name_start);
+}
+
+bool path_query_reset(PathQuery *query, const PathIndex *index) {
+    if (query->capacity < index->count) {
+        size_t capacity = index->count;
+        uint32_t *candidates = realloc(query->candidates, capacity * sizeof(uint32_t));
+        if (!candidates) {
+            return false;
+        }
+        query->candidates = candidates;
+        int32_t *scores = realloc(query->scores, capacity * sizeof(int32_t));
+        if (!scores) {
+            return false;
+        }
+        query->scores = scores;
+        query->capacity = capacity;
+    }
+    for (size_t i = 0; i < index->count; i++) {
+        query->candidates[i] = (uint32_t)i;
+    }
+    query->counts[0] = index->count;
+    query->length = 0;
+    query->text[0] = '\0';
+    return true;
+}
+
+void path_query_free(PathQuery *query) {
+    free(query->candidates);
+    free(query->scores);
+    memset(query, 0, sizeof(*query));
+}
+
+bool path_query_push(PathQuery *query, const PathIndex *index, char c) {
+    if (query->length >= PATH_QUERY_MAX) {
+        return false;
+    }
+    query->text[query->length++] = c;
+    query->text[query->length] = '\0';
+    // Only the candidates that matched the shorter query can match this one
+    query->counts[query->length] = filter_candidates(query, index, query->counts[query->length - 1]);
+    return true;
+}
+
+void path_query_pop(PathQuery *query, const PathIndex *index) {
+    if (query->length == 0) {
+        return;
+    }
+    query->text[--query->length] = '\0';
+    if (query->length > 0) {
+        // Same set as before the last push, but the scores are for the shorter query
+        filter_candidates(query, index, query->counts[query->length]);
+    }
+}
+
+size_t path_query_match_count(const PathQuery *query) {
+    return query->length > 0 ? query->counts[query->length] : 0;
+}
+
+size_t path_query_best(const PathQuery *query, uint32_t *best, size_t max) {
+    int32_t best_scores[BEST_MAX];
+    size_t found = 0;
+    size_t matches = path_query_match_count(query);
+    if (max > BEST_MAX) {
+        max = BEST_MAX;
+    }
+    if (max == 0) {
+        return 0;
+    }
+
+    // Insertion into a short sorted list; a candidate below the last place is rejected at once
+    for (size_t i = 0; i < matches; i++) {
+        int32_t score = query->scores[i];
+        uint32_t node = query->candidates[i];
+        if (found == max && (score < best_scores[max - 1] ||
+                             (score == best_scores[max - 1] && node > best[max - 1]))) {
+            continue;
+        }
+        size_t pos = found < max ? found++ : max - 1;
+        while (pos > 0 && (best_scores[pos - 1] < score ||
+                           (best_scores[pos - 1] == score && best[pos - 1] > node))) {
+            best_scores[pos] = best_scores[pos - 1];
+            best[pos] = best[pos - 1];
+            pos--;
+        }
+        best_scores[pos] = score;
+        best[pos] = node;
+    }
+    return found;
+}
@@ -0,0 +1,190 @@
+#ifndef PATH_INDEX_H
+#define PATH_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PATH_INDEX_NONE UINT32_MAX   // No node: the parent of top level entries, end of a child list
+#define PATH_QUERY_MAX 64            // Longest query, in characters
+
+/**
+ * @struct PathNode
+ * @brief One file or folder of the index.
+ *
+ * Only the entry's own name is stored; its full path is rebuilt by following
+ * the parent links, so renaming a folder is a single update however much is
+ * below it.
+ */
+typedef struct {
+    uint32_t parent;        // Containing folder, PATH_INDEX_NONE at the root
+    uint32_t first_child;   // Children of a folder, linked through next_sibling
+    uint32_t next_sibling;
+    uint32_t name;          // Offset of the name in the name pool
+    uint8_t type;           // DirEntryType
+} PathNode;
+
+/**
+ * @struct PathIndex
+ * @brief Every path below the storage root, for type-ahead search.
+ *
+ * Nodes are appended in the order they are found and never move, so a node
+ * number stays valid for the lifetime of the index. Names live in one pool of
+ * NUL-terminated strings; a rename appends the new name and leaves the old one
+ * unused.
+ */
+typedef struct {
+    PathNode *nodes;
+    size_t count;
+    size_t capacity;
+    char *names;            // Name pool
+    size_t names_used;
+    size_t names_capacity;
+    uint32_t first_root;    // First top level entry
+    const char *hidden;     // Path left out of the index with everything below it, or NULL
+} PathIndex;
+
+/**
+ * @struct PathQuery
+ * @brief Incremental fuzzy search over a PathIndex.
+ *
+ * candidates holds every node number. Each typed character filters the
+ * candidates that matched the query so far, moving the ones that still match
+ * to the front; counts[n] is the number of candidates that match the first n
+ * characters. Removing the last character therefore only steps back one
+ * level, and neither direction looks at paths that were already ruled out.
+ */
+typedef struct {
+    uint32_t *candidates;             // Node numbers, best matches first after filtering
+    int32_t *scores;                  // Match score of each candidate for the current query
+    size_t capacity;
+    size_t counts[PATH_QUERY_MAX + 1];
+    char text[PATH_QUERY_MAX + 1];    // The query
+    size_t length;
+} PathQuery;
+
+/**
+ * @brief Sets up an empty index.
+ */
+void path_index_init(PathIndex *index);
+
+/**
+ * @brief Releases the index storage and leaves an empty index.
+ */
+void path_index_free(PathIndex *index);
+
+/**
+ * @brief Leaves path and everything below it out of the index, for files the
+ * application keeps to itself.
+ *
+ * Applies to the following builds, loads and adds; path must stay valid.
+ * Renames onto it fail.
+ */
+void path_index_hide(PathIndex *index, const char *path);
+
+/**
+ * @brief Replaces the index with every file and folder below root.
+ *
+ * Folders are listed breadth first through hal_storage_list_entries, one
+ * chunk at a time, so no listing is ever held in full.
+ *
+ * @return true on success, false if the index could not grow.
+ */
+bool path_index_build(PathIndex *index, const char *root);
+
+/**
+ * @brief Writes the index to file, with the hal_storage_dir_stamp of the root
+ * and of every folder, for path_index_load at the next start.
+ *
+ * The index must have been built from "/" and match the card.
+ *
+ * @return true on success, false if memory ran out, a folder has no stamp or
+ *         the file could not be written.
+ */
+bool path_index_save(const PathIndex *index, const char *file);
+
+/**
+ * @brief Replaces the index with the one saved in file and brings it up to date.
+ *
+ * Only the stamp of each folder is read. A folder whose stamp changed since
+ * the save is listed again: its new entries are added, with everything below
+ * them, and entries that are gone are dropped with everything below them.
+ * Everything else is taken from the file, so the card is not walked.
+ *
+ * @param changed Set to true if a folder had to be listed; the index should then be saved again.
+ * @return true on success, false if the file is missing or damaged or memory
+ *         ran out. The index is then empty and should be built.
+ */
+bool path_index_load(PathIndex *index, const char *file, bool *changed);
+
+/**
+ * @brief Adds a newly created file or folder.
+ *
+ * @param path Full path of the entry; its folder must already be indexed.
+ * @param type DirEntryType of the entry.
+ * @return true on success, false if the folder is unknown or the index could not grow.
+ */
+bool path_index_add(PathIndex *index, const char *path, uint8_t type);
+
+/**
+ * @brief Moves an entry to a new path, taking everything below it along.
+ *
+ * @return true on success, false if either path does not resolve. The caller
+ *         should then rebuild the index.
+ */
+bool path_index_rename(PathIndex *index, const char *old_path, const char *new_path);
+
+/**
+ * @brief Writes the full path of a node, starting with '/', into out.
+ *
+ * @return Length of the path, which is truncated if it does not fit in size.
+ */
+size_t path_index_path(const PathIndex *index, uint32_t node, char *out, size_t size);
+
+/**
+ * @brief Starts a new, empty query over every node of the index.
+ *
+ * Must be called again after the index changes.
+ *
+ * @return true on success, false if the candidate list could not be allocated.
+ */
+bool path_query_reset(PathQuery *query, const PathIndex *index);
+
+/**
+ * @brief Releases the query storage.
+ */
+void path_query_free(PathQuery *query);
+
+/**
+ * @brief Appends a character to the query and narrows the candidates.
+ *
+ * Matching is case-insensitive: the query characters must appear in the path
+ * in order, not necessarily next to each other.
+ *
+ * @return false if the query is already PATH_QUERY_MAX characters long.
+ */
+bool path_query_push(PathQuery *query, const PathIndex *index, char c);
+
+/**
+ * @brief Removes the last character of the query.
+ */
+void path_query_pop(PathQuery *query, const PathIndex *index);
+
+/**
+ * @brief Returns the number of nodes matching the current query.
+ */
+size_t path_query_match_count(const PathQuery *query);
+
+/**
+ * @brief Picks the best matches of the current query.
+ *
+ * Matches score higher when their characters are adjacent, start a path
+ * component or fall in the entry's own name. Equal scores keep index order,
+ * which lists shallower entries first.
+ *
+ * @param best Receives up to max node numbers, best first; at most 64 are ranked.
+ * @return Number of nodes written.
+ */
+size_t path_query_best(const PathQuery *query, uint32_t *best, size_t max);
+
+#endif // PATH_INDEX_H
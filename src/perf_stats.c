@@ -0,0 +1,97 @@
+// perf_stats.c
+
+#include "perf_stats.h"
+
+#ifdef CYBERTYPER_PERF
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+typedef struct {
+    atomic_uint_fast32_t calls;
+    atomic_uint_fast64_t total_us;
+    atomic_uint_fast32_t max_us;
+    atomic_uint_fast64_t bytes;
+} ProbeCounters;
+
+static ProbeCounters probes[PERF_PROBE_COUNT];
+
+static const char *probe_names[PERF_PROBE_COUNT] = {
+    "display_columns",
+    "display_editor_screen",
+    "hal_display_write",
+    "hal_display_flush",
+    "hal_storage_list_*",
+    "hal_storage_read_*",
+    "hal_storage_write_*",
+    "hal_input_*",
+};
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+uint64_t perf_now_us(void) {
+#ifdef ESP_PLATFORM
+    return (uint64_t)esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+// Relaxed atomics: the counters are independent and only read for display
+void perf_record(PerfProbe probe, uint64_t start_us, size_t bytes) {
+    ProbeCounters *counters = &probes[probe];
+    uint64_t elapsed = perf_now_us() - start_us;
+    uint_fast32_t duration = elapsed > UINT32_MAX ? UINT32_MAX : (uint_fast32_t)elapsed;
+
+    atomic_fetch_add_explicit(&counters->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->total_us, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->bytes, bytes, memory_order_relaxed);
+    uint_fast32_t max = atomic_load_explicit(&counters->max_us, memory_order_relaxed);
+    while (duration > max &&
+           !atomic_compare_exchange_weak_explicit(&counters->max_us, &max, duration, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+PerfProbeStats perf_stats_get(PerfProbe probe) {
+    PerfProbeStats stats;
+    stats.calls = (uint32_t)atomic_load_explicit(&probes[probe].calls, memory_order_relaxed);
+    stats.total_us = atomic_load_explicit(&probes[probe].total_us, memory_order_relaxed);
+    stats.max_us = (uint32_t)atomic_load_explicit(&probes[probe].max_us, memory_order_relaxed);
+    stats.bytes = atomic_load_explicit(&probes[probe].bytes, memory_order_relaxed);
+    return stats;
+}
+
+void perf_stats_reset(void) {
+    for (int probe = 0; probe < PERF_PROBE_COUNT; probe++) {
+        atomic_store(&probes[probe].calls, 0);
+        atomic_store(&probes[probe].total_us, 0);
+        atomic_store(&probes[probe].max_us, 0);
+        atomic_store(&probes[probe].bytes, 0);
+    }
+}
+
+int perf_stats_format_header(char *line, size_t size) {
+    return snprintf(line, size, "%-24s %10s %12s %10s %10s %14s", "probe", "calls", "total ms", "avg us", "max us",
+                    "bytes");
+}
+
+int perf_stats_format(PerfProbe probe, char *line, size_t size) {
+    PerfProbeStats stats = perf_stats_get(probe);
+    return snprintf(line, size, "%-24s %10lu %12.1f %10.1f %10lu %14llu", probe_names[probe],
+                    (unsigned long)stats.calls, stats.total_us / 1000.0,
+                    stats.calls ? (double)stats.total_us / stats.calls : 0.0, (unsigned long)stats.max_us,
+                    (unsigned long long)stats.bytes);
+}
+
+#endif // CYBERTYPER_PERF
@@ -0,0 +1,83 @@
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Instrumentation of the hot paths, switched on at compile time with
+// -DCYBERTYPER_PERF. Without it PERF_BEGIN and PERF_END expand to nothing
+// (the byte count is only looked at by sizeof, never evaluated), so the
+// probes cost nothing and perf_stats.c compiles to an empty unit.
+
+#define PERF_DUMP_PATH "/perf_stats.txt"   // Written from the stats overlay
+
+/**
+ * @enum PerfProbe
+ * @brief The instrumented hot paths.
+ */
+typedef enum {
+    PERF_COLUMNS_SCREEN,   // display_columns; bytes are cells sent to the display
+    PERF_EDITOR_SCREEN,    // display_editor_screen; bytes are cells sent to the display
+    PERF_DISPLAY_WRITE,    // hal_display_write
+    PERF_DISPLAY_FLUSH,    // hal_display_flush; bytes are panel bytes where known
+    PERF_STORAGE_LIST,     // hal_storage_list_entries / hal_storage_list_files; bytes are the records returned
+    PERF_STORAGE_READ,     // hal_storage_read_file / hal_storage_read_range
+    PERF_STORAGE_WRITE,    // hal_storage_write_file / hal_storage_write_range
+    PERF_INPUT_READ,       // hal_input_read_keys, which hal_input_get_key goes through
+    PERF_PROBE_COUNT
+} PerfProbe;
+
+/**
+ * @struct PerfProbeStats
+ * @brief What one probe has recorded since startup or the last reset.
+ */
+typedef struct {
+    uint32_t calls;
+    uint64_t total_us;   // Cumulative duration
+    uint32_t max_us;     // Longest single call
+    uint64_t bytes;      // Bytes moved
+} PerfProbeStats;
+
+#ifdef CYBERTYPER_PERF
+#define PERF_BEGIN(span) uint64_t span = perf_now_us()
+#define PERF_END(span, probe, bytes) perf_record((probe), (span), (bytes))
+#else
+#define PERF_BEGIN(span)
+#define PERF_END(span, probe, bytes) ((void)sizeof(bytes))
+#endif
+
+/**
+ * @brief Returns a monotonic microsecond clock (esp_timer on the device).
+ */
+uint64_t perf_now_us(void);
+
+/**
+ * @brief Adds one call that started at start_us and moved bytes.
+ *
+ * Safe to call from any thread; the storage worker records its calls too.
+ */
+void perf_record(PerfProbe probe, uint64_t start_us, size_t bytes);
+
+/**
+ * @brief Returns the counters of a probe.
+ */
+PerfProbeStats perf_stats_get(PerfProbe probe);
+
+/**
+ * @brief Clears every probe.
+ */
+void perf_stats_reset(void);
+
+/**
+ * @brief Formats the column titles of perf_stats_format.
+ */
+int perf_stats_format_header(char *line, size_t size);
+
+/**
+ * @brief Formats one probe as a line of the overlay and the dump file.
+ *
+ * @return The length of the line, as snprintf.
+ */
+int perf_stats_format(PerfProbe probe, char *line, size_t size);
+
+#endif // PERF_STATS_H
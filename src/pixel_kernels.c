@@ -0,0 +1,140 @@
+// pixel_kernels.c
+
+#include "pixel_kernels.h"
+#include <string.h>
+
+#define BLOCK_PIXELS 8   // Pixels per iteration of the fill kernel
+
+// -----------------------------------------------------------------------------
+/* Colours */
+// -----------------------------------------------------------------------------
+
+RenderPixel pixel_from_rgb(uint32_t rgb) {
+    uint16_t value = (uint16_t)(((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) | ((rgb >> 3) & 0x001F));
+    uint8_t bytes[2] = { (uint8_t)(value >> 8), (uint8_t)value };
+    RenderPixel pixel;
+    memcpy(&pixel, bytes, sizeof(pixel));
+    return pixel;
+}
+
+void pixel_shades_init(PixelShades *shades, uint32_t paper, uint32_t ink) {
+    for (unsigned coverage = 0; coverage < 16; coverage++) {
+        uint32_t rgb = 0;
+        for (int shift = 0; shift < 24; shift += 8) {
+            unsigned from = (paper >> shift) & 0xFF;
+            unsigned to = (ink >> shift) & 0xFF;
+            rgb |= (uint32_t)((from * (15 - coverage) + to * coverage + 7) / 15) << shift;
+        }
+        shades->shades[coverage] = pixel_from_rgb(rgb);
+    }
+    for (unsigned pair = 0; pair < 256; pair++) {
+        RenderPixel two[2] = { shades->shades[pair >> 4], shades->shades[pair & 0xF] };
+        memcpy(&shades->pairs[pair], two, sizeof(two));
+    }
+}
+
+// -----------------------------------------------------------------------------
+/* RGB565 to RGB666 */
+// -----------------------------------------------------------------------------
+
+void pixel_convert_rgb666_scalar(uint8_t *out, const RenderPixel *in, size_t count) {
+    const uint8_t *bytes = (const uint8_t *)in;
+    for (size_t i = 0; i < count; i++) {
+        unsigned value = (unsigned)bytes[2 * i] << 8 | bytes[2 * i + 1];
+        unsigned red = value >> 11, green = (value >> 5) & 0x3F, blue = value & 0x1F;
+        out[3 * i] = (uint8_t)((red << 3 | red >> 2) & 0xFC);
+        out[3 * i + 1] = (uint8_t)((green << 2 | green >> 4) & 0xFC);
+        out[3 * i + 2] = (uint8_t)((blue << 3 | blue >> 2) & 0xFC);
+    }
+}
+
+// Each output byte is a shift-and-mask of one or both input bytes:
+//   high = RRRRRGGG, low = GGGBBBBB
+//   R666 = RRRRR R.. (top red bit repeated), G666 = GGGGGG.., B666 = BBBBB B..
+static inline void convert_pixel(uint8_t *restrict out, const uint8_t *restrict in) {
+    uint8_t high = in[0], low = in[1];
+    out[0] = (uint8_t)((high & 0xF8) | ((high >> 5) & 0x04));
+    out[1] = (uint8_t)((high << 5) | ((low >> 3) & 0x1C));
+    out[2] = (uint8_t)((low << 3) | ((low >> 2) & 0x04));
+}
+
+void pixel_convert_rgb666(uint8_t *restrict out, const RenderPixel *restrict in, size_t count) {
+    const uint8_t *restrict bytes = (const uint8_t *)in;
+    size_t i = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Four pixels at a time in one 64-bit word (SWAR): each 16-bit lane holds
+    // high in its low byte and low in its high byte. The three channels are
+    // computed for all lanes at once, then packed into 12 output bytes.
+    for (; i + 4 <= count; i += 4) {
+        uint64_t v;
+        memcpy(&v, bytes + 2 * i, sizeof(v));
+        uint64_t red = (v & 0x00F800F800F800F8u) | ((v >> 5) & 0x0004000400040004u);
+        uint64_t green = ((v << 5) & 0x00E000E000E000E0u) | ((v >> 11) & 0x001C001C001C001Cu);
+        uint64_t blue = ((v >> 5) & 0x00F800F800F800F8u) | ((v >> 10) & 0x0004000400040004u);
+
+        uint64_t red_green = red | green << 8;
+        uint64_t p0 = (red_green & 0xFFFF) | (blue & 0xFF) << 16;
+        uint64_t p1 = ((red_green >> 16) & 0xFFFF) | ((blue >> 16) & 0xFF) << 16;
+        uint64_t p2 = ((red_green >> 32) & 0xFFFF) | ((blue >> 32) & 0xFF) << 16;
+        uint64_t p3 = ((red_green >> 48) & 0xFFFF) | ((blue >> 48) & 0xFF) << 16;
+        uint64_t first = p0 | p1 << 24 | p2 << 48;
+        uint32_t rest = (uint32_t)(p2 >> 16 | p3 << 8);
+        memcpy(out + 3 * i, &first, sizeof(first));
+        memcpy(out + 3 * i + 8, &rest, sizeof(rest));
+    }
+#endif
+    for (; i < count; i++) {
+        convert_pixel(out + 3 * i, bytes + 2 * i);
+    }
+}
+
+// -----------------------------------------------------------------------------
+/* Fill */
+// -----------------------------------------------------------------------------
+
+void pixel_fill_scalar(RenderPixel *out, RenderPixel value, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = value;
+    }
+}
+
+void pixel_fill(RenderPixel *out, RenderPixel value, size_t count) {
+    // Four pixels per 64-bit store
+    uint64_t pattern = value;
+    pattern |= pattern << 16;
+    pattern |= pattern << 32;
+
+    size_t i = 0;
+    for (; i + BLOCK_PIXELS <= count; i += BLOCK_PIXELS) {
+        memcpy(out + i, &pattern, sizeof(pattern));
+        memcpy(out + i + 4, &pattern, sizeof(pattern));
+    }
+    for (; i < count; i++) {
+        out[i] = value;
+    }
+}
+
+// -----------------------------------------------------------------------------
+/* Glyph Expansion */
+// -----------------------------------------------------------------------------
+
+void pixel_expand_4bpp_scalar(RenderPixel *out, const uint32_t *coverage, size_t words, const PixelShades *shades) {
+    for (size_t w = 0; w < words; w++) {
+        for (int x = 0; x < 8; x++) {
+            *out++ = shades->shades[(coverage[w] >> (28 - 4 * x)) & 0xF];
+        }
+    }
+}
+
+void pixel_expand_4bpp(RenderPixel *restrict out, const uint32_t *restrict coverage, size_t words,
+                       const PixelShades *shades) {
+    // Two pixels per lookup and 32-bit store
+    for (size_t w = 0; w < words; w++) {
+        uint32_t bits = coverage[w];
+        memcpy(out, &shades->pairs[bits >> 24], 4);
+        memcpy(out + 2, &shades->pairs[(bits >> 16) & 0xFF], 4);
+        memcpy(out + 4, &shades->pairs[(bits >> 8) & 0xFF], 4);
+        memcpy(out + 6, &shades->pairs[bits & 0xFF], 4);
+        out += 8;
+    }
+}
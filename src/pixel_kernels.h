@@ -0,0 +1,70 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PANEL_BYTES_PER_PIXEL 3   // RGB666 on the wire: R, G, B bytes, six bits each in bits 7..2
+
+/**
+ * @brief One framebuffer pixel: RGB565, high byte first in memory.
+ *
+ * The framebuffer keeps 16 bits per pixel to halve PSRAM traffic; pixels are
+ * widened to the panel's 18-bit layout on their way out.
+ */
+typedef uint16_t RenderPixel;
+
+/**
+ * @struct PixelShades
+ * @brief The 16 blends from paper to ink, for expanding 4-bit glyph coverage.
+ *
+ * pairs holds every combination of two shades, indexed by a byte of two
+ * coverage nibbles (left pixel in the top nibble), so expansion writes two
+ * pixels per lookup.
+ */
+typedef struct {
+    RenderPixel shades[16];
+    uint32_t pairs[256];
+} PixelShades;
+
+// Each kernel has a plain per-pixel reference (*_scalar) that defines its
+// result. The fast versions handle several pixels per step in 32- or 64-bit
+// words (lookups of pixel pairs, wide stores, SWAR bit tricks) without
+// data-dependent branches, and must produce exactly what the reference does.
+
+/**
+ * @brief Packs a 0xRRGGBB colour into a framebuffer pixel.
+ */
+RenderPixel pixel_from_rgb(uint32_t rgb);
+
+/**
+ * @brief Fills shades with the blends between paper and ink (both 0xRRGGBB).
+ */
+void pixel_shades_init(PixelShades *shades, uint32_t paper, uint32_t ink);
+
+/**
+ * @brief Converts count framebuffer pixels to the panel's RGB666 layout.
+ *
+ * out receives count * PANEL_BYTES_PER_PIXEL bytes. Each 5- or 6-bit
+ * component is widened by repeating its top bits, so white stays white.
+ */
+void pixel_convert_rgb666(uint8_t *restrict out, const RenderPixel *restrict in, size_t count);
+void pixel_convert_rgb666_scalar(uint8_t *out, const RenderPixel *in, size_t count);
+
+/**
+ * @brief Sets count pixels to value.
+ */
+void pixel_fill(RenderPixel *out, RenderPixel value, size_t count);
+void pixel_fill_scalar(RenderPixel *out, RenderPixel value, size_t count);
+
+/**
+ * @brief Expands 4-bit coverage into pixels, eight pixels per word.
+ *
+ * Each word of coverage holds eight 4-bit values, leftmost pixel in the top
+ * nibble, as in font_8x16. out receives words * 8 pixels.
+ */
+void pixel_expand_4bpp(RenderPixel *restrict out, const uint32_t *restrict coverage, size_t words,
+                       const PixelShades *shades);
+void pixel_expand_4bpp_scalar(RenderPixel *out, const uint32_t *coverage, size_t words, const PixelShades *shades);
+
+#endif // PIXEL_KERNELS_H
@@ -0,0 +1,42 @@
+// ppm_panel.c
+
+#include "ppm_panel.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ROW_BYTES (TEXT_RENDERER_WIDTH * PANEL_BYTES_PER_PIXEL)
+
+// Panel memory in the RGB666 wire layout
+static uint8_t panel[TEXT_RENDERER_HEIGHT][ROW_BYTES];
+
+void ppm_panel_write(const RenderRect *rect, const uint8_t *data) {
+    size_t length = (size_t)rect->width * PANEL_BYTES_PER_PIXEL;
+    for (int y = 0; y < rect->height; y++) {
+        memcpy(&panel[rect->y + y][rect->x * PANEL_BYTES_PER_PIXEL], data + (size_t)y * length, length);
+    }
+}
+
+void ppm_panel_flush(const RenderRect *rect, const RenderPixel *pixels, size_t stride) {
+    for (int y = 0; y < rect->height; y++) {
+        pixel_convert_rgb666(&panel[rect->y + y][rect->x * PANEL_BYTES_PER_PIXEL], pixels + (size_t)y * stride,
+                             (size_t)rect->width);
+    }
+}
+
+bool ppm_panel_save(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", TEXT_RENDERER_WIDTH, TEXT_RENDERER_HEIGHT);
+
+    static uint8_t line[ROW_BYTES];
+    for (int y = 0; y < TEXT_RENDERER_HEIGHT; y++) {
+        // Six bits per component in bits 7..2, widened to eight
+        for (size_t i = 0; i < ROW_BYTES; i++) {
+            line[i] = (uint8_t)(panel[y][i] | panel[y][i] >> 6);
+        }
+        fwrite(line, 1, sizeof(line), file);
+    }
+    return fclose(file) == 0;
+}
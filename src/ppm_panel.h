@@ -0,0 +1,29 @@
+#ifndef PPM_PANEL_H
+#define PPM_PANEL_H
+
+#include "text_renderer.h"
+#include <stdbool.h>
+
+/**
+ * @brief Mock panel for Linux: stores rect->width * rect->height RGB666 pixels.
+ *
+ * Copies each transferred rectangle into an image of the panel memory, as the
+ * display controller would. Pixels outside the transferred rectangles keep
+ * what they showed before, so a missed dirty cell shows up as stale text in
+ * the saved frames.
+ */
+void ppm_panel_write(const RenderRect *rect, const uint8_t *data);
+
+/**
+ * @brief Converts a framebuffer rectangle and stores it; a flush callback for text_renderer_init.
+ */
+void ppm_panel_flush(const RenderRect *rect, const RenderPixel *pixels, size_t stride);
+
+/**
+ * @brief Writes the panel image to a binary PPM (P6) file on the host.
+ *
+ * @return true on success.
+ */
+bool ppm_panel_save(const char *path);
+
+#endif // PPM_PANEL_H
@@ -0,0 +1,411 @@
+// ram_disk.c
+//
+// The card as a tree of nodes in memory. Children are kept in creation order
+// on a singly linked list with a tail pointer, which is also the listing
+// order. One mutex covers the tree, as the core and the storage worker use
+// the card at the same time.
+
+#include "ram_disk.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAM_DISK_EPOCH 1700000000u   // mtime of the first change; every change adds a second
+#define RAM_DISK_MIN_CAPACITY 64     // Smallest file buffer allocated
+
+typedef struct RamNode RamNode;
+
+struct RamNode {
+    char name[HAL_NAME_LEN];
+    uint8_t type;        // DirEntryType
+    uint32_t mtime;
+    char *data;          // File contents
+    size_t length;
+    size_t capacity;
+    uint64_t stamp;      // Directory generation, advanced when its entries change
+    RamNode *parent;
+    RamNode *first_child;
+    RamNode *last_child;
+    RamNode *next_sibling;
+};
+
+static RamNode root = { .name = "/", .type = DIR_ENTRY_DIRECTORY, .mtime = RAM_DISK_EPOCH, .stamp = 1 };
+static uint32_t ticks = RAM_DISK_EPOCH;
+static uint64_t generation = 1;   // Last stamp handed out, unique across directories
+static size_t used_bytes = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Where the last listing stopped, so reading a directory a chunk at a time
+// does not walk it from the start for every chunk
+static const RamNode *cursor_dir = NULL;
+static uint64_t cursor_stamp = 0;
+static size_t cursor_index = 0;
+static const RamNode *cursor_next = NULL;
+
+// -----------------------------------------------------------------------------
+/* Tree */
+// -----------------------------------------------------------------------------
+
+static void touch(RamNode *node) {
+    node->mtime = ++ticks;
+}
+
+// A new stamp, never equal to one handed out before, so a directory freed
+// and allocated again at the same address is still told apart.
+static void changed(RamNode *dir) {
+    dir->stamp = ++generation;
+    touch(dir);
+}
+
+static RamNode *find_child(const RamNode *dir, const char *name, size_t name_length) {
+    for (RamNode *child = dir->first_child; child; child = child->next_sibling) {
+        if (strncmp(child->name, name, name_length) == 0 && child->name[name_length] == '\0') {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+// Walks the components of path; empty components ("//", a trailing "/") are skipped.
+static RamNode *lookup(const char *path) {
+    RamNode *node = &root;
+    while (*path) {
+        if (*path == '/') {
+            path++;
+            continue;
+        }
+        size_t length = strcspn(path, "/");
+        if (node->type != DIR_ENTRY_DIRECTORY || !(node = find_child(node, path, length))) {
+            return NULL;
+        }
+        path += length;
+    }
+    return node;
+}
+
+// Finds the directory that holds path and copies the last component to name.
+static RamNode *lookup_parent(const char *path, char name[HAL_NAME_LEN]) {
+    size_t end = strlen(path);
+    while (end > 0 && path[end - 1] == '/') {
+        end--;
+    }
+    size_t start = end;
+    while (start > 0 && path[start - 1] != '/') {
+        start--;
+    }
+    if (start == end || end - start >= HAL_NAME_LEN) {
+        return NULL;
+    }
+    memcpy(name, path + start, end - start);
+    name[end - start] = '\0';
+
+    char dir_path[512];
+    if (start >= sizeof(dir_path)) {
+        return NULL;
+    }
+    memcpy(dir_path, path, start);
+    dir_path[start] = '\0';
+    RamNode *dir = lookup(dir_path);
+    return dir && dir->type == DIR_ENTRY_DIRECTORY ? dir : NULL;
+}
+
+static void attach(RamNode *dir, RamNode *node) {
+    node->parent = dir;
+    node->next_sibling = NULL;
+    if (dir->last_child) {
+        dir->last_child->next_sibling = node;
+    } else {
+        dir->first_child = node;
+    }
+    dir->last_child = node;
+    changed(dir);
+}
+
+static void detach(RamNode *node) {
+    RamNode *dir = node->parent;
+    RamNode *previous = NULL;
+    for (RamNode *child = dir->first_child; child != node; child = child->next_sibling) {
+        previous = child;
+    }
+    if (previous) {
+        previous->next_sibling = node->next_sibling;
+    } else {
+        dir->first_child = node->next_sibling;
+    }
+    if (dir->last_child == node) {
+        dir->last_child = previous;
+    }
+    node->parent = NULL;
+    changed(dir);
+}
+
+static RamNode *create_node(RamNode *dir, const char *name, DirEntryType type) {
+    RamNode *node = calloc(1, sizeof(RamNode));
+    if (!node) {
+        return NULL;
+    }
+    strcpy(node->name, name);
+    node->type = (uint8_t)type;
+    node->stamp = ++generation;
+    touch(node);
+    attach(dir, node);
+    return node;
+}
+
+static void free_node(RamNode *node) {
+    RamNode *child = node->first_child;
+    while (child) {
+        RamNode *next = child->next_sibling;
+        free_node(child);
+        child = next;
+    }
+    used_bytes -= node->capacity;
+    free(node->data);
+    free(node);
+}
+
+// Makes room for length bytes, zero-filling anything past the current end.
+static bool resize(RamNode *file, size_t length) {
+    if (length > file->capacity) {
+        size_t capacity = file->capacity ? file->capacity : RAM_DISK_MIN_CAPACITY;
+        while (capacity < length) {
+            capacity *= 2;
+        }
+        char *data = realloc(file->data, capacity);
+        if (!data) {
+            return false;
+        }
+        used_bytes += capacity - file->capacity;
+        file->data = data;
+        file->capacity = capacity;
+    }
+    if (length > file->length) {
+        memset(file->data + file->length, 0, length - file->length);
+    }
+    file->length = length;
+    return true;
+}
+
+static void fill_entry(const RamNode *node, DirEntry *entry) {
+    memcpy(entry->name, node->name, HAL_NAME_LEN);
+    entry->type = node->type;
+    entry->size = node->type == DIR_ENTRY_DIRECTORY ? 0 : (uint32_t)node->length;
+    entry->mtime = node->mtime;
+}
+
+// -----------------------------------------------------------------------------
+/* Directories */
+// -----------------------------------------------------------------------------
+
+static size_t ram_list(const char *directory, size_t start, DirEntry *entries, size_t max_entries) {
+    pthread_mutex_lock(&lock);
+    const RamNode *dir = lookup(directory);
+    size_t count = 0;
+    if (dir && dir->type == DIR_ENTRY_DIRECTORY) {
+        const RamNode *node = dir->first_child;
+        size_t index = 0;
+        if (dir == cursor_dir && dir->stamp == cursor_stamp && start >= cursor_index) {
+            node = cursor_next;
+            index = cursor_index;
+        }
+        while (node && index < start) {
+            node = node->next_sibling;
+            index++;
+        }
+        while (node && count < max_entries) {
+            fill_entry(node, &entries[count++]);
+            node = node->next_sibling;
+        }
+        cursor_dir = dir;
+        cursor_stamp = dir->stamp;
+        cursor_index = index + count;
+        cursor_next = node;
+    }
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
+static bool ram_stat(const char *path, DirEntry *entry) {
+    pthread_mutex_lock(&lock);
+    const RamNode *node = lookup(path);
+    if (node) {
+        fill_entry(node, entry);
+    }
+    pthread_mutex_unlock(&lock);
+    return node != NULL;
+}
+
+static bool ram_create_directory(const char *path) {
+    char name[HAL_NAME_LEN];
+    pthread_mutex_lock(&lock);
+    RamNode *dir = lookup_parent(path, name);
+    bool ok = dir && !find_child(dir, name, strlen(name)) && create_node(dir, name, DIR_ENTRY_DIRECTORY);
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+// Replaces an existing file at new_path, as rename(2) does.
+static bool ram_rename(const char *old_path, const char *new_path) {
+    char name[HAL_NAME_LEN];
+    bool ok = false;
+    pthread_mutex_lock(&lock);
+    RamNode *node = lookup(old_path);
+    RamNode *dir = lookup_parent(new_path, name);
+    if (node && node != &root && dir) {
+        // A directory cannot move into itself
+        const RamNode *ancestor = dir;
+        while (ancestor && ancestor != node) {
+            ancestor = ancestor->parent;
+        }
+        RamNode *existing = find_child(dir, name, strlen(name));
+        bool replaceable = !existing || existing == node ||
+                           (existing->type == DIR_ENTRY_FILE && node->type == DIR_ENTRY_FILE);
+        if (!ancestor && replaceable) {
+            if (existing && existing != node) {
+                detach(existing);
+                free_node(existing);
+            }
+            detach(node);
+            strcpy(node->name, name);
+            attach(dir, node);
+            ok = true;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+// Removes a file or an empty directory.
+static bool ram_remove(const char *path) {
+    pthread_mutex_lock(&lock);
+    RamNode *node = lookup(path);
+    bool ok = node && node != &root && !node->first_child;
+    if (ok) {
+        detach(node);
+        free_node(node);
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+static bool ram_dir_stamp(const char *path, uint64_t *stamp) {
+    pthread_mutex_lock(&lock);
+    const RamNode *dir = lookup(path);
+    bool ok = dir && dir->type == DIR_ENTRY_DIRECTORY;
+    if (ok) {
+        *stamp = dir->stamp;
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+/* Files */
+// -----------------------------------------------------------------------------
+
+// Returns the file at path, created empty if missing; NULL for directories.
+static RamNode *open_file(const char *path) {
+    RamNode *node = lookup(path);
+    if (node) {
+        return node->type == DIR_ENTRY_FILE ? node : NULL;
+    }
+    char name[HAL_NAME_LEN];
+    RamNode *dir = lookup_parent(path, name);
+    return dir ? create_node(dir, name, DIR_ENTRY_FILE) : NULL;
+}
+
+static bool ram_create_file(const char *path) {
+    pthread_mutex_lock(&lock);
+    RamNode *file = open_file(path);
+    if (file) {
+        file->length = 0;
+        touch(file);
+    }
+    pthread_mutex_unlock(&lock);
+    return file != NULL;
+}
+
+static int ram_read(const char *path, size_t offset, char *buffer, size_t length) {
+    int read = -1;
+    pthread_mutex_lock(&lock);
+    const RamNode *file = lookup(path);
+    if (file && file->type == DIR_ENTRY_FILE) {
+        size_t available = offset < file->length ? file->length - offset : 0;
+        size_t count = length < available ? length : available;
+        if (count > INT32_MAX) {
+            count = INT32_MAX;
+        }
+        if (count > 0) {
+            memcpy(buffer, file->data + offset, count);
+        }
+        read = (int)count;
+    }
+    pthread_mutex_unlock(&lock);
+    return read;
+}
+
+static bool ram_write(const char *path, size_t offset, const char *buffer, size_t length) {
+    bool ok = false;
+    pthread_mutex_lock(&lock);
+    RamNode *file = open_file(path);
+    if (file) {
+        size_t end = offset + length;
+        ok = end <= file->length || resize(file, end);
+        if (ok) {
+            memcpy(file->data + offset, buffer, length);
+            touch(file);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+static bool ram_truncate(const char *path, size_t length) {
+    bool ok = false;
+    pthread_mutex_lock(&lock);
+    RamNode *file = lookup(path);
+    if (file && file->type == DIR_ENTRY_FILE) {
+        if (length <= file->length) {
+            file->length = length;
+            ok = true;
+        } else {
+            ok = resize(file, length);
+        }
+        if (ok) {
+            touch(file);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+const StorageBackend ram_disk_backend = {
+    "ram", ram_list, ram_stat, ram_read, ram_write, ram_truncate,
+    ram_create_file, ram_create_directory, ram_rename, ram_remove, ram_dir_stamp,
+};
+
+void ram_disk_reset(void) {
+    pthread_mutex_lock(&lock);
+    RamNode *child = root.first_child;
+    while (child) {
+        RamNode *next = child->next_sibling;
+        free_node(child);
+        child = next;
+    }
+    root.first_child = NULL;
+    root.last_child = NULL;
+    changed(&root);
+    cursor_dir = NULL;
+    pthread_mutex_unlock(&lock);
+}
+
+size_t ram_disk_used_bytes(void) {
+    pthread_mutex_lock(&lock);
+    size_t used = used_bytes;
+    pthread_mutex_unlock(&lock);
+    return used;
+}
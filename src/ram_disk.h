@@ -0,0 +1,27 @@
+#ifndef RAM_DISK_H
+#define RAM_DISK_H
+
+#include "storage_backend.h"
+
+/**
+ * @brief A card held in memory, for hal_mock_storage_set_backend.
+ *
+ * A tree of directories and files with the semantics of the host backend:
+ * entries list in creation order, rename replaces an existing file, remove
+ * takes files and empty directories. Modification times come from a counter
+ * instead of the clock, so runs on it are deterministic and never touch the
+ * host filesystem.
+ */
+extern const StorageBackend ram_disk_backend;
+
+/**
+ * @brief Frees every file and directory, leaving an empty root.
+ */
+void ram_disk_reset(void);
+
+/**
+ * @brief Returns the bytes allocated for file contents.
+ */
+size_t ram_disk_used_bytes(void);
+
+#endif // RAM_DISK_H
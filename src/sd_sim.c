@@ -0,0 +1,224 @@
+// sd_sim.c
+//
+// A storage backend that adds the time an SD card would take to another
+// backend. The card is modelled as one resource with an absolute "free at"
+// time: an operation starts when the card is free, or now if it is idle, and
+// its caller sleeps until it ends. Sleeping to an absolute time keeps the
+// thread's wake-up latency out of the model, as in flush_sim.c.
+
+#define _POSIX_C_SOURCE 200809L // clock_nanosleep
+
+#include "sd_sim.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define SD_SIM_DIR_ENTRY_BYTES 32   // FAT directory entry; long names take more, ignored
+
+typedef struct {
+    const char *name;
+    SdSimTiming timing;
+} SdSimProfile;
+
+static const SdSimProfile profiles[] = {
+    { "spi", { 300, 1000000, 500000, 2000, 512u * 1024u, 50000 } },
+    { "sdmmc", { 100, 10000000, 5000000, 1000, 1024u * 1024u, 20000 } },
+    { "slow", { 1000, 400000, 150000, 8000, 128u * 1024u, 250000 } },
+};
+
+static const StorageBackend *inner = NULL;
+static SdSimTiming model;
+static SdSimStats stats;
+static uint64_t card_free_ns = 0;       // When the last operation accepted ends
+static uint64_t written_since_gc = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// -----------------------------------------------------------------------------
+/* Cost Model */
+// -----------------------------------------------------------------------------
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t sectors_spanned(size_t offset, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    size_t first = offset / HAL_STORAGE_BLOCK_SIZE;
+    size_t last = (offset + length - 1) / HAL_STORAGE_BLOCK_SIZE;
+    return last - first + 1;
+}
+
+static uint64_t transfer_us(uint64_t bytes, uint32_t bytes_per_second) {
+    return bytes_per_second ? bytes * 1000000u / bytes_per_second : 0;
+}
+
+// Books cost_us of card time and sleeps until it has passed.
+static void occupy(uint64_t cost_us) {
+    pthread_mutex_lock(&lock);
+    uint64_t now = now_ns();
+    uint64_t start = card_free_ns > now ? card_free_ns : now;
+    card_free_ns = start + cost_us * 1000u;
+    uint64_t done_ns = card_free_ns;
+    stats.operations++;
+    stats.busy_us += cost_us;
+    pthread_mutex_unlock(&lock);
+
+    struct timespec done_at = { (time_t)(done_ns / 1000000000u), (long)(done_ns % 1000000000u) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &done_at, NULL) != 0) {
+    }
+}
+
+static uint64_t read_cost_us(size_t offset, size_t length) {
+    uint64_t sectors = sectors_spanned(offset, length);
+    pthread_mutex_lock(&lock);
+    stats.sectors_read += sectors;
+    pthread_mutex_unlock(&lock);
+    return model.command_us + transfer_us(sectors * HAL_STORAGE_BLOCK_SIZE, model.read_bytes_per_second);
+}
+
+// Partial first and last sectors are read back before they are written.
+static uint64_t write_cost_us(size_t offset, size_t length) {
+    uint64_t sectors = sectors_spanned(offset, length);
+    uint32_t partial = 0;
+    if (length > 0) {
+        size_t end = offset + length;
+        bool head = offset % HAL_STORAGE_BLOCK_SIZE != 0;
+        bool tail = end % HAL_STORAGE_BLOCK_SIZE != 0;
+        partial = (uint32_t)head + (uint32_t)tail;
+        if (head && tail && sectors == 1) {
+            partial = 1;
+        }
+    }
+
+    uint64_t cost = model.command_us + transfer_us(sectors * HAL_STORAGE_BLOCK_SIZE, model.write_bytes_per_second) +
+                    transfer_us((uint64_t)partial * HAL_STORAGE_BLOCK_SIZE, model.read_bytes_per_second);
+
+    pthread_mutex_lock(&lock);
+    stats.sectors_written += sectors;
+    stats.sectors_read += partial;
+    stats.read_modify_writes += partial;
+    if (model.gc_every_bytes) {
+        written_since_gc += sectors * HAL_STORAGE_BLOCK_SIZE;
+        while (written_since_gc >= model.gc_every_bytes) {
+            written_since_gc -= model.gc_every_bytes;
+            stats.gc_stalls++;
+            cost += model.gc_us;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return cost;
+}
+
+static uint64_t metadata_cost_us(void) {
+    return model.command_us + model.metadata_us;
+}
+
+// -----------------------------------------------------------------------------
+/* Backend */
+// -----------------------------------------------------------------------------
+
+static size_t sd_list(const char *directory, size_t start, DirEntry *entries, size_t max_entries) {
+    size_t count = inner->list(directory, start, entries, max_entries);
+    // The HAL keeps the directory open, so a chunk reads only its own entries
+    occupy(read_cost_us(0, count * SD_SIM_DIR_ENTRY_BYTES));
+    return count;
+}
+
+static bool sd_stat(const char *path, DirEntry *entry) {
+    bool ok = inner->stat(path, entry);
+    occupy(read_cost_us(0, HAL_STORAGE_BLOCK_SIZE));
+    return ok;
+}
+
+static int sd_read(const char *path, size_t offset, char *buffer, size_t length) {
+    int read = inner->read(path, offset, buffer, length);
+    occupy(read_cost_us(offset, read > 0 ? (size_t)read : 0));
+    return read;
+}
+
+static bool sd_write(const char *path, size_t offset, const char *buffer, size_t length) {
+    bool ok = inner->write(path, offset, buffer, length);
+    occupy(write_cost_us(offset, length));
+    return ok;
+}
+
+static bool sd_truncate(const char *path, size_t length) {
+    bool ok = inner->truncate(path, length);
+    occupy(metadata_cost_us());
+    return ok;
+}
+
+static bool sd_create_file(const char *path) {
+    bool ok = inner->create_file(path);
+    occupy(metadata_cost_us());
+    return ok;
+}
+
+static bool sd_create_directory(const char *path) {
+    bool ok = inner->create_directory(path);
+    occupy(metadata_cost_us());
+    return ok;
+}
+
+static bool sd_rename(const char *old_path, const char *new_path) {
+    bool ok = inner->rename(old_path, new_path);
+    occupy(metadata_cost_us());
+    return ok;
+}
+
+static bool sd_remove(const char *path) {
+    bool ok = inner->remove(path);
+    occupy(metadata_cost_us());
+    return ok;
+}
+
+// Kept in RAM by a FAT port, so it costs no card time
+static bool sd_dir_stamp(const char *path, uint64_t *stamp) {
+    return inner->dir_stamp(path, stamp);
+}
+
+const StorageBackend sd_sim_backend = {
+    "sd", sd_list, sd_stat, sd_read, sd_write, sd_truncate,
+    sd_create_file, sd_create_directory, sd_rename, sd_remove, sd_dir_stamp,
+};
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void sd_sim_init(const StorageBackend *backend, const SdSimTiming *timing) {
+    pthread_mutex_lock(&lock);
+    inner = backend;
+    model = *timing;
+    memset(&stats, 0, sizeof(stats));
+    card_free_ns = 0;
+    written_since_gc = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+bool sd_sim_profile(const char *name, SdSimTiming *timing) {
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+        if (strcmp(profiles[i].name, name) == 0) {
+            *timing = profiles[i].timing;
+            return true;
+        }
+    }
+    return false;
+}
+
+SdSimStats sd_sim_stats(void) {
+    pthread_mutex_lock(&lock);
+    SdSimStats current = stats;
+    pthread_mutex_unlock(&lock);
+    return current;
+}
+
+void sd_sim_reset_stats(void) {
+    pthread_mutex_lock(&lock);
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,79 @@
+#ifndef SD_SIM_H
+#define SD_SIM_H
+
+#include "storage_backend.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct SdSimTiming
+ * @brief Cost model of the emulated SD card.
+ *
+ * Every operation is one command of command_us. Reads and writes then move
+ * whole HAL_STORAGE_BLOCK_SIZE sectors at the given rates; a write that
+ * starts or ends inside a sector reads that sector first. Directory changes
+ * add metadata_us for the FAT and directory entry updates, listings move 32
+ * bytes of directory entry per entry. After every gc_every_bytes written the
+ * card stalls for gc_us, as flash cards do when they erase a block.
+ */
+typedef struct {
+    uint32_t command_us;              // Command, response and busy wait per operation
+    uint32_t read_bytes_per_second;   // Sector read rate
+    uint32_t write_bytes_per_second;  // Sector write rate
+    uint32_t metadata_us;             // Extra cost of create, rename, remove and truncate
+    uint32_t gc_every_bytes;          // Bytes written between stalls, 0 for none
+    uint32_t gc_us;                   // Length of one stall
+} SdSimTiming;
+
+/**
+ * @struct SdSimStats
+ * @brief What the emulated card has done since sd_sim_init or the last reset.
+ */
+typedef struct {
+    uint32_t operations;
+    uint64_t sectors_read;
+    uint64_t sectors_written;
+    uint32_t read_modify_writes;   // Sectors read to complete a partial write
+    uint32_t gc_stalls;
+    uint64_t busy_us;              // Modelled card time
+} SdSimStats;
+
+/**
+ * @brief The emulated card, for hal_mock_storage_set_backend.
+ *
+ * Passes every operation on to the backend given to sd_sim_init and then
+ * holds the caller until the card would have finished it. The card does one
+ * operation at a time: a caller that arrives while it is busy waits for it,
+ * so the storage worker and the core contend for it as on the device.
+ */
+extern const StorageBackend sd_sim_backend;
+
+/**
+ * @brief Puts the emulated card in front of another backend.
+ *
+ * @param inner  The backend holding the data.
+ * @param timing Cost model; copied.
+ */
+void sd_sim_init(const StorageBackend *inner, const SdSimTiming *timing);
+
+/**
+ * @brief Looks up a named cost model.
+ *
+ * "spi" is a card on a 20 MHz SPI bus as on the device, "sdmmc" the same card
+ * on a 4-bit SDMMC bus and "slow" a worn card with long stalls.
+ *
+ * @return true if the name is known.
+ */
+bool sd_sim_profile(const char *name, SdSimTiming *timing);
+
+/**
+ * @brief Returns the counters of the emulated card.
+ */
+SdSimStats sd_sim_stats(void);
+
+/**
+ * @brief Clears the counters.
+ */
+void sd_sim_reset_stats(void);
+
+#endif // SD_SIM_H
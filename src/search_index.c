@@ -0,0 +1,1228 @@
+// search_index.c
+
+#include "search_index.h"
+#include "hal_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DOCS_PATH SEARCH_INDEX_DIR "/docs.idx"
+#define MAIN_PATH SEARCH_INDEX_DIR "/main.idx"
+#define DELTA_PATH SEARCH_INDEX_DIR "/delta.idx"
+#define TMP_PATH SEARCH_INDEX_DIR "/segment.tmp"
+#define DOCS_TMP_PATH SEARCH_INDEX_DIR "/docs.tmp"
+
+#define SEGMENT_MAGIC 0x58535443u    // "CTSX"
+#define SEGMENT_VERSION 1
+#define SEGMENT_HEADER_SIZE 24
+#define BLOCK_TERMS 64               // Dictionary entries per block
+#define BLOCK_DICT_MAX (BLOCK_TERMS * (1 + SEARCH_TERM_MAX + 2 * 5))
+#define DELTA_MAX_POSTINGS 32768     // Delta size that triggers a merge into the main segment
+#define READ_CHUNK 4096
+#define MIN_TERM 2                   // Shorter words are not indexed
+#define NO_PENDING UINT32_MAX
+#define NO_RECORD UINT32_MAX
+
+// Which segment holds a document's current postings. Postings of a document
+// found in any other segment are out of date and skipped.
+enum { SEGMENT_NONE = 0, SEGMENT_MAIN = 1, SEGMENT_DELTA = 2 };
+
+typedef struct {
+    uint32_t doc;
+    uint32_t tf;        // Occurrences in the document
+    uint32_t first;     // Byte offset of the first occurrence
+} Posting;
+
+typedef struct {
+    Posting *items;     // Ascending by doc
+    size_t count;
+    size_t capacity;
+} PostingList;
+
+typedef struct {
+    char term[SEARCH_TERM_MAX + 1];
+    PostingList list;
+    uint32_t pending;   // Posting of the document being indexed, or NO_PENDING
+} DeltaTerm;
+
+typedef struct {
+    uint32_t path;      // Offset in doc_paths
+    uint32_t record;    // Offset of the document's record in DOCS_PATH, or NO_RECORD
+    uint8_t segment;
+    bool dirty;         // segment changed since the record was written
+} SearchDoc;
+
+// A segment file: header, then blocks of dictionary entries each followed by
+// the posting lists of its terms, then a table with the first term, offset and
+// dictionary length of every block.
+typedef struct {
+    bool present;
+    uint32_t term_count;
+    uint32_t block_count;
+    uint32_t size;
+    uint8_t *table;     // Raw block table
+    uint32_t *blocks;   // Offset of each block's entry in table
+} Segment;
+
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    bool ok;
+} ByteBuffer;
+
+// Document table
+static SearchDoc *docs;
+static size_t doc_count, doc_capacity;
+static char *doc_paths;
+static size_t doc_paths_used, doc_paths_capacity;
+static size_t docs_file_size;
+static bool docs_rewrite;            // Paths changed: the table is written again in full
+
+// Main segment, read from the card on demand
+static Segment main_segment;
+
+// Delta segment, held in RAM: a hash of terms to posting lists
+static DeltaTerm *delta_terms;
+static size_t delta_count, delta_capacity;
+static uint32_t *delta_slots;        // Indices into delta_terms, NO_PENDING when empty
+static size_t delta_slot_count;      // Power of two
+static size_t delta_postings;
+static bool delta_dirty;
+
+static bool needs_build;
+static uint32_t merge_count;
+
+// -----------------------------------------------------------------------------
+/* Encoding */
+// -----------------------------------------------------------------------------
+
+static void buffer_reserve(ByteBuffer *buffer, size_t extra) {
+    if (!buffer->ok || buffer->length + extra <= buffer->capacity) {
+        return;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+    uint8_t *grown = realloc(buffer->data, capacity);
+    if (!grown) {
+        buffer->ok = false;
+        return;
+    }
+    buffer->data = grown;
+    buffer->capacity = capacity;
+}
+
+static void buffer_put(ByteBuffer *buffer, const void *data, size_t length) {
+    buffer_reserve(buffer, length);
+    if (buffer->ok) {
+        memcpy(buffer->data + buffer->length, data, length);
+        buffer->length += length;
+    }
+}
+
+static void buffer_put_varint(ByteBuffer *buffer, uint32_t value) {
+    uint8_t bytes[5];
+    size_t n = 0;
+    do {
+        bytes[n] = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        if (value) {
+            bytes[n] |= 0x80;
+        }
+        n++;
+    } while (value);
+    buffer_put(buffer, bytes, n);
+}
+
+static void buffer_put_u32(ByteBuffer *buffer, uint32_t value) {
+    uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    buffer_put(buffer, bytes, 4);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static bool get_varint(const uint8_t **p, const uint8_t *end, uint32_t *value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t byte = *(*p)++;
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Postings are stored as (doc gap, tf, first offset) varint triples.
+static void encode_postings(ByteBuffer *buffer, const PostingList *list) {
+    uint32_t previous = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        buffer_put_varint(buffer, list->items[i].doc - previous);
+        buffer_put_varint(buffer, list->items[i].tf);
+        buffer_put_varint(buffer, list->items[i].first);
+        previous = list->items[i].doc;
+    }
+}
+
+static bool list_reserve(PostingList *list, size_t needed) {
+    if (needed <= list->capacity) {
+        return true;
+    }
+    size_t capacity = list->capacity ? list->capacity : 4;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    Posting *grown = realloc(list->items, capacity * sizeof(Posting));
+    if (!grown) {
+        return false;
+    }
+    list->items = grown;
+    list->capacity = capacity;
+    return true;
+}
+
+// Appends the postings of docs whose current segment is segment.
+static bool decode_postings(const uint8_t *data, size_t length, uint32_t count, uint8_t segment, PostingList *list) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + length;
+    uint32_t doc = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t gap, tf, first;
+        if (!get_varint(&p, end, &gap) || !get_varint(&p, end, &tf) || !get_varint(&p, end, &first)) {
+            return false;
+        }
+        doc += gap;
+        if (doc < doc_count && docs[doc].segment == segment) {
+            if (!list_reserve(list, list->count + 1)) {
+                return false;
+            }
+            list->items[list->count++] = (Posting){ doc, tf, first };
+        }
+    }
+    return true;
+}
+
+// Compares a stored term of length length with a NUL-terminated term, like strcmp.
+static int compare_term(const uint8_t *stored, size_t length, const char *term) {
+    size_t term_length = strlen(term);
+    int cmp = memcmp(stored, term, length < term_length ? length : term_length);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return length < term_length ? -1 : length > term_length;
+}
+
+// -----------------------------------------------------------------------------
+/* Segment Files */
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    const char *path;
+    uint32_t offset;        // Where the next block goes
+    ByteBuffer dict;        // Dictionary of the block being built
+    ByteBuffer postings;    // Its posting lists
+    ByteBuffer table;
+    size_t block_terms;
+    uint32_t term_count;
+    uint32_t block_count;
+    bool ok;
+} SegmentWriter;
+
+static void writer_begin(SegmentWriter *writer, const char *path) {
+    hal_storage_create_directory(SEARCH_INDEX_DIR); // Fails harmlessly if it exists
+    memset(writer, 0, sizeof(*writer));
+    writer->path = path;
+    writer->offset = SEGMENT_HEADER_SIZE;
+    writer->dict.ok = writer->postings.ok = writer->table.ok = true;
+    writer->ok = hal_storage_create_file(path); // Truncates leftovers
+}
+
+static void writer_flush_block(SegmentWriter *writer) {
+    if (writer->block_terms == 0 || !writer->ok) {
+        return;
+    }
+    writer->ok = writer->dict.ok && writer->postings.ok &&
+                 hal_storage_write_range(writer->path, writer->offset, (const char *)writer->dict.data, writer->dict.length) &&
+                 hal_storage_write_range(writer->path, writer->offset + writer->dict.length,
+                                         (const char *)writer->postings.data, writer->postings.length);
+    buffer_put_u32(&writer->table, writer->offset);
+    buffer_put_u32(&writer->table, (uint32_t)writer->dict.length);
+    writer->offset += (uint32_t)(writer->dict.length + writer->postings.length);
+    writer->dict.length = 0;
+    writer->postings.length = 0;
+    writer->block_terms = 0;
+    writer->block_count++;
+}
+
+static void writer_add(SegmentWriter *writer, const char *term, const PostingList *list) {
+    if (list->count == 0) {
+        return;
+    }
+    uint8_t length = (uint8_t)strlen(term);
+    if (writer->block_terms == 0) {
+        // The block's first term goes to the table, its offset follows at flush
+        buffer_put(&writer->table, &length, 1);
+        buffer_put(&writer->table, term, length);
+    }
+    size_t before = writer->postings.length;
+    encode_postings(&writer->postings, list);
+    buffer_put(&writer->dict, &length, 1);
+    buffer_put(&writer->dict, term, length);
+    buffer_put_varint(&writer->dict, (uint32_t)list->count);
+    buffer_put_varint(&writer->dict, (uint32_t)(writer->postings.length - before));
+    writer->term_count++;
+    if (++writer->block_terms == BLOCK_TERMS) {
+        writer_flush_block(writer);
+    }
+}
+
+static bool writer_finish(SegmentWriter *writer) {
+    writer_flush_block(writer);
+    ByteBuffer header = { .ok = true };
+    buffer_put_u32(&header, SEGMENT_MAGIC);
+    buffer_put_u32(&header, SEGMENT_VERSION);
+    buffer_put_u32(&header, writer->term_count);
+    buffer_put_u32(&header, writer->block_count);
+    buffer_put_u32(&header, writer->offset);
+    buffer_put_u32(&header, (uint32_t)writer->table.length);
+    bool ok = writer->ok && writer->table.ok && header.ok &&
+              hal_storage_write_range(writer->path, writer->offset, (const char *)writer->table.data, writer->table.length) &&
+              hal_storage_write_range(writer->path, 0, (const char *)header.data, header.length);
+    free(header.data);
+    free(writer->dict.data);
+    free(writer->postings.data);
+    free(writer->table.data);
+    return ok;
+}
+
+static void segment_free(Segment *segment) {
+    free(segment->table);
+    free(segment->blocks);
+    memset(segment, 0, sizeof(*segment));
+}
+
+// Loads the header and block table of a segment file; a missing file is an empty segment.
+static bool segment_open(Segment *segment, const char *path) {
+    segment_free(segment);
+    uint8_t header[SEGMENT_HEADER_SIZE];
+    if (hal_storage_file_size(path) < 0) {
+        return true;
+    }
+    if (hal_storage_read_range(path, 0, (char *)header, sizeof(header)) != (int)sizeof(header) ||
+        get_u32(header) != SEGMENT_MAGIC || get_u32(header + 4) != SEGMENT_VERSION) {
+        return false;
+    }
+    segment->term_count = get_u32(header + 8);
+    segment->block_count = get_u32(header + 12);
+    uint32_t table_offset = get_u32(header + 16);
+    uint32_t table_length = get_u32(header + 20);
+    segment->size = table_offset + table_length;
+
+    segment->table = malloc(table_length ? table_length : 1);
+    segment->blocks = malloc((segment->block_count ? segment->block_count : 1) * sizeof(uint32_t));
+    if (!segment->table || !segment->blocks ||
+        hal_storage_read_range(path, table_offset, (char *)segment->table, table_length) != (int)table_length) {
+        segment_free(segment);
+        return false;
+    }
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < segment->block_count; i++) {
+        if (pos >= table_length || pos + 1 + segment->table[pos] + 8 > table_length) {
+            segment_free(segment);
+            return false;
+        }
+        segment->blocks[i] = pos;
+        pos += 1 + segment->table[pos] + 8;
+    }
+    segment->present = true;
+    return true;
+}
+
+// File offset and dictionary length of a block, from the table.
+static void block_location(const Segment *segment, uint32_t block, uint32_t *offset, uint32_t *dict_length) {
+    const uint8_t *entry = segment->table + segment->blocks[block];
+    *offset = get_u32(entry + 1 + entry[0]);
+    *dict_length = get_u32(entry + 1 + entry[0] + 4);
+}
+
+// Finds term in the main segment and appends its live postings to list.
+static bool segment_lookup(const Segment *segment, const char *path, const char *term, PostingList *list) {
+    if (!segment->present || segment->block_count == 0) {
+        return true;
+    }
+
+    // Last block whose first term is not after term
+    uint32_t low = 0;
+    uint32_t high = segment->block_count;
+    while (high - low > 1) {
+        uint32_t mid = low + (high - low) / 2;
+        const uint8_t *entry = segment->table + segment->blocks[mid];
+        if (compare_term(entry + 1, entry[0], term) <= 0) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    uint32_t offset, dict_length;
+    block_location(segment, low, &offset, &dict_length);
+    static uint8_t dict[BLOCK_DICT_MAX];
+    if (dict_length > sizeof(dict) ||
+        hal_storage_read_range(path, offset, (char *)dict, dict_length) != (int)dict_length) {
+        return false;
+    }
+
+    const uint8_t *p = dict;
+    const uint8_t *end = dict + dict_length;
+    uint32_t postings_offset = offset + dict_length;
+    while (p < end) {
+        uint8_t length = *p++;
+        const uint8_t *stored = p;
+        uint32_t count, postings_length;
+        p += length;
+        if (p > end || !get_varint(&p, end, &count) || !get_varint(&p, end, &postings_length)) {
+            return false;
+        }
+        int cmp = compare_term(stored, length, term);
+        if (cmp == 0) {
+            uint8_t *data = malloc(postings_length ? postings_length : 1);
+            bool ok = data &&
+                      hal_storage_read_range(path, postings_offset, (char *)data, postings_length) == (int)postings_length &&
+                      decode_postings(data, postings_length, count, SEGMENT_MAIN, list);
+            free(data);
+            return ok;
+        }
+        if (cmp > 0) {
+            break; // Sorted: the term is not in the segment
+        }
+        postings_offset += postings_length;
+    }
+    return true;
+}
+
+// Walks every term of a segment in order, one block read at a time.
+typedef struct {
+    const Segment *segment;
+    const char *path;
+    uint32_t next_block;
+    uint8_t dict[BLOCK_DICT_MAX];
+    uint32_t dict_length;
+    uint32_t dict_pos;
+    uint8_t *postings;      // Posting lists of the loaded block
+    uint32_t postings_pos;
+    uint32_t postings_length;
+    bool ok;
+} SegmentCursor;
+
+static bool cursor_load_block(SegmentCursor *cursor) {
+    uint32_t offset;
+    block_location(cursor->segment, cursor->next_block++, &offset, &cursor->dict_length);
+    if (cursor->dict_length > sizeof(cursor->dict) ||
+        hal_storage_read_range(cursor->path, offset, (char *)cursor->dict, cursor->dict_length) != (int)cursor->dict_length) {
+        return false;
+    }
+
+    // The block's posting lists follow its dictionary back to back
+    const uint8_t *p = cursor->dict;
+    const uint8_t *dict_end = cursor->dict + cursor->dict_length;
+    uint32_t total = 0;
+    while (p < dict_end) {
+        uint8_t length = *p++;
+        uint32_t count, postings_length;
+        p += length;
+        if (p > dict_end || !get_varint(&p, dict_end, &count) || !get_varint(&p, dict_end, &postings_length)) {
+            return false;
+        }
+        total += postings_length;
+    }
+
+    uint8_t *grown = realloc(cursor->postings, total ? total : 1);
+    if (!grown) {
+        return false;
+    }
+    cursor->postings = grown;
+    cursor->postings_length = total;
+    cursor->postings_pos = 0;
+    cursor->dict_pos = 0;
+    return hal_storage_read_range(cursor->path, offset + cursor->dict_length, (char *)cursor->postings, total) == (int)total;
+}
+
+static void cursor_open(SegmentCursor *cursor, const Segment *segment, const char *path) {
+    cursor->segment = segment;
+    cursor->path = path;
+    cursor->next_block = 0;
+    cursor->dict_length = 0;
+    cursor->dict_pos = 0;
+    cursor->postings = NULL;
+    cursor->ok = true;
+}
+
+// Reads the next term and its postings for docs currently in segment; false at the end.
+static bool cursor_next(SegmentCursor *cursor, char *term, uint8_t segment, PostingList *list) {
+    list->count = 0;
+    if (!cursor->ok || !cursor->segment->present) {
+        return false;
+    }
+    if (cursor->dict_pos >= cursor->dict_length) {
+        if (cursor->next_block >= cursor->segment->block_count) {
+            return false;
+        }
+        if (!cursor_load_block(cursor)) {
+            cursor->ok = false;
+            return false;
+        }
+    }
+
+    const uint8_t *p = cursor->dict + cursor->dict_pos;
+    const uint8_t *end = cursor->dict + cursor->dict_length;
+    uint8_t length = *p++;
+    uint32_t count, postings_length;
+    memcpy(term, p, length);
+    term[length] = '\0';
+    p += length;
+    if (length > SEARCH_TERM_MAX || p > end || !get_varint(&p, end, &count) ||
+        !get_varint(&p, end, &postings_length) || cursor->postings_pos + postings_length > cursor->postings_length ||
+        !decode_postings(cursor->postings + cursor->postings_pos, postings_length, count, segment, list)) {
+        cursor->ok = false;
+        return false;
+    }
+    cursor->dict_pos = (uint32_t)(p - cursor->dict);
+    cursor->postings_pos += postings_length;
+    return true;
+}
+
+static void cursor_close(SegmentCursor *cursor) {
+    free(cursor->postings);
+    cursor->postings = NULL;
+}
+
+// -----------------------------------------------------------------------------
+/* Delta Segment */
+// -----------------------------------------------------------------------------
+
+static uint32_t hash_term(const char *term, size_t length) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)term[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool delta_rehash(size_t slot_count) {
+    uint32_t *slots = malloc(slot_count * sizeof(uint32_t));
+    if (!slots) {
+        return false;
+    }
+    for (size_t i = 0; i < slot_count; i++) {
+        slots[i] = NO_PENDING;
+    }
+    for (size_t t = 0; t < delta_count; t++) {
+        size_t slot = hash_term(delta_terms[t].term, strlen(delta_terms[t].term)) & (slot_count - 1);
+        while (slots[slot] != NO_PENDING) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot] = (uint32_t)t;
+    }
+    free(delta_slots);
+    delta_slots = slots;
+    delta_slot_count = slot_count;
+    return true;
+}
+
+// Returns the delta term for term, adding it if create is set; NO_PENDING if absent or out of memory.
+static uint32_t delta_find(const char *term, size_t length, bool create) {
+    if (delta_slot_count > 0) {
+        size_t slot = hash_term(term, length) & (delta_slot_count - 1);
+        while (delta_slots[slot] != NO_PENDING) {
+            DeltaTerm *candidate = &delta_terms[delta_slots[slot]];
+            if (strncmp(candidate->term, term, length) == 0 && candidate->term[length] == '\0') {
+                return delta_slots[slot];
+            }
+            slot = (slot + 1) & (delta_slot_count - 1);
+        }
+    }
+    if (!create) {
+        return NO_PENDING;
+    }
+
+    // Keep the table at most half full
+    if ((delta_count + 1) * 2 > delta_slot_count && !delta_rehash(delta_slot_count ? delta_slot_count * 2 : 1024)) {
+        return NO_PENDING;
+    }
+    if (delta_count == delta_capacity) {
+        size_t capacity = delta_capacity ? delta_capacity * 2 : 512;
+        DeltaTerm *grown = realloc(delta_terms, capacity * sizeof(DeltaTerm));
+        if (!grown) {
+            return NO_PENDING;
+        }
+        delta_terms = grown;
+        delta_capacity = capacity;
+    }
+    uint32_t index = (uint32_t)delta_count++;
+    DeltaTerm *added = &delta_terms[index];
+    memcpy(added->term, term, length);
+    added->term[length] = '\0';
+    added->list = (PostingList){ 0 };
+    added->pending = NO_PENDING;
+
+    size_t slot = hash_term(term, length) & (delta_slot_count - 1);
+    while (delta_slots[slot] != NO_PENDING) {
+        slot = (slot + 1) & (delta_slot_count - 1);
+    }
+    delta_slots[slot] = index;
+    return index;
+}
+
+// Position of doc in a list, or where it would be inserted.
+static size_t list_search(const PostingList *list, uint32_t doc) {
+    size_t low = 0;
+    size_t high = list->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (list->items[mid].doc < doc) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Drops every delta posting of a document.
+static void delta_remove_doc(uint32_t doc) {
+    for (size_t t = 0; t < delta_count; t++) {
+        PostingList *list = &delta_terms[t].list;
+        size_t pos = list_search(list, doc);
+        if (pos < list->count && list->items[pos].doc == doc) {
+            memmove(&list->items[pos], &list->items[pos + 1], (list->count - pos - 1) * sizeof(Posting));
+            list->count--;
+            delta_postings--;
+        }
+    }
+}
+
+static void delta_clear(void) {
+    for (size_t t = 0; t < delta_count; t++) {
+        free(delta_terms[t].list.items);
+    }
+    free(delta_terms);
+    free(delta_slots);
+    delta_terms = NULL;
+    delta_slots = NULL;
+    delta_count = delta_capacity = delta_slot_count = 0;
+    delta_postings = 0;
+}
+
+static int compare_delta_terms(const void *a, const void *b) {
+    return strcmp(delta_terms[*(const uint32_t *)a].term, delta_terms[*(const uint32_t *)b].term);
+}
+
+// Returns the delta term numbers in term order; the caller frees the array.
+static uint32_t *delta_sorted(void) {
+    uint32_t *order = malloc((delta_count ? delta_count : 1) * sizeof(uint32_t));
+    if (order) {
+        for (size_t t = 0; t < delta_count; t++) {
+            order[t] = (uint32_t)t;
+        }
+        qsort(order, delta_count, sizeof(uint32_t), compare_delta_terms);
+    }
+    return order;
+}
+
+// -----------------------------------------------------------------------------
+/* Document Table */
+// -----------------------------------------------------------------------------
+
+// Copies path with runs of '/' collapsed and a leading '/', as every path is stored.
+static void normalize_path(const char *path, char *out, size_t size) {
+    size_t length = 0;
+    out[length++] = '/';
+    for (const char *p = path; *p && length < size - 1; p++) {
+        if (*p == '/' && out[length - 1] == '/') {
+            continue;
+        }
+        out[length++] = *p;
+    }
+    out[length] = '\0';
+}
+
+static const char *doc_path(uint32_t doc) {
+    return doc_paths + docs[doc].path;
+}
+
+static uint32_t store_doc_path(const char *path) {
+    size_t length = strlen(path) + 1;
+    if (doc_paths_used + length > doc_paths_capacity) {
+        size_t capacity = doc_paths_capacity ? doc_paths_capacity : 4096;
+        while (capacity < doc_paths_used + length) {
+            capacity *= 2;
+        }
+        char *grown = realloc(doc_paths, capacity);
+        if (!grown) {
+            return NO_RECORD;
+        }
+        doc_paths = grown;
+        doc_paths_capacity = capacity;
+    }
+    memcpy(doc_paths + doc_paths_used, path, length);
+    doc_paths_used += length;
+    return (uint32_t)(doc_paths_used - length);
+}
+
+static uint32_t add_doc(const char *path, uint32_t record, uint8_t segment) {
+    if (doc_count == doc_capacity) {
+        size_t capacity = doc_capacity ? doc_capacity * 2 : 256;
+        SearchDoc *grown = realloc(docs, capacity * sizeof(SearchDoc));
+        if (!grown) {
+            return NO_RECORD;
+        }
+        docs = grown;
+        doc_capacity = capacity;
+    }
+    uint32_t offset = store_doc_path(path);
+    if (offset == NO_RECORD) {
+        return NO_RECORD;
+    }
+    docs[doc_count] = (SearchDoc){ .path = offset, .record = record, .segment = segment, .dirty = false };
+    return (uint32_t)doc_count++;
+}
+
+static uint32_t find_doc(const char *path) {
+    for (size_t d = 0; d < doc_count; d++) {
+        if (strcmp(doc_path((uint32_t)d), path) == 0) {
+            return (uint32_t)d;
+        }
+    }
+    return NO_RECORD;
+}
+
+// Document records are [segment][path length, 2 bytes][path]; the record
+// number is the document number used in the postings.
+static bool load_docs(void) {
+    long size = hal_storage_file_size(DOCS_PATH);
+    if (size < 0) {
+        needs_build = true;
+        return true;
+    }
+    char *data = malloc(size ? (size_t)size : 1);
+    if (!data || hal_storage_read_range(DOCS_PATH, 0, data, (size_t)size) != (int)size) {
+        free(data);
+        return false;
+    }
+    char path[SEARCH_PATH_LEN];
+    size_t pos = 0;
+    while (pos + 3 <= (size_t)size) {
+        size_t length = (uint8_t)data[pos + 1] | (size_t)(uint8_t)data[pos + 2] << 8;
+        if (pos + 3 + length > (size_t)size || length >= sizeof(path)) {
+            break; // Torn record at the end
+        }
+        memcpy(path, data + pos + 3, length);
+        path[length] = '\0';
+        if (add_doc(path, (uint32_t)pos, (uint8_t)data[pos]) == NO_RECORD) {
+            free(data);
+            return false;
+        }
+        pos += 3 + length;
+    }
+    docs_file_size = pos;
+    free(data);
+    return true;
+}
+
+// Writes every record into a temporary file with one write and puts it in
+// place by rename, so a power loss leaves either the old or the new table.
+static bool rewrite_docs(void) {
+    ByteBuffer table = { .ok = true };
+    for (size_t d = 0; d < doc_count; d++) {
+        const char *path = doc_path((uint32_t)d);
+        size_t length = strlen(path);
+        uint8_t header[3] = { docs[d].segment, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8) };
+        buffer_put(&table, header, 3);
+        buffer_put(&table, path, length);
+    }
+    bool ok = table.ok && hal_storage_write_file(DOCS_TMP_PATH, (const char *)table.data, table.length) &&
+              hal_storage_rename_file(DOCS_TMP_PATH, DOCS_PATH);
+    if (ok) {
+        size_t pos = 0;
+        for (size_t d = 0; d < doc_count; d++) {
+            docs[d].record = (uint32_t)pos;
+            docs[d].dirty = false;
+            pos += 3 + strlen(doc_path((uint32_t)d));
+        }
+        docs_file_size = pos;
+        docs_rewrite = false;
+    } else {
+        hal_storage_delete_file(DOCS_TMP_PATH);
+    }
+    free(table.data);
+    return ok;
+}
+
+// Appends the records of new documents and rewrites the segment byte of changed ones.
+static bool save_docs(void) {
+    if (docs_rewrite) {
+        return rewrite_docs();
+    }
+    bool ok = true;
+    for (size_t d = 0; d < doc_count; d++) {
+        SearchDoc *doc = &docs[d];
+        if (doc->record == NO_RECORD) {
+            const char *path = doc_path((uint32_t)d);
+            size_t length = strlen(path);
+            char header[3] = { (char)doc->segment, (char)(length & 0xFF), (char)(length >> 8) };
+            if (hal_storage_write_range(DOCS_PATH, docs_file_size, header, 3) &&
+                hal_storage_write_range(DOCS_PATH, docs_file_size + 3, path, length)) {
+                doc->record = (uint32_t)docs_file_size;
+                docs_file_size += 3 + length;
+                doc->dirty = false;
+            } else {
+                ok = false;
+            }
+        } else if (doc->dirty) {
+            char segment = (char)doc->segment;
+            doc->dirty = !hal_storage_write_range(DOCS_PATH, doc->record, &segment, 1);
+            ok = ok && !doc->dirty;
+        }
+    }
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+/* Indexing */
+// -----------------------------------------------------------------------------
+
+static bool is_word_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+static bool is_indexed_path(const char *path) {
+    const char *dot = strrchr(path, '.');
+    return dot && !strchr(dot, '/') && (strcmp(dot, ".txt") == 0 || strcmp(dot, ".md") == 0) &&
+           strncmp(path, SEARCH_INDEX_DIR "/", sizeof(SEARCH_INDEX_DIR)) != 0;
+}
+
+typedef struct {
+    uint32_t doc;
+    uint32_t *touched;      // Delta terms that got a posting for doc
+    size_t touched_count;
+    size_t touched_capacity;
+    bool ok;
+} IndexingState;
+
+static void add_occurrence(IndexingState *state, const char *term, size_t length, uint32_t offset) {
+    uint32_t index = delta_find(term, length, true);
+    if (index == NO_PENDING) {
+        state->ok = false;
+        return;
+    }
+    DeltaTerm *entry = &delta_terms[index];
+    if (entry->pending == NO_PENDING) {
+        // First occurrence in this document: insert its posting in doc order
+        if (state->touched_count == state->touched_capacity) {
+            size_t capacity = state->touched_capacity ? state->touched_capacity * 2 : 256;
+            uint32_t *grown = realloc(state->touched, capacity * sizeof(uint32_t));
+            if (!grown) {
+                state->ok = false;
+                return;
+            }
+            state->touched = grown;
+            state->touched_capacity = capacity;
+        }
+        if (!list_reserve(&entry->list, entry->list.count + 1)) {
+            state->ok = false;
+            return;
+        }
+        size_t pos = list_search(&entry->list, state->doc);
+        memmove(&entry->list.items[pos + 1], &entry->list.items[pos], (entry->list.count - pos) * sizeof(Posting));
+        entry->list.items[pos] = (Posting){ state->doc, 0, offset };
+        entry->list.count++;
+        entry->pending = (uint32_t)pos;
+        state->touched[state->touched_count++] = index;
+        delta_postings++;
+    }
+    entry->list.items[entry->pending].tf++;
+}
+
+// Reads a document in chunks and adds a posting per distinct word to the delta.
+static bool index_document(uint32_t doc, const char *path) {
+    IndexingState state = { .doc = doc, .ok = true };
+    char chunk[READ_CHUNK];
+    char word[SEARCH_TERM_MAX];
+    size_t word_length = 0;
+    uint32_t word_start = 0;
+    size_t offset = 0;
+    int read;
+
+    while (state.ok && (read = hal_storage_read_range(path, offset, chunk, sizeof(chunk))) > 0) {
+        for (int i = 0; i < read; i++) {
+            unsigned char c = (unsigned char)chunk[i];
+            if (is_word_byte(c)) {
+                if (word_length == 0) {
+                    word_start = (uint32_t)(offset + (size_t)i);
+                }
+                if (word_length < SEARCH_TERM_MAX) {
+                    word[word_length] = (char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+                }
+                word_length++;
+            } else if (word_length > 0) {
+                if (word_length >= MIN_TERM) {
+                    add_occurrence(&state, word, word_length < SEARCH_TERM_MAX ? word_length : SEARCH_TERM_MAX, word_start);
+                }
+                word_length = 0;
+            }
+        }
+        offset += (size_t)read;
+    }
+    if (state.ok && word_length >= MIN_TERM) {
+        add_occurrence(&state, word, word_length < SEARCH_TERM_MAX ? word_length : SEARCH_TERM_MAX, word_start);
+    }
+
+    for (size_t i = 0; i < state.touched_count; i++) {
+        delta_terms[state.touched[i]].pending = NO_PENDING;
+    }
+    free(state.touched);
+    return state.ok;
+}
+
+// Merges two doc-ordered lists of disjoint documents into out.
+static bool merge_lists(const PostingList *a, const PostingList *b, PostingList *out) {
+    out->count = 0;
+    if (!list_reserve(out, a->count + b->count)) {
+        return false;
+    }
+    size_t i = 0, j = 0;
+    while (i < a->count || j < b->count) {
+        if (j >= b->count || (i < a->count && a->items[i].doc < b->items[j].doc)) {
+            out->items[out->count++] = a->items[i++];
+        } else {
+            out->items[out->count++] = b->items[j++];
+        }
+    }
+    return true;
+}
+
+// Writes the live postings of the main segment and the delta into a new main
+// segment, then points every delta document at it.
+static bool merge_delta(void) {
+    uint32_t *order = delta_sorted();
+    if (!order) {
+        return false;
+    }
+
+    SegmentWriter writer;
+    writer_begin(&writer, TMP_PATH);
+    SegmentCursor cursor;
+    cursor_open(&cursor, &main_segment, MAIN_PATH);
+    PostingList main_list = { 0 };
+    PostingList merged = { 0 };
+    char term[SEARCH_TERM_MAX + 1];
+    bool have_main = cursor_next(&cursor, term, SEGMENT_MAIN, &main_list);
+    size_t next = 0;
+    bool ok = true;
+
+    while (ok && (have_main || next < delta_count)) {
+        int cmp = !have_main ? 1 : next >= delta_count ? -1 : strcmp(term, delta_terms[order[next]].term);
+        if (cmp < 0) {
+            writer_add(&writer, term, &main_list);
+            have_main = cursor_next(&cursor, term, SEGMENT_MAIN, &main_list);
+        } else if (cmp > 0) {
+            DeltaTerm *entry = &delta_terms[order[next++]];
+            writer_add(&writer, entry->term, &entry->list);
+        } else {
+            DeltaTerm *entry = &delta_terms[order[next++]];
+            ok = merge_lists(&main_list, &entry->list, &merged);
+            writer_add(&writer, term, &merged);
+            have_main = cursor_next(&cursor, term, SEGMENT_MAIN, &main_list);
+        }
+    }
+    ok = ok && cursor.ok && writer_finish(&writer);
+    cursor_close(&cursor);
+    free(main_list.items);
+    free(merged.items);
+    free(order);
+
+    // Replacing the main segment is the commit point: until then the old main
+    // and delta files still describe every document
+    if (!ok || !hal_storage_rename_file(TMP_PATH, MAIN_PATH) || !segment_open(&main_segment, MAIN_PATH)) {
+        hal_storage_delete_file(TMP_PATH);
+        return false;
+    }
+    for (size_t d = 0; d < doc_count; d++) {
+        if (docs[d].segment == SEGMENT_DELTA) {
+            docs[d].segment = SEGMENT_MAIN;
+            docs[d].dirty = true;
+        }
+    }
+    save_docs();
+    delta_clear();
+    hal_storage_delete_file(DELTA_PATH);
+    delta_dirty = false;
+    merge_count++;
+    return true;
+}
+
+// Loads the postings of the delta file that are still current.
+static bool load_delta(void) {
+    Segment segment = { 0 };
+    if (!segment_open(&segment, DELTA_PATH)) {
+        return false;
+    }
+    SegmentCursor cursor;
+    cursor_open(&cursor, &segment, DELTA_PATH);
+    PostingList list = { 0 };
+    char term[SEARCH_TERM_MAX + 1];
+    bool ok = true;
+    while (ok && cursor_next(&cursor, term, SEGMENT_DELTA, &list)) {
+        if (list.count == 0) {
+            continue;
+        }
+        uint32_t index = delta_find(term, strlen(term), true);
+        PostingList *target = index != NO_PENDING ? &delta_terms[index].list : NULL;
+        ok = target && list_reserve(target, list.count);
+        if (ok) {
+            memcpy(target->items, list.items, list.count * sizeof(Posting));
+            target->count = list.count;
+            delta_postings += list.count;
+        }
+    }
+    ok = ok && cursor.ok;
+    cursor_close(&cursor);
+    free(list.items);
+    segment_free(&segment);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+bool search_index_open(void) {
+    search_index_close();
+    if (!load_docs()) {
+        return false;
+    }
+    return segment_open(&main_segment, MAIN_PATH) && load_delta();
+}
+
+bool search_index_needs_build(void) {
+    return needs_build;
+}
+
+bool search_index_update(const char *path) {
+    char normalized[SEARCH_PATH_LEN];
+    normalize_path(path, normalized, sizeof(normalized));
+    if (!is_indexed_path(normalized)) {
+        return true;
+    }
+
+    uint32_t doc = find_doc(normalized);
+    if (doc == NO_RECORD) {
+        doc = add_doc(normalized, NO_RECORD, SEGMENT_NONE);
+        if (doc == NO_RECORD) {
+            return false;
+        }
+    } else if (docs[doc].segment == SEGMENT_DELTA) {
+        delta_remove_doc(doc);
+    }
+
+    // From here on the main segment's postings of the document are stale
+    docs[doc].segment = SEGMENT_DELTA;
+    docs[doc].dirty = true;
+    delta_dirty = true;
+    if (!index_document(doc, normalized)) {
+        delta_remove_doc(doc);
+        docs[doc].segment = SEGMENT_NONE;
+        return false;
+    }
+
+    if (delta_postings > DELTA_MAX_POSTINGS) {
+        return merge_delta();
+    }
+    return true;
+}
+
+bool search_index_commit(void) {
+    hal_storage_create_directory(SEARCH_INDEX_DIR);
+
+    if (delta_dirty) {
+        if (delta_postings == 0) {
+            hal_storage_delete_file(DELTA_PATH);
+        } else {
+            uint32_t *order = delta_sorted();
+            if (!order) {
+                return false;
+            }
+            SegmentWriter writer;
+            writer_begin(&writer, TMP_PATH);
+            for (size_t t = 0; t < delta_count; t++) {
+                writer_add(&writer, delta_terms[order[t]].term, &delta_terms[order[t]].list);
+            }
+            free(order);
+            if (!writer_finish(&writer) || !hal_storage_rename_file(TMP_PATH, DELTA_PATH)) {
+                hal_storage_delete_file(TMP_PATH);
+                return false;
+            }
+        }
+        delta_dirty = false;
+    }
+    if (!save_docs()) {
+        return false;
+    }
+    needs_build = false;
+    return true;
+}
+
+void search_index_rename(const char *old_path, const char *new_path) {
+    char old_normalized[SEARCH_PATH_LEN];
+    char new_normalized[SEARCH_PATH_LEN];
+    normalize_path(old_path, old_normalized, sizeof(old_normalized));
+    normalize_path(new_path, new_normalized, sizeof(new_normalized));
+    size_t old_length = strlen(old_normalized);
+
+    bool affected = false;
+    for (size_t d = 0; d < doc_count && !affected; d++) {
+        const char *path = doc_path((uint32_t)d);
+        affected = strncmp(path, old_normalized, old_length) == 0 && (path[old_length] == '\0' || path[old_length] == '/');
+    }
+    if (!affected) {
+        return;
+    }
+
+    // Records have the path in them, so the next commit writes the table again in full
+    char *paths = doc_paths;
+    doc_paths = NULL;
+    doc_paths_used = doc_paths_capacity = 0;
+
+    char renamed[SEARCH_PATH_LEN];
+    for (size_t d = 0; d < doc_count; d++) {
+        const char *path = paths + docs[d].path;
+        if (strncmp(path, old_normalized, old_length) == 0 && (path[old_length] == '\0' || path[old_length] == '/')) {
+            snprintf(renamed, sizeof(renamed), "%s%s", new_normalized, path + old_length);
+            path = renamed;
+        }
+        uint32_t offset = store_doc_path(path);
+        docs[d].path = offset != NO_RECORD ? offset : 0;
+    }
+    free(paths);
+    docs_rewrite = true;
+}
+
+size_t search_index_query(const char *query, SearchHit *hits, size_t max) {
+    // Split the query into words the way documents are split
+    char terms[SEARCH_QUERY_TERMS][SEARCH_TERM_MAX + 1];
+    size_t term_count = 0;
+    for (const char *p = query; *p && term_count < SEARCH_QUERY_TERMS; ) {
+        if (!is_word_byte((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+        size_t length = 0;
+        for (; is_word_byte((unsigned char)*p); p++) {
+            if (length < SEARCH_TERM_MAX) {
+                char c = *p;
+                terms[term_count][length++] = (char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+            }
+        }
+        terms[term_count][length] = '\0';
+        if (length >= MIN_TERM) {
+            term_count++;
+        }
+    }
+    if (term_count == 0) {
+        return 0;
+    }
+
+    // Postings of each word: live main postings plus the delta's
+    PostingList lists[SEARCH_QUERY_TERMS] = { { 0 } };
+    PostingList main_list = { 0 };
+    bool ok = true;
+    for (size_t t = 0; t < term_count && ok; t++) {
+        main_list.count = 0;
+        ok = segment_lookup(&main_segment, MAIN_PATH, terms[t], &main_list);
+        uint32_t index = delta_find(terms[t], strlen(terms[t]), false);
+        PostingList empty = { 0 };
+        ok = ok && merge_lists(&main_list, index != NO_PENDING ? &delta_terms[index].list : &empty, &lists[t]);
+    }
+    free(main_list.items);
+
+    // Intersect, rarest word first, summing the occurrences
+    size_t rarest = 0;
+    for (size_t t = 1; t < term_count; t++) {
+        if (lists[t].count < lists[rarest].count) {
+            rarest = t;
+        }
+    }
+    PostingList *result = &lists[rarest];
+    for (size_t t = 0; t < term_count && ok; t++) {
+        if (t == rarest) {
+            continue;
+        }
+        size_t kept = 0;
+        size_t j = 0;
+        for (size_t i = 0; i < result->count; i++) {
+            Posting *hit = &result->items[i];
+            j += list_search(&(PostingList){ lists[t].items + j, lists[t].count - j, 0 }, hit->doc);
+            if (j < lists[t].count && lists[t].items[j].doc == hit->doc) {
+                hit->tf += lists[t].items[j].tf;
+                if (lists[t].items[j].first < hit->first) {
+                    hit->first = lists[t].items[j].first;
+                }
+                result->items[kept++] = *hit;
+            }
+        }
+        result->count = kept;
+    }
+
+    // Keep the best max by score, then document order
+    size_t found = 0;
+    for (size_t i = 0; ok && i < result->count; i++) {
+        Posting *hit = &result->items[i];
+        if (found == max && (max == 0 || hit->tf <= hits[max - 1].score)) {
+            continue;
+        }
+        size_t pos = found < max ? found++ : max - 1;
+        while (pos > 0 && hits[pos - 1].score < hit->tf) {
+            hits[pos] = hits[pos - 1];
+            pos--;
+        }
+        snprintf(hits[pos].path, sizeof(hits[pos].path), "%s", doc_path(hit->doc));
+        hits[pos].offset = hit->first;
+        hits[pos].score = hit->tf;
+    }
+
+    for (size_t t = 0; t < term_count; t++) {
+        free(lists[t].items);
+    }
+    return ok ? found : 0;
+}
+
+SearchIndexStats search_index_stats(void) {
+    SearchIndexStats stats = {
+        .documents = (uint32_t)doc_count,
+        .main_terms = main_segment.term_count,
+        .main_bytes = main_segment.size,
+        .delta_postings = (uint32_t)delta_postings,
+        .merges = merge_count,
+    };
+    return stats;
+}
+
+void search_index_close(void) {
+    delta_clear();
+    segment_free(&main_segment);
+    free(docs);
+    free(doc_paths);
+    docs = NULL;
+    doc_paths = NULL;
+    doc_count = doc_capacity = 0;
+    doc_paths_used = doc_paths_capacity = 0;
+    docs_file_size = 0;
+    docs_rewrite = false;
+    delta_dirty = false;
+    needs_build = false;
+}
@@ -0,0 +1,103 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SEARCH_INDEX_DIR "/.search"     // Where the index files live on the card
+#define SEARCH_TERM_MAX 32              // Longer words are indexed by their first bytes
+#define SEARCH_QUERY_TERMS 8            // Words of a query that are used
+#define SEARCH_PATH_LEN 512
+
+/**
+ * @struct SearchHit
+ * @brief A document containing every word of a query.
+ */
+typedef struct {
+    char path[SEARCH_PATH_LEN];
+    uint32_t offset;    // Byte offset of the earliest occurrence of a query word
+    uint32_t score;     // Total occurrences of the query words
+} SearchHit;
+
+/**
+ * @struct SearchIndexStats
+ * @brief Sizes and counters of the index.
+ */
+typedef struct {
+    uint32_t documents;         // Documents indexed
+    uint32_t main_terms;        // Distinct words in the main segment
+    uint32_t main_bytes;        // Size of the main segment file
+    uint32_t delta_postings;    // Postings waiting in the delta segment
+    uint32_t merges;            // Delta merges into the main segment since open
+} SearchIndexStats;
+
+/**
+ * @brief Loads the index from SEARCH_INDEX_DIR.
+ *
+ * The index is kept as an immutable main segment and a small delta segment
+ * for documents saved since the last merge. Each segment is a sorted term
+ * dictionary in blocks, with delta and varint encoded posting lists. Only the
+ * first term of each dictionary block of the main segment is held in RAM; a
+ * lookup reads one block and one posting list from the card. The delta
+ * segment is small and held in RAM completely.
+ *
+ * @return true on success, false if the index could not be read. An index
+ *         that does not exist yet loads as empty.
+ */
+bool search_index_open(void);
+
+/**
+ * @brief Returns true if no index was found on the card, so it has to be built.
+ */
+bool search_index_needs_build(void);
+
+/**
+ * @brief Indexes the current content of a document, replacing what was indexed for it before.
+ *
+ * The file is read in chunks and its words go to the delta segment; once the
+ * delta holds too many postings it is merged into the main segment. Only
+ * .txt and .md documents are indexed; other paths are ignored.
+ *
+ * @return true on success (or if the path is not indexed), false on failure.
+ */
+bool search_index_update(const char *path);
+
+/**
+ * @brief Writes the pending delta segment and document table to the card.
+ *
+ * Call after search_index_update once the batch of updates is done.
+ *
+ * @return true on success, false if a file could not be written.
+ */
+bool search_index_commit(void);
+
+/**
+ * @brief Follows a rename of a document or of a folder holding documents.
+ *
+ * Only the paths in RAM change; the next search_index_commit writes the
+ * document table again, to a temporary file that replaces the old table.
+ */
+void search_index_rename(const char *old_path, const char *new_path);
+
+/**
+ * @brief Finds the documents that contain every word of query.
+ *
+ * Words are matched whole and case-insensitively. Hits are ordered by score.
+ *
+ * @param hits Receives up to max hits, best first.
+ * @return Number of hits written.
+ */
+size_t search_index_query(const char *query, SearchHit *hits, size_t max);
+
+/**
+ * @brief Returns the index sizes and counters.
+ */
+SearchIndexStats search_index_stats(void);
+
+/**
+ * @brief Releases the index memory. The files on the card are kept.
+ */
+void search_index_close(void);
+
+#endif // SEARCH_INDEX_H
@@ -0,0 +1,61 @@
+// side_file.c
+
+#include "side_file.h"
+#include <string.h>
+
+#define SIDE_FILE_PREFIX '.'
+
+static const char *const suffixes[] = { ".ct-jnl", ".ct-swp", ".ct-tmp", ".ct-old" };
+
+// Length of the folder part of path, up to and including its last '/'.
+static size_t folder_length(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? (size_t)(slash + 1 - path) : 0;
+}
+
+// Length of the document name inside the side file name, or 0 if it is not one of kind.
+static size_t document_name_length(const char *name, SideFileKind kind) {
+    size_t length = strlen(name);
+    size_t suffix_length = strlen(suffixes[kind]);
+    if (name[0] != SIDE_FILE_PREFIX || length <= 1 + suffix_length ||
+        strcmp(name + length - suffix_length, suffixes[kind]) != 0) {
+        return 0;
+    }
+    return length - 1 - suffix_length;
+}
+
+bool side_file_path(const char *doc_path, SideFileKind kind, char *out, size_t size) {
+    size_t folder = folder_length(doc_path);
+    size_t name_length = strlen(doc_path + folder);
+    size_t suffix_length = strlen(suffixes[kind]);
+    if (name_length == 0 || folder + 1 + name_length + suffix_length >= size) {
+        return false;
+    }
+    memcpy(out, doc_path, folder);
+    out[folder] = SIDE_FILE_PREFIX;
+    memcpy(out + folder + 1, doc_path + folder, name_length);
+    memcpy(out + folder + 1 + name_length, suffixes[kind], suffix_length + 1);
+    return true;
+}
+
+bool side_file_document(const char *path, SideFileKind kind, char *out, size_t size) {
+    size_t folder = folder_length(path);
+    size_t name_length = document_name_length(path + folder, kind);
+    if (name_length == 0 || folder + name_length >= size) {
+        return false;
+    }
+    memcpy(out, path, folder);
+    memcpy(out + folder, path + folder + 1, name_length);
+    out[folder + name_length] = '\0';
+    return true;
+}
+
+bool side_file_is_reserved(const char *path) {
+    const char *name = path + folder_length(path);
+    for (size_t kind = 0; kind < sizeof(suffixes) / sizeof(suffixes[0]); kind++) {
+        if (document_name_length(name, (SideFileKind)kind) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef SIDE_FILE_H
+#define SIDE_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @enum SideFileKind
+ * @brief The files the editor keeps next to a document.
+ *
+ * A side file of notes.txt is named .notes.txt.ct-jnl, .notes.txt.ct-swp and
+ * so on, in the same folder. The explorer refuses to create such a name or to
+ * rename anything to or from it, so a side file is never one of the user's
+ * files and recovery may replace or remove it.
+ */
+typedef enum {
+    SIDE_FILE_JOURNAL,  // Edit journal, see edit_journal.h
+    SIDE_FILE_SWAP,     // Dirty pages evicted from RAM
+    SIDE_FILE_TEMP,     // A rewrite of the document, renamed over it once complete
+    SIDE_FILE_OLD       // The previous file, read by a document edited while it was saved
+} SideFileKind;
+
+/**
+ * @brief Builds the path of a side file of doc_path.
+ *
+ * @return true on success, false if the path does not fit in size bytes.
+ */
+bool side_file_path(const char *doc_path, SideFileKind kind, char *out, size_t size);
+
+/**
+ * @brief Builds the path of the document a side file belongs to.
+ *
+ * @return true if the last component of path is a side file of that kind and
+ *         the document path fits in size bytes, false otherwise.
+ */
+bool side_file_document(const char *path, SideFileKind kind, char *out, size_t size);
+
+/**
+ * @brief Returns true if the last component of path is named like a side file of any kind.
+ */
+bool side_file_is_reserved(const char *path);
+
+#endif // SIDE_FILE_H
@@ -0,0 +1,54 @@
+#ifndef STORAGE_BACKEND_H
+#define STORAGE_BACKEND_H
+
+#include "hal_interface.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct StorageBackend
+ * @brief The card behind the hal_storage_* functions of the mock HAL.
+ *
+ * The primitive operations of a FAT volume. The remaining HAL calls are
+ * built from these in hal_mock_storage.c (hal_storage_read_file is stat and
+ * read, hal_storage_write_file is create_file and write, and so on), so a
+ * backend only implements what a card driver would. Paths are the HAL's
+ * virtual paths, "/" being the root. Operations may be called from the core
+ * and the storage worker at the same time; backends serialize as needed.
+ */
+typedef struct {
+    const char *name;
+
+    /** As hal_storage_list_entries. */
+    size_t (*list)(const char *directory, size_t start, DirEntry *entries, size_t max_entries);
+
+    /** As hal_storage_stat. */
+    bool (*stat)(const char *path, DirEntry *entry);
+
+    /** As hal_storage_read_range. */
+    int (*read)(const char *path, size_t offset, char *buffer, size_t length);
+
+    /** As hal_storage_write_range: creates the file if needed, never truncates. */
+    bool (*write)(const char *path, size_t offset, const char *buffer, size_t length);
+
+    /** As hal_storage_truncate. */
+    bool (*truncate)(const char *path, size_t length);
+
+    /** Creates an empty file, or empties an existing one. */
+    bool (*create_file)(const char *path);
+
+    /** As hal_storage_create_directory. */
+    bool (*create_directory)(const char *path);
+
+    /** As hal_storage_rename_file. */
+    bool (*rename)(const char *old_path, const char *new_path);
+
+    /** As hal_storage_delete_file. */
+    bool (*remove)(const char *path);
+
+    /** As hal_storage_dir_stamp. */
+    bool (*dir_stamp)(const char *path, uint64_t *stamp);
+} StorageBackend;
+
+#endif // STORAGE_BACKEND_H
@@ -0,0 +1,147 @@
+// storage_worker.c
+
+#include "storage_worker.h"
+#include "hal_interface.h"
+#include <pthread.h>
+#include <stdio.h>
+
+// Jobs move from the queue to the done list in order. Both are short rings
+// guarded by one mutex that is only held to move a job, never while it runs.
+static StorageJob queue[STORAGE_WORKER_JOBS];
+static size_t queue_head = 0;    // Next job to run
+static size_t queue_count = 0;
+static StorageJob done_jobs[STORAGE_WORKER_JOBS];
+static size_t done_head = 0;     // Next completion to collect
+static size_t done_count = 0;
+static size_t outstanding = 0;   // Submitted and not yet collected
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+static pthread_t worker_thread;
+static bool running = false;
+static bool stopping = false;
+
+// -----------------------------------------------------------------------------
+/* Worker Thread */
+// -----------------------------------------------------------------------------
+
+static void *worker_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (queue_count == 0 && !stopping) {
+            pthread_cond_wait(&job_queued, &lock);
+        }
+        if (queue_count == 0) {
+            break; // Stopping and nothing left to run
+        }
+        StorageJob job = queue[queue_head];
+        queue_head = (queue_head + 1) % STORAGE_WORKER_JOBS;
+        queue_count--;
+        pthread_mutex_unlock(&lock);
+
+        job.ok = job.run(job.context);
+
+        pthread_mutex_lock(&lock);
+        // outstanding bounds queued plus done, so there is always room here
+        done_jobs[(done_head + done_count) % STORAGE_WORKER_JOBS] = job;
+        done_count++;
+        pthread_cond_broadcast(&job_done);
+        pthread_mutex_unlock(&lock);
+        hal_event_signal();
+        pthread_mutex_lock(&lock);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+/* Lifecycle */
+// -----------------------------------------------------------------------------
+
+bool storage_worker_start(void) {
+    if (running) {
+        return true;
+    }
+    stopping = false;
+    if (pthread_create(&worker_thread, NULL, worker_main, NULL) != 0) {
+        perror("storage_worker pthread_create");
+        return false;
+    }
+    running = true;
+    return true;
+}
+
+void storage_worker_stop(void) {
+    if (!running) {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_signal(&job_queued);
+    pthread_mutex_unlock(&lock);
+    pthread_join(worker_thread, NULL);
+
+    running = false;
+    queue_count = 0;
+    done_count = 0;
+    outstanding = 0;
+}
+
+// -----------------------------------------------------------------------------
+/* Jobs */
+// -----------------------------------------------------------------------------
+
+bool storage_worker_submit(StorageJobFn run, void *context, int tag) {
+    if (!running) {
+        return false;
+    }
+    pthread_mutex_lock(&lock);
+    bool ok = outstanding < STORAGE_WORKER_JOBS;
+    if (ok) {
+        StorageJob job = { run, context, tag, false };
+        queue[(queue_head + queue_count) % STORAGE_WORKER_JOBS] = job;
+        queue_count++;
+        outstanding++;
+        pthread_cond_signal(&job_queued);
+    }
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+// Takes the oldest completion. The lock must be held.
+static bool collect(StorageJob *done) {
+    if (done_count == 0) {
+        return false;
+    }
+    *done = done_jobs[done_head];
+    done_head = (done_head + 1) % STORAGE_WORKER_JOBS;
+    done_count--;
+    outstanding--;
+    return true;
+}
+
+bool storage_worker_poll(StorageJob *done) {
+    pthread_mutex_lock(&lock);
+    bool found = collect(done);
+    pthread_mutex_unlock(&lock);
+    return found;
+}
+
+bool storage_worker_wait(StorageJob *done) {
+    pthread_mutex_lock(&lock);
+    while (done_count == 0 && outstanding > 0) {
+        pthread_cond_wait(&job_done, &lock);
+    }
+    bool found = collect(done);
+    pthread_mutex_unlock(&lock);
+    return found;
+}
+
+size_t storage_worker_outstanding(void) {
+    pthread_mutex_lock(&lock);
+    size_t count = outstanding;
+    pthread_mutex_unlock(&lock);
+    return count;
+}
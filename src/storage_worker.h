@@ -0,0 +1,74 @@
+#ifndef STORAGE_WORKER_H
+#define STORAGE_WORKER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define STORAGE_WORKER_JOBS 8   // Jobs submitted and not yet collected, at most
+
+/**
+ * @brief Storage work to run on the worker thread.
+ *
+ * @param context The caller's data, owned by the job until it completes.
+ * @return true on success, false on failure.
+ */
+typedef bool (*StorageJobFn)(void *context);
+
+/**
+ * @struct StorageJob
+ * @brief A job handed to the storage worker, and returned once it has run.
+ */
+typedef struct {
+    StorageJobFn run;   // Called on the worker thread
+    void *context;      // Passed to run
+    int tag;            // The caller's job kind, for dispatching the completion
+    bool ok;            // Result of run, set on completion
+} StorageJob;
+
+/**
+ * @brief Starts the worker thread.
+ *
+ * Storage operations that may take as long as the card wants (saving a
+ * document, reading ahead) are run there in submission order, so the core
+ * loop keeps handling keys and drawing meanwhile. Every completed job wakes
+ * the core through hal_event_signal; the core collects it with
+ * storage_worker_poll.
+ *
+ * @return true on success, false if the thread could not be created.
+ */
+bool storage_worker_start(void);
+
+/**
+ * @brief Runs the queued jobs and stops the thread. Uncollected completions are dropped.
+ */
+void storage_worker_stop(void);
+
+/**
+ * @brief Queues a job.
+ *
+ * @return true on success, false if the worker is not running or
+ *         STORAGE_WORKER_JOBS jobs are outstanding. The caller should then do
+ *         the work itself.
+ */
+bool storage_worker_submit(StorageJobFn run, void *context, int tag);
+
+/**
+ * @brief Collects one completed job without waiting.
+ *
+ * @return true if a completed job was written to done.
+ */
+bool storage_worker_poll(StorageJob *done);
+
+/**
+ * @brief Waits until a job completes and collects it.
+ *
+ * @return true if a completed job was written to done, false if no job is outstanding.
+ */
+bool storage_worker_wait(StorageJob *done);
+
+/**
+ * @brief Returns the number of jobs submitted and not yet collected.
+ */
+size_t storage_worker_outstanding(void);
+
+#endif // STORAGE_WORKER_H
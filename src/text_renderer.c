@@ -0,0 +1,207 @@
+// text_renderer.c
+
+#include "text_renderer.h"
+#include <string.h>
+
+#define UNDERLINE_ROW (FONT_GLYPH_HEIGHT - 1)
+
+// Glyphs blended once into framebuffer pixels; cells are copied from here.
+static RenderPixel atlas[FONT_GLYPH_COUNT][FONT_GLYPH_HEIGHT][FONT_GLYPH_WIDTH];
+static RenderPixel paper_pixel;
+static RenderPixel ink_pixel;
+
+// What the panel should show. 600 KB: on the ESP32-S3 this lives in PSRAM.
+static RenderPixel framebuffer[TEXT_RENDERER_HEIGHT][TEXT_RENDERER_WIDTH];
+static ScreenCell cells[VSCREEN_ROWS][VSCREEN_COLS];   // Character drawn in each cell
+
+// Changed cells per row, dirty_start > dirty_end when the row is clean
+static int dirty_start[VSCREEN_ROWS];
+static int dirty_end[VSCREEN_ROWS];
+
+static TextRendererFlush flush_cb;
+static TextRendererStats stats;
+static int cursor_row = 0;
+static int cursor_col = 0;
+static uint8_t cursor_attr = CELL_ATTR_NONE;
+
+// -----------------------------------------------------------------------------
+/* Glyph Atlas */
+// -----------------------------------------------------------------------------
+
+static void build_atlas(void) {
+    static PixelShades shades;
+    pixel_shades_init(&shades, TEXT_RENDERER_PAPER, TEXT_RENDERER_INK);
+    paper_pixel = shades.shades[0];
+    ink_pixel = shades.shades[15];
+    for (int glyph = 0; glyph < FONT_GLYPH_COUNT; glyph++) {
+        pixel_expand_4bpp(atlas[glyph][0], font_8x16[glyph], FONT_GLYPH_HEIGHT, &shades);
+    }
+}
+
+// -----------------------------------------------------------------------------
+/* Drawing */
+// -----------------------------------------------------------------------------
+
+static void mark_dirty(int row, int col) {
+    if (dirty_start[row] > dirty_end[row]) {
+        dirty_start[row] = col;
+        dirty_end[row] = col;
+    } else if (col < dirty_start[row]) {
+        dirty_start[row] = col;
+    } else if (col > dirty_end[row]) {
+        dirty_end[row] = col;
+    }
+}
+
+static void mark_clean(void) {
+    for (int row = 0; row < VSCREEN_ROWS; row++) {
+        dirty_start[row] = VSCREEN_COLS;
+        dirty_end[row] = -1;
+    }
+}
+
+// Copies the glyph for c from the atlas into a cell of the framebuffer.
+static void draw_cell(int row, int col, char c, uint8_t attr) {
+    ScreenCell *cell = &cells[row][col];
+    if (cell->ch == c && cell->attr == attr) {
+        return;
+    }
+    cell->ch = c;
+    cell->attr = attr;
+
+    unsigned char glyph_char = (unsigned char)c;
+    if (glyph_char < FONT_FIRST_CHAR || glyph_char > FONT_LAST_CHAR) {
+        glyph_char = ' ';
+    }
+    const RenderPixel (*glyph)[FONT_GLYPH_WIDTH] = atlas[glyph_char - FONT_FIRST_CHAR];
+    RenderPixel *out = &framebuffer[row * FONT_GLYPH_HEIGHT][col * FONT_GLYPH_WIDTH];
+    for (int y = 0; y < FONT_GLYPH_HEIGHT; y++) {
+        memcpy(out, glyph[y], sizeof(glyph[y]));
+        out += TEXT_RENDERER_WIDTH;
+    }
+    if (attr == CELL_ATTR_UNDERLINE) {
+        out -= TEXT_RENDERER_WIDTH * (FONT_GLYPH_HEIGHT - UNDERLINE_ROW);
+        pixel_fill(out, ink_pixel, FONT_GLYPH_WIDTH);
+    }
+
+    stats.glyphs_drawn++;
+    mark_dirty(row, col);
+}
+
+// Applies the underline/reset attributes of an ANSI escape sequence starting
+// at text[0] == '\033' and returns the sequence length.
+static size_t parse_escape(const char *text) {
+    if (text[1] != '[') {
+        return 1;
+    }
+    size_t i = 2;
+    int param = 0;
+    while ((text[i] >= '0' && text[i] <= '9') || text[i] == ';') {
+        param = text[i] == ';' ? 0 : param * 10 + (text[i] - '0');
+        i++;
+    }
+    if (text[i] == '\0') {
+        return i;
+    }
+    if (text[i] == 'm') {
+        cursor_attr = param == 4 ? CELL_ATTR_UNDERLINE : CELL_ATTR_NONE;
+    }
+    return i + 1;
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void text_renderer_init(TextRendererFlush flush) {
+    flush_cb = flush;
+    memset(&stats, 0, sizeof(stats));
+    build_atlas();
+    text_renderer_clear();
+    cursor_attr = CELL_ATTR_NONE;
+}
+
+void text_renderer_clear(void) {
+    pixel_fill(framebuffer[0], paper_pixel, (size_t)TEXT_RENDERER_WIDTH * TEXT_RENDERER_HEIGHT);
+    for (int row = 0; row < VSCREEN_ROWS; row++) {
+        for (int col = 0; col < VSCREEN_COLS; col++) {
+            cells[row][col].ch = ' ';
+            cells[row][col].attr = CELL_ATTR_NONE;
+        }
+        dirty_start[row] = 0;
+        dirty_end[row] = VSCREEN_COLS - 1;
+    }
+    cursor_row = 0;
+    cursor_col = 0;
+}
+
+void text_renderer_set_cursor(int row, int col) {
+    cursor_row = row;
+    cursor_col = col;
+}
+
+void text_renderer_write(const char *text) {
+    for (size_t i = 0; text[i] != '\0';) {
+        if (text[i] == '\033') {
+            i += parse_escape(text + i);
+            continue;
+        }
+        if (cursor_row >= 0 && cursor_row < VSCREEN_ROWS && cursor_col >= 0 && cursor_col < VSCREEN_COLS) {
+            draw_cell(cursor_row, cursor_col, text[i], cursor_attr);
+        }
+        cursor_col++;
+        i++;
+    }
+}
+
+size_t text_renderer_flush(void) {
+    size_t pixels = 0;
+    int row = 0;
+    while (row < VSCREEN_ROWS) {
+        if (dirty_start[row] > dirty_end[row]) {
+            row++;
+            continue;
+        }
+
+        // Grow the rectangle over the following dirty rows while the clean
+        // cells it would resend stay within TEXT_RENDERER_MERGE_CELLS
+        int start = dirty_start[row];
+        int end = dirty_end[row];
+        int last = row;
+        int dirty_cells = end - start + 1;
+        while (last + 1 < VSCREEN_ROWS && dirty_start[last + 1] <= dirty_end[last + 1]) {
+            int next = last + 1;
+            int merged_start = dirty_start[next] < start ? dirty_start[next] : start;
+            int merged_end = dirty_end[next] > end ? dirty_end[next] : end;
+            int merged_dirty = dirty_cells + dirty_end[next] - dirty_start[next] + 1;
+            if ((merged_end - merged_start + 1) * (next - row + 1) - merged_dirty > TEXT_RENDERER_MERGE_CELLS) {
+                break;
+            }
+            start = merged_start;
+            end = merged_end;
+            dirty_cells = merged_dirty;
+            last = next;
+        }
+
+        RenderRect rect = {
+            .x = start * FONT_GLYPH_WIDTH,
+            .y = row * FONT_GLYPH_HEIGHT,
+            .width = (end - start + 1) * FONT_GLYPH_WIDTH,
+            .height = (last - row + 1) * FONT_GLYPH_HEIGHT
+        };
+        if (flush_cb) {
+            flush_cb(&rect, &framebuffer[rect.y][rect.x], TEXT_RENDERER_WIDTH);
+        }
+        pixels += (size_t)rect.width * (size_t)rect.height;
+        stats.rects_flushed++;
+        row = last + 1;
+    }
+
+    stats.pixels_flushed += pixels;
+    mark_clean();
+    return pixels;
+}
+
+TextRendererStats text_renderer_stats(void) {
+    return stats;
+}
@@ -0,0 +1,94 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include "font_8x16.h"
+#include "pixel_kernels.h"
+#include "virtual_screen.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define TEXT_RENDERER_WIDTH (VSCREEN_COLS * FONT_GLYPH_WIDTH)     // 960 px
+#define TEXT_RENDERER_HEIGHT (VSCREEN_ROWS * FONT_GLYPH_HEIGHT)   // 320 px
+#define TEXT_RENDERER_INK 0xE8E8E0     // Text colour, 0xRRGGBB
+#define TEXT_RENDERER_PAPER 0x101010   // Background colour, 0xRRGGBB
+#define TEXT_RENDERER_MERGE_CELLS 4    // Clean cells worth resending to save one transfer
+
+/**
+ * @struct RenderRect
+ * @brief A rectangle of the framebuffer, in pixels.
+ */
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} RenderRect;
+
+/**
+ * @brief Sends a rectangle of the framebuffer to the panel.
+ *
+ * pixels points at the top-left pixel of rect inside the framebuffer, and
+ * consecutive rows are stride pixels apart. The pixels must be sent before
+ * the callback returns.
+ */
+typedef void (*TextRendererFlush)(const RenderRect *rect, const RenderPixel *pixels, size_t stride);
+
+/**
+ * @struct TextRendererStats
+ * @brief Work done by the renderer since text_renderer_init.
+ */
+typedef struct {
+    uint32_t glyphs_drawn;     // Cells blitted into the framebuffer
+    uint32_t rects_flushed;    // Calls to the flush callback
+    uint64_t pixels_flushed;   // Pixels handed to the flush callback
+} TextRendererStats;
+
+/**
+ * @brief Rasterizes the font into the glyph atlas and clears the framebuffer.
+ *
+ * The atlas holds every glyph already blended between TEXT_RENDERER_PAPER and
+ * TEXT_RENDERER_INK as framebuffer pixels, so drawing a cell is a copy of
+ * sixteen rows. The first text_renderer_flush sends the whole screen.
+ *
+ * @param flush Called by text_renderer_flush for each dirty rectangle.
+ */
+void text_renderer_init(TextRendererFlush flush);
+
+/**
+ * @brief Blanks every cell with one fill of the framebuffer; the next flush sends the whole screen.
+ */
+void text_renderer_clear(void);
+
+/**
+ * @brief Moves the cell position that text_renderer_write draws from.
+ */
+void text_renderer_set_cursor(int row, int col);
+
+/**
+ * @brief Draws text into the framebuffer from the current cell position.
+ *
+ * The same text hal_display_write takes: "\033[4m" and "\033[0m" switch
+ * underlining on and off, other escape sequences are ignored and text past
+ * the right edge is dropped. Cells that already show the same character are
+ * not redrawn. Nothing reaches the panel until text_renderer_flush.
+ */
+void text_renderer_write(const char *text);
+
+/**
+ * @brief Sends the cells changed since the last flush to the panel.
+ *
+ * Changed cells are tracked as one column span per text row. Adjacent rows
+ * are merged into one rectangle as long as that resends no more than
+ * TEXT_RENDERER_MERGE_CELLS unchanged cells, since every transfer costs a
+ * window setup on the panel.
+ *
+ * @return Number of pixels sent.
+ */
+size_t text_renderer_flush(void);
+
+/**
+ * @brief Returns the counters since text_renderer_init.
+ */
+TextRendererStats text_renderer_stats(void);
+
+#endif // TEXT_RENDERER_H
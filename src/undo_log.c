@@ -0,0 +1,180 @@
+// undo_log.c
+
+#include "undo_log.h"
+#include <string.h>
+
+// Record layout: type, pos (32 bits), length (16 bits), the bytes, then the
+// record size (16 bits) so the record can also be found from its end.
+// Numbers are little endian.
+#define HEADER_SIZE 7
+#define TRAILER_SIZE 2
+
+// -----------------------------------------------------------------------------
+/* Ring Arena */
+// -----------------------------------------------------------------------------
+
+// Offsets wrap around at 2^32, which keeps them in step with the arena index
+// as long as the arena size is a power of two.
+#if (UNDO_LOG_ARENA_BYTES & (UNDO_LOG_ARENA_BYTES - 1)) != 0
+#error "UNDO_LOG_ARENA_BYTES must be a power of two"
+#endif
+
+static void ring_write(UndoLog *log, uint32_t at, const char *data, size_t length) {
+    size_t index = at % UNDO_LOG_ARENA_BYTES;
+    size_t first = UNDO_LOG_ARENA_BYTES - index < length ? UNDO_LOG_ARENA_BYTES - index : length;
+    memcpy(log->arena + index, data, first);
+    memcpy(log->arena, data + first, length - first);
+}
+
+static void ring_read(const UndoLog *log, uint32_t at, char *data, size_t length) {
+    size_t index = at % UNDO_LOG_ARENA_BYTES;
+    size_t first = UNDO_LOG_ARENA_BYTES - index < length ? UNDO_LOG_ARENA_BYTES - index : length;
+    memcpy(data, log->arena + index, first);
+    memcpy(data + first, log->arena, length - first);
+}
+
+// Reads the record starting at offset at into step and returns its size.
+static uint32_t read_record(const UndoLog *log, uint32_t at, UndoStep *step) {
+    char header[HEADER_SIZE];
+    ring_read(log, at, header, HEADER_SIZE);
+    step->type = (UndoType)header[0];
+    step->pos = 0;
+    for (int i = 0; i < 4; i++) {
+        step->pos |= (size_t)(uint8_t)header[1 + i] << (8 * i);
+    }
+    step->length = (size_t)(uint8_t)header[5] | (size_t)(uint8_t)header[6] << 8;
+    ring_read(log, at + HEADER_SIZE, step->text, step->length);
+    return (uint32_t)(HEADER_SIZE + step->length + TRAILER_SIZE);
+}
+
+static void drop_oldest(UndoLog *log) {
+    UndoStep step;
+    log->oldest += read_record(log, log->oldest, &step);
+    log->dropped++;
+}
+
+// Moves the open record into the arena, dropping old history to make room.
+static void flush_open(UndoLog *log) {
+    if (!log->has_open) {
+        return;
+    }
+    log->has_open = false;
+
+    const UndoStep *step = &log->open;
+    uint32_t size = (uint32_t)(HEADER_SIZE + step->length + TRAILER_SIZE);
+    while (log->newest + size - log->oldest > UNDO_LOG_ARENA_BYTES) {
+        drop_oldest(log);
+    }
+
+    char header[HEADER_SIZE];
+    header[0] = (char)step->type;
+    for (int i = 0; i < 4; i++) {
+        header[1 + i] = (char)(step->pos >> (8 * i));
+    }
+    header[5] = (char)step->length;
+    header[6] = (char)(step->length >> 8);
+    char trailer[TRAILER_SIZE] = { (char)size, (char)(size >> 8) };
+
+    ring_write(log, log->newest, header, HEADER_SIZE);
+    ring_write(log, log->newest + HEADER_SIZE, step->text, step->length);
+    ring_write(log, log->newest + HEADER_SIZE + (uint32_t)step->length, trailer, TRAILER_SIZE);
+    log->newest += size;
+    log->current = log->newest;
+}
+
+// -----------------------------------------------------------------------------
+/* Recording */
+// -----------------------------------------------------------------------------
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\t';
+}
+
+// Text continuing after whitespace begins a new word, and a new undo step.
+static bool starts_word(char before, char after) {
+    return is_space(before) && !is_space(after);
+}
+
+// Merges an edit into the open record if it continues it, or opens a new one.
+static void record(UndoLog *log, UndoType type, size_t pos, const char *text, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    if (length > UNDO_LOG_RECORD_MAX || pos > UINT32_MAX) {
+        undo_log_clear(log); // Earlier records would no longer apply after it
+        return;
+    }
+    log->newest = log->current;
+
+    UndoStep *open = &log->open;
+    if (log->has_open && open->type == type && open->length + length <= UNDO_LOG_RECORD_MAX) {
+        bool after = pos == open->pos + (type == UNDO_INSERT ? open->length : 0);
+        if (after && !starts_word(open->text[open->length - 1], text[0])) {
+            // Typing, or the Delete key
+            memcpy(open->text + open->length, text, length);
+            open->length += length;
+            return;
+        }
+        if (type == UNDO_DELETE && pos + length == open->pos && !starts_word(text[length - 1], open->text[0])) {
+            // Backspace: the bytes go in front
+            memmove(open->text + length, open->text, open->length);
+            memcpy(open->text, text, length);
+            open->pos = pos;
+            open->length += length;
+            return;
+        }
+    }
+
+    flush_open(log);
+    open->type = type;
+    open->pos = pos;
+    open->length = length;
+    memcpy(open->text, text, length);
+    log->has_open = true;
+}
+
+void undo_log_init(UndoLog *log) {
+    undo_log_clear(log);
+    log->dropped = 0;
+}
+
+void undo_log_clear(UndoLog *log) {
+    log->oldest = 0;
+    log->current = 0;
+    log->newest = 0;
+    log->has_open = false;
+}
+
+void undo_log_insert(UndoLog *log, size_t pos, const char *text, size_t length) {
+    record(log, UNDO_INSERT, pos, text, length);
+}
+
+void undo_log_delete(UndoLog *log, size_t pos, const char *text, size_t length) {
+    record(log, UNDO_DELETE, pos, text, length);
+}
+
+// -----------------------------------------------------------------------------
+/* Undo and Redo */
+// -----------------------------------------------------------------------------
+
+bool undo_log_undo(UndoLog *log, UndoStep *step) {
+    flush_open(log);
+    if (log->current == log->oldest) {
+        return false;
+    }
+    char trailer[TRAILER_SIZE];
+    ring_read(log, log->current - TRAILER_SIZE, trailer, TRAILER_SIZE);
+    uint32_t size = (uint32_t)(uint8_t)trailer[0] | (uint32_t)(uint8_t)trailer[1] << 8;
+    log->current -= size;
+    read_record(log, log->current, step);
+    return true;
+}
+
+bool undo_log_redo(UndoLog *log, UndoStep *step) {
+    flush_open(log);
+    if (log->current == log->newest) {
+        return false;
+    }
+    log->current += read_record(log, log->current, step);
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef UNDO_LOG_H
+#define UNDO_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UNDO_LOG_ARENA_BYTES 8192   // SRAM the whole history may use, a power of two
+#define UNDO_LOG_RECORD_MAX 128     // Longest edit one record holds; larger edits end the history
+
+/**
+ * @enum UndoType
+ * @brief The kind of edit a record describes.
+ */
+typedef enum {
+    UNDO_INSERT,   // text was inserted at pos
+    UNDO_DELETE    // text was deleted at pos
+} UndoType;
+
+/**
+ * @struct UndoStep
+ * @brief One recorded edit, as handed out by undo and redo.
+ */
+typedef struct {
+    UndoType type;
+    size_t pos;
+    size_t length;
+    char text[UNDO_LOG_RECORD_MAX];   // The inserted or deleted bytes
+} UndoStep;
+
+/**
+ * @struct UndoLog
+ * @brief Undo and redo history of one document in a fixed ring arena.
+ *
+ * Edits are recorded as operations (position, length, bytes), never as copies
+ * of the document, so the history costs the same for any document size.
+ * Records sit back to back in the arena, each with its size at both ends so
+ * it can be walked either way. Offsets only grow; the arena index is the
+ * offset modulo its size. When a new record does not fit, the oldest records
+ * are dropped until it does.
+ *
+ * The record being typed stays open outside the arena: consecutive typing is
+ * merged into it up to the end of a word, and consecutive backspaces likewise,
+ * so one undo step takes back about one word.
+ */
+typedef struct {
+    char arena[UNDO_LOG_ARENA_BYTES];
+    uint32_t oldest;    // Start of the oldest record
+    uint32_t current;   // End of the last applied record: undo goes back from here
+    uint32_t newest;    // End of the last record: redo goes forward up to here
+    UndoStep open;      // Edit still being merged into
+    bool has_open;
+    uint32_t dropped;   // Records dropped to make room since the history started
+} UndoLog;
+
+/**
+ * @brief Starts an empty history.
+ */
+void undo_log_init(UndoLog *log);
+
+/**
+ * @brief Forgets the whole history, for instance when it no longer matches the document.
+ */
+void undo_log_clear(UndoLog *log);
+
+/**
+ * @brief Records that length bytes of text were inserted at pos.
+ *
+ * Anything that could be redone is dropped. An insert longer than
+ * UNDO_LOG_RECORD_MAX cannot be recorded and clears the history.
+ */
+void undo_log_insert(UndoLog *log, size_t pos, const char *text, size_t length);
+
+/**
+ * @brief Records that the length bytes text were deleted at pos.
+ *
+ * Same rules as undo_log_insert.
+ */
+void undo_log_delete(UndoLog *log, size_t pos, const char *text, size_t length);
+
+/**
+ * @brief Steps back over the last applied edit.
+ *
+ * The caller reverts it in the document: deletes what step inserted, or
+ * inserts again what it deleted.
+ *
+ * @return true if there was an edit to undo.
+ */
+bool undo_log_undo(UndoLog *log, UndoStep *step);
+
+/**
+ * @brief Steps forward over the last undone edit, which the caller applies again.
+ *
+ * @return true if there was an edit to redo.
+ */
+bool undo_log_redo(UndoLog *log, UndoStep *step);
+
+#endif // UNDO_LOG_H
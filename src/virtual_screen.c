@@ -0,0 +1,204 @@
+// virtual_screen.c
+
+#include "virtual_screen.h"
+#include "hal_interface.h"
+#include <string.h>
+
+#define CONTENT_ROWS (VSCREEN_ROWS - 1)  // Bottom row is reserved for the status line
+#define RUN_MERGE_GAP 4                  // Unchanged cells bridged to save a cursor move
+#define ANSI_UNDERLINE "\033[4m"
+#define ANSI_RESET "\033[0m"
+
+static ScreenCell front[VSCREEN_ROWS][VSCREEN_COLS];  // What the display shows
+static ScreenCell back[VSCREEN_ROWS][VSCREEN_COLS];   // Frame being composed
+static char status[VSCREEN_STATUS_LEN + 1];
+
+static int write_row = 0;
+static int write_col = 0;
+static uint8_t write_attr = CELL_ATTR_NONE;
+
+// -----------------------------------------------------------------------------
+/* Internal Helpers */
+// -----------------------------------------------------------------------------
+
+static void fill_blank(ScreenCell buffer[VSCREEN_ROWS][VSCREEN_COLS]) {
+    for (int row = 0; row < VSCREEN_ROWS; row++) {
+        for (int col = 0; col < VSCREEN_COLS; col++) {
+            buffer[row][col].ch = ' ';
+            buffer[row][col].attr = CELL_ATTR_NONE;
+        }
+    }
+}
+
+static bool cell_equal(const ScreenCell *a, const ScreenCell *b) {
+    return a->ch == b->ch && a->attr == b->attr;
+}
+
+static void put_char(char c) {
+    if (write_row >= CONTENT_ROWS) {
+        return;
+    }
+    back[write_row][write_col].ch = c;
+    back[write_row][write_col].attr = write_attr;
+    if (++write_col == VSCREEN_COLS) {
+        write_col = 0;
+        write_row++;
+    }
+}
+
+// Parses an ANSI escape sequence starting at text[0] == '\033'.
+// Applies the underline/reset attributes and returns the sequence length.
+static size_t parse_escape(const char *text, size_t length) {
+    if (length < 2 || text[1] != '[') {
+        return 1;
+    }
+    size_t i = 2;
+    int param = 0;
+    while (i < length && ((text[i] >= '0' && text[i] <= '9') || text[i] == ';')) {
+        param = text[i] == ';' ? 0 : param * 10 + (text[i] - '0');
+        i++;
+    }
+    if (i == length) {
+        return length;
+    }
+    if (text[i] == 'm') {
+        write_attr = param == 4 ? CELL_ATTR_UNDERLINE : CELL_ATTR_NONE;
+    }
+    return i + 1;
+}
+
+// Renders the status message into the bottom row of the back buffer.
+static void compose_status_row(void) {
+    ScreenCell *row = back[VSCREEN_ROWS - 1];
+    size_t len = strlen(status);
+    for (size_t col = 0; col < VSCREEN_COLS; col++) {
+        row[col].ch = col < len ? status[col] : ' ';
+        row[col].attr = CELL_ATTR_NONE;
+    }
+}
+
+// Sends back[row][start..end] to the display as one positioned write.
+static void emit_run(int row, int start, int end) {
+    // Worst case every cell switches attributes
+    char out[VSCREEN_COLS * (sizeof(ANSI_UNDERLINE) + 1) + sizeof(ANSI_RESET)];
+    size_t len = 0;
+    uint8_t attr = CELL_ATTR_NONE;
+
+    for (int col = start; col <= end; col++) {
+        const ScreenCell *cell = &back[row][col];
+        if (cell->attr != attr) {
+            const char *code = cell->attr == CELL_ATTR_UNDERLINE ? ANSI_UNDERLINE : ANSI_RESET;
+            size_t code_len = strlen(code);
+            memcpy(out + len, code, code_len);
+            len += code_len;
+            attr = cell->attr;
+        }
+        out[len++] = cell->ch;
+    }
+    if (attr != CELL_ATTR_NONE) {
+        memcpy(out + len, ANSI_RESET, sizeof(ANSI_RESET) - 1);
+        len += sizeof(ANSI_RESET) - 1;
+    }
+    out[len] = '\0';
+
+    hal_display_set_cursor(row, start);
+    hal_display_write(out);
+}
+
+// -----------------------------------------------------------------------------
+/* Public Functions */
+// -----------------------------------------------------------------------------
+
+void vscreen_init(void) {
+    status[0] = '\0';
+    fill_blank(back);
+    vscreen_invalidate();
+    write_row = 0;
+    write_col = 0;
+    write_attr = CELL_ATTR_NONE;
+}
+
+void vscreen_begin_frame(void) {
+    fill_blank(back);
+    write_row = 0;
+    write_col = 0;
+    write_attr = CELL_ATTR_NONE;
+}
+
+void vscreen_write(const char *text) {
+    vscreen_write_span(text, strlen(text));
+}
+
+void vscreen_write_span(const char *text, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        char c = text[i];
+        if (c == '\033') {
+            i += parse_escape(text + i, length - i);
+            continue;
+        }
+        if (c == '\n') {
+            write_row++;
+            write_col = 0;
+        } else if (c == '\t') {
+            put_char(' ');
+        } else if ((unsigned char)c >= 32) {
+            put_char(c);
+        }
+        i++;
+    }
+}
+
+void vscreen_write_at(int row, int col, const char *text, size_t max_width) {
+    if (row < 0 || row >= CONTENT_ROWS || col < 0) {
+        return;
+    }
+    for (size_t i = 0; text[i] != '\0' && i < max_width && col < VSCREEN_COLS; i++) {
+        unsigned char c = (unsigned char)text[i];
+        back[row][col].ch = c >= 32 ? (char)c : ' ';
+        back[row][col].attr = CELL_ATTR_NONE;
+        col++;
+    }
+}
+
+void vscreen_set_status(const char *message) {
+    strncpy(status, message, VSCREEN_STATUS_LEN);
+    status[VSCREEN_STATUS_LEN] = '\0';
+}
+
+size_t vscreen_flush(void) {
+    compose_status_row();
+
+    size_t cells_sent = 0;
+    for (int row = 0; row < VSCREEN_ROWS; row++) {
+        int col = 0;
+        while (col < VSCREEN_COLS) {
+            if (cell_equal(&back[row][col], &front[row][col])) {
+                col++;
+                continue;
+            }
+
+            // Extend the run over changed cells, bridging short unchanged gaps
+            int start = col;
+            int end = col;
+            for (int probe = col + 1; probe < VSCREEN_COLS && probe - end <= RUN_MERGE_GAP; probe++) {
+                if (!cell_equal(&back[row][probe], &front[row][probe])) {
+                    end = probe;
+                }
+            }
+
+            emit_run(row, start, end);
+            memcpy(&front[row][start], &back[row][start], (size_t)(end - start + 1) * sizeof(ScreenCell));
+            cells_sent += (size_t)(end - start + 1);
+            col = end + 1;
+        }
+    }
+    hal_display_flush();
+    return cells_sent;
+}
+
+void vscreen_invalidate(void) {
+    // The display content is unknown: clear it so the front buffer is exact
+    hal_display_clear();
+    fill_blank(front);
+}
@@ -0,0 +1,94 @@
+#ifndef VIRTUAL_SCREEN_H
+#define VIRTUAL_SCREEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VSCREEN_ROWS 20     // 320 px / 16 px glyphs
+#define VSCREEN_COLS 120    // 960 px / 8 px glyphs
+#define VSCREEN_STATUS_LEN VSCREEN_COLS
+
+/**
+ * @enum CellAttr
+ * @brief Display attributes of a single character cell.
+ */
+typedef enum {
+    CELL_ATTR_NONE = 0,
+    CELL_ATTR_UNDERLINE = 1
+} CellAttr;
+
+/**
+ * @struct ScreenCell
+ * @brief One character cell of the virtual screen.
+ */
+typedef struct {
+    char ch;
+    uint8_t attr;
+} ScreenCell;
+
+/**
+ * @brief Clears the display and resets both screen buffers.
+ *
+ * Must be called once before any other vscreen function.
+ */
+void vscreen_init(void);
+
+/**
+ * @brief Starts composing a new frame.
+ *
+ * Clears the back buffer and moves the write position to the top-left cell.
+ * Nothing is sent to the display until vscreen_flush().
+ */
+void vscreen_begin_frame(void);
+
+/**
+ * @brief Writes text into the back buffer at the current write position.
+ *
+ * '\n' moves to the start of the next row and long rows wrap. The ANSI
+ * sequences "\033[4m" and "\033[0m" switch underlining on and off; other
+ * escape sequences are ignored. Text below the last row is dropped.
+ */
+void vscreen_write(const char *text);
+
+/**
+ * @brief Writes length bytes of text, like vscreen_write but without a terminator.
+ */
+void vscreen_write_span(const char *text, size_t length);
+
+/**
+ * @brief Writes text at a cell position without wrapping.
+ *
+ * At most max_width cells are written and nothing past the right edge; the
+ * text is taken literally, without escape sequences. Does not move the write
+ * position used by vscreen_write. Used for column layouts.
+ */
+void vscreen_write_at(int row, int col, const char *text, size_t max_width);
+
+/**
+ * @brief Sets the status message drawn on the bottom row.
+ *
+ * The message persists across frames until it is replaced. Pass an empty
+ * string to clear it.
+ */
+void vscreen_set_status(const char *message);
+
+/**
+ * @brief Sends the differences between the back and front buffers to the display.
+ *
+ * Only runs of changed cells are emitted, each as one hal_display_set_cursor
+ * followed by one hal_display_write, and the frame ends with
+ * hal_display_flush. Afterwards the front buffer matches the back buffer.
+ *
+ * @return Number of cells sent to the display.
+ */
+size_t vscreen_flush(void);
+
+/**
+ * @brief Forces the next flush to repaint every cell.
+ *
+ * Use after something else has drawn on the display.
+ */
+void vscreen_invalidate(void);
+
+#endif // VIRTUAL_SCREEN_H
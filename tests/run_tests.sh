@@ -0,0 +1,23 @@
+#!/bin/sh
+# Builds the replay harness with optimizations on and plays every trace in
+# tests/traces, on the RAM disk and then on a FAT32 image. Exits non-zero if
+# the build or a trace check fails.
+# Usage: tests/run_tests.sh [trace.keys...]
+set -e
+cd "$(dirname "$0")/.."
+mkdir -p build
+
+CFLAGS="-std=c11 -O2 -Isrc"
+CORE="src/cybertyper_core.c src/editor_buffer.c src/paged_document.c src/side_file.c src/line_index.c src/virtual_screen.c src/frame_builder.c src/dir_cache.c src/path_index.c src/search_index.c src/storage_worker.c src/edit_journal.c src/undo_log.c"
+
+echo "== Key replay through cybertyper_run_cycle (scripted HAL, RAM disk) =="
+gcc $CFLAGS tests/test_cybertyper.c $CORE src/hal_mock_storage.c src/host_storage.c src/ram_disk.c src/sd_sim.c src/fat_volume.c src/block_image.c -o build/test_cybertyper -pthread
+if [ $# -eq 0 ]; then
+    set -- tests/traces/*.keys
+fi
+# The core and the mock storage log to stderr
+./build/test_cybertyper "$@" 2> build/test_cybertyper.log
+
+echo
+echo "== The same traces on a FAT32 image (sectors per operation) =="
+./build/test_cybertyper --fat "$@" 2>> build/test_cybertyper.log
@@ -0,0 +1,661 @@
+// test_cybertyper.c
+//
+// Headless replay harness for the core. cybertyper_core.c runs against a
+// scripted HAL: keys come from trace files instead of the terminal, the clock
+// is virtual and only moves when the core waits, and the display only counts
+// the bytes the terminal mock would have sent and keeps a copy of the screen
+// for the checks. Storage is the mock SD card of
+// hal_mock_storage.c on a generated card, held on the RAM disk unless --host
+// puts it in a temporary directory or --fat in a FAT32 image there. --sd puts
+// the SD card emulator in front, so cycle times include the waits for a card
+// of that profile.
+//
+// For every trace it reports the time cybertyper_run_cycle takes for the
+// cycles that handle keys (p50, p99, max), the display bytes emitted per key
+// and the storage calls and bytes per key, background saves included. On a
+// FAT32 image it adds the sectors each kind of operation read and wrote. The
+// exit status is non-zero if a trace cannot be read or one of its <expect>
+// checks fails, so it can run in CI.
+//
+// Usage: test_cybertyper [--host | --fat] [--sd spi|sdmmc|slow] trace.keys...
+//
+// Trace format: printable characters are typed as they are. Line breaks are
+// ignored, and lines starting with "# " are comments. Other keys and
+// directives are written in angle brackets:
+//   <Enter> <Esc> <Bksp> <Tab> <Del> <Up> <Down> <Left> <Right> <Home> <End>
+//   <PgUp> <PgDn> <F1> <^F> <^N> <^R> <^S> <^Y> <^Z> <lt> (a literal '<')
+//   <gap N>          N ms between the following keys (default 50, 0 = pasted)
+//   <pause N>        N ms of idle time before the next key
+//   <expect P TEXT>  after the trace, file P on the card contains TEXT (or
+//                    just exists if TEXT is empty)
+//   <expect-not P TEXT>  after the trace, file P exists and does not contain TEXT
+//   <cursor-row N>   once the keys before it are handled, the cursor is on
+//                    screen row N (0 is the top row)
+//   <expect-row N TEXT>  once the keys before it are handled, screen row N
+//                    reads exactly TEXT, trailing blanks ignored
+
+#define _XOPEN_SOURCE 700
+
+#include "cybertyper_core.h"
+#include "hal_interface.h"
+#include "block_image.h"
+#include "fat_volume.h"
+#include "hal_mock_storage.h"
+#include "host_storage.h"
+#include "ram_disk.h"
+#include "sd_sim.h"
+#include "storage_worker.h"
+#include "virtual_screen.h"
+#include <ftw.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_GAP_MS 50
+#define MAX_EXPECTS 8
+#define MAX_CHECKS 32
+#define CARD_NOTES 300     // Files in /notes, for navigation sweeps
+#define CARD_DRAFTS 40     // Files in /drafts, for rename storms
+#define CARD_STORY_LINES 2000
+#define CARD_IMAGE_SECTORS (1024u * 1024u)   // 512 MB FAT32 image for --fat, sparse on the host
+#define CARD_CLUSTER_SECTORS 8               // 4 KB clusters, the usual size for such a card
+
+typedef struct {
+    KeyCode key;
+    uint32_t at_ms;    // Virtual time the key is pressed, from the start of the trace
+} ScriptKey;
+
+typedef struct {
+    char path[256];
+    char text[256];
+    bool absent;       // TEXT must not be in the file
+} Expect;
+
+// A check of the screen, made between two keys of the trace.
+typedef struct {
+    size_t at_key;     // Made before this key is read
+    int line;          // In the trace file, for messages
+    int row;
+    bool cursor;       // The cursor is on row, rather than row reads text
+    char text[VSCREEN_COLS + 1];
+} ScreenCheck;
+
+typedef struct {
+    ScriptKey *keys;
+    size_t count;
+    size_t capacity;
+    Expect expects[MAX_EXPECTS];
+    size_t expect_count;
+    ScreenCheck checks[MAX_CHECKS];
+    size_t check_count;
+} Script;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+/* Trace Parsing */
+// -----------------------------------------------------------------------------
+
+static const struct {
+    const char *name;
+    KeyCode key;
+} key_names[] = {
+    { "Enter", KEY_ENTER },     { "Esc", KEY_ESCAPE },         { "Bksp", KEY_BACKSPACE },
+    { "Tab", KEY_TAB },         { "Del", KEY_DELETE },         { "Up", KEY_ARROW_UP },
+    { "Down", KEY_ARROW_DOWN }, { "Left", KEY_ARROW_LEFT },    { "Right", KEY_ARROW_RIGHT },
+    { "Home", KEY_HOME },       { "End", KEY_END },            { "PgUp", KEY_PAGE_UP },
+    { "PgDn", KEY_PAGE_DOWN },  { "F1", KEY_F1 },              { "^F", KEY_CTRL_F },
+    { "^N", KEY_CTRL_N },       { "^R", KEY_CTRL_R },          { "^S", KEY_CTRL_S },
+    { "^Y", KEY_CTRL_Y },       { "^Z", KEY_CTRL_Z },          { "lt", (KeyCode)(KEY_CHAR_BASE + '<') },
+};
+
+static bool script_add(Script *script, KeyCode key, uint32_t at_ms) {
+    if (script->count == script->capacity) {
+        size_t capacity = script->capacity ? script->capacity * 2 : 256;
+        ScriptKey *keys = realloc(script->keys, capacity * sizeof(*keys));
+        if (!keys) {
+            return false;
+        }
+        script->keys = keys;
+        script->capacity = capacity;
+    }
+    script->keys[script->count++] = (ScriptKey){ key, at_ms };
+    return true;
+}
+
+// Handles the text between '<' and '>'. Returns false if it is not understood.
+static bool parse_tag(Script *script, const char *tag, int line, uint32_t *gap_ms, uint32_t *time_ms) {
+    unsigned value;
+    if (sscanf(tag, "gap %u", &value) == 1) {
+        *gap_ms = value;
+        return true;
+    }
+    if (sscanf(tag, "pause %u", &value) == 1) {
+        *time_ms += value;
+        return true;
+    }
+    bool absent = strncmp(tag, "expect-not ", 11) == 0;
+    if (absent || strncmp(tag, "expect ", 7) == 0) {
+        if (script->expect_count == MAX_EXPECTS) {
+            return false;
+        }
+        Expect *expect = &script->expects[script->expect_count++];
+        const char *path = tag + (absent ? 11 : 7);
+        const char *end = strchr(path, ' ');
+        size_t length = end ? (size_t)(end - path) : strlen(path);
+        snprintf(expect->path, sizeof(expect->path), "%.*s", (int)length, path);
+        snprintf(expect->text, sizeof(expect->text), "%s", end ? end + 1 : "");
+        expect->absent = absent;
+        return !absent || expect->text[0] != '\0';
+    }
+    int text_at = 0;
+    bool cursor = sscanf(tag, "cursor-row %u", &value) == 1;
+    if (cursor || sscanf(tag, "expect-row %u %n", &value, &text_at) == 1) {
+        if (script->check_count == MAX_CHECKS || value >= VSCREEN_ROWS) {
+            return false;
+        }
+        ScreenCheck *check = &script->checks[script->check_count++];
+        *check = (ScreenCheck){ script->count, line, (int)value, cursor, "" };
+        if (!cursor) {
+            snprintf(check->text, sizeof(check->text), "%s", tag + text_at);
+        }
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(key_names) / sizeof(key_names[0]); i++) {
+        if (strcmp(tag, key_names[i].name) == 0) {
+            *time_ms += *gap_ms;
+            return script_add(script, key_names[i].key, *time_ms);
+        }
+    }
+    return false;
+}
+
+static bool script_load(Script *script, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    memset(script, 0, sizeof(*script));
+
+    uint32_t gap_ms = DEFAULT_GAP_MS;
+    uint32_t time_ms = 0;
+    char line[4096];
+    bool ok = true;
+    for (int number = 1; ok && fgets(line, sizeof(line), f); number++) {
+        if (strncmp(line, "# ", 2) == 0) {
+            continue;
+        }
+        for (const char *c = line; ok && *c && *c != '\n' && *c != '\r'; c++) {
+            if (*c != '<') {
+                time_ms += gap_ms;
+                ok = script_add(script, (KeyCode)(KEY_CHAR_BASE + (unsigned char)*c), time_ms);
+                continue;
+            }
+            const char *end = strchr(c, '>');
+            char tag[512];
+            if (end) {
+                snprintf(tag, sizeof(tag), "%.*s", (int)(end - c - 1), c + 1);
+            }
+            if (!end || !parse_tag(script, tag, number, &gap_ms, &time_ms)) {
+                fprintf(stderr, "%s:%d: cannot read '%s'\n", path, number, c);
+                ok = false;
+            } else {
+                c = end;
+            }
+        }
+    }
+    fclose(f);
+    if (!ok) {
+        free(script->keys);
+    }
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+/* Scripted HAL */
+// -----------------------------------------------------------------------------
+
+// The clock is virtual: it stands still while the core works and jumps to the
+// next key or timer when the core waits, so a replay does not depend on how
+// fast the host is. Only the cycle times are measured in real time.
+static const Script *script;
+static size_t next_key;
+static size_t next_check;
+static uint32_t clock_ms;
+static uint32_t trace_start_ms;
+
+// Display output, counted as the terminal mock would send it, and the screen
+// it leaves
+static uint64_t display_bytes;
+static char screen_text[VSCREEN_ROWS][VSCREEN_COLS];
+static bool screen_underline[VSCREEN_ROWS][VSCREEN_COLS];
+static int screen_row;
+static int screen_col;
+static bool underline_on;
+
+// Set by hal_event_signal from the storage worker
+static pthread_mutex_t signal_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t signal_cond = PTHREAD_COND_INITIALIZER;
+static bool signalled;
+
+static const char *sd_profile = NULL;   // --sd
+
+// Keys stop at a pending screen check, so it sees the screen the keys before it left.
+static bool key_due(void) {
+    return script && next_key < script->count &&
+           !(next_check < script->check_count && script->checks[next_check].at_key == next_key) &&
+           (int32_t)(clock_ms - (trace_start_ms + script->keys[next_key].at_ms)) >= 0;
+}
+
+size_t hal_input_read_keys(KeyEvent *out, size_t max) {
+    size_t count = 0;
+    while (count < max && key_due()) {
+        out[count].key = script->keys[next_key].key;
+        out[count].timestamp_ms = trace_start_ms + script->keys[next_key].at_ms;
+        next_key++;
+        count++;
+    }
+    return count;
+}
+
+KeyCode hal_input_get_key(void) {
+    KeyEvent event;
+    return hal_input_read_keys(&event, 1) == 1 ? event.key : KEY_NONE;
+}
+
+// Returns at once for a due key or a signal. Otherwise the clock moves to the
+// next key or the timeout, whichever comes first. Once the trace is over, this
+// waits (in real time) for the storage worker instead.
+bool hal_event_wait(uint32_t timeout_ms) {
+    if (key_due()) {
+        return true;
+    }
+    pthread_mutex_lock(&signal_lock);
+    if (signalled) {
+        signalled = false;
+        pthread_mutex_unlock(&signal_lock);
+        return false;
+    }
+
+    bool keys_left = script && next_key < script->count;
+    if (!keys_left && (timeout_ms == HAL_WAIT_FOREVER || storage_worker_outstanding() > 0)) {
+        while (!signalled) {
+            pthread_cond_wait(&signal_cond, &signal_lock);
+        }
+        signalled = false;
+        pthread_mutex_unlock(&signal_lock);
+        return false;
+    }
+    pthread_mutex_unlock(&signal_lock);
+
+    uint32_t wait_ms = timeout_ms;
+    if (keys_left) {
+        uint32_t until_key = trace_start_ms + script->keys[next_key].at_ms - clock_ms;
+        if (until_key < wait_ms) {
+            wait_ms = until_key;
+        }
+    }
+    clock_ms += wait_ms;
+    return key_due();
+}
+
+void hal_event_signal(void) {
+    pthread_mutex_lock(&signal_lock);
+    signalled = true;
+    pthread_cond_signal(&signal_cond);
+    pthread_mutex_unlock(&signal_lock);
+}
+
+uint32_t hal_time_ms(void) {
+    return clock_ms;
+}
+
+void hal_display_clear(void) {
+    display_bytes += strlen("\033[2J\033[H");
+    memset(screen_text, ' ', sizeof(screen_text));
+    memset(screen_underline, 0, sizeof(screen_underline));
+    screen_row = 0;
+    screen_col = 0;
+}
+
+// Only the underline on and off sequences of virtual_screen.c are expected.
+void hal_display_write(const char *text) {
+    display_bytes += strlen(text);
+    for (const char *c = text; *c; c++) {
+        if (strncmp(c, "\033[4m", 4) == 0 || strncmp(c, "\033[0m", 4) == 0) {
+            underline_on = c[2] == '4';
+            c += 3;
+        } else if (screen_row < VSCREEN_ROWS && screen_col < VSCREEN_COLS) {
+            screen_text[screen_row][screen_col] = *c;
+            screen_underline[screen_row][screen_col++] = underline_on;
+        }
+    }
+}
+
+void hal_display_set_cursor(int line, int column) {
+    char sequence[32];
+    display_bytes += (uint64_t)snprintf(sequence, sizeof(sequence), "\033[%d;%dH", line + 1, column + 1);
+    screen_row = line;
+    screen_col = column;
+}
+
+void hal_display_flush(void) {
+}
+
+bool hal_system_is_wakeup_from_sleep(void) {
+    return false;
+}
+
+void hal_system_prepare_for_sleep(void) {
+}
+
+void hal_system_sleep(void) {
+}
+
+// -----------------------------------------------------------------------------
+/* Test Card */
+// -----------------------------------------------------------------------------
+
+// The backend holding the card. The harness sets it up and checks it through
+// this directly, so neither shows up in the storage counters or costs card time.
+static const StorageBackend *card = &ram_disk_backend;
+
+static bool write_text_file(const char *path, const char *text, size_t repeat) {
+    char line[128];
+    size_t offset = 0;
+    bool ok = card->create_file(path);
+    for (size_t i = 0; ok && i < repeat; i++) {
+        int length = snprintf(line, sizeof(line), "%s %05zu\n", text, i);
+        ok = card->write(path, offset, line, (size_t)length);
+        offset += (size_t)length;
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: cannot write\n", path);
+    }
+    return ok;
+}
+
+// A card with a long document, a large folder and a folder of drafts.
+static bool make_card(void) {
+    char path[64];
+    if (!card->create_directory("/notes") || !card->create_directory("/drafts")) {
+        fprintf(stderr, "test card: cannot create folders\n");
+        return false;
+    }
+    bool ok = write_text_file("/story.txt", "It was a dark and stormy night, line", CARD_STORY_LINES);
+    for (int i = 0; ok && i < CARD_NOTES; i++) {
+        snprintf(path, sizeof(path), "/notes/note-%03d.txt", i);
+        ok = write_text_file(path, "A short note about nothing in particular", 3);
+    }
+    for (int i = 0; ok && i < CARD_DRAFTS; i++) {
+        snprintf(path, sizeof(path), "/drafts/draft-%03d.txt", i);
+        ok = write_text_file(path, "First draft of a chapter", 20);
+    }
+    return ok;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+// -----------------------------------------------------------------------------
+/* Replay */
+// -----------------------------------------------------------------------------
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// The row of the underlined cursor cell, or -1 if none is shown.
+static int screen_cursor_row(void) {
+    for (int row = 0; row < VSCREEN_ROWS; row++) {
+        for (int col = 0; col < VSCREEN_COLS; col++) {
+            if (screen_underline[row][col]) {
+                return row;
+            }
+        }
+    }
+    return -1;
+}
+
+static bool check_screen(const ScreenCheck *check) {
+    if (check->cursor) {
+        int row = screen_cursor_row();
+        if (row != check->row) {
+            printf("    FAILED: line %d: cursor on row %d, expected row %d\n", check->line, row, check->row);
+            return false;
+        }
+        return true;
+    }
+    int length = VSCREEN_COLS;
+    while (length > 0 && screen_text[check->row][length - 1] == ' ') {
+        length--;
+    }
+    if (length != (int)strlen(check->text) || strncmp(screen_text[check->row], check->text, (size_t)length) != 0) {
+        printf("    FAILED: line %d: row %d reads \"%.*s\", expected \"%s\"\n", check->line, check->row, length,
+               screen_text[check->row], check->text);
+        return false;
+    }
+    return true;
+}
+
+static bool check_expect(const Expect *expect) {
+    DirEntry entry;
+    if (!card->stat(expect->path, &entry) || entry.type != DIR_ENTRY_FILE) {
+        printf("    FAILED: %s does not exist\n", expect->path);
+        return false;
+    }
+    char *text = malloc((size_t)entry.size + 1);
+    bool readable = text != NULL;
+    bool found = false;
+    if (readable) {
+        int read = card->read(expect->path, 0, text, entry.size);
+        text[read > 0 ? read : 0] = '\0';
+        found = strstr(text, expect->text) != NULL;
+    }
+    free(text);
+    if (!readable || found == expect->absent) {
+        printf("    FAILED: %s %s \"%s\"\n", expect->path, expect->absent ? "contains" : "does not contain",
+               expect->text);
+        return false;
+    }
+    return true;
+}
+
+// The block device traffic of each kind of operation, per key.
+static void print_fat_stats(double keys) {
+    FatVolumeStats fat = fat_volume_stats();
+    uint64_t read = 0, written = 0;
+    for (int op = 0; op < FAT_OP_COUNT; op++) {
+        read += fat.ops[op].sectors_read;
+        written += fat.ops[op].sectors_written;
+    }
+    printf("%-22s %6.1f sectors read + %5.1f written/key  cache %u/%u hits  FAT cache %u/%u hits\n", "",
+           read / keys, written / keys, fat.cache_hits, fat.cache_hits + fat.cache_misses, fat.fat_cache_hits,
+           fat.fat_cache_hits + fat.fat_cache_misses);
+    for (int op = 0; op < FAT_OP_COUNT; op++) {
+        const FatOpStats *stats = &fat.ops[op];
+        if (stats->calls) {
+            printf("%-24s %-16s %6u calls  %6.1f sectors read + %5.1f written/call\n", "",
+                   fat_volume_op_name((FatOp)op), stats->calls, (double)stats->sectors_read / stats->calls,
+                   (double)stats->sectors_written / stats->calls);
+        }
+    }
+}
+
+// Plays a trace from its first key until the storage worker has finished the
+// work it caused, and prints its numbers.
+static bool replay(const char *path) {
+    Script trace;
+    if (!script_load(&trace, path)) {
+        return false;
+    }
+
+    double *cycle_ns = malloc((trace.count + 1) * sizeof(double));
+    size_t samples = 0;
+    uint32_t cycles = 0;
+    uint64_t bytes = 0;
+    HalMockStorageStats before = hal_mock_storage_stats();
+    sd_sim_reset_stats();
+    fat_volume_reset_stats();
+
+    bool ok = true;
+    script = &trace;
+    next_key = 0;
+    next_check = 0;
+    trace_start_ms = clock_ms;
+    while (next_key < trace.count || storage_worker_outstanding() > 0) {
+        while (next_check < trace.check_count && trace.checks[next_check].at_key == next_key) {
+            ok = check_screen(&trace.checks[next_check++]) && ok;
+        }
+        size_t keys_before = next_key;
+        uint64_t bytes_before = display_bytes;
+        double t0 = now_ns();
+        cybertyper_run_cycle();
+        double elapsed = now_ns() - t0;
+        cycles++;
+        if (next_key != keys_before) {
+            cycle_ns[samples++] = elapsed;
+            bytes += display_bytes - bytes_before;
+        }
+    }
+    HalMockStorageStats after = hal_mock_storage_stats();
+    while (next_check < trace.check_count) {
+        ok = check_screen(&trace.checks[next_check++]) && ok;
+    }
+    script = NULL;
+
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    double keys = trace.count ? (double)trace.count : 1;
+    qsort(cycle_ns, samples, sizeof(double), compare_doubles);
+    printf("%-22s %6zu keys %6u cycles  p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", name, trace.count, cycles,
+           samples ? cycle_ns[samples / 2] / 1e3 : 0, samples ? cycle_ns[samples * 99 / 100] / 1e3 : 0,
+           samples ? cycle_ns[samples - 1] / 1e3 : 0);
+    printf("%-22s %6.1f display bytes/key  %5.2f storage calls/key  %7.1f read + %6.1f written bytes/key\n", "",
+           (double)bytes / keys, (after.calls - before.calls) / keys,
+           (double)(after.bytes_read - before.bytes_read) / keys,
+           (double)(after.bytes_written - before.bytes_written) / keys);
+    if (sd_profile) {
+        SdSimStats sd = sd_sim_stats();
+        printf("%-22s %6.1f ms card busy  %7.1f sectors/key  %5u read-modify-writes  %3u stalls\n", "",
+               sd.busy_us / 1e3, (double)(sd.sectors_read + sd.sectors_written) / keys, sd.read_modify_writes,
+               sd.gc_stalls);
+    }
+    if (card == &fat_volume_backend) {
+        print_fat_stats(keys);
+    }
+
+    for (size_t i = 0; i < trace.expect_count; i++) {
+        ok = check_expect(&trace.expects[i]) && ok;
+    }
+    free(cycle_ns);
+    free(trace.keys);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    bool host = false;
+    bool fat = false;
+    int first = 1;
+    for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++) {
+        SdSimTiming timing;
+        if (strcmp(argv[first], "--host") == 0) {
+            host = true;
+        } else if (strcmp(argv[first], "--fat") == 0) {
+            fat = true;
+        } else if (strcmp(argv[first], "--sd") == 0 && first + 1 < argc && sd_sim_profile(argv[first + 1], &timing)) {
+            sd_profile = argv[++first];
+        } else {
+            break;
+        }
+    }
+    if (first >= argc || strncmp(argv[first], "--", 2) == 0) {
+        fprintf(stderr, "Usage: %s [--host | --fat] [--sd spi|sdmmc|slow] trace.keys...\n", argv[0]);
+        return 2;
+    }
+
+    // Trace paths are opened before moving to the card
+    char **paths = calloc((size_t)argc, sizeof(char *));
+    for (int i = first; i < argc; i++) {
+        paths[i] = realpath(argv[i], NULL);
+        if (!paths[i]) {
+            perror(argv[i]);
+            return 2;
+        }
+    }
+
+    char card_dir[] = "/tmp/cybertyper_replay.XXXXXX";
+    if (host || fat) {
+        if (!mkdtemp(card_dir) || chdir(card_dir) != 0) {
+            perror("test card");
+            return 2;
+        }
+    }
+    if (host) {
+        card = &host_storage_backend;
+        if (mkdir("sdcard", 0777) != 0) {
+            perror("test card");
+            return 2;
+        }
+    } else if (fat) {
+        card = &fat_volume_backend;
+        if (!block_image_create("card.img", CARD_IMAGE_SECTORS) ||
+            !fat_volume_format(&block_image_device, CARD_CLUSTER_SECTORS) ||
+            !fat_volume_mount(&block_image_device, NULL)) {
+            fprintf(stderr, "test card: cannot make the FAT32 image\n");
+            return 2;
+        }
+    }
+    if (!make_card()) {
+        return 2;
+    }
+    if (sd_profile) {
+        SdSimTiming timing;
+        sd_sim_profile(sd_profile, &timing);
+        sd_sim_init(card, &timing);
+        hal_mock_storage_set_backend(&sd_sim_backend);
+    } else {
+        hal_mock_storage_set_backend(card);
+    }
+    printf("card: %s%s%s\n", host ? "host directory" : fat ? "FAT32 image" : "RAM disk", sd_profile ? " behind SD card emulator " : "",
+           sd_profile ? sd_profile : "");
+
+    HalMockStorageStats before = hal_mock_storage_stats();
+    double t0 = now_ns();
+    cybertyper_init();
+    HalMockStorageStats after = hal_mock_storage_stats();
+    printf("init: %.1f ms, %u storage calls, %u display bytes\n", (now_ns() - t0) / 1e6, after.calls - before.calls,
+           (unsigned)display_bytes);
+
+    bool ok = true;
+    for (int i = first; i < argc; i++) {
+        ok = replay(paths[i]) && ok;
+        free(paths[i]);
+    }
+    free(paths);
+
+    storage_worker_stop();
+    if (fat) {
+        fat_volume_unmount();
+        block_image_close();
+    }
+    if ((host || fat) && chdir("/") == 0) {
+        nftw(card_dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}